@@ -78,6 +78,7 @@ void PeriodicMemoryChecker::start() {
         }
         if (config_.systemMemPushbackEnabled &&
             systemUsedMemoryBytes() > config_.systemMemLimitBytes) {
+          std::lock_guard<std::mutex> l(pushbackMutex_);
           pushbackMemory();
         }
       },
@@ -100,6 +101,19 @@ int64_t PeriodicMemoryChecker::systemUsedMemoryBytes(bool fetchFresh) {
   return cachedSystemUsedMemoryBytes_;
 }
 
+void PeriodicMemoryChecker::onMemoryPressure() {
+  if (!config_.systemMemPushbackEnabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> l(pushbackMutex_);
+  const uint64_t targetMemBytes =
+      config_.systemMemLimitBytes - config_.systemMemShrinkBytes;
+  const uint64_t currentMemBytes = systemUsedMemoryBytes(/*fetchFresh=*/true);
+  if (currentMemBytes > targetMemBytes) {
+    pushbackMemory();
+  }
+}
+
 std::string PeriodicMemoryChecker::createHeapDumpFilePath() const {
   const size_t now = velox::getCurrentTimeMs() / 1000;
   // Format as follow:
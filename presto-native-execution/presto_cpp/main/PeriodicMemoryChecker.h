@@ -14,6 +14,7 @@
 #pragma once
 #include <folly/executors/FunctionScheduler.h>
 #include <cstdint>
+#include <mutex>
 #include <queue>
 #include <string>
 
@@ -82,6 +83,12 @@ class PeriodicMemoryChecker {
   /// 'Config::systemMemLimitBytes'.
   int64_t systemUsedMemoryBytes(bool fetchFresh = false);
 
+  /// Invoked when the kernel reports memory stalls. Runs the memory pushback
+  /// right away instead of waiting for the next check if
+  /// 'Config::systemMemPushbackEnabled' is true and the system memory usage is
+  /// above the pushback target ('systemMemLimitBytes' - 'systemMemShrinkBytes').
+  void onMemoryPressure();
+
  protected:
   /// Fetches current system memory usage in bytes and stores it in the cache.
   virtual void loadSystemMemoryUsage() = 0;
@@ -135,6 +142,9 @@ class PeriodicMemoryChecker {
 
   std::string createHeapDumpFilePath() const;
 
+  // Serializes memory pushback between the scheduler thread and
+  // onMemoryPressure().
+  std::mutex pushbackMutex_;
   std::shared_ptr<folly::FunctionScheduler> scheduler_;
   size_t lastHeapDumpAttemptTimestamp_{0};
   std::priority_queue<
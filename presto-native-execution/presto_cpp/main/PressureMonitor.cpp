@@ -0,0 +1,234 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/PressureMonitor.h"
+#include <fcntl.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/system/ThreadName.h>
+#include <glog/logging.h>
+#include <poll.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "velox/common/base/Exceptions.h"
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace facebook::presto {
+namespace {
+uint64_t steadyTimeMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+std::string_view pressureResourceName(PressureResource resource) {
+  switch (resource) {
+    case PressureResource::kCpu:
+      return "cpu";
+    case PressureResource::kMemory:
+      return "memory";
+    case PressureResource::kIo:
+      return "io";
+  }
+  VELOX_UNREACHABLE();
+}
+
+PressureMonitor::PressureMonitor(const Config& config, Callback callback)
+    : config_(config), callback_(std::move(callback)) {
+  VELOX_CHECK(
+      config_.windowMs >= 500 && config_.windowMs <= 10'000,
+      "PSI window must be between 500ms and 10s: {}ms",
+      config_.windowMs);
+  for (size_t i = 0; i < kNumResources; ++i) {
+    const auto threshold = stallThresholdMs(static_cast<PressureResource>(i));
+    VELOX_CHECK_LE(
+        threshold,
+        config_.windowMs,
+        "Stall threshold of {} must not exceed the PSI window",
+        pressureResourceName(static_cast<PressureResource>(i)));
+    fds_[i] = -1;
+    lastEventMs_[i] = 0;
+  }
+}
+
+PressureMonitor::~PressureMonitor() {
+  stop();
+}
+
+std::string PressureMonitor::pressureFilePath(PressureResource resource) const {
+  return fmt::format(
+      "{}/{}.pressure", config_.cgroupPath, pressureResourceName(resource));
+}
+
+uint64_t PressureMonitor::stallThresholdMs(PressureResource resource) const {
+  switch (resource) {
+    case PressureResource::kCpu:
+      return config_.cpuStallThresholdMs;
+    case PressureResource::kMemory:
+      return config_.memoryStallThresholdMs;
+    case PressureResource::kIo:
+      return config_.ioStallThresholdMs;
+  }
+  VELOX_UNREACHABLE();
+}
+
+int PressureMonitor::registerTrigger(PressureResource resource) const {
+  const auto path = pressureFilePath(resource);
+  const int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    LOG(WARNING) << "Unable to open " << path << ": "
+                 << folly::errnoStr(errno);
+    return -1;
+  }
+  // The trigger stays registered as long as the fd is open.
+  const auto trigger = fmt::format(
+      "some {} {}",
+      stallThresholdMs(resource) * 1'000,
+      config_.windowMs * 1'000);
+  // The trailing null byte is part of the expected trigger format.
+  if (folly::writeFull(fd, trigger.c_str(), trigger.size() + 1) < 0) {
+    const int error = errno;
+    LOG(WARNING) << "Unable to register PSI trigger '" << trigger << "' on "
+                 << path << ": " << folly::errnoStr(error);
+    if (error == EINVAL && config_.windowMs % 2'000 != 0) {
+      LOG(WARNING) << "Unprivileged processes can only register PSI triggers "
+                   << "with a window that is a multiple of 2000ms, the "
+                   << "window is " << config_.windowMs << "ms";
+    }
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int16_t PressureMonitor::triggerEvents() const {
+  return POLLPRI;
+}
+
+bool PressureMonitor::start() {
+#ifdef __linux__
+  VELOX_CHECK(!thread_.joinable(), "start() called more than once");
+  size_t numTriggers{0};
+  for (size_t i = 0; i < kNumResources; ++i) {
+    const auto resource = static_cast<PressureResource>(i);
+    if (stallThresholdMs(resource) == 0) {
+      continue;
+    }
+    fds_[i] = registerTrigger(resource);
+    if (fds_[i] >= 0) {
+      LOG(INFO) << "Registered PSI trigger for "
+                << pressureResourceName(resource) << ": "
+                << stallThresholdMs(resource) << "ms stall in "
+                << config_.windowMs << "ms window";
+      ++numTriggers;
+    }
+  }
+  if (numTriggers == 0) {
+    return false;
+  }
+  stopFd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  VELOX_CHECK_GE(stopFd_, 0, "eventfd failed: {}", folly::errnoStr(errno));
+  thread_ = std::thread([this]() { run(); });
+  return true;
+#else
+  return false;
+#endif
+}
+
+void PressureMonitor::stop() {
+  if (thread_.joinable()) {
+    const uint64_t one{1};
+    folly::writeFull(stopFd_, &one, sizeof(one));
+    thread_.join();
+  }
+  if (stopFd_ >= 0) {
+    ::close(stopFd_);
+    stopFd_ = -1;
+  }
+  for (auto& fd : fds_) {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+}
+
+void PressureMonitor::run() {
+  folly::setThreadName("PressureMonitor");
+  // The last pollfd is the stop eventfd.
+  std::vector<struct pollfd> pollFds;
+  std::vector<PressureResource> resources;
+  for (size_t i = 0; i < kNumResources; ++i) {
+    if (fds_[i] >= 0) {
+      pollFds.push_back({fds_[i], triggerEvents(), 0});
+      resources.push_back(static_cast<PressureResource>(i));
+    }
+  }
+  pollFds.push_back({stopFd_, POLLIN, 0});
+
+  for (;;) {
+    const int ret = ::poll(pollFds.data(), pollFds.size(), -1);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG(ERROR) << "PSI poll failed: " << folly::errnoStr(errno);
+      return;
+    }
+    if (pollFds.back().revents != 0) {
+      return;
+    }
+    for (size_t i = 0; i < resources.size(); ++i) {
+      auto& pollFd = pollFds[i];
+      if (pollFd.revents & POLLERR) {
+        // The cgroup went away. Stop polling this fd.
+        LOG(WARNING) << "PSI trigger for "
+                     << pressureResourceName(resources[i])
+                     << " is no longer valid";
+        pollFd.fd = -1;
+        continue;
+      }
+      if (pollFd.revents & triggerEvents()) {
+        clearTrigger(pollFd.fd);
+        lastEventMs_[static_cast<size_t>(resources[i])] = steadyTimeMs();
+        if (callback_ != nullptr) {
+          callback_(resources[i]);
+        }
+      }
+    }
+  }
+}
+
+bool PressureMonitor::underPressure(PressureResource resource) const {
+  const auto lastEventMs = lastEventMs_[static_cast<size_t>(resource)].load();
+  return lastEventMs != 0 && steadyTimeMs() - lastEventMs < config_.holdMs;
+}
+
+std::vector<PressureResource> PressureMonitor::stalledResources() const {
+  std::vector<PressureResource> resources;
+  for (size_t i = 0; i < kNumResources; ++i) {
+    const auto resource = static_cast<PressureResource>(i);
+    if (underPressure(resource)) {
+      resources.push_back(resource);
+    }
+  }
+  return resources;
+}
+
+} // namespace facebook::presto
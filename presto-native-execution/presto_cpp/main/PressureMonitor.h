@@ -0,0 +1,121 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace facebook::presto {
+
+/// Resources for which the kernel reports pressure stall information (PSI).
+enum class PressureResource { kCpu = 0, kMemory = 1, kIo = 2 };
+
+std::string_view pressureResourceName(PressureResource resource);
+
+/// Watches cgroup v2 'cpu.pressure', 'memory.pressure' and 'io.pressure' using
+/// PSI triggers. A trigger is registered by writing "some <stall us> <window
+/// us>" to the pressure file, after which the kernel wakes up poll() with
+/// POLLPRI as soon as the stall time within the window crosses the threshold.
+/// This lets the worker react to resource contention within milliseconds
+/// instead of waiting for the next periodic sample.
+///
+/// A resource is reported as under pressure for 'Config::holdMs' after the
+/// last trigger event. Requires Linux 5.2+ with PSI enabled. Unprivileged
+/// processes can only create triggers with windows that are multiples of 2s.
+///
+/// Tests override registerTrigger() and the trigger event hooks to drive the
+/// monitor without PSI. Subclasses must call stop() in their destructor.
+class PressureMonitor {
+ public:
+  struct Config {
+    /// cgroup v2 directory holding the '*.pressure' files.
+    std::string cgroupPath{"/sys/fs/cgroup"};
+
+    /// Stall time in milliseconds within 'windowMs' that fires the trigger for
+    /// each resource. Zero disables monitoring of that resource.
+    uint64_t cpuStallThresholdMs{0};
+    uint64_t memoryStallThresholdMs{0};
+    uint64_t ioStallThresholdMs{0};
+
+    /// PSI tracking window in milliseconds. The kernel accepts 500ms to 10s,
+    /// and only multiples of 2s from unprivileged processes.
+    uint64_t windowMs{2'000};
+
+    /// How long in milliseconds a resource stays under pressure after the last
+    /// trigger event.
+    uint64_t holdMs{5'000};
+  };
+
+  /// Invoked on the monitor thread every time a trigger fires.
+  using Callback = std::function<void(PressureResource)>;
+
+  PressureMonitor(const Config& config, Callback callback);
+
+  virtual ~PressureMonitor();
+
+  /// Registers the triggers and launches the monitor thread. Returns false if
+  /// no trigger could be registered, e.g. PSI is not supported. Should only be
+  /// called once.
+  bool start();
+
+  /// Stops the monitor thread and closes the trigger fds.
+  void stop();
+
+  /// Returns true if 'resource' triggered within the last 'Config::holdMs'.
+  bool underPressure(PressureResource resource) const;
+
+  /// Returns the resources that are under pressure.
+  std::vector<PressureResource> stalledResources() const;
+
+ protected:
+  std::string pressureFilePath(PressureResource resource) const;
+
+  /// Opens the pressure file of 'resource' and registers a trigger on it.
+  /// Returns the fd to poll or -1 on failure.
+  virtual int registerTrigger(PressureResource resource) const;
+
+  /// poll() events that report a trigger on the fds returned by
+  /// registerTrigger().
+  virtual int16_t triggerEvents() const;
+
+  /// Called after poll() reports a trigger on 'fd'. PSI triggers are
+  /// re-armed by poll() itself, so there is nothing to do.
+  virtual void clearTrigger(int /*fd*/) const {}
+
+ private:
+  static constexpr size_t kNumResources = 3;
+
+  uint64_t stallThresholdMs(PressureResource resource) const;
+
+  void run();
+
+  const Config config_;
+  const Callback callback_;
+
+  // Trigger fd per resource, -1 if not monitored.
+  std::array<int, kNumResources> fds_;
+  // Eventfd used to wake up the monitor thread on stop().
+  int stopFd_{-1};
+  // Steady clock time in ms of the last trigger event per resource.
+  std::array<std::atomic<uint64_t>, kNumResources> lastEventMs_;
+  std::thread thread_;
+};
+
+} // namespace facebook::presto
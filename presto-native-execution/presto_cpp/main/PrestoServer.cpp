@@ -15,6 +15,7 @@
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <folly/String.h>
 #include <folly/system/HardwareConcurrency.h>
 #include <glog/logging.h>
 #include <proxygen/lib/http/HTTPHeaders.h>
@@ -22,6 +23,7 @@
 #include "presto_cpp/main/CoordinatorDiscoverer.h"
 #include "presto_cpp/main/PeriodicMemoryChecker.h"
 #include "presto_cpp/main/PeriodicTaskManager.h"
+#include "presto_cpp/main/PressureMonitor.h"
 #include "presto_cpp/main/PrestoToVeloxQueryConfig.h"
 #include "presto_cpp/main/SignalHandler.h"
 #include "presto_cpp/main/TaskResource.h"
@@ -53,6 +55,7 @@
 #include "presto_cpp/main/types/VeloxPlanConversion.h"
 #include "velox/common/base/Counters.h"
 #include "velox/common/base/StatsReporter.h"
+#include "velox/common/base/SuccinctPrinter.h"
 #include "velox/common/caching/CacheTTLController.h"
 #include "velox/common/caching/SsdCache.h"
 #include "velox/common/dynamic_registry/DynamicLibraryLoader.h"
@@ -171,6 +174,18 @@ bool cachePeriodicPersistenceEnabled() {
       std::chrono::seconds::zero();
 }
 
+// Serves the function metadata from the cache of serialized responses. The
+// coordinator polls it while planning, so it is only rebuilt after functions
+// were registered.
+void sendFunctionsMetadata(
+    proxygen::HTTPMessage* message,
+    proxygen::ResponseHandler* downstream,
+    const std::optional<std::string>& catalog) {
+  const auto response = getFunctionsMetadataResponse(catalog);
+  http::sendOkCachedResponse(
+      message, downstream, response->body, response->gzipBody, response->etag);
+}
+
 bool isSharedLibrary(const fs::path& path) {
   std::string pathExt = path.extension().string();
   std::transform(pathExt.begin(), pathExt.end(), pathExt.begin(), ::tolower);
@@ -212,7 +227,8 @@ json::array_t getOptimizedExpressions(
     const proxygen::HTTPHeaders& httpHeaders,
     const std::vector<std::unique_ptr<folly::IOBuf>>& body,
     folly::Executor* executor,
-    velox::memory::MemoryPool* pool) {
+    velox::memory::MemoryPool* pool,
+    expression::ExpressionOptimizationCache* cache) {
   static constexpr char const* kOptimizerLevelHeader =
       "X-Presto-Expression-Optimizer-Level";
   const auto& optimizerLevelString =
@@ -246,6 +262,24 @@ json::array_t getOptimizedExpressions(
   configs.insert(
       {velox::core::QueryConfig::kSessionStartTime, sessionStartTime});
 
+  expression::OptimizationOptions options;
+  options.cache = cache;
+  options.executor = executor;
+  options.batchSize =
+      SystemConfig::instance()->nativeSidecarExpressionBatchSize();
+  if (cache != nullptr) {
+    // Everything the query config is built from may change the result. The
+    // session start time differs for every query and, like the time zone,
+    // only matters to some expressions.
+    std::map<std::string, std::string> sortedConfigs(
+        configs.begin(), configs.end());
+    sortedConfigs.erase(velox::core::QueryConfig::kSessionTimezone);
+    sortedConfigs.erase(velox::core::QueryConfig::kSessionStartTime);
+    options.sessionKey = json(sortedConfigs).dump();
+    options.timeZoneKey = timezone;
+    options.startTimeKey = sessionStartTime;
+  }
+
   auto queryConfig = velox::core::QueryConfig{std::move(configs)};
   auto queryCtx =
       velox::core::QueryCtx::create(executor, std::move(queryConfig));
@@ -254,8 +288,19 @@ json::array_t getOptimizedExpressions(
   for (const auto& expr : request.expressions) {
     expressions.push_back(expr);
   }
+  expression::OptimizationStats stats;
   const auto optimizedList = expression::optimizeExpressions(
-      expressions, optimizerLevel, queryCtx.get(), pool);
+      expressions, optimizerLevel, queryCtx.get(), pool, options, stats);
+  RECORD_METRIC_VALUE(
+      kCounterSidecarNumOptimizedExpressions, stats.numExpressions);
+  RECORD_METRIC_VALUE(kCounterSidecarExpressionCacheHits, stats.numCacheHits);
+  RECORD_HISTOGRAM_METRIC_VALUE(
+      kCounterSidecarOptimizeExpressionsLatencyMs,
+      stats.wallNanos / 1'000'000);
+  VLOG(1) << "Optimized " << stats.numExpressions << " expressions in "
+          << velox::succinctNanos(stats.wallNanos) << ": "
+          << stats.numCacheHits << " cache hits, " << stats.numFailures
+          << " failures, " << stats.numBatches << " batches";
 
   json::array_t result;
   for (const auto& optimized : optimizedList) {
@@ -364,6 +409,7 @@ void PrestoServer::run() {
   if (memoryChecker_ != nullptr) {
     memoryChecker_->start();
   }
+  createPressureMonitor();
 
   // Start everything. After the return from the following call we are shutting
   // down.
@@ -892,6 +938,15 @@ void PrestoServer::shutdownServer() {
 
   PRESTO_SHUTDOWN_LOG(INFO) << "Stopping all periodic tasks";
 
+  PressureMonitor* pressureMonitor;
+  {
+    std::lock_guard<std::mutex> l(overloadMutex_);
+    pressureMonitor = pressureMonitor_.get();
+  }
+  if (pressureMonitor != nullptr) {
+    pressureMonitor->stop();
+    pressureExecutor_->join();
+  }
   if (memoryChecker_ != nullptr) {
     memoryChecker_->stop();
   }
@@ -1347,6 +1402,65 @@ void PrestoServer::createPeriodicMemoryChecker() {
   memoryChecker_ = createMemoryChecker();
 }
 
+void PrestoServer::createPressureMonitor() {
+  auto* systemConfig = SystemConfig::instance();
+  if (!systemConfig->workerPressureMonitorEnabled()) {
+    PRESTO_STARTUP_LOG(INFO) << "Pressure stall monitor is not enabled";
+    return;
+  }
+  PressureMonitor::Config config;
+  config.cgroupPath = systemConfig->workerPressureCgroupPath();
+  config.cpuStallThresholdMs =
+      systemConfig->workerPressureCpuStallThresholdMs();
+  config.memoryStallThresholdMs =
+      systemConfig->workerPressureMemoryStallThresholdMs();
+  config.ioStallThresholdMs = systemConfig->workerPressureIoStallThresholdMs();
+  config.windowMs = systemConfig->workerPressureWindowMs();
+  if (config.windowMs < 500 || config.windowMs > 10'000) {
+    PRESTO_STARTUP_LOG(ERROR)
+        << "Invalid " << SystemConfig::kWorkerPressureWindowMs << " "
+        << config.windowMs
+        << "ms, must be between 500ms and 10s. Pressure stall monitor is "
+        << "disabled";
+    return;
+  }
+  if (config.windowMs % 2'000 != 0) {
+    PRESTO_STARTUP_LOG(WARNING)
+        << SystemConfig::kWorkerPressureWindowMs << " " << config.windowMs
+        << "ms is not a multiple of 2s. Registering the PSI triggers fails "
+        << "unless the worker runs with CAP_SYS_RESOURCE";
+  }
+  // A trigger re-evaluates the overloaded state right away, after which the
+  // overload cooldown applies as for the other signals. Holding the resource
+  // any longer than the window would delay recovery beyond the cooldown.
+  config.holdMs = config.windowMs;
+  // Pushback and the overload check can take a while. They run on their own
+  // thread so that the monitor thread keeps polling the triggers.
+  pressureExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+      1, std::make_shared<folly::NamedThreadFactory>("PressureHandler"));
+  auto pressureMonitor = std::make_unique<PressureMonitor>(
+      config, [this](PressureResource resource) {
+        pressureExecutor_->add([this, resource]() {
+          if (resource == PressureResource::kMemory &&
+              memoryChecker_ != nullptr) {
+            memoryChecker_->onMemoryPressure();
+          }
+          checkOverload();
+        });
+      });
+  if (!pressureMonitor->start()) {
+    PRESTO_STARTUP_LOG(WARNING)
+        << "Unable to register any PSI trigger under " << config.cgroupPath
+        << ", pressure stall monitor is disabled";
+    pressureExecutor_.reset();
+    return;
+  }
+  // checkOverload() reads the monitor under 'overloadMutex_'. It is only
+  // published once started and never reset before shutdown.
+  std::lock_guard<std::mutex> l(overloadMutex_);
+  pressureMonitor_ = std::move(pressureMonitor);
+}
+
 std::shared_ptr<velox::exec::TaskListener> PrestoServer::getTaskListener() {
   return nullptr;
 }
@@ -1548,6 +1662,7 @@ void PrestoServer::registerRemoteFunctions() {
       const auto serdeName = systemConfig->remoteFunctionServerSerde();
       size_t registeredCount = presto::registerRemoteFunctions(
           *dirPath, *remoteLocation, catalogName, serdeName);
+      invalidateFunctionsMetadata();
 
       PRESTO_STARTUP_LOG(INFO)
           << registeredCount << " remote functions registered in the '"
@@ -1706,6 +1821,7 @@ void PrestoServer::populateMemAndCPUInfo() {
 }
 
 void PrestoServer::checkOverload() {
+  std::lock_guard<std::mutex> l(overloadMutex_);
   auto systemConfig = SystemConfig::instance();
 
   const auto overloadedThresholdMemBytes =
@@ -1769,16 +1885,33 @@ void PrestoServer::checkOverload() {
     cpuOverloaded_ = cpuOverloaded;
   }
 
-  // Determine if the server is overloaded. We require both memory and CPU to be
-  // not overloaded for some time (continuous period) to consider the server as
-  // not overloaded.
+  if (pressureMonitor_ != nullptr) {
+    std::vector<std::string_view> stalledResources;
+    for (auto resource : pressureMonitor_->stalledResources()) {
+      stalledResources.push_back(pressureResourceName(resource));
+    }
+    const bool pressureOverloaded = !stalledResources.empty();
+    if (pressureOverloaded && !pressureOverloaded_) {
+      LOG(WARNING) << "OVERLOAD: Server is stalled on "
+                   << folly::join(", ", stalledResources);
+    } else if (!pressureOverloaded && pressureOverloaded_) {
+      LOG(INFO) << "OVERLOAD: Server is no longer stalled on any resource";
+    }
+    RECORD_METRIC_VALUE(
+        kCounterOverloadedPressure, pressureOverloaded ? 100 : 0);
+    pressureOverloaded_ = pressureOverloaded;
+  }
+
+  // Determine if the server is overloaded. We require memory, CPU and resource
+  // pressure to be not overloaded for some time (continuous period) to
+  // consider the server as not overloaded.
   const uint64_t currentTimeSecs = velox::getCurrentTimeSec();
-  if (memOverloaded_ || cpuOverloaded_) {
+  if (memOverloaded_ || cpuOverloaded_ || pressureOverloaded_) {
     lastOverloadedTimeInSecs_ = currentTimeSecs;
   }
   VELOX_CHECK_GE(currentTimeSecs, lastOverloadedTimeInSecs_);
   const bool serverOverloaded =
-      ((cpuOverloaded_ || memOverloaded_) ||
+      ((cpuOverloaded_ || memOverloaded_ || pressureOverloaded_) ||
        ((currentTimeSecs - lastOverloadedTimeInSecs_) <
         systemConfig->workerOverloadedCooldownPeriodSec()));
 
@@ -1855,6 +1988,11 @@ void PrestoServer::handleGracefulShutdown(
 
 void PrestoServer::registerSidecarEndpoints() {
   VELOX_CHECK(httpServer_);
+  if (const auto maxBytes =
+          SystemConfig::instance()->nativeSidecarExpressionCacheMaxBytes()) {
+    expressionOptimizationCache_ =
+        std::make_unique<expression::ExpressionOptimizationCache>(maxBytes);
+  }
   httpServer_->registerGet(
       "/v1/properties/session",
       [this](
@@ -1866,10 +2004,10 @@ void PrestoServer::registerSidecarEndpoints() {
       });
   httpServer_->registerGet(
       "/v1/functions",
-      [](proxygen::HTTPMessage* /*message*/,
+      [](proxygen::HTTPMessage* message,
          const std::vector<std::unique_ptr<folly::IOBuf>>& /*body*/,
          proxygen::ResponseHandler* downstream) {
-        http::sendOkResponse(downstream, getFunctionsMetadata());
+        sendFunctionsMetadata(message, downstream, std::nullopt);
       });
   httpServer_->registerGet(
       R"(/v1/functions/([^/]+))",
@@ -1877,10 +2015,10 @@ void PrestoServer::registerSidecarEndpoints() {
          const std::vector<std::string>& pathMatch) {
         return new http::CallbackRequestHandler(
             [catalog = pathMatch[1]](
-                proxygen::HTTPMessage* /*message*/,
+                proxygen::HTTPMessage* message,
                 std::vector<std::unique_ptr<folly::IOBuf>>& /*body*/,
                 proxygen::ResponseHandler* downstream) {
-              http::sendOkResponse(downstream, getFunctionsMetadata(catalog));
+              sendFunctionsMetadata(message, downstream, catalog);
             });
       });
   httpServer_->registerPost(
@@ -1891,7 +2029,11 @@ void PrestoServer::registerSidecarEndpoints() {
           proxygen::ResponseHandler* downstream) {
         const auto& httpHeaders = message->getHeaders();
         const auto result = getOptimizedExpressions(
-            httpHeaders, body, driverExecutor_.get(), nativeWorkerPool_.get());
+            httpHeaders,
+            body,
+            driverExecutor_.get(),
+            nativeWorkerPool_.get(),
+            expressionOptimizationCache_.get());
         http::sendOkResponse(downstream, result);
       });
 
@@ -1963,6 +2105,7 @@ void PrestoServer::registerDynamicFunctions() {
         velox::loadDynamicLibrary(dirEntry.path().c_str());
       }
     }
+    invalidateFunctionsMetadata();
   } else {
     PRESTO_STARTUP_LOG(INFO)
         << "Plugin directory path: " << pluginDir << " is invalid.";
@@ -2025,7 +2168,8 @@ void PrestoServer::registerTraceNodeFactories() {
               partitionAndSerializeNode->isReplicateNullsAndAny(),
               partitionAndSerializeNode->partitionFunctionFactory(),
               partitionAndSerializeNode->sortingOrders(),
-              partitionAndSerializeNode->sortingKeys());
+              partitionAndSerializeNode->sortingKeys(),
+              partitionAndSerializeNode->skewSplit());
         }
         return nullptr;
       });
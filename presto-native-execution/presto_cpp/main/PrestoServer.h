@@ -25,6 +25,7 @@
 #include "presto_cpp/main/PeriodicHeartbeatManager.h"
 #include "presto_cpp/main/PrestoExchangeSource.h"
 #include "presto_cpp/main/PrestoServerOperations.h"
+#include "presto_cpp/main/types/ExpressionOptimizer.h"
 #include "presto_cpp/main/types/VeloxPlanValidator.h"
 #include "velox/common/caching/AsyncDataCache.h"
 #include "velox/common/memory/MemoryAllocator.h"
@@ -68,6 +69,7 @@ class SignalHandler;
 class TaskManager;
 class TaskResource;
 class PeriodicMemoryChecker;
+class PressureMonitor;
 class PeriodicTaskManager;
 class SystemConfig;
 
@@ -268,6 +270,13 @@ class PrestoServer {
 
   std::unique_ptr<velox::cache::SsdCache> setupSsdCache();
 
+  /// Starts the PSI pressure monitor if enabled. Trigger events re-evaluate
+  /// the overloaded state immediately and memory events start the memory
+  /// pushback.
+  void createPressureMonitor();
+
+  /// Re-evaluates the overloaded state. Called periodically and from the
+  /// pressure monitor thread.
   void checkOverload();
 
   virtual void createTaskManager();
@@ -329,6 +338,10 @@ class PrestoServer {
   std::unique_ptr<PeriodicHeartbeatManager> heartbeatManager_;
   std::shared_ptr<velox::memory::MemoryPool> pool_;
   std::shared_ptr<velox::memory::MemoryPool> nativeWorkerPool_;
+  // Results of /v1/expressions shared across requests. Null if the sidecar
+  // expression cache is disabled.
+  std::unique_ptr<expression::ExpressionOptimizationCache>
+      expressionOptimizationCache_;
   std::unique_ptr<TaskManager> taskManager_;
   std::unique_ptr<TaskResource> taskResource_;
   std::atomic<NodeState> nodeState_{NodeState::kActive};
@@ -337,16 +350,25 @@ class PrestoServer {
   std::unique_ptr<PeriodicTaskManager> periodicTaskManager_;
   std::unique_ptr<PrestoServerOperations> prestoServerOperations_;
   std::unique_ptr<PeriodicMemoryChecker> memoryChecker_;
+  // Runs the pressure monitor callbacks. Set with 'pressureMonitor_'.
+  std::unique_ptr<folly::CPUThreadPoolExecutor> pressureExecutor_;
+  // Guarded by 'overloadMutex_'.
+  std::unique_ptr<PressureMonitor> pressureMonitor_;
 
   // Last known memory overloaded status.
   bool memOverloaded_{false};
   // Last known CPU overloaded status.
   bool cpuOverloaded_{false};
+  // Last known cgroup pressure stall overloaded status.
+  bool pressureOverloaded_{false};
   // Current worker overloaded status. It can still be true when memory and CPU
   // overloaded flags are not due to cooldown period.
   bool serverOverloaded_{false};
   // Last time point (in seconds) when the worker was overloaded.
   uint64_t lastOverloadedTimeInSecs_{0};
+  // Serializes checkOverload() between the periodic task and the pressure
+  // monitor thread.
+  std::mutex overloadMutex_;
 
   // We update these members asynchronously and return in http requests w/o
   // delay.
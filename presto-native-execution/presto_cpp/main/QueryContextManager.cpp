@@ -13,11 +13,13 @@
  */
 
 #include "presto_cpp/main/QueryContextManager.h"
+#include <folly/ScopeGuard.h>
 #include <folly/executors/IOThreadPoolExecutor.h>
 #include "presto_cpp/main/PrestoToVeloxQueryConfig.h"
 #include "presto_cpp/main/common/Configs.h"
 #include "presto_cpp/main/properties/session/SessionProperties.h"
 #include "velox/connectors/hive/HiveConfig.h"
+#include "velox/common/time/Timer.h"
 #include "velox/core/QueryConfig.h"
 
 using namespace facebook::velox;
@@ -40,36 +42,43 @@ std::shared_ptr<velox::core::QueryCtx> QueryContextCache::get(
   if (iter == queryCtxs_.end()) {
     return nullptr;
   }
-
-  queryIds_.erase(iter->second.idListIterator);
-
-  if (auto queryCtx = iter->second.queryCtx.lock()) {
-    // Move the queryId to front, if queryCtx is still alive.
-    queryIds_.push_front(queryId);
-    iter->second.idListIterator = queryIds_.begin();
+  auto value = iter->second;
+  if (auto queryCtx = value->queryCtx.lock()) {
     return queryCtx;
   }
-  queryCtxs_.erase(iter);
+  // The query context has been released. Only erase the entry we looked at,
+  // a concurrent insert may have replaced it already.
+  queryCtxs_.erase_if_equal(queryId, value);
   return nullptr;
 }
 
 std::shared_ptr<velox::core::QueryCtx> QueryContextCache::insert(
     const protocol::QueryId& queryId,
     std::shared_ptr<velox::core::QueryCtx> queryCtx) {
-  if (queryCtxs_.size() >= capacity_) {
-    evict();
+  maybeEvict();
+  auto value =
+      std::make_shared<QueryCtxCacheValue>(folly::to_weak_ptr(queryCtx));
+  for (;;) {
+    auto [iter, inserted] = queryCtxs_.insert(queryId, value);
+    if (inserted) {
+      return queryCtx;
+    }
+    auto existing = iter->second;
+    if (auto existingQueryCtx = existing->queryCtx.lock()) {
+      return existingQueryCtx;
+    }
+    if (queryCtxs_.assign_if_equal(queryId, existing, value).has_value()) {
+      return queryCtx;
+    }
+    // Lost a race with another insert or erase. Retry.
   }
-  queryIds_.push_front(queryId);
-  queryCtxs_[queryId] = {
-      folly::to_weak_ptr(queryCtx), queryIds_.begin(), false};
-  return queryCtx;
 }
 
 bool QueryContextCache::hasStartedTasks(
     const protocol::QueryId& queryId) const {
   auto iter = queryCtxs_.find(queryId);
   if (iter != queryCtxs_.end()) {
-    return iter->second.hasStartedTasks;
+    return iter->second->hasStartedTasks;
   }
   return false;
 }
@@ -77,23 +86,32 @@ bool QueryContextCache::hasStartedTasks(
 void QueryContextCache::setTasksStarted(const protocol::QueryId& queryId) {
   auto iter = queryCtxs_.find(queryId);
   if (iter != queryCtxs_.end()) {
-    iter->second.hasStartedTasks = true;
+    iter->second->hasStartedTasks = true;
+  }
+}
+
+void QueryContextCache::maybeEvict() {
+  const auto nowMs = getCurrentTimeMs();
+  auto lastSweepTimeMs = lastSweepTimeMs_.load();
+  if (nowMs < lastSweepTimeMs + sweepInterval_.count()) {
+    return;
+  }
+  // Only one of the concurrent inserts sweeps.
+  if (lastSweepTimeMs_.compare_exchange_strong(lastSweepTimeMs, nowMs)) {
+    evict();
   }
 }
 
 void QueryContextCache::evict() {
-  // Evict least recently used queryCtx if it is not referenced elsewhere.
-  for (auto victim = queryIds_.end(); victim != queryIds_.begin();) {
-    --victim;
-    if (!queryCtxs_[*victim].queryCtx.lock()) {
-      queryCtxs_.erase(*victim);
-      queryIds_.erase(victim);
-      return;
+  for (auto iter = queryCtxs_.cbegin(); iter != queryCtxs_.cend(); ++iter) {
+    if (iter->second->queryCtx.expired()) {
+      queryCtxs_.erase_if_equal(iter->first, iter->second);
     }
   }
+}
 
-  // All queries are still inflight. Increase capacity.
-  capacity_ = std::max(kInitialCapacity, capacity_ * 2);
+void QueryContextCache::clear() {
+  queryCtxs_.clear();
 }
 
 QueryContextManager::QueryContextManager(
@@ -101,28 +119,67 @@ QueryContextManager::QueryContextManager(
     folly::Executor* spillerExecutor)
     : driverExecutor_(driverExecutor), spillerExecutor_(spillerExecutor) {}
 
+folly::SemiFuture<std::shared_ptr<velox::core::QueryCtx>>
+QueryContextManager::findOrCreateQueryCtxAsync(
+    const protocol::TaskId& taskId,
+    const protocol::TaskUpdateRequest& taskUpdateRequest) {
+  const QueryId queryId{queryIdFromTaskId(taskId)};
+  if (auto queryCtx = queryContextCache_.get(queryId)) {
+    return folly::makeSemiFuture(std::move(queryCtx));
+  }
+
+  // The first task of the query creates the query context. Other tasks of the
+  // same query that arrive meanwhile get a future for it.
+  std::shared_ptr<folly::SharedPromise<std::shared_ptr<core::QueryCtx>>>
+      pending;
+  bool creator{false};
+  {
+    auto pendingQueryCtxs = pendingQueryCtxs_.wlock();
+    auto& promise = (*pendingQueryCtxs)[queryId];
+    if (promise == nullptr) {
+      promise = std::make_shared<
+          folly::SharedPromise<std::shared_ptr<core::QueryCtx>>>();
+      creator = true;
+    }
+    pending = promise;
+  }
+  if (!creator) {
+    return pending->getSemiFuture();
+  }
+
+  SCOPE_EXIT {
+    pendingQueryCtxs_.wlock()->erase(queryId);
+  };
+  try {
+    // Re-check: the query context may have been created between the lookup
+    // and the registration of the pending creation.
+    auto queryCtx = queryContextCache_.get(queryId);
+    if (queryCtx == nullptr) {
+      queryCtx = createQueryCtx(queryId, taskUpdateRequest);
+    }
+    pending->setValue(queryCtx);
+    return folly::makeSemiFuture(std::move(queryCtx));
+  } catch (const std::exception&) {
+    folly::exception_wrapper error(std::current_exception());
+    pending->setException(error);
+    return folly::makeSemiFuture<std::shared_ptr<core::QueryCtx>>(
+        std::move(error));
+  }
+}
+
 std::shared_ptr<velox::core::QueryCtx>
 QueryContextManager::findOrCreateQueryCtx(
     const protocol::TaskId& taskId,
     const protocol::TaskUpdateRequest& taskUpdateRequest) {
-  std::lock_guard<std::mutex> lock(queryContextCacheMutex_);
-  return findOrCreateQueryCtxLocked(
-      taskId,
-      toVeloxConfigs(
-          taskUpdateRequest.session, taskUpdateRequest.extraCredentials),
-      toConnectorConfigs(taskUpdateRequest));
+  return findOrCreateQueryCtxAsync(taskId, taskUpdateRequest).get();
 }
 
 std::shared_ptr<velox::core::QueryCtx>
 QueryContextManager::findOrCreateBatchQueryCtx(
     const protocol::TaskId& taskId,
     const protocol::TaskUpdateRequest& taskUpdateRequest) {
-  std::lock_guard<std::mutex> lock(queryContextCacheMutex_);
-  auto queryCtx = findOrCreateQueryCtxLocked(
-      taskId,
-      toVeloxConfigs(
-          taskUpdateRequest.session, taskUpdateRequest.extraCredentials),
-      toConnectorConfigs(taskUpdateRequest));
+  std::lock_guard<std::mutex> lock(batchQueryCtxMutex_);
+  auto queryCtx = findOrCreateQueryCtx(taskId, taskUpdateRequest);
   if (queryCtx->pool()->aborted()) {
     // In Batch mode, only one query is running at a time. When tasks fail
     // during memory arbitration, the query memory pool will be set
@@ -132,26 +189,21 @@ QueryContextManager::findOrCreateBatchQueryCtx(
     // independent. So if query memory pool is aborted already, a cache clear is
     // performed to allow successive tasks to create a new query context to
     // continue execution.
+    queryContextCache_.evict();
     VELOX_CHECK_EQ(queryContextCache_.size(), 1);
     queryContextCache_.clear();
-    queryCtx = findOrCreateQueryCtxLocked(
-        taskId,
-        toVeloxConfigs(
-            taskUpdateRequest.session, taskUpdateRequest.extraCredentials),
-        toConnectorConfigs(taskUpdateRequest));
+    queryCtx = findOrCreateQueryCtx(taskId, taskUpdateRequest);
   }
   return queryCtx;
 }
 
 bool QueryContextManager::queryHasStartedTasks(
     const protocol::TaskId& taskId) const {
-  std::lock_guard<std::mutex> lock(queryContextCacheMutex_);
   return queryContextCache_.hasStartedTasks(queryIdFromTaskId(taskId));
 }
 
 void QueryContextManager::setQueryHasStartedTasks(
     const protocol::TaskId& taskId) {
-  std::lock_guard<std::mutex> lock(queryContextCacheMutex_);
   queryContextCache_.setTasksStarted(queryIdFromTaskId(taskId));
 }
 
@@ -173,16 +225,11 @@ QueryContextManager::createAndCacheQueryCtxLocked(
   return queryContextCache_.insert(queryId, std::move(queryCtx));
 }
 
-std::shared_ptr<core::QueryCtx> QueryContextManager::findOrCreateQueryCtxLocked(
-    const TaskId& taskId,
-    velox::core::QueryConfig&& queryConfig,
-    std::unordered_map<std::string, std::shared_ptr<config::ConfigBase>>&&
-        connectorConfigs) {
-  const QueryId queryId{queryIdFromTaskId(taskId)};
-
-  if (auto queryCtx = queryContextCache_.get(queryId)) {
-    return queryCtx;
-  }
+std::shared_ptr<core::QueryCtx> QueryContextManager::createQueryCtx(
+    const QueryId& queryId,
+    const protocol::TaskUpdateRequest& taskUpdateRequest) {
+  auto queryConfig = toVeloxConfigs(
+      taskUpdateRequest.session, taskUpdateRequest.extraCredentials);
 
   // NOTE: the monotonically increasing 'poolId' is appended to 'queryId' to
   // ensure that the name of root memory pool instance is always unique. In some
@@ -208,7 +255,7 @@ std::shared_ptr<core::QueryCtx> QueryContextManager::findOrCreateQueryCtxLocked(
   return createAndCacheQueryCtxLocked(
       queryId,
       std::move(queryConfig),
-      std::move(connectorConfigs),
+      toConnectorConfigs(taskUpdateRequest),
       std::move(pool));
 }
 
@@ -216,22 +263,15 @@ void QueryContextManager::visitAllContexts(
     const std::function<
         void(const protocol::QueryId&, const velox::core::QueryCtx*)>& visitor)
     const {
-  std::lock_guard<std::mutex> lock(queryContextCacheMutex_);
   for (const auto& it : queryContextCache_.ctxMap()) {
-    if (const auto queryCtxSP = it.second.queryCtx.lock()) {
+    if (const auto queryCtxSP = it.second->queryCtx.lock()) {
       visitor(it.first, queryCtxSP.get());
     }
   }
 }
 
 void QueryContextManager::clearCache() {
-  std::lock_guard<std::mutex> lock(queryContextCacheMutex_);
   queryContextCache_.clear();
 }
 
-void QueryContextCache::clear() {
-  queryCtxs_.clear();
-  queryIds_.clear();
-}
-
 } // namespace facebook::presto
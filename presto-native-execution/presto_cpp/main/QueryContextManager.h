@@ -14,8 +14,11 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <folly/concurrency/ConcurrentHashMap.h>
+#include <folly/container/F14Map.h>
 #include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/futures/SharedPromise.h>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -24,23 +27,30 @@
 #include "velox/core/QueryCtx.h"
 
 namespace facebook::presto {
+/// Concurrent registry of query contexts indexed by query id. Lookups are
+/// lock-free. Entries only hold weak references: an entry is dropped as soon
+/// as a lookup finds its query context released, and entries that are never
+/// looked up again are swept at most once per 'sweepInterval'.
 class QueryContextCache {
  public:
   using QueryCtxWeakPtr = std::weak_ptr<velox::core::QueryCtx>;
-  using QueryIdList = std::list<protocol::QueryId>;
   struct QueryCtxCacheValue {
-    QueryCtxWeakPtr queryCtx;
-    QueryIdList::iterator idListIterator;
-    bool hasStartedTasks{false};
+    explicit QueryCtxCacheValue(QueryCtxWeakPtr _queryCtx)
+        : queryCtx(std::move(_queryCtx)) {}
+
+    const QueryCtxWeakPtr queryCtx;
+    std::atomic_bool hasStartedTasks{false};
   };
-  using QueryCtxMap = std::unordered_map<protocol::QueryId, QueryCtxCacheValue>;
+  using QueryCtxMap = folly::ConcurrentHashMap<
+      protocol::QueryId,
+      std::shared_ptr<QueryCtxCacheValue>>;
 
-  QueryContextCache(size_t initial_capacity = kInitialCapacity)
-      : capacity_(initial_capacity) {}
+  explicit QueryContextCache(
+      std::chrono::milliseconds sweepInterval = kDefaultSweepInterval)
+      : sweepInterval_(sweepInterval) {}
 
-  size_t capacity() const {
-    return capacity_;
-  }
+  /// Returns the number of entries, including those whose query context was
+  /// released but not yet swept.
   size_t size() const {
     return queryCtxs_.size();
   }
@@ -51,6 +61,8 @@ class QueryContextCache {
 
   std::shared_ptr<velox::core::QueryCtx> get(const protocol::QueryId& queryId);
 
+  /// Inserts 'queryCtx' unless a live query context is already cached for
+  /// 'queryId'. Returns the cached query context.
   std::shared_ptr<velox::core::QueryCtx> insert(
       const protocol::QueryId& queryId,
       std::shared_ptr<velox::core::QueryCtx> queryCtx);
@@ -59,17 +71,21 @@ class QueryContextCache {
 
   void setTasksStarted(const protocol::QueryId& queryId);
 
+  /// Removes the entries whose query context has been released.
   void evict();
 
   void clear();
 
  private:
-  static constexpr size_t kInitialCapacity = 256UL;
+  static constexpr std::chrono::milliseconds kDefaultSweepInterval{10'000};
 
-  size_t capacity_;
+  // Calls evict() if the last sweep is more than 'sweepInterval_' ago.
+  void maybeEvict();
+
+  const std::chrono::milliseconds sweepInterval_;
+  std::atomic<uint64_t> lastSweepTimeMs_{0};
 
   QueryCtxMap queryCtxs_;
-  QueryIdList queryIds_;
 };
 
 class QueryContextManager {
@@ -80,6 +96,17 @@ class QueryContextManager {
 
   virtual ~QueryContextManager() = default;
 
+  /// Returns the query context of the task's query, creating it on the first
+  /// task of the query. Lookups of existing query contexts do not take locks.
+  /// If another task of the same query is creating the query context, returns
+  /// a future that is fulfilled once it is created, so the caller does not
+  /// block a thread on it. Otherwise the returned future is ready.
+  folly::SemiFuture<std::shared_ptr<velox::core::QueryCtx>>
+  findOrCreateQueryCtxAsync(
+      const protocol::TaskId& taskId,
+      const protocol::TaskUpdateRequest& taskUpdateRequest);
+
+  /// Blocking version of findOrCreateQueryCtxAsync().
   std::shared_ptr<velox::core::QueryCtx> findOrCreateQueryCtx(
       const protocol::TaskId& taskId,
       const protocol::TaskUpdateRequest& taskUpdateRequest);
@@ -117,14 +144,19 @@ class QueryContextManager {
           std::shared_ptr<velox::config::ConfigBase>>&& connectorConfigs,
       std::shared_ptr<velox::memory::MemoryPool>&& pool);
 
-  std::shared_ptr<velox::core::QueryCtx> findOrCreateQueryCtxLocked(
-      const protocol::TaskId& taskId,
-      velox::core::QueryConfig&& queryConfig,
-      std::unordered_map<
-          std::string,
-          std::shared_ptr<velox::config::ConfigBase>>&& connectorConfigStrings);
+  std::shared_ptr<velox::core::QueryCtx> createQueryCtx(
+      const protocol::QueryId& queryId,
+      const protocol::TaskUpdateRequest& taskUpdateRequest);
+
+  // Query contexts that are being created, keyed by query id.
+  folly::Synchronized<folly::F14FastMap<
+      protocol::QueryId,
+      std::shared_ptr<
+          folly::SharedPromise<std::shared_ptr<velox::core::QueryCtx>>>>>
+      pendingQueryCtxs_;
 
-  mutable std::mutex queryContextCacheMutex_;
+  // Serializes batch query context creation, which may reset the cache.
+  std::mutex batchQueryCtxMutex_;
 };
 
 } // namespace facebook::presto
@@ -652,67 +652,58 @@ std::unique_ptr<TaskInfo> TaskManager::createOrUpdateTaskImpl(
       VLOG(1) << "Failed to update output buffers for task: " << taskId;
     }
 
-    folly::F14FastMap<protocol::PlanNodeId, protocol::TaskSource> sourcesMap;
+    // Groups the sources by plan node without copying their splits. An update
+    // may carry several sources for the same plan node.
+    folly::F14FastMap<
+        protocol::PlanNodeId,
+        std::vector<const protocol::TaskSource*>>
+        sourcesMap;
     for (const auto& source : sources) {
-      auto it = sourcesMap.find(source.planNodeId);
-      if (it == sourcesMap.end()) {
-        // No existing source with same planNodeId, add as new
-        sourcesMap.emplace(source.planNodeId, source);
-        continue;
-      }
-
-      // Merge with existing source that has the same planNodeId
-      auto& merged = it->second;
-
-      // Merge splits
-      merged.splits.insert(
-          merged.splits.end(), source.splits.begin(), source.splits.end());
-
-      // Merge noMoreSplitsForLifespan
-      merged.noMoreSplitsForLifespan.insert(
-          merged.noMoreSplitsForLifespan.end(),
-          source.noMoreSplitsForLifespan.begin(),
-          source.noMoreSplitsForLifespan.end());
-
-      // Use OR logic for noMoreSplits flag
-      merged.noMoreSplits = merged.noMoreSplits || source.noMoreSplits;
+      sourcesMap[source.planNodeId].push_back(&source);
     }
 
-    for (const auto& [_, source] : sourcesMap) {
-      // Add all splits from the source to the task.
-      VLOG(1) << "Adding " << source.splits.size() << " splits to " << taskId
-              << " for node " << source.planNodeId;
+    for (const auto& [planNodeId, planNodeSources] : sourcesMap) {
       // Keep track of the max sequence for this batch of splits.
       int64_t maxSplitSequenceId{-1};
-      for (const auto& protocolSplit : source.splits) {
-        auto split = toVeloxSplit(protocolSplit);
-        if (split.hasConnectorSplit()) {
-          maxSplitSequenceId =
-              std::max(maxSplitSequenceId, protocolSplit.sequenceId);
-          execTask->addSplitWithSequence(
-              source.planNodeId, std::move(split), protocolSplit.sequenceId);
+      // Use OR logic for noMoreSplits flag
+      bool noMoreSplits{false};
+      for (const auto* source : planNodeSources) {
+        // Add all splits from the source to the task.
+        VLOG(1) << "Adding " << source->splits.size() << " splits to "
+                << taskId << " for node " << planNodeId;
+        for (const auto& protocolSplit : source->splits) {
+          auto split = toVeloxSplit(protocolSplit);
+          if (split.hasConnectorSplit()) {
+            maxSplitSequenceId =
+                std::max(maxSplitSequenceId, protocolSplit.sequenceId);
+            execTask->addSplitWithSequence(
+                planNodeId, std::move(split), protocolSplit.sequenceId);
+          }
         }
+        noMoreSplits = noMoreSplits || source->noMoreSplits;
       }
       // Update task's max split sequence id after all splits have been added.
-      execTask->setMaxSplitSequenceId(source.planNodeId, maxSplitSequenceId);
-
-      for (const auto& lifespan : source.noMoreSplitsForLifespan) {
-        if (lifespan.isgroup) {
-          LOG(INFO) << "No more splits for group " << lifespan.groupid
-                    << " for " << taskId << " for node " << source.planNodeId;
-          execTask->noMoreSplitsForGroup(source.planNodeId, lifespan.groupid);
+      execTask->setMaxSplitSequenceId(planNodeId, maxSplitSequenceId);
+
+      for (const auto* source : planNodeSources) {
+        for (const auto& lifespan : source->noMoreSplitsForLifespan) {
+          if (lifespan.isgroup) {
+            LOG(INFO) << "No more splits for group " << lifespan.groupid
+                      << " for " << taskId << " for node " << planNodeId;
+            execTask->noMoreSplitsForGroup(planNodeId, lifespan.groupid);
+          }
         }
       }
 
-      if (source.noMoreSplits) {
+      if (noMoreSplits) {
         LOG(INFO) << "No more splits for " << taskId << " for node "
-                  << source.planNodeId;
+                  << planNodeId;
         // If the task has not been started yet, we collect the plan node to
         // call 'no more splits' after the start.
         if (prestoTask->taskStarted) {
-          execTask->noMoreSplits(source.planNodeId);
+          execTask->noMoreSplits(planNodeId);
         } else {
-          prestoTask->delayedNoMoreSplitsPlanNodes_.emplace(source.planNodeId);
+          prestoTask->delayedNoMoreSplitsPlanNodes_.emplace(planNodeId);
         }
       }
     }
@@ -108,8 +108,80 @@ proxygen::RequestHandler* executeAndRespond(
                 });
       });
 }
+
+// Returns true if the JSON task update request in 'requestBody' may carry a
+// plan fragment, without parsing it. Quotes inside string values are escaped,
+// so an unescaped "fragment": is a key. A key of that name nested in another
+// object only costs a full decode.
+bool mayHavePlanFragment(std::string_view requestBody) {
+  static constexpr std::string_view kFragmentKey{"\"fragment\":"};
+  for (auto pos = requestBody.find(kFragmentKey);
+       pos != std::string_view::npos;
+       pos = requestBody.find(kFragmentKey, pos + kFragmentKey.size())) {
+    if (pos > 0 && requestBody[pos - 1] == '\\') {
+      continue;
+    }
+    auto valuePos = requestBody.find_first_not_of(
+        " \t\n\r", pos + kFragmentKey.size());
+    if (valuePos == std::string_view::npos ||
+        requestBody.compare(valuePos, 4, "null") != 0) {
+      return true;
+    }
+  }
+  return false;
+}
 } // namespace
 
+protocol::TaskUpdateRequest decodeTaskUpdateRequest(
+    const std::string& requestBody,
+    bool receiveThrift) {
+  protocol::TaskUpdateRequest updateRequest;
+  if (!receiveThrift) {
+    updateRequest = json::parse(requestBody);
+    return updateRequest;
+  }
+  auto thriftTaskUpdateRequest = std::make_shared<thrift::TaskUpdateRequest>();
+  thriftRead(requestBody, thriftTaskUpdateRequest);
+  std::shared_ptr<std::string> fragment;
+  if (thriftTaskUpdateRequest->fragment_ref().has_value()) {
+    fragment = std::make_shared<std::string>(
+        std::move(*thriftTaskUpdateRequest->fragment_ref()));
+    thriftTaskUpdateRequest->fragment_ref().reset();
+  }
+  fromThrift(*thriftTaskUpdateRequest, updateRequest);
+  updateRequest.fragment = std::move(fragment);
+  return updateRequest;
+}
+
+std::optional<protocol::TaskUpdateRequest> decodeSplitUpdateRequest(
+    const std::string& requestBody) {
+  if (mayHavePlanFragment(requestBody)) {
+    return std::nullopt;
+  }
+  const auto body = json::parse(
+      requestBody,
+      [&](int depth, json::parse_event_t event, json& parsed) {
+        if (depth == 1 && event == json::parse_event_t::key) {
+          const auto& key = parsed.get_ref<const std::string&>();
+          return key == "sources" || key == "outputIds";
+        }
+        return true;
+      });
+  protocol::TaskUpdateRequest updateRequest;
+  body.at("sources").get_to(updateRequest.sources);
+  body.at("outputIds").get_to(updateRequest.outputIds);
+  return updateRequest;
+}
+
+protocol::PlanFragment decodePlanFragment(
+    const std::string& fragment,
+    bool receiveThrift) {
+  protocol::PlanFragment prestoPlan = receiveThrift
+      ? json::parse(fragment)
+      : json::parse(velox::encoding::Base64::decode(fragment));
+  return prestoPlan;
+}
+
 void TaskResource::registerUris(http::HttpServer& server) {
   server.registerDelete(
       R"(/v1/task/(.+)/results/(.+))",
@@ -209,7 +281,7 @@ proxygen::RequestHandler* TaskResource::acknowledgeResults(
 proxygen::RequestHandler* TaskResource::createOrUpdateTaskImpl(
     proxygen::HTTPMessage* message,
     const std::vector<std::string>& pathMatch,
-    const std::function<std::unique_ptr<protocol::TaskInfo>(
+    const std::function<folly::Future<std::unique_ptr<protocol::TaskInfo>>(
         const protocol::TaskId& taskId,
         const std::string& requestBody,
         const bool summarize,
@@ -253,29 +325,28 @@ proxygen::RequestHandler* TaskResource::createOrUpdateTaskImpl(
              receiveThrift]() {
               const auto startProcessCpuTimeNs = util::getProcessCpuTimeNs();
 
-              std::unique_ptr<protocol::TaskInfo> taskInfo;
-              try {
-                taskInfo = createOrUpdateFunc(
-                    taskId,
-                    requestBody,
-                    summarize,
-                    startProcessCpuTimeNs,
-                    receiveThrift);
-              } catch (const velox::VeloxException&) {
-                // Creating an empty task, putting errors inside so that next
-                // status fetch from coordinator will catch the error and well
-                // categorize it.
-                try {
-                  taskInfo = taskManager_.createOrUpdateErrorTask(
-                      taskId,
-                      std::current_exception(),
-                      summarize,
-                      startProcessCpuTimeNs);
-                } catch (const velox::VeloxUserError&) {
-                  throw;
-                }
-              }
-              return taskInfo;
+              return folly::makeFutureWith([&]() {
+                       return createOrUpdateFunc(
+                           taskId,
+                           requestBody,
+                           summarize,
+                           startProcessCpuTimeNs,
+                           receiveThrift);
+                     })
+                  .thenError([this, taskId, summarize, startProcessCpuTimeNs](
+                                 folly::exception_wrapper&& error) {
+                    if (!error.is_compatible_with<velox::VeloxException>()) {
+                      error.throw_exception();
+                    }
+                    // Creating an empty task, putting errors inside so that
+                    // next status fetch from coordinator will catch the error
+                    // and well categorize it.
+                    return taskManager_.createOrUpdateErrorTask(
+                        taskId,
+                        error.to_exception_ptr(),
+                        summarize,
+                        startProcessCpuTimeNs);
+                  });
             })
             .via(
                 folly::getKeepAliveToken(
@@ -312,9 +383,8 @@ proxygen::RequestHandler* TaskResource::createOrUpdateBatchTask(
         auto updateRequest = batchUpdateRequest.taskUpdateRequest;
         VELOX_USER_CHECK_NOT_NULL(updateRequest.fragment);
 
-        auto fragment =
-            velox::encoding::Base64::decode(*updateRequest.fragment);
-        protocol::PlanFragment prestoPlan = json::parse(fragment);
+        auto prestoPlan =
+            decodePlanFragment(*updateRequest.fragment, /*receiveThrift=*/false);
 
         auto serializedShuffleWriteInfo = batchUpdateRequest.shuffleWriteInfo;
         auto broadcastBasePath = batchUpdateRequest.broadcastBasePath;
@@ -342,13 +412,13 @@ proxygen::RequestHandler* TaskResource::createOrUpdateBatchTask(
           velox::core::PlanConsistencyChecker::check(planFragment.planNode);
         }
 
-        return taskManager_.createOrUpdateBatchTask(
+        return folly::makeFuture(taskManager_.createOrUpdateBatchTask(
             taskId,
             batchUpdateRequest,
             planFragment,
             summarize,
             std::move(queryCtx),
-            startProcessCpuTime);
+            startProcessCpuTime));
       });
 }
 
@@ -363,44 +433,56 @@ proxygen::RequestHandler* TaskResource::createOrUpdateTask(
           const bool summarize,
           long startProcessCpuTime,
           bool receiveThrift) {
-        protocol::TaskUpdateRequest updateRequest;
-        if (receiveThrift) {
-          auto thriftTaskUpdateRequest =
-              std::make_shared<thrift::TaskUpdateRequest>();
-          thriftRead(requestBody, thriftTaskUpdateRequest);
-          fromThrift(*thriftTaskUpdateRequest, updateRequest);
-        } else {
-          updateRequest = json::parse(requestBody);
-        }
-        velox::core::PlanFragment planFragment;
-        std::shared_ptr<velox::core::QueryCtx> queryCtx;
-        if (updateRequest.fragment) {
-          protocol::PlanFragment prestoPlan = json::parse(
-              receiveThrift
-                  ? *updateRequest.fragment
-                  : velox::encoding::Base64::decode(*updateRequest.fragment));
-
-          queryCtx =
-              taskManager_.getQueryContextManager()->findOrCreateQueryCtx(
-                  taskId, updateRequest);
-
-          VeloxInteractiveQueryPlanConverter converter(queryCtx.get(), pool_);
-
-          planFragment = converter.toVeloxQueryPlan(
-              prestoPlan, updateRequest.tableWriteInfo, taskId);
-          if (SystemConfig::instance()->planConsistencyCheckEnabled()) {
-            velox::core::PlanConsistencyChecker::check(planFragment.planNode);
-          }
-          planValidator_->validatePlanFragment(planFragment);
+        // Updates after the first one usually only carry new splits. Those
+        // skip decoding the session and the other fields they do not use.
+        auto splitUpdateRequest = receiveThrift
+            ? std::nullopt
+            : decodeSplitUpdateRequest(requestBody);
+        auto updateRequest = splitUpdateRequest.has_value()
+            ? std::move(splitUpdateRequest.value())
+            : decodeTaskUpdateRequest(requestBody, receiveThrift);
+        if (!updateRequest.fragment) {
+          return folly::makeFuture(taskManager_.createOrUpdateTask(
+              taskId,
+              updateRequest,
+              {},
+              summarize,
+              nullptr,
+              startProcessCpuTime));
         }
 
-        return taskManager_.createOrUpdateTask(
-            taskId,
-            updateRequest,
-            planFragment,
-            summarize,
-            std::move(queryCtx),
-            startProcessCpuTime);
+        auto prestoPlan =
+            decodePlanFragment(*updateRequest.fragment, receiveThrift);
+        // If another task of the query is creating the query context, the
+        // plan is converted once it is created without holding this thread.
+        return taskManager_.getQueryContextManager()
+            ->findOrCreateQueryCtxAsync(taskId, updateRequest)
+            .via(folly::getKeepAliveToken(httpSrvCpuExecutor_))
+            .thenValue([this,
+                        taskId,
+                        summarize,
+                        startProcessCpuTime,
+                        updateRequest = std::move(updateRequest),
+                        prestoPlan = std::move(prestoPlan)](
+                           std::shared_ptr<velox::core::QueryCtx> queryCtx) {
+              VeloxInteractiveQueryPlanConverter converter(
+                  queryCtx.get(), pool_);
+              auto planFragment = converter.toVeloxQueryPlan(
+                  prestoPlan, updateRequest.tableWriteInfo, taskId);
+              if (SystemConfig::instance()->planConsistencyCheckEnabled()) {
+                velox::core::PlanConsistencyChecker::check(
+                    planFragment.planNode);
+              }
+              planValidator_->validatePlanFragment(planFragment);
+
+              return taskManager_.createOrUpdateTask(
+                  taskId,
+                  updateRequest,
+                  planFragment,
+                  summarize,
+                  std::move(queryCtx),
+                  startProcessCpuTime);
+            });
       });
 }
 
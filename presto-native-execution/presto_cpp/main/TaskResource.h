@@ -20,6 +20,27 @@
 
 namespace facebook::presto {
 
+/// Decodes the body of a task update request. The plan fragment of a thrift
+/// request, which can be several MB, is moved out of the thrift struct rather
+/// than copied.
+protocol::TaskUpdateRequest decodeTaskUpdateRequest(
+    const std::string& requestBody,
+    bool receiveThrift);
+
+/// Decodes only 'sources' and 'outputIds' of a JSON task update request,
+/// which is all that an update delivering splits to an existing task needs.
+/// The session and the other fields are skipped while parsing. Returns
+/// std::nullopt without parsing if the request carries a plan fragment and
+/// needs the full decode, which is detected by scanning for the key.
+std::optional<protocol::TaskUpdateRequest> decodeSplitUpdateRequest(
+    const std::string& requestBody);
+
+/// Decodes the plan fragment of a task update request. Thrift requests carry
+/// the JSON bytes as is while JSON requests carry them base64 encoded.
+protocol::PlanFragment decodePlanFragment(
+    const std::string& fragment,
+    bool receiveThrift);
+
 class TaskResource {
  public:
   explicit TaskResource(
@@ -72,7 +93,7 @@ class TaskResource {
   proxygen::RequestHandler* createOrUpdateTaskImpl(
       proxygen::HTTPMessage* message,
       const std::vector<std::string>& pathMatch,
-      const std::function<std::unique_ptr<protocol::TaskInfo>(
+      const std::function<folly::Future<std::unique_ptr<protocol::TaskInfo>>(
           const protocol::TaskId&,
           const std::string&,
           const bool,
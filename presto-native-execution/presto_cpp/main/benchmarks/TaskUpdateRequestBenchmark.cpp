@@ -0,0 +1,236 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <folly/Benchmark.h>
+#include <folly/FileUtil.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include "presto_cpp/main/TaskResource.h"
+#include "presto_cpp/main/connectors/HivePrestoToVeloxConnector.h"
+#include "presto_cpp/main/thrift/ProtocolToThrift.h"
+#include "presto_cpp/main/thrift/ThriftIO.h"
+#include "velox/common/encode/Base64.h"
+
+DEFINE_string(
+    fragment_files,
+    "",
+    "Comma separated list of base64 encoded plan fragment JSON files, e.g. "
+    "captured from TPC-DS task update requests. Defaults to the fragment in "
+    "presto_cpp/main/tests/data of the source tree");
+
+namespace {
+// Counts heap allocations so that the decode paths can be compared by the
+// number of allocations they make, not only by latency.
+std::atomic<uint64_t> numAllocations{0};
+} // namespace
+
+void* operator new(size_t size) {
+  numAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+
+namespace facebook::presto {
+namespace {
+
+struct EncodedRequest {
+  std::string name;
+  std::string jsonBody;
+  std::string thriftBody;
+  // The plan fragment JSON and the same document in MessagePack.
+  std::string fragmentJson;
+  std::string fragmentMsgpack;
+  // The parsed fragment JSON.
+  json fragmentDom;
+};
+
+std::vector<EncodedRequest>& requests() {
+  static std::vector<EncodedRequest> requests;
+  return requests;
+}
+
+EncodedRequest encodeRequest(const std::string& path) {
+  std::string base64Fragment;
+  VELOX_CHECK(
+      folly::readFile(path.c_str(), base64Fragment), "Cannot read {}", path);
+  const auto end = base64Fragment.find_last_not_of(" \t\n\r");
+  base64Fragment.erase(end == std::string::npos ? 0 : end + 1);
+
+  protocol::TaskUpdateRequest updateRequest;
+  updateRequest.fragment = std::make_shared<std::string>(base64Fragment);
+  json jsonRequest = updateRequest;
+
+  auto fragmentJson = velox::encoding::Base64::decode(base64Fragment);
+  updateRequest.fragment = std::make_shared<std::string>(fragmentJson);
+  thrift::TaskUpdateRequest thriftRequest;
+  thrift::toThrift(updateRequest, thriftRequest);
+
+  auto fragmentDom = json::parse(fragmentJson);
+  const auto msgpack = json::to_msgpack(fragmentDom);
+  return {
+      path,
+      jsonRequest.dump(),
+      thriftWrite(thriftRequest),
+      std::move(fragmentJson),
+      std::string(msgpack.begin(), msgpack.end()),
+      std::move(fragmentDom)};
+}
+
+// Runs 'decodeOne' 'iterations' times on every request and reports the
+// allocations per request and the total of 'inputBytes' of the requests.
+template <typename DecodeOne, typename InputBytes>
+void run(
+    uint32_t iterations,
+    folly::UserCounters& counters,
+    DecodeOne decodeOne,
+    InputBytes inputBytes) {
+  const auto allocationsBefore = numAllocations.load();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    for (const auto& request : requests()) {
+      decodeOne(request);
+    }
+  }
+  counters["allocsPerRequest"] = folly::UserMetric(
+      (numAllocations.load() - allocationsBefore) /
+          (iterations * requests().size()),
+      folly::UserMetric::Type::METRIC);
+  size_t bytes = 0;
+  for (const auto& request : requests()) {
+    bytes += inputBytes(request);
+  }
+  counters["inputBytes"] =
+      folly::UserMetric(bytes, folly::UserMetric::Type::METRIC);
+}
+
+// End-to-end decode of the request and its plan fragment as done by
+// TaskResource.
+void decode(
+    uint32_t iterations,
+    bool receiveThrift,
+    folly::UserCounters& counters) {
+  run(
+      iterations,
+      counters,
+      [&](const EncodedRequest& request) {
+        auto updateRequest = decodeTaskUpdateRequest(
+            receiveThrift ? request.thriftBody : request.jsonBody,
+            receiveThrift);
+        auto plan = decodePlanFragment(*updateRequest.fragment, receiveThrift);
+        folly::doNotOptimizeAway(plan);
+      },
+      [&](const EncodedRequest& request) {
+        return receiveThrift ? request.thriftBody.size()
+                             : request.jsonBody.size();
+      });
+}
+
+BENCHMARK_COUNTERS(decodeJson, counters, n) {
+  decode(n, /*receiveThrift=*/false, counters);
+}
+
+BENCHMARK_COUNTERS_RELATIVE(decodeThrift, counters, n) {
+  decode(n, /*receiveThrift=*/true, counters);
+}
+
+BENCHMARK_DRAW_LINE();
+
+// The plan fragment decode split into building the JSON document and
+// converting it to protocol::PlanFragment. Both request encodings pay for
+// both steps.
+BENCHMARK_COUNTERS(fragmentFromJsonText, counters, n) {
+  run(
+      n,
+      counters,
+      [](const EncodedRequest& request) {
+        protocol::PlanFragment plan = json::parse(request.fragmentJson);
+        folly::doNotOptimizeAway(plan);
+      },
+      [](const EncodedRequest& request) {
+        return request.fragmentJson.size();
+      });
+}
+
+BENCHMARK_COUNTERS_RELATIVE(fragmentJsonTextToDom, counters, n) {
+  run(
+      n,
+      counters,
+      [](const EncodedRequest& request) {
+        auto dom = json::parse(request.fragmentJson);
+        folly::doNotOptimizeAway(dom);
+      },
+      [](const EncodedRequest& request) {
+        return request.fragmentJson.size();
+      });
+}
+
+BENCHMARK_COUNTERS_RELATIVE(fragmentDomToPlan, counters, n) {
+  run(
+      n,
+      counters,
+      [](const EncodedRequest& request) {
+        protocol::PlanFragment plan = request.fragmentDom;
+        folly::doNotOptimizeAway(plan);
+      },
+      [](const EncodedRequest& request) {
+        return request.fragmentJson.size();
+      });
+}
+
+// A binary encoding of the same document. Shows what replacing the JSON text
+// by a binary format saves while the protocol classes are still built from a
+// document. The worker does not accept MessagePack fragments.
+BENCHMARK_COUNTERS_RELATIVE(fragmentFromMsgpack, counters, n) {
+  run(
+      n,
+      counters,
+      [](const EncodedRequest& request) {
+        protocol::PlanFragment plan = json::from_msgpack(
+            request.fragmentMsgpack.begin(), request.fragmentMsgpack.end());
+        folly::doNotOptimizeAway(plan);
+      },
+      [](const EncodedRequest& request) {
+        return request.fragmentMsgpack.size();
+      });
+}
+
+} // namespace
+} // namespace facebook::presto
+
+int main(int argc, char** argv) {
+  folly::Init init{&argc, &argv};
+  facebook::presto::registerPrestoToVeloxConnector(
+      std::make_unique<facebook::presto::HivePrestoToVeloxConnector>("hive"));
+  std::vector<std::string> paths;
+  folly::split(',', FLAGS_fragment_files, paths, true);
+  if (paths.empty()) {
+    paths.push_back(
+        std::string(PRESTO_CPP_TEST_DATA_DIR) + "/Fragment.thrift.base64");
+  }
+  for (const auto& path : paths) {
+    facebook::presto::requests().push_back(
+        facebook::presto::encodeRequest(path));
+  }
+  folly::runBenchmarks();
+  return 0;
+}
@@ -13,6 +13,7 @@
  */
 
 #include "presto_cpp/main/common/Configs.h"
+#include <folly/String.h>
 #include <folly/system/HardwareConcurrency.h>
 #include "presto_cpp/main/common/ConfigReader.h"
 #include "presto_cpp/main/common/Utils.h"
@@ -200,10 +201,18 @@ SystemConfig::SystemConfig() {
           NUM_PROP(kWorkerOverloadedCooldownPeriodSec, 5),
           NUM_PROP(kWorkerOverloadedSecondsToDetachWorker, 0),
           BOOL_PROP(kWorkerOverloadedTaskQueuingEnabled, false),
+          BOOL_PROP(kWorkerPressureMonitorEnabled, false),
+          STR_PROP(kWorkerPressureCgroupPath, "/sys/fs/cgroup"),
+          NUM_PROP(kWorkerPressureCpuStallThresholdMs, 500),
+          NUM_PROP(kWorkerPressureMemoryStallThresholdMs, 100),
+          NUM_PROP(kWorkerPressureIoStallThresholdMs, 0),
+          NUM_PROP(kWorkerPressureWindowMs, 2'000),
           NUM_PROP(kMallocHeapDumpThresholdGb, 20),
           NUM_PROP(kMallocMemMinHeapDumpInterval, 10),
           NUM_PROP(kMallocMemMaxHeapDumpFiles, 5),
           BOOL_PROP(kNativeSidecar, false),
+          STR_PROP(kNativeSidecarExpressionCacheMaxBytes, "64MB"),
+          NUM_PROP(kNativeSidecarExpressionBatchSize, 32),
           BOOL_PROP(kAsyncDataCacheEnabled, true),
           NUM_PROP(kAsyncCacheSsdGb, 0),
           NUM_PROP(kAsyncCacheSsdCheckpointGb, 0),
@@ -232,6 +241,10 @@ SystemConfig::SystemConfig() {
           BOOL_PROP(kEnableVeloxTaskLogging, false),
           BOOL_PROP(kEnableVeloxExprSetLogging, false),
           NUM_PROP(kLocalShuffleMaxPartitionBytes, 65536),
+          BOOL_PROP(kLocalShuffleConsolidateFiles, false),
+          NUM_PROP(kLocalShuffleMergeMemoryBytes, 0),
+          NUM_PROP(kLocalShuffleFlushThreads, 0),
+          NUM_PROP(kLocalShuffleMaxPendingFlushBytes, 64L << 20),
           STR_PROP(kShuffleName, ""),
           BOOL_PROP(kExchangeMaterializationEnabled, false),
           NUM_PROP(
@@ -242,8 +255,16 @@ SystemConfig::SystemConfig() {
               kExchangeMaterializationOutputBufferPerPartitionMaxBytes,
               130L * 1024),
           NUM_PROP(kExchangeMaterializationReclaimDrainThresholdRatio, 0.67),
+          BOOL_PROP(kExchangeMaterializationLazyColumnsEnabled, false),
+          BOOL_PROP(kShuffleReadPushdownEnabled, false),
           STR_PROP(kRemoteFunctionServerCatalogName, ""),
           STR_PROP(kRemoteFunctionServerSerde, "presto_page"),
+          NUM_PROP(kRemoteFunctionServerRestResultCacheMaxBytes, 0),
+          STR_PROP(kRemoteFunctionServerRestResultCacheFunctions, ""),
+          NUM_PROP(kRemoteFunctionServerRestBatchTargetBytes, 0),
+          NUM_PROP(kRemoteFunctionServerRestBatchMaxWaitMs, 5),
+          NUM_PROP(kRemoteFunctionServerRestRequestMaxRows, 0),
+          NUM_PROP(kRemoteFunctionServerRestMaxRequestsInFlight, 4),
           BOOL_PROP(kHttpEnableAccessLog, false),
           BOOL_PROP(kHttpEnableStatsFilter, false),
           BOOL_PROP(kHttpEnableEndpointLatencyFilter, false),
@@ -540,6 +561,50 @@ std::string SystemConfig::remoteFunctionServerRestURL() const {
   return optionalProperty(kRemoteFunctionServerRestURL).value();
 }
 
+uint64_t SystemConfig::remoteFunctionServerRestResultCacheMaxBytes() const {
+  return optionalProperty<uint64_t>(
+             kRemoteFunctionServerRestResultCacheMaxBytes)
+      .value();
+}
+
+std::vector<std::string>
+SystemConfig::remoteFunctionServerRestResultCacheFunctions() const {
+  const auto value =
+      optionalProperty(kRemoteFunctionServerRestResultCacheFunctions).value();
+  std::vector<folly::StringPiece> names;
+  folly::split(',', value, names, true);
+  std::vector<std::string> functions;
+  functions.reserve(names.size());
+  for (auto name : names) {
+    name = folly::trimWhitespace(name);
+    if (!name.empty()) {
+      functions.emplace_back(name);
+    }
+  }
+  return functions;
+}
+
+uint64_t SystemConfig::remoteFunctionServerRestBatchTargetBytes() const {
+  return optionalProperty<uint64_t>(kRemoteFunctionServerRestBatchTargetBytes)
+      .value();
+}
+
+uint32_t SystemConfig::remoteFunctionServerRestBatchMaxWaitMs() const {
+  return optionalProperty<uint32_t>(kRemoteFunctionServerRestBatchMaxWaitMs)
+      .value();
+}
+
+int32_t SystemConfig::remoteFunctionServerRestRequestMaxRows() const {
+  return optionalProperty<int32_t>(kRemoteFunctionServerRestRequestMaxRows)
+      .value();
+}
+
+int32_t SystemConfig::remoteFunctionServerRestMaxRequestsInFlight() const {
+  return optionalProperty<int32_t>(
+             kRemoteFunctionServerRestMaxRequestsInFlight)
+      .value();
+}
+
 int32_t SystemConfig::maxDriversPerTask() const {
   return optionalProperty<int32_t>(kMaxDriversPerTask).value();
 }
@@ -651,6 +716,16 @@ bool SystemConfig::prestoNativeSidecar() const {
   return optionalProperty<bool>(kNativeSidecar).value();
 }
 
+uint64_t SystemConfig::nativeSidecarExpressionCacheMaxBytes() const {
+  return velox::config::toCapacity(
+      optionalProperty(kNativeSidecarExpressionCacheMaxBytes).value(),
+      velox::config::CapacityUnit::BYTE);
+}
+
+uint32_t SystemConfig::nativeSidecarExpressionBatchSize() const {
+  return optionalProperty<uint32_t>(kNativeSidecarExpressionBatchSize).value();
+}
+
 uint32_t SystemConfig::systemMemLimitGb() const {
   return optionalProperty<uint32_t>(kSystemMemLimitGb).value();
 }
@@ -695,6 +770,32 @@ bool SystemConfig::workerOverloadedTaskQueuingEnabled() const {
   return optionalProperty<bool>(kWorkerOverloadedTaskQueuingEnabled).value();
 }
 
+bool SystemConfig::workerPressureMonitorEnabled() const {
+  return optionalProperty<bool>(kWorkerPressureMonitorEnabled).value();
+}
+
+std::string SystemConfig::workerPressureCgroupPath() const {
+  return optionalProperty<std::string>(kWorkerPressureCgroupPath).value();
+}
+
+uint64_t SystemConfig::workerPressureCpuStallThresholdMs() const {
+  return optionalProperty<uint64_t>(kWorkerPressureCpuStallThresholdMs)
+      .value();
+}
+
+uint64_t SystemConfig::workerPressureMemoryStallThresholdMs() const {
+  return optionalProperty<uint64_t>(kWorkerPressureMemoryStallThresholdMs)
+      .value();
+}
+
+uint64_t SystemConfig::workerPressureIoStallThresholdMs() const {
+  return optionalProperty<uint64_t>(kWorkerPressureIoStallThresholdMs).value();
+}
+
+uint64_t SystemConfig::workerPressureWindowMs() const {
+  return optionalProperty<uint64_t>(kWorkerPressureWindowMs).value();
+}
+
 bool SystemConfig::mallocMemHeapDumpEnabled() const {
   return optionalProperty<bool>(kMallocMemHeapDumpEnabled).value();
 }
@@ -727,6 +828,23 @@ uint64_t SystemConfig::localShuffleMaxPartitionBytes() const {
   return optionalProperty<uint32_t>(kLocalShuffleMaxPartitionBytes).value();
 }
 
+bool SystemConfig::localShuffleConsolidateFiles() const {
+  return optionalProperty<bool>(kLocalShuffleConsolidateFiles).value();
+}
+
+uint64_t SystemConfig::localShuffleMergeMemoryBytes() const {
+  return optionalProperty<uint64_t>(kLocalShuffleMergeMemoryBytes).value();
+}
+
+uint32_t SystemConfig::localShuffleFlushThreads() const {
+  return optionalProperty<uint32_t>(kLocalShuffleFlushThreads).value();
+}
+
+uint64_t SystemConfig::localShuffleMaxPendingFlushBytes() const {
+  return optionalProperty<uint64_t>(kLocalShuffleMaxPendingFlushBytes)
+      .value();
+}
+
 std::string SystemConfig::asyncCacheSsdPath() const {
   return optionalProperty(kAsyncCacheSsdPath).value();
 }
@@ -819,6 +937,15 @@ bool SystemConfig::exchangeMaterializationReclaimHighPriority() const {
       .value_or(false);
 }
 
+bool SystemConfig::exchangeMaterializationLazyColumnsEnabled() const {
+  return optionalProperty<bool>(kExchangeMaterializationLazyColumnsEnabled)
+      .value_or(false);
+}
+
+bool SystemConfig::shuffleReadPushdownEnabled() const {
+  return optionalProperty<bool>(kShuffleReadPushdownEnabled).value_or(false);
+}
+
 bool SystemConfig::enableSerializedPageChecksum() const {
   return optionalProperty<bool>(kEnableSerializedPageChecksum).value();
 }
@@ -1233,7 +1360,6 @@ NodeConfig::NodeConfig() {
           NONE_PROP(kNodeIp),
           NONE_PROP(kNodeInternalAddress),
           NONE_PROP(kNodeLocation),
-          NONE_PROP(kNodePrometheusExecutorThreads),
       };
 }
 
@@ -1246,15 +1372,6 @@ std::string NodeConfig::nodeEnvironment() const {
   return requiredProperty(kNodeEnvironment);
 }
 
-int NodeConfig::prometheusExecutorThreads() const {
-  static constexpr int kNodePrometheusExecutorThreadsDefault = 2;
-  auto resultOpt = optionalProperty<int>(kNodePrometheusExecutorThreads);
-  if (resultOpt.has_value()) {
-    return resultOpt.value();
-  }
-  return kNodePrometheusExecutorThreadsDefault;
-}
-
 std::string NodeConfig::nodeId() const {
   auto resultOpt = optionalProperty(kNodeId);
   if (resultOpt.has_value()) {
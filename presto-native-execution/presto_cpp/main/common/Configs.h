@@ -351,6 +351,17 @@ class SystemConfig : public ConfigBase {
   /// Indicates if the process is configured as a sidecar.
   static constexpr std::string_view kNativeSidecar{"native-sidecar"};
 
+  /// Capacity of the cache of optimized expressions the sidecar keeps to
+  /// answer repeated /v1/expressions requests, e.g. "64MB". Only
+  /// deterministic results are cached. 0B disables the cache.
+  static constexpr std::string_view kNativeSidecarExpressionCacheMaxBytes{
+      "native-sidecar.expression-cache-max-bytes"};
+
+  /// /v1/expressions requests with more expressions than this are optimized
+  /// in batches of this size in parallel on the driver executor.
+  static constexpr std::string_view kNativeSidecarExpressionBatchSize{
+      "native-sidecar.expression-batch-size"};
+
   /// If true, enable memory pushback when the server is under low memory
   /// condition. This only applies if 'system-mem-limit-gb' is set.
   static constexpr std::string_view kSystemMemPushbackEnabled{
@@ -396,6 +407,29 @@ class SystemConfig : public ConfigBase {
   /// starts them gradually when it stops being overloaded.
   static constexpr std::string_view kWorkerOverloadedTaskQueuingEnabled{
       "worker-overloaded-task-queuing-enabled"};
+  /// If true, the worker registers cgroup v2 pressure stall information (PSI)
+  /// triggers and considers itself overloaded while any of them fires. Memory
+  /// pressure events also run the memory pushback right away.
+  static constexpr std::string_view kWorkerPressureMonitorEnabled{
+      "worker-pressure-monitor-enabled"};
+  /// cgroup v2 directory containing the 'cpu.pressure', 'memory.pressure' and
+  /// 'io.pressure' files.
+  static constexpr std::string_view kWorkerPressureCgroupPath{
+      "worker-pressure-cgroup-path"};
+  /// Stall time in milliseconds within 'worker-pressure-window-ms' that marks
+  /// the worker as overloaded on CPU, memory and IO respectively. Zero disables
+  /// the corresponding trigger.
+  static constexpr std::string_view kWorkerPressureCpuStallThresholdMs{
+      "worker-pressure-cpu-stall-threshold-ms"};
+  static constexpr std::string_view kWorkerPressureMemoryStallThresholdMs{
+      "worker-pressure-memory-stall-threshold-ms"};
+  static constexpr std::string_view kWorkerPressureIoStallThresholdMs{
+      "worker-pressure-io-stall-threshold-ms"};
+  /// PSI tracking window in milliseconds. Must be between 500ms and 10s.
+  /// Unprivileged processes can only register triggers with windows that are
+  /// multiples of 2s.
+  static constexpr std::string_view kWorkerPressureWindowMs{
+      "worker-pressure-window-ms"};
 
   /// If true, memory allocated via malloc is periodically checked and a heap
   /// profile is dumped if usage exceeds 'malloc-heap-dump-gb-threshold'.
@@ -661,6 +695,24 @@ class SystemConfig : public ConfigBase {
       "enable_velox_expression_logging"};
   static constexpr std::string_view kLocalShuffleMaxPartitionBytes{
       "shuffle.local.max-partition-bytes"};
+  /// If true, each local shuffle writer appends the blocks of all partitions
+  /// to a single data file with an index file, instead of creating one file
+  /// per block.
+  static constexpr std::string_view kLocalShuffleConsolidateFiles{
+      "shuffle.local.consolidate-files"};
+  /// Memory limit for the read buffers of the merge of a sorted local
+  /// shuffle read. Blocks that do not fit are first merged into intermediate
+  /// runs. 0 means no limit.
+  static constexpr std::string_view kLocalShuffleMergeMemoryBytes{
+      "shuffle.local.merge-memory-bytes"};
+  /// Number of threads that write the blocks of local shuffle writers in the
+  /// background. 0 means blocks are written by the driver threads.
+  static constexpr std::string_view kLocalShuffleFlushThreads{
+      "shuffle.local.flush-threads"};
+  /// Maximum bytes of blocks each local shuffle writer may have waiting to be
+  /// written in the background before it waits for them.
+  static constexpr std::string_view kLocalShuffleMaxPendingFlushBytes{
+      "shuffle.local.max-pending-flush-bytes"};
   static constexpr std::string_view kShuffleName{"shuffle.name"};
 
   /// Enable materialized exchange I/O (MaterializedOutput/MaterializedExchange
@@ -715,6 +767,22 @@ class SystemConfig : public ConfigBase {
   static constexpr std::string_view kExchangeMaterializationReclaimHighPriority{
       "exchange.materialization.reclaim-high-priority"};
 
+  /// Let MaterializedExchange return fixed-width columns as lazy vectors that
+  /// are only copied out of the received pages when an operator loads them.
+  /// Columns that are filtered out or never read are not deserialized at all.
+  /// The received pages are held until the returned vectors are released.
+  /// Default: false.
+  static constexpr std::string_view kExchangeMaterializationLazyColumnsEnabled{
+      "exchange.materialization.lazy-columns-enabled"};
+
+  /// Fold a filter directly above a shuffle read (ShuffleRead or
+  /// MaterializedExchange) and the columns the plan reads into the read, so
+  /// that filter columns are deserialized and evaluated first and unused
+  /// columns are skipped where the row layout allows.
+  /// Default: false.
+  static constexpr std::string_view kShuffleReadPushdownEnabled{
+      "shuffle.read-pushdown-enabled"};
+
   static constexpr std::string_view kHttpEnableAccessLog{
       "http-server.enable-access-log"};
   static constexpr std::string_view kHttpEnableStatsFilter{
@@ -863,6 +931,46 @@ class SystemConfig : public ConfigBase {
   static constexpr std::string_view kRemoteFunctionServerRestURL{
       "remote-function-server.rest.url"};
 
+  /// Capacity in bytes of the per-function cache of REST remote function
+  /// results, keyed by the serialized arguments. Only used by the functions
+  /// listed in 'remote-function-server.rest.result-cache-functions'. 0
+  /// disables the cache.
+  static constexpr std::string_view
+      kRemoteFunctionServerRestResultCacheMaxBytes{
+          "remote-function-server.rest.result-cache-max-bytes"};
+
+  /// Comma-separated list of the fully qualified names of the REST remote
+  /// functions whose results are cached, e.g.
+  /// 'catalog.schema.function'. Only list deterministic functions, since the
+  /// function handles do not tell whether a function is deterministic.
+  static constexpr std::string_view
+      kRemoteFunctionServerRestResultCacheFunctions{
+          "remote-function-server.rest.result-cache-functions"};
+
+  /// Inputs of a REST remote function smaller than this many bytes are merged
+  /// with concurrent inputs from other drivers of the same query into one
+  /// request. An input is sent right away if no other request of the query
+  /// is outstanding. 0 disables batching.
+  static constexpr std::string_view kRemoteFunctionServerRestBatchTargetBytes{
+      "remote-function-server.rest.batch-target-bytes"};
+
+  /// Maximum time in milliseconds the first input of a batch waits for an
+  /// outstanding request of the query to complete before the batch is sent.
+  static constexpr std::string_view kRemoteFunctionServerRestBatchMaxWaitMs{
+      "remote-function-server.rest.batch-max-wait-ms"};
+
+  /// Inputs of a REST remote function with more rows than this are sent in
+  /// several requests of up to this many rows. Only used if batching is
+  /// disabled. 0 sends each input in a single request.
+  static constexpr std::string_view kRemoteFunctionServerRestRequestMaxRows{
+      "remote-function-server.rest.request-max-rows"};
+
+  /// Maximum number of the requests of one input of a REST remote function
+  /// that are outstanding at the same time.
+  static constexpr std::string_view
+      kRemoteFunctionServerRestMaxRequestsInFlight{
+          "remote-function-server.rest.max-requests-in-flight"};
+
   /// Path where json files containing signatures for remote functions can be
   /// found.
   static constexpr std::string_view
@@ -1062,6 +1170,19 @@ class SystemConfig : public ConfigBase {
 
   std::string remoteFunctionServerRestURL() const;
 
+  uint64_t remoteFunctionServerRestResultCacheMaxBytes() const;
+
+  std::vector<std::string> remoteFunctionServerRestResultCacheFunctions()
+      const;
+
+  uint64_t remoteFunctionServerRestBatchTargetBytes() const;
+
+  uint32_t remoteFunctionServerRestBatchMaxWaitMs() const;
+
+  int32_t remoteFunctionServerRestRequestMaxRows() const;
+
+  int32_t remoteFunctionServerRestMaxRequestsInFlight() const;
+
   int32_t maxDriversPerTask() const;
 
   int32_t driverMaxSplitPreload() const;
@@ -1132,6 +1253,18 @@ class SystemConfig : public ConfigBase {
 
   bool workerOverloadedTaskQueuingEnabled() const;
 
+  bool workerPressureMonitorEnabled() const;
+
+  std::string workerPressureCgroupPath() const;
+
+  uint64_t workerPressureCpuStallThresholdMs() const;
+
+  uint64_t workerPressureMemoryStallThresholdMs() const;
+
+  uint64_t workerPressureIoStallThresholdMs() const;
+
+  uint64_t workerPressureWindowMs() const;
+
   bool mallocMemHeapDumpEnabled() const;
 
   uint32_t mallocHeapDumpThresholdGb() const;
@@ -1150,6 +1283,14 @@ class SystemConfig : public ConfigBase {
 
   uint64_t localShuffleMaxPartitionBytes() const;
 
+  bool localShuffleConsolidateFiles() const;
+
+  uint64_t localShuffleMergeMemoryBytes() const;
+
+  uint32_t localShuffleFlushThreads() const;
+
+  uint64_t localShuffleMaxPendingFlushBytes() const;
+
   std::string asyncCacheSsdPath() const;
 
   double asyncCacheMaxSsdWriteRatio() const;
@@ -1188,6 +1329,10 @@ class SystemConfig : public ConfigBase {
 
   bool exchangeMaterializationReclaimHighPriority() const;
 
+  bool exchangeMaterializationLazyColumnsEnabled() const;
+
+  bool shuffleReadPushdownEnabled() const;
+
   bool enableSerializedPageChecksum() const;
 
   bool enableVeloxTaskLogging() const;
@@ -1316,6 +1461,10 @@ class SystemConfig : public ConfigBase {
 
   bool prestoNativeSidecar() const;
 
+  uint64_t nativeSidecarExpressionCacheMaxBytes() const;
+
+  uint32_t nativeSidecarExpressionBatchSize() const;
+
   std::string prestoDefaultNamespacePrefix() const;
 
   std::string poolType() const;
@@ -1373,8 +1522,6 @@ class NodeConfig : public ConfigBase {
   static constexpr std::string_view kNodeInternalAddress{
       "node.internal-address"};
   static constexpr std::string_view kNodeLocation{"node.location"};
-  static constexpr std::string_view kNodePrometheusExecutorThreads{
-      "node.prometheus.num-executor-threads"};
 
   NodeConfig();
 
@@ -1384,8 +1531,6 @@ class NodeConfig : public ConfigBase {
 
   std::string nodeEnvironment() const;
 
-  int prometheusExecutorThreads() const;
-
   std::string nodeId() const;
 
   std::string nodeInternalAddress(
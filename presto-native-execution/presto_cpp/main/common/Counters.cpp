@@ -103,6 +103,7 @@ void registerPrestoMetrics() {
   DEFINE_METRIC(kCounterNumBlockedYieldDrivers, facebook::velox::StatType::AVG);
   DEFINE_METRIC(kCounterOverloadedMem, facebook::velox::StatType::AVG);
   DEFINE_METRIC(kCounterOverloadedCpu, facebook::velox::StatType::AVG);
+  DEFINE_METRIC(kCounterOverloadedPressure, facebook::velox::StatType::AVG);
   DEFINE_METRIC(kCounterOverloaded, facebook::velox::StatType::AVG);
   DEFINE_METRIC(kCounterNumStuckDrivers, facebook::velox::StatType::AVG);
   DEFINE_METRIC(kCounterNumDriverThreads, facebook::velox::StatType::AVG);
@@ -170,6 +171,20 @@ void registerPrestoMetrics() {
   DEFINE_HISTOGRAM_METRIC(
       kCounterExchangeGetDataSizeNumTries, 1, 0, 20, 50, 90, 99, 100);
 
+  DEFINE_METRIC(
+      kCounterSidecarNumOptimizedExpressions, facebook::velox::StatType::SUM);
+  DEFINE_METRIC(
+      kCounterSidecarExpressionCacheHits, facebook::velox::StatType::SUM);
+  DEFINE_HISTOGRAM_METRIC(
+      kCounterSidecarOptimizeExpressionsLatencyMs,
+      100,
+      0,
+      10'000,
+      50,
+      90,
+      99,
+      100);
+
   DEFINE_METRIC(kCounterMemoryPushbackCount, facebook::velox::StatType::COUNT);
   DEFINE_HISTOGRAM_METRIC(
       kCounterMemoryPushbackLatencyMs, 10'000, 0, 100'000, 50, 90, 99, 100);
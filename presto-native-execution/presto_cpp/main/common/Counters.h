@@ -140,6 +140,10 @@ constexpr std::string_view kCounterNumDriverThreads{
 constexpr std::string_view kCounterOverloadedMem{"presto_cpp.overloaded_mem"};
 /// Export 100 if worker is overloaded in terms of CPU, 0 otherwise.
 constexpr std::string_view kCounterOverloadedCpu{"presto_cpp.overloaded_cpu"};
+/// Export 100 if any cgroup pressure stall trigger fired recently, 0
+/// otherwise.
+constexpr std::string_view kCounterOverloadedPressure{
+    "presto_cpp.overloaded_pressure"};
 /// Export 100 if worker is overloaded in terms of memory or CPU, 0 otherwise.
 constexpr std::string_view kCounterOverloaded{"presto_cpp.overloaded"};
 /// Worker exports the average time tasks spend in the queue (considered
@@ -227,6 +231,19 @@ constexpr std::string_view kCounterExchangeIoEvbViolation{
 constexpr std::string_view kCounterHttpServerIoEvbViolation{
     "presto_cpp.http_server_io_evb_violation_count"};
 
+/// ================== Sidecar Counters =================
+
+/// Number of expressions received by the /v1/expressions endpoint.
+constexpr std::string_view kCounterSidecarNumOptimizedExpressions{
+    "presto_cpp.sidecar_num_optimized_expressions"};
+/// Number of those expressions answered from the expression cache.
+constexpr std::string_view kCounterSidecarExpressionCacheHits{
+    "presto_cpp.sidecar_expression_cache_hits"};
+/// Latency distribution of /v1/expressions requests in range of [0, 10s] and
+/// reports P50, P90, P99, and P100.
+constexpr std::string_view kCounterSidecarOptimizeExpressionsLatencyMs{
+    "presto_cpp.sidecar_optimize_expressions_latency_ms"};
+
 /// ================== Memory Pushback Counters =================
 
 /// Number of times memory pushback mechanism is triggered.
@@ -216,10 +216,6 @@ TEST_F(ConfigTest, optionalNodeConfigs) {
   init(config, {{std::string(NodeConfig::kNodeIp), "127.0.0.1"}});
   ASSERT_EQ(
       config.nodeInternalAddress([]() { return "0.0.0.0"; }), "127.0.0.1");
-
-  init(
-      config, {{std::string(NodeConfig::kNodePrometheusExecutorThreads), "4"}});
-  ASSERT_EQ(config.prometheusExecutorThreads(), 4);
 }
 
 TEST_F(ConfigTest, optionalSystemConfigsWithDefault) {
@@ -293,6 +289,18 @@ TEST_F(ConfigTest, remoteFunctionServer) {
   ASSERT_EQ(
       config.remoteFunctionServerLocation(),
       (folly::SocketAddress::makeFromPath("/tmp/any.socket")));
+
+  // Functions using the REST result cache.
+  init(config, {});
+  ASSERT_TRUE(config.remoteFunctionServerRestResultCacheFunctions().empty());
+  init(
+      config,
+      {{std::string(
+            SystemConfig::kRemoteFunctionServerRestResultCacheFunctions),
+        "remote.schema.f1, remote.schema.f2,,"}});
+  ASSERT_EQ(
+      config.remoteFunctionServerRestResultCacheFunctions(),
+      (std::vector<std::string>{"remote.schema.f1", "remote.schema.f2"}));
 }
 
 TEST_F(ConfigTest, parseValid) {
@@ -0,0 +1,228 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/connectors/arrow_flight/ArrowFlightClientPool.h"
+#include <arrow/flight/api.h>
+#include <fmt/format.h>
+#include "presto_cpp/main/connectors/arrow_flight/Macros.h"
+#include "velox/common/time/Timer.h"
+
+namespace facebook::presto {
+namespace {
+// Wrapper for CallOptions which does not add any member variables,
+// but provides a write-only interface for adding call headers.
+class CallOptionsAddHeaders : public arrow::flight::FlightCallOptions,
+                              public arrow::flight::AddCallHeaders {
+ public:
+  void AddHeader(const std::string& key, const std::string& value) override {
+    headers.emplace_back(key, value);
+  }
+};
+} // namespace
+
+struct ArrowFlightClientPool::PooledClient {
+  std::string key;
+  std::unique_ptr<arrow::flight::FlightClient> client;
+  arrow::flight::FlightCallOptions callOptions;
+  std::chrono::steady_clock::time_point lastUsed;
+};
+
+ArrowFlightClientPool::Lease::Lease(
+    std::shared_ptr<ArrowFlightClientPool> pool,
+    std::unique_ptr<PooledClient> client)
+    : pool_(std::move(pool)), client_(std::move(client)) {}
+
+ArrowFlightClientPool::Lease& ArrowFlightClientPool::Lease::operator=(
+    Lease&& other) noexcept {
+  if (this != &other) {
+    release();
+    pool_ = std::move(other.pool_);
+    client_ = std::move(other.client_);
+  }
+  return *this;
+}
+
+ArrowFlightClientPool::Lease::~Lease() {
+  release();
+}
+
+arrow::flight::FlightClient* ArrowFlightClientPool::Lease::client() const {
+  VELOX_CHECK_NOT_NULL(client_);
+  return client_->client.get();
+}
+
+const arrow::flight::FlightCallOptions&
+ArrowFlightClientPool::Lease::callOptions() const {
+  VELOX_CHECK_NOT_NULL(client_);
+  return client_->callOptions;
+}
+
+void ArrowFlightClientPool::Lease::release() {
+  if (client_ != nullptr) {
+    pool_->release(std::move(client_));
+  }
+  pool_.reset();
+}
+
+void ArrowFlightClientPool::Lease::invalidate() {
+  client_.reset();
+  pool_.reset();
+}
+
+// static
+std::shared_ptr<ArrowFlightClientPool> ArrowFlightClientPool::create(
+    std::shared_ptr<arrow::flight::FlightClientOptions> clientOpts,
+    Options options) {
+  return std::shared_ptr<ArrowFlightClientPool>(
+      new ArrowFlightClientPool(std::move(clientOpts), options));
+}
+
+ArrowFlightClientPool::ArrowFlightClientPool(
+    std::shared_ptr<arrow::flight::FlightClientOptions> clientOpts,
+    Options options)
+    : clientOpts_(std::move(clientOpts)),
+      options_(options),
+      lastEviction_(std::chrono::steady_clock::now()) {
+  VELOX_CHECK_NOT_NULL(clientOpts_, "FlightClientOptions is not initialized");
+}
+
+ArrowFlightClientPool::~ArrowFlightClientPool() = default;
+
+ArrowFlightClientPool::Lease ArrowFlightClientPool::acquire(
+    const arrow::flight::Location& location,
+    Authenticator& authenticator,
+    const velox::config::ConfigBase* sessionProperties,
+    AcquireStats& stats) {
+  auto key = fmt::format(
+      "{}|{}", location.ToString(), authenticator.identity(sessionProperties));
+  const auto now = std::chrono::steady_clock::now();
+  std::unique_ptr<PooledClient> idleClient;
+  std::vector<std::unique_ptr<PooledClient>> expired;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    evictIdleLocked(now, expired);
+    auto it = idleClients_.find(key);
+    if (it != idleClients_.end()) {
+      idleClient = std::move(it->second.back());
+      it->second.pop_back();
+      if (it->second.empty()) {
+        idleClients_.erase(it);
+      }
+    }
+  }
+
+  if (idleClient != nullptr) {
+    bool healthy{true};
+    if (now - idleClient->lastUsed >= options_.healthCheckInterval) {
+      velox::NanosecondTimer timer(&stats.healthCheckNanos);
+      healthy = isHealthy(*idleClient);
+    }
+    if (healthy) {
+      stats.reused = true;
+      return Lease(shared_from_this(), std::move(idleClient));
+    }
+  }
+  return Lease(
+      shared_from_this(),
+      connect(
+          std::move(key), location, authenticator, sessionProperties, stats));
+}
+
+std::unique_ptr<ArrowFlightClientPool::PooledClient>
+ArrowFlightClientPool::connect(
+    std::string key,
+    const arrow::flight::Location& location,
+    Authenticator& authenticator,
+    const velox::config::ConfigBase* sessionProperties,
+    AcquireStats& stats) {
+  auto pooledClient = std::make_unique<PooledClient>();
+  pooledClient->key = std::move(key);
+  {
+    velox::NanosecondTimer timer(&stats.connectNanos);
+    AFC_ASSIGN_OR_RAISE(
+        pooledClient->client,
+        arrow::flight::FlightClient::Connect(location, *clientOpts_));
+  }
+
+  CallOptionsAddHeaders callOptsAddHeaders{};
+  {
+    velox::NanosecondTimer timer(&stats.authNanos);
+    authenticator.authenticateClient(
+        pooledClient->client, sessionProperties, callOptsAddHeaders);
+  }
+  pooledClient->callOptions = callOptsAddHeaders;
+  return pooledClient;
+}
+
+// static
+bool ArrowFlightClientPool::isHealthy(PooledClient& client) {
+  // Any response from the server means the connection and the credentials are
+  // still usable. Servers are not required to implement ListActions.
+  auto result = client.client->ListActions(client.callOptions);
+  return result.ok() || result.status().IsNotImplemented();
+}
+
+void ArrowFlightClientPool::release(std::unique_ptr<PooledClient> client) {
+  if (options_.maxIdleClientsPerKey == 0) {
+    return;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  client->lastUsed = now;
+  std::vector<std::unique_ptr<PooledClient>> expired;
+  std::lock_guard<std::mutex> l(mutex_);
+  evictIdleLocked(now, expired);
+  auto& idleClients = idleClients_[client->key];
+  if (idleClients.size() < options_.maxIdleClientsPerKey) {
+    idleClients.push_back(std::move(client));
+  } else {
+    expired.push_back(std::move(client));
+  }
+}
+
+void ArrowFlightClientPool::evictIdleLocked(
+    std::chrono::steady_clock::time_point now,
+    std::vector<std::unique_ptr<PooledClient>>& expired) {
+  // Scanning all keys on every call is not needed for an idle timeout in the
+  // order of seconds.
+  if (now - lastEviction_ < options_.idleTimeout / 10) {
+    return;
+  }
+  lastEviction_ = now;
+  for (auto it = idleClients_.begin(); it != idleClients_.end();) {
+    auto& clients = it->second;
+    // Clients are ordered by last use, so the expired ones come first.
+    auto firstLive = clients.begin();
+    while (firstLive != clients.end() &&
+           now - (*firstLive)->lastUsed >= options_.idleTimeout) {
+      expired.push_back(std::move(*firstLive));
+      ++firstLive;
+    }
+    clients.erase(clients.begin(), firstLive);
+    if (clients.empty()) {
+      it = idleClients_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t ArrowFlightClientPool::numIdleClients() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  size_t numClients{0};
+  for (const auto& [_, clients] : idleClients_) {
+    numClients += clients.size();
+  }
+  return numClients;
+}
+
+} // namespace facebook::presto
@@ -0,0 +1,154 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "presto_cpp/main/connectors/arrow_flight/auth/Authenticator.h"
+
+namespace arrow::flight {
+class FlightCallOptions;
+class FlightClient;
+class FlightClientOptions;
+class Location;
+} // namespace arrow::flight
+
+namespace facebook::presto {
+
+/// Pool of authenticated Flight clients shared by all data sources of a
+/// connector. Clients are keyed by server location and authentication
+/// identity (see Authenticator::identity()) and are used by one data source
+/// at a time. Idle clients are closed after 'idleTimeout'. Clients that were
+/// idle for longer than 'healthCheckInterval' are probed with a ListActions
+/// call before they are reused.
+class ArrowFlightClientPool
+    : public std::enable_shared_from_this<ArrowFlightClientPool> {
+ public:
+  struct Options {
+    /// Maximum number of idle clients kept per key. 0 disables pooling.
+    size_t maxIdleClientsPerKey{8};
+    std::chrono::milliseconds idleTimeout{60'000};
+    std::chrono::milliseconds healthCheckInterval{10'000};
+  };
+
+  /// Cost of acquiring a client. Only a reused client may be health checked
+  /// and only a new one is connected and authenticated.
+  struct AcquireStats {
+    uint64_t connectNanos{0};
+    uint64_t authNanos{0};
+    uint64_t healthCheckNanos{0};
+    bool reused{false};
+  };
+
+ private:
+  struct PooledClient;
+
+ public:
+  /// A client checked out of the pool. Returns the client to the pool when
+  /// released or destroyed.
+  class Lease {
+   public:
+    Lease() = default;
+
+    Lease(Lease&& other) noexcept = default;
+
+    Lease& operator=(Lease&& other) noexcept;
+
+    ~Lease();
+
+    explicit operator bool() const {
+      return client_ != nullptr;
+    }
+
+    arrow::flight::FlightClient* client() const;
+
+    /// Call options carrying the authentication headers of the client.
+    const arrow::flight::FlightCallOptions& callOptions() const;
+
+    /// Returns the client to the pool.
+    void release();
+
+    /// Closes the client instead of returning it to the pool. Used after a
+    /// failed call, since the connection or the credentials may be broken.
+    void invalidate();
+
+   private:
+    friend class ArrowFlightClientPool;
+
+    Lease(
+        std::shared_ptr<ArrowFlightClientPool> pool,
+        std::unique_ptr<PooledClient> client);
+
+    std::shared_ptr<ArrowFlightClientPool> pool_;
+    std::unique_ptr<PooledClient> client_;
+  };
+
+  static std::shared_ptr<ArrowFlightClientPool> create(
+      std::shared_ptr<arrow::flight::FlightClientOptions> clientOpts,
+      Options options);
+
+  ~ArrowFlightClientPool();
+
+  /// Returns a client connected to 'location' and authenticated by
+  /// 'authenticator' for 'sessionProperties'. Reuses an idle client with the
+  /// same location and identity if there is a healthy one.
+  Lease acquire(
+      const arrow::flight::Location& location,
+      Authenticator& authenticator,
+      const velox::config::ConfigBase* sessionProperties,
+      AcquireStats& stats);
+
+  /// Number of idle clients over all keys.
+  size_t numIdleClients() const;
+
+  const Options& options() const {
+    return options_;
+  }
+
+ private:
+  ArrowFlightClientPool(
+      std::shared_ptr<arrow::flight::FlightClientOptions> clientOpts,
+      Options options);
+
+  std::unique_ptr<PooledClient> connect(
+      std::string key,
+      const arrow::flight::Location& location,
+      Authenticator& authenticator,
+      const velox::config::ConfigBase* sessionProperties,
+      AcquireStats& stats);
+
+  static bool isHealthy(PooledClient& client);
+
+  void release(std::unique_ptr<PooledClient> client);
+
+  // Moves the clients idle for longer than 'idleTimeout' to 'expired' so that
+  // they are closed outside of 'mutex_'.
+  void evictIdleLocked(
+      std::chrono::steady_clock::time_point now,
+      std::vector<std::unique_ptr<PooledClient>>& expired);
+
+  const std::shared_ptr<arrow::flight::FlightClientOptions> clientOpts_;
+  const Options options_;
+
+  mutable std::mutex mutex_;
+  // Idle clients per key, the most recently used last.
+  folly::F14FastMap<std::string, std::vector<std::unique_ptr<PooledClient>>>
+      idleClients_;
+  std::chrono::steady_clock::time_point lastEviction_;
+};
+
+} // namespace facebook::presto
@@ -53,4 +53,20 @@ std::optional<std::string> ArrowFlightConfig::clientSslKey() const {
       config_->get<std::string>(kClientSslKey));
 }
 
+bool ArrowFlightConfig::pushdownEnabled() const {
+  return config_->get<bool>(kPushdownEnabled, false);
+}
+
+uint32_t ArrowFlightConfig::clientPoolMaxIdleClients() const {
+  return config_->get<uint32_t>(kClientPoolMaxIdleClients, 8);
+}
+
+uint32_t ArrowFlightConfig::clientPoolIdleTimeoutMs() const {
+  return config_->get<uint32_t>(kClientPoolIdleTimeoutMs, 60'000);
+}
+
+uint32_t ArrowFlightConfig::clientPoolHealthCheckIntervalMs() const {
+  return config_->get<uint32_t>(kClientPoolHealthCheckIntervalMs, 10'000);
+}
+
 } // namespace facebook::presto
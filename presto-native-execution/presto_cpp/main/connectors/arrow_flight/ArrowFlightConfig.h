@@ -43,6 +43,18 @@ class ArrowFlightConfig {
 
   static constexpr const char* kClientSslKey = "arrow-flight.client-ssl-key";
 
+  static constexpr const char* kPushdownEnabled =
+      "arrow-flight.pushdown-enabled";
+
+  static constexpr const char* kClientPoolMaxIdleClients =
+      "arrow-flight.client-pool.max-idle-clients";
+
+  static constexpr const char* kClientPoolIdleTimeoutMs =
+      "arrow-flight.client-pool.idle-timeout-ms";
+
+  static constexpr const char* kClientPoolHealthCheckIntervalMs =
+      "arrow-flight.client-pool.health-check-interval-ms";
+
   std::string authenticatorName() const;
 
   std::optional<std::string> defaultServerHostname() const;
@@ -59,6 +71,18 @@ class ArrowFlightConfig {
 
   std::optional<std::string> clientSslKey() const;
 
+  /// If true, the columns and filters of a scan are sent to the Flight server
+  /// in a PushdownTicket that wraps the ticket of the split.
+  bool pushdownEnabled() const;
+
+  /// Maximum number of idle authenticated clients kept per server and
+  /// identity. 0 disables client reuse across splits.
+  uint32_t clientPoolMaxIdleClients() const;
+
+  uint32_t clientPoolIdleTimeoutMs() const;
+
+  uint32_t clientPoolHealthCheckIntervalMs() const;
+
  private:
   const std::shared_ptr<const velox::config::ConfigBase> config_;
 };
@@ -12,14 +12,14 @@
  * limitations under the License.
  */
 #include "presto_cpp/main/connectors/arrow_flight/ArrowFlightConnector.h"
-#include <arrow/c/abi.h>
-#include <arrow/c/bridge.h>
 #include <arrow/flight/api.h>
 #include <folly/base64.h>
 #include <utility>
 #include "presto_cpp/main/common/ConfigReader.h"
 #include "presto_cpp/main/connectors/arrow_flight/Macros.h"
-#include "velox/vector/arrow/Bridge.h"
+#include "presto_cpp/main/connectors/arrow_flight/PushdownTicket.h"
+#include "velox/common/future/VeloxPromise.h"
+#include "velox/vector/DecodedVector.h"
 
 using namespace facebook::velox::connector;
 
@@ -43,17 +43,81 @@ std::shared_ptr<arrow::flight::Location> getDefaultLocation(
 
   return std::make_shared<arrow::flight::Location>(std::move(defaultLocation));
 }
-} // namespace
 
-// Wrapper for CallOptions which does not add any member variables,
-// but provides a write-only interface for adding call headers.
-class CallOptionsAddHeaders : public arrow::flight::FlightCallOptions,
-                              public arrow::flight::AddCallHeaders {
- public:
-  void AddHeader(const std::string& key, const std::string& value) override {
-    headers.emplace_back(key, value);
+template <typename T>
+bool testValue(const velox::common::Filter& filter, const T& value) {
+  if constexpr (std::is_same_v<T, bool>) {
+    return filter.testBool(value);
+  } else if constexpr (std::is_same_v<T, velox::int128_t>) {
+    return filter.testInt128(value);
+  } else if constexpr (std::is_integral_v<T>) {
+    return filter.testInt64(value);
+  } else if constexpr (std::is_same_v<T, float>) {
+    return filter.testFloat(value);
+  } else if constexpr (std::is_same_v<T, double>) {
+    return filter.testDouble(value);
+  } else if constexpr (std::is_same_v<T, velox::StringView>) {
+    return filter.testBytes(value.data(), value.size());
+  } else {
+    static_assert(std::is_same_v<T, velox::Timestamp>);
+    return filter.testTimestamp(value);
   }
-};
+}
+
+template <typename T>
+void filterRows(
+    const velox::common::Filter& filter,
+    const velox::DecodedVector& decoded,
+    velox::SelectivityVector& rows) {
+  for (auto row = rows.begin(); row < rows.end(); ++row) {
+    if (!rows.isValid(row)) {
+      continue;
+    }
+    const bool pass = decoded.isNullAt(row)
+        ? filter.testNull()
+        : testValue(filter, decoded.valueAt<T>(row));
+    if (!pass) {
+      rows.setValid(row, false);
+    }
+  }
+  rows.updateBounds();
+}
+
+// Deselects the rows of 'rows' for which 'decoded' does not pass 'filter'.
+void filterRows(
+    const velox::common::Filter& filter,
+    const velox::DecodedVector& decoded,
+    velox::SelectivityVector& rows) {
+  const auto& type = decoded.base()->type();
+  switch (type->kind()) {
+    case velox::TypeKind::BOOLEAN:
+      return filterRows<bool>(filter, decoded, rows);
+    case velox::TypeKind::TINYINT:
+      return filterRows<int8_t>(filter, decoded, rows);
+    case velox::TypeKind::SMALLINT:
+      return filterRows<int16_t>(filter, decoded, rows);
+    case velox::TypeKind::INTEGER:
+      return filterRows<int32_t>(filter, decoded, rows);
+    case velox::TypeKind::BIGINT:
+      return filterRows<int64_t>(filter, decoded, rows);
+    case velox::TypeKind::HUGEINT:
+      return filterRows<velox::int128_t>(filter, decoded, rows);
+    case velox::TypeKind::REAL:
+      return filterRows<float>(filter, decoded, rows);
+    case velox::TypeKind::DOUBLE:
+      return filterRows<double>(filter, decoded, rows);
+    case velox::TypeKind::VARCHAR:
+    case velox::TypeKind::VARBINARY:
+      return filterRows<velox::StringView>(filter, decoded, rows);
+    case velox::TypeKind::TIMESTAMP:
+      return filterRows<velox::Timestamp>(filter, decoded, rows);
+    default:
+      VELOX_UNSUPPORTED(
+          "Arrow Flight connector doesn't support dynamic filters on {}",
+          type->toString());
+  }
+}
+} // namespace
 
 std::shared_ptr<arrow::flight::FlightClientOptions>
 ArrowFlightConnector::initClientOpts(
@@ -98,25 +162,61 @@ ArrowFlightConnector::initClientOpts(
   return clientOpts;
 }
 
+ArrowFlightClientPool::Options ArrowFlightConnector::initClientPoolOptions(
+    const ArrowFlightConfig& config) {
+  ArrowFlightClientPool::Options options;
+  options.maxIdleClientsPerKey = config.clientPoolMaxIdleClients();
+  options.idleTimeout =
+      std::chrono::milliseconds(config.clientPoolIdleTimeoutMs());
+  options.healthCheckInterval =
+      std::chrono::milliseconds(config.clientPoolHealthCheckIntervalMs());
+  return options;
+}
+
+struct ArrowFlightDataSource::Stream {
+  // Declared before 'reader' so that the reader is destroyed before its
+  // client goes back to the pool.
+  ArrowFlightClientPool::Lease client;
+  std::unique_ptr<arrow::flight::FlightStreamReader> reader;
+
+  std::mutex mutex;
+  // Record batch read ahead on the executor, not yet returned by next().
+  std::optional<arrow::Result<arrow::flight::FlightStreamChunk>> nextChunk;
+  // Fulfilled when 'nextChunk' is set. Present while a driver waits for it.
+  std::optional<velox::ContinuePromise> nextChunkPromise;
+};
+
 ArrowFlightDataSource::ArrowFlightDataSource(
     const velox::RowTypePtr& outputType,
+    const velox::connector::ConnectorTableHandlePtr& tableHandle,
     const velox::connector::ColumnHandleMap& columnHandles,
     std::shared_ptr<Authenticator> authenticator,
     const ConnectorQueryCtx* connectorQueryCtx,
     const std::shared_ptr<ArrowFlightConfig>& flightConfig,
-    const std::shared_ptr<arrow::flight::FlightClientOptions>& clientOpts)
+    std::shared_ptr<ArrowFlightClientPool> clientPool,
+    folly::Executor* executor)
     : outputType_{outputType},
       authenticator_{std::move(authenticator)},
       connectorQueryCtx_{connectorQueryCtx},
       flightConfig_{flightConfig},
-      clientOpts_{clientOpts},
-      defaultLocation_(getDefaultLocation(flightConfig_)) {
-  VELOX_CHECK_NOT_NULL(clientOpts_, "FlightClientOptions is not initialized");
+      clientPool_{std::move(clientPool)},
+      defaultLocation_(getDefaultLocation(flightConfig_)),
+      executor_(executor) {
+  VELOX_CHECK_NOT_NULL(clientPool_, "Flight client pool is not initialized");
+
+  auto flightTableHandle =
+      std::dynamic_pointer_cast<const ArrowFlightTableHandle>(tableHandle);
+  VELOX_CHECK_NOT_NULL(
+      flightTableHandle, "table handle is not an ArrowFlightTableHandle");
+  for (const auto& [subfield, filter] : flightTableHandle->subfieldFilters()) {
+    // Only filters on top-level columns are pushed down.
+    if (subfield.path().size() == 1) {
+      pushdownFilters_[subfield.baseName()] = filter->clone();
+    }
+  }
 
-  // columnMapping_ contains the real column names in the expected order.
-  // This is later used by projectOutputColumns to filter out unnecessary
-  // columns from the fetched chunk.
-  columnMapping_.reserve(outputType_->size());
+  // columnNames_ contains the real column names in the expected order.
+  columnNames_.reserve(outputType_->size());
 
   for (const auto& columnName : outputType_->names()) {
     auto it = columnHandles.find(columnName);
@@ -132,11 +232,80 @@ ArrowFlightDataSource::ArrowFlightDataSource(
         "handle for column '{}' is not an ArrowFlightColumnHandle",
         columnName);
 
-    columnMapping_.push_back(handle->name());
+    columnNames_.push_back(handle->name());
+  }
+  importer_ = std::make_unique<RecordBatchImporter>(outputType_, columnNames_);
+}
+
+ArrowFlightDataSource::~ArrowFlightDataSource() {
+  closeStream();
+}
+
+void ArrowFlightDataSource::closeStream() {
+  if (stream_ == nullptr) {
+    return;
+  }
+  // The server keeps sending the rest of an unfinished stream otherwise. A
+  // read-ahead in flight returns early and drops the last reference.
+  stream_->reader->Cancel();
+  stream_ = nullptr;
+}
+
+void ArrowFlightDataSource::startReadAhead() {
+  if (executor_ == nullptr) {
+    return;
+  }
+  executor_->add([stream = stream_]() {
+    auto chunk = stream->reader->Next();
+    std::optional<velox::ContinuePromise> promise;
+    {
+      std::lock_guard<std::mutex> l(stream->mutex);
+      stream->nextChunk = std::move(chunk);
+      promise.swap(stream->nextChunkPromise);
+    }
+    if (promise.has_value()) {
+      promise->setValue();
+    }
+  });
+}
+
+void ArrowFlightDataSource::addDynamicFilter(
+    velox::column_index_t outputChannel,
+    const std::shared_ptr<velox::common::Filter>& filter) {
+  VELOX_CHECK_LT(outputChannel, columnNames_.size());
+  auto& dynamicFilter = dynamicFilters_[outputChannel];
+  if (dynamicFilter == nullptr) {
+    dynamicFilter = filter;
+  } else {
+    dynamicFilter = dynamicFilter->mergeWith(filter.get());
+  }
+  auto& pushdownFilter = pushdownFilters_[columnNames_[outputChannel]];
+  if (pushdownFilter == nullptr) {
+    pushdownFilter = filter;
+  } else {
+    pushdownFilter = pushdownFilter->mergeWith(filter.get());
   }
 }
 
+std::string ArrowFlightDataSource::makeTicket(std::string ticket) const {
+  if (!flightConfig_->pushdownEnabled()) {
+    return ticket;
+  }
+  PushdownTicket pushdown;
+  pushdown.ticket = std::move(ticket);
+  for (const auto& name : columnNames_) {
+    if (std::find(pushdown.columns.begin(), pushdown.columns.end(), name) ==
+        pushdown.columns.end()) {
+      pushdown.columns.push_back(name);
+    }
+  }
+  pushdown.filters.insert(pushdownFilters_.begin(), pushdownFilters_.end());
+  return pushdown.serialize();
+}
+
 void ArrowFlightDataSource::addSplit(std::shared_ptr<ConnectorSplit> split) {
+  closeStream();
+
   auto flightSplit = std::dynamic_pointer_cast<ArrowFlightSplit>(split);
   VELOX_CHECK(
       flightSplit, "ArrowFlightDataSource received wrong type of split");
@@ -159,62 +328,163 @@ void ArrowFlightDataSource::addSplit(std::shared_ptr<ConnectorSplit> split) {
     loc = *defaultLocation_;
   }
 
-  AFC_ASSIGN_OR_RAISE(
-      auto client, arrow::flight::FlightClient::Connect(loc, *clientOpts_));
+  auto stream = std::make_shared<Stream>();
+  ArrowFlightClientPool::AcquireStats stats;
+  stream->client = clientPool_->acquire(
+      loc, *authenticator_, connectorQueryCtx_->sessionProperties(), stats);
+  connectNanos_ += stats.connectNanos;
+  authNanos_ += stats.authNanos;
+  healthCheckNanos_ += stats.healthCheckNanos;
+  if (stats.reused) {
+    ++numClientsReused_;
+  } else {
+    ++numClientsCreated_;
+  }
 
-  CallOptionsAddHeaders callOptsAddHeaders{};
-  authenticator_->authenticateClient(
-      client, connectorQueryCtx_->sessionProperties(), callOptsAddHeaders);
+  const arrow::flight::Ticket ticket{
+      makeTicket(std::move(flightEndpoint.ticket.ticket))};
+  auto readerResult =
+      stream->client.client()->DoGet(stream->client.callOptions(), ticket);
+  if (!readerResult.ok()) {
+    stream->client.invalidate();
+  }
+  AFC_ASSIGN_OR_RAISE(stream->reader, readerResult);
+  stream_ = std::move(stream);
+  startReadAhead();
+}
 
-  auto readerResult = client->DoGet(callOptsAddHeaders, flightEndpoint.ticket);
-  AFC_ASSIGN_OR_RAISE(currentReader_, readerResult);
+void ArrowFlightDataSource::setFromDataSource(
+    std::unique_ptr<DataSource> sourceUnique) {
+  auto* source = dynamic_cast<ArrowFlightDataSource*>(sourceUnique.get());
+  VELOX_CHECK_NOT_NULL(source, "Bad DataSource type");
+  closeStream();
+  stream_ = std::move(source->stream_);
+  connectNanos_ += source->connectNanos_;
+  authNanos_ += source->authNanos_;
+  healthCheckNanos_ += source->healthCheckNanos_;
+  numClientsCreated_ += source->numClientsCreated_;
+  numClientsReused_ += source->numClientsReused_;
+  ++numPreloadedSplits_;
 }
 
 std::optional<velox::RowVectorPtr> ArrowFlightDataSource::next(
     uint64_t size,
-    velox::ContinueFuture& /* unused */) {
-  VELOX_CHECK_NOT_NULL(currentReader_, "Missing split, call addSplit() first");
+    velox::ContinueFuture& future) {
+  VELOX_CHECK_NOT_NULL(stream_, "Missing split, call addSplit() first");
 
-  AFC_ASSIGN_OR_RAISE(auto chunk, currentReader_->Next());
+  std::optional<arrow::Result<arrow::flight::FlightStreamChunk>> chunkResult;
+  if (executor_ == nullptr) {
+    chunkResult = stream_->reader->Next();
+  } else {
+    std::lock_guard<std::mutex> l(stream_->mutex);
+    if (!stream_->nextChunk.has_value()) {
+      auto [promise, readyFuture] = velox::makeVeloxContinuePromiseContract(
+          "ArrowFlightDataSource::next");
+      stream_->nextChunkPromise = std::move(promise);
+      future = std::move(readyFuture);
+      return std::nullopt;
+    }
+    chunkResult.swap(stream_->nextChunk);
+  }
+
+  if (!chunkResult->ok()) {
+    stream_->client.invalidate();
+    stream_ = nullptr;
+  }
+  AFC_ASSIGN_OR_RAISE(auto chunk, *chunkResult);
 
   // Null values in the chunk indicates that the Flight stream is complete.
   if (!chunk.data) {
-    currentReader_ = nullptr;
+    stream_->reader = nullptr;
+    stream_->client.release();
+    stream_ = nullptr;
     return nullptr;
   }
 
+  // Fetches the next record batch while this one is converted and processed
+  // by the downstream operators.
+  startReadAhead();
+
   // Extract only required columns from the record batch as a velox RowVector.
-  auto output = projectOutputColumns(chunk.data);
+  auto output =
+      importer_->importBatch(chunk.data, connectorQueryCtx_->memoryPool());
 
   completedRows_ += output->size();
   completedBytes_ += output->estimateFlatSize();
-  return output;
+  return applyDynamicFilters(output);
 }
 
-velox::RowVectorPtr ArrowFlightDataSource::projectOutputColumns(
-    const std::shared_ptr<arrow::RecordBatch>& input) {
-  velox::memory::MemoryPool* pool = connectorQueryCtx_->memoryPool();
-  std::vector<velox::VectorPtr> children;
-  children.reserve(columnMapping_.size());
-
-  // Extract and convert desired columns in the correct order.
-  for (const auto& name : columnMapping_) {
-    auto column = input->GetColumnByName(name);
-    VELOX_CHECK_NOT_NULL(column, "column with name '{}' not found", name);
-    ArrowArray array;
-    ArrowSchema schema;
-    AFC_RAISE_NOT_OK(arrow::ExportArray(*column, &array, &schema));
-    children.push_back(velox::importFromArrowAsOwner(schema, array, pool));
+velox::RowVectorPtr ArrowFlightDataSource::applyDynamicFilters(
+    const velox::RowVectorPtr& output) {
+  if (dynamicFilters_.empty()) {
+    return output;
+  }
+  velox::SelectivityVector rows(output->size());
+  velox::DecodedVector decoded;
+  for (const auto& [channel, filter] : dynamicFilters_) {
+    decoded.decode(*output->childAt(channel), rows);
+    filterRows(*filter, decoded, rows);
+  }
+  if (rows.isAllSelected()) {
+    return output;
   }
 
+  auto* pool = connectorQueryCtx_->memoryPool();
+  const auto numRows = rows.countSelected();
+  auto indices = velox::allocateIndices(numRows, pool);
+  auto* rawIndices = indices->asMutable<velox::vector_size_t>();
+  velox::vector_size_t numPassed = 0;
+  rows.applyToSelected([&](auto row) { rawIndices[numPassed++] = row; });
+
+  std::vector<velox::VectorPtr> children;
+  children.reserve(output->childrenSize());
+  for (const auto& child : output->children()) {
+    children.push_back(
+        velox::BaseVector::wrapInDictionary(nullptr, indices, numRows, child));
+  }
   return std::make_shared<velox::RowVector>(
       pool,
       outputType_,
       velox::BufferPtr() /*nulls*/,
-      input->num_rows(),
+      numRows,
       std::move(children));
 }
 
+std::unordered_map<std::string, velox::RuntimeMetric>
+ArrowFlightDataSource::getRuntimeStats() {
+  std::unordered_map<std::string, velox::RuntimeMetric> stats;
+  if (connectNanos_ > 0) {
+    stats.emplace(
+        "flightConnectNanos",
+        velox::RuntimeMetric(
+            connectNanos_, velox::RuntimeCounter::Unit::kNanos));
+  }
+  if (authNanos_ > 0) {
+    stats.emplace(
+        "flightAuthNanos",
+        velox::RuntimeMetric(authNanos_, velox::RuntimeCounter::Unit::kNanos));
+  }
+  if (healthCheckNanos_ > 0) {
+    stats.emplace(
+        "flightHealthCheckNanos",
+        velox::RuntimeMetric(
+            healthCheckNanos_, velox::RuntimeCounter::Unit::kNanos));
+  }
+  if (numClientsCreated_ > 0) {
+    stats.emplace(
+        "flightClientsCreated", velox::RuntimeMetric(numClientsCreated_));
+  }
+  if (numClientsReused_ > 0) {
+    stats.emplace(
+        "flightClientsReused", velox::RuntimeMetric(numClientsReused_));
+  }
+  if (numPreloadedSplits_ > 0) {
+    stats.emplace(
+        "flightPreloadedSplits", velox::RuntimeMetric(numPreloadedSplits_));
+  }
+  return stats;
+}
+
 std::unique_ptr<velox::connector::DataSource>
 ArrowFlightConnector::createDataSource(
     const velox::RowTypePtr& outputType,
@@ -223,11 +493,13 @@ ArrowFlightConnector::createDataSource(
     velox::connector::ConnectorQueryCtx* connectorQueryCtx) {
   return std::make_unique<ArrowFlightDataSource>(
       outputType,
+      tableHandle,
       columnHandles,
       authenticator_,
       connectorQueryCtx,
       flightConfig_,
-      clientOpts_);
+      clientPool_,
+      ioExecutor_);
 }
 
 } // namespace facebook::presto
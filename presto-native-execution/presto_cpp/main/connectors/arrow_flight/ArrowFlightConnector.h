@@ -13,9 +13,13 @@
  */
 #pragma once
 
+#include "presto_cpp/main/connectors/arrow_flight/ArrowFlightClientPool.h"
 #include "presto_cpp/main/connectors/arrow_flight/ArrowFlightConfig.h"
+#include "presto_cpp/main/connectors/arrow_flight/RecordBatchImporter.h"
 #include "presto_cpp/main/connectors/arrow_flight/auth/Authenticator.h"
 #include "velox/connectors/Connector.h"
+#include "velox/type/Filter.h"
+#include "velox/type/Subfield.h"
 
 namespace arrow {
 class RecordBatch;
@@ -30,15 +34,27 @@ namespace facebook::presto {
 
 class ArrowFlightTableHandle : public velox::connector::ConnectorTableHandle {
  public:
-  explicit ArrowFlightTableHandle(const std::string& connectorId)
-      : ConnectorTableHandle(connectorId), name_("arrow_flight") {}
+  /// @param subfieldFilters Filters the coordinator derived from the query
+  /// predicate. The query plan still evaluates the predicate, so they are only
+  /// used to let the Flight server prune rows (see PushdownTicket).
+  explicit ArrowFlightTableHandle(
+      const std::string& connectorId,
+      velox::common::SubfieldFilters subfieldFilters = {})
+      : ConnectorTableHandle(connectorId),
+        name_("arrow_flight"),
+        subfieldFilters_(std::move(subfieldFilters)) {}
 
   const std::string& name() const override {
     return name_;
   }
 
+  const velox::common::SubfieldFilters& subfieldFilters() const {
+    return subfieldFilters_;
+  }
+
  private:
   const std::string name_;
+  const velox::common::SubfieldFilters subfieldFilters_;
 };
 
 struct ArrowFlightSplit : public velox::connector::ConnectorSplit {
@@ -70,24 +86,37 @@ class ArrowFlightDataSource : public velox::connector::DataSource {
  public:
   ArrowFlightDataSource(
       const velox::RowTypePtr& outputType,
+      const velox::connector::ConnectorTableHandlePtr& tableHandle,
       const velox::connector::ColumnHandleMap& columnHandles,
       std::shared_ptr<Authenticator> authenticator,
       const velox::connector::ConnectorQueryCtx* connectorQueryCtx,
       const std::shared_ptr<ArrowFlightConfig>& flightConfig,
-      const std::shared_ptr<arrow::flight::FlightClientOptions>& clientOpts);
+      std::shared_ptr<ArrowFlightClientPool> clientPool,
+      folly::Executor* executor = nullptr);
+
+  ~ArrowFlightDataSource() override;
 
+  /// Starts the Flight stream of 'split'. With an executor, the first record
+  /// batch is also requested right away.
   void addSplit(
       std::shared_ptr<velox::connector::ConnectorSplit> split) override;
 
+  /// Takes over the stream of a data source prepared by split preloading.
+  void setFromDataSource(
+      std::unique_ptr<velox::connector::DataSource> source) override;
+
+  /// Returns the next record batch. With an executor, batches are read ahead
+  /// on it and std::nullopt is returned together with 'future' while the next
+  /// batch is not available yet. Without one, the call blocks.
   std::optional<velox::RowVectorPtr> next(
       uint64_t size,
-      velox::ContinueFuture& /* unused */) override;
+      velox::ContinueFuture& future) override;
 
+  /// Evaluates 'filter' on the rows returned from now on and, with pushdown
+  /// enabled, sends it to the server along with the splits added later.
   void addDynamicFilter(
       velox::column_index_t outputChannel,
-      const std::shared_ptr<velox::common::Filter>& filter) override {
-    VELOX_UNSUPPORTED("Arrow Flight connector doesn't support dynamic filters");
-  }
+      const std::shared_ptr<velox::common::Filter>& filter) override;
 
   uint64_t getCompletedBytes() override {
     return completedBytes_;
@@ -98,26 +127,55 @@ class ArrowFlightDataSource : public velox::connector::DataSource {
   }
 
   std::unordered_map<std::string, velox::RuntimeMetric> getRuntimeStats()
-      override {
-    return {};
-  }
+      override;
 
  private:
-  /// Convert an Arrow record batch to Velox RowVector.
-  /// Process only those columns that are present in outputType_.
-  velox::RowVectorPtr projectOutputColumns(
-      const std::shared_ptr<arrow::RecordBatch>& input);
+  struct Stream;
+
+  // Cancels the stream of the current split if it was not read to the end and
+  // returns its client to the pool.
+  void closeStream();
+
+  // Requests the next record batch of 'stream_' on 'executor_'.
+  void startReadAhead();
+
+  // Returns the ticket to request from the server for 'ticket' of a split.
+  std::string makeTicket(std::string ticket) const;
+
+  // Returns the rows of 'output' that pass 'dynamicFilters_'.
+  velox::RowVectorPtr applyDynamicFilters(const velox::RowVectorPtr& output);
 
   velox::RowTypePtr outputType_;
-  std::vector<std::string> columnMapping_;
-  std::unique_ptr<arrow::flight::FlightStreamReader> currentReader_;
+  // Converts the fetched record batches to 'outputType_', dropping unneeded
+  // columns.
+  std::unique_ptr<RecordBatchImporter> importer_;
+  // Names of the columns read from the server in output order.
+  std::vector<std::string> columnNames_;
+  // Filters sent to the server per column name, including dynamic filters.
+  folly::F14FastMap<std::string, std::shared_ptr<const velox::common::Filter>>
+      pushdownFilters_;
+  // Dynamic filters per output channel, evaluated by next().
+  folly::F14FastMap<
+      velox::column_index_t,
+      std::shared_ptr<const velox::common::Filter>>
+      dynamicFilters_;
+  // Stream of the current split. Shared with a read-ahead in flight.
+  std::shared_ptr<Stream> stream_;
   uint64_t completedRows_ = 0;
   uint64_t completedBytes_ = 0;
   std::shared_ptr<Authenticator> authenticator_;
   const velox::connector::ConnectorQueryCtx* const connectorQueryCtx_;
   const std::shared_ptr<ArrowFlightConfig> flightConfig_;
-  const std::shared_ptr<arrow::flight::FlightClientOptions> clientOpts_;
+  const std::shared_ptr<ArrowFlightClientPool> clientPool_;
   const std::shared_ptr<arrow::flight::Location> defaultLocation_;
+  folly::Executor* const executor_;
+
+  uint64_t connectNanos_{0};
+  uint64_t authNanos_{0};
+  uint64_t healthCheckNanos_{0};
+  uint64_t numClientsCreated_{0};
+  uint64_t numClientsReused_{0};
+  uint64_t numPreloadedSplits_{0};
 };
 
 class ArrowFlightConnector : public velox::connector::Connector {
@@ -125,15 +183,33 @@ class ArrowFlightConnector : public velox::connector::Connector {
   explicit ArrowFlightConnector(
       const std::string& id,
       std::shared_ptr<const velox::config::ConfigBase> config,
-      const char* authenticatorName = nullptr)
+      const char* authenticatorName = nullptr,
+      folly::Executor* ioExecutor = nullptr)
       : Connector(id),
         flightConfig_(std::make_shared<ArrowFlightConfig>(config)),
-        clientOpts_(initClientOpts(flightConfig_)),
+        clientPool_(ArrowFlightClientPool::create(
+            initClientOpts(flightConfig_),
+            initClientPoolOptions(*flightConfig_))),
         authenticator_(getAuthenticatorFactory(
                            authenticatorName
                                ? authenticatorName
                                : flightConfig_->authenticatorName())
-                           ->newAuthenticator(config)) {}
+                           ->newAuthenticator(config)),
+        ioExecutor_(ioExecutor) {}
+
+  /// Splits are preloaded on 'ioExecutor' when there is one, so that the
+  /// Flight calls of upcoming splits overlap with the current one.
+  bool supportsSplitPreload() const override {
+    return true;
+  }
+
+  bool canAddDynamicFilter() const override {
+    return true;
+  }
+
+  folly::Executor* executor() const override {
+    return ioExecutor_;
+  }
 
   std::unique_ptr<velox::connector::DataSource> createDataSource(
       const velox::RowTypePtr& outputType,
@@ -154,9 +230,13 @@ class ArrowFlightConnector : public velox::connector::Connector {
   static std::shared_ptr<arrow::flight::FlightClientOptions> initClientOpts(
       const std::shared_ptr<ArrowFlightConfig>& config);
 
+  static ArrowFlightClientPool::Options initClientPoolOptions(
+      const ArrowFlightConfig& config);
+
   const std::shared_ptr<ArrowFlightConfig> flightConfig_;
-  const std::shared_ptr<arrow::flight::FlightClientOptions> clientOpts_;
+  const std::shared_ptr<ArrowFlightClientPool> clientPool_;
   const std::shared_ptr<Authenticator> authenticator_;
+  folly::Executor* const ioExecutor_;
 };
 
 class ArrowFlightConnectorFactory : public velox::connector::ConnectorFactory {
@@ -176,7 +256,7 @@ class ArrowFlightConnectorFactory : public velox::connector::ConnectorFactory {
       folly::Executor* ioExecutor = nullptr,
       folly::Executor* cpuExecutor = nullptr) override {
     return std::make_shared<ArrowFlightConnector>(
-        id, config, authenticatorName_);
+        id, config, authenticatorName_, ioExecutor);
   }
 
  private:
@@ -13,6 +13,7 @@
  */
 #include "presto_cpp/main/connectors/arrow_flight/ArrowPrestoToVeloxConnector.h"
 #include <folly/base64.h>
+#include "presto_cpp/main/connectors/PrestoToVeloxConnectorUtils.h"
 #include "presto_cpp/main/connectors/arrow_flight/ArrowFlightConnector.h"
 #include "presto_cpp/presto_protocol/connector/arrow_flight/ArrowFlightConnectorProtocol.h"
 
@@ -46,10 +47,30 @@ ArrowPrestoToVeloxConnector::toVeloxColumnHandle(
 std::unique_ptr<velox::connector::ConnectorTableHandle>
 ArrowPrestoToVeloxConnector::toVeloxTableHandle(
     const protocol::TableHandle& tableHandle,
-    const VeloxExprConverter& /*exprConverter*/,
-    const TypeParser& /*typeParser*/) const {
+    const VeloxExprConverter& exprConverter,
+    const TypeParser& typeParser) const {
+  velox::common::SubfieldFilters subfieldFilters;
+  auto arrowLayout = std::dynamic_pointer_cast<
+      const protocol::arrow_flight::ArrowTableLayoutHandle>(
+      tableHandle.connectorTableLayout);
+  if (arrowLayout != nullptr && arrowLayout->tupleDomain.domains != nullptr) {
+    for (const auto& [column, domain] : *arrowLayout->tupleDomain.domains) {
+      auto arrowColumn =
+          std::dynamic_pointer_cast<protocol::arrow_flight::ArrowColumnHandle>(
+              column);
+      VELOX_CHECK_NOT_NULL(
+          arrowColumn, "Unexpected column handle type {}", column->_type);
+      try {
+        subfieldFilters[velox::common::Subfield(arrowColumn->columnName)] =
+            toFilter(domain, exprConverter, typeParser);
+      } catch (const velox::VeloxUserError&) {
+        // The filters are only a hint for the Flight server. Domains without
+        // a Velox filter are left to the query plan.
+      }
+    }
+  }
   return std::make_unique<presto::ArrowFlightTableHandle>(
-      tableHandle.connectorId);
+      tableHandle.connectorId, std::move(subfieldFilters));
 }
 
 std::unique_ptr<protocol::ConnectorProtocol>
@@ -0,0 +1,51 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/connectors/arrow_flight/PushdownTicket.h"
+#include <folly/base64.h>
+#include <folly/json.h>
+
+namespace facebook::presto {
+
+std::string PushdownTicket::serialize() const {
+  folly::dynamic columnsArray = folly::dynamic::array;
+  for (const auto& column : columns) {
+    columnsArray.push_back(column);
+  }
+  folly::dynamic filtersObject = folly::dynamic::object;
+  for (const auto& [column, filter] : filters) {
+    filtersObject[column] = filter->serialize();
+  }
+  folly::dynamic object = folly::dynamic::object;
+  object["ticket"] = folly::base64Encode(ticket);
+  object["columns"] = std::move(columnsArray);
+  object["filters"] = std::move(filtersObject);
+  return folly::toJson(object);
+}
+
+// static
+PushdownTicket PushdownTicket::deserialize(const std::string& data) {
+  const auto object = folly::parseJson(data);
+  PushdownTicket pushdown;
+  pushdown.ticket = folly::base64Decode(object["ticket"].asString());
+  for (const auto& column : object["columns"]) {
+    pushdown.columns.push_back(column.asString());
+  }
+  for (const auto& [column, filter] : object["filters"].items()) {
+    pushdown.filters[column.asString()] =
+        velox::ISerializable::deserialize<velox::common::Filter>(filter);
+  }
+  return pushdown;
+}
+
+} // namespace facebook::presto
@@ -0,0 +1,49 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include "velox/type/Filter.h"
+
+namespace facebook::presto {
+
+/// Flight ticket that wraps the ticket of a split together with the columns
+/// and filters of the scan, sent when 'arrow-flight.pushdown-enabled' is set.
+/// Servers that understand it can prune columns and rows at the source.
+/// Pushdown is best effort: the worker still evaluates the filters it relies
+/// on, so servers may ignore any part of it.
+///
+/// The ticket is a JSON object:
+///
+///   {
+///     "ticket": "<base64 of the original ticket>",
+///     "columns": ["<column>", ...],
+///     "filters": {"<column>": <serialized velox::common::Filter>, ...}
+///   }
+struct PushdownTicket {
+  std::string ticket;
+  /// Columns read by the scan. Empty if the scan only counts rows.
+  std::vector<std::string> columns;
+  /// Filters on top-level columns.
+  folly::F14FastMap<std::string, std::shared_ptr<const velox::common::Filter>>
+      filters;
+
+  std::string serialize() const;
+
+  /// Parses a ticket produced by serialize(). Requires the Filter
+  /// deserializers to be registered (velox::common::Filter::registerSerDe()).
+  static PushdownTicket deserialize(const std::string& data);
+};
+
+} // namespace facebook::presto
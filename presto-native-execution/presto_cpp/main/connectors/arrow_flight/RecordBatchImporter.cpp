@@ -0,0 +1,78 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/connectors/arrow_flight/RecordBatchImporter.h"
+#include <arrow/c/abi.h>
+#include <arrow/c/bridge.h>
+#include <arrow/record_batch.h>
+#include "presto_cpp/main/connectors/arrow_flight/Macros.h"
+#include "velox/vector/arrow/Bridge.h"
+
+namespace facebook::presto {
+
+RecordBatchImporter::RecordBatchImporter(
+    velox::RowTypePtr outputType,
+    std::vector<std::string> columnNames)
+    : outputType_(std::move(outputType)), columnNames_(std::move(columnNames)) {
+  VELOX_CHECK_EQ(outputType_->size(), columnNames_.size());
+}
+
+void RecordBatchImporter::resolveColumns(
+    const std::shared_ptr<arrow::Schema>& schema) {
+  selectedColumns_.clear();
+  childIndices_.clear();
+  childIndices_.reserve(columnNames_.size());
+  for (const auto& name : columnNames_) {
+    const auto column = schema->GetFieldIndex(name);
+    VELOX_CHECK_GE(column, 0, "column with name '{}' not found", name);
+    auto it =
+        std::find(selectedColumns_.begin(), selectedColumns_.end(), column);
+    childIndices_.push_back(it - selectedColumns_.begin());
+    if (it == selectedColumns_.end()) {
+      selectedColumns_.push_back(column);
+    }
+  }
+  schema_ = schema;
+}
+
+velox::RowVectorPtr RecordBatchImporter::importBatch(
+    const std::shared_ptr<arrow::RecordBatch>& input,
+    velox::memory::MemoryPool* pool) {
+  // All batches of a Flight stream normally share one schema object.
+  if (schema_ == nullptr ||
+      (input->schema() != schema_ && !input->schema()->Equals(*schema_))) {
+    resolveColumns(input->schema());
+  }
+
+  AFC_ASSIGN_OR_RAISE(auto projected, input->SelectColumns(selectedColumns_));
+  ArrowArray array;
+  ArrowSchema schema;
+  AFC_RAISE_NOT_OK(arrow::ExportRecordBatch(*projected, &array, &schema));
+  auto imported = std::dynamic_pointer_cast<velox::RowVector>(
+      velox::importFromArrowAsOwner(schema, array, pool));
+  VELOX_CHECK_NOT_NULL(imported);
+
+  std::vector<velox::VectorPtr> children;
+  children.reserve(childIndices_.size());
+  for (auto index : childIndices_) {
+    children.push_back(imported->childAt(index));
+  }
+  return std::make_shared<velox::RowVector>(
+      pool,
+      outputType_,
+      velox::BufferPtr() /*nulls*/,
+      input->num_rows(),
+      std::move(children));
+}
+
+} // namespace facebook::presto
@@ -0,0 +1,63 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "velox/vector/ComplexVector.h"
+
+namespace arrow {
+class RecordBatch;
+class Schema;
+} // namespace arrow
+
+namespace facebook::presto {
+
+/// Converts the Arrow record batches of a Flight stream to Velox RowVectors
+/// holding the requested columns in the requested order.
+///
+/// Column positions are resolved by name once per schema. The projected
+/// columns are exported through the Arrow C data interface as a single struct
+/// and imported with velox::importFromArrowAsOwner, which wraps the Arrow
+/// buffers instead of copying them: fixed-width values and validity bitmaps
+/// are shared, dictionary arrays become DictionaryVectors over the shared
+/// indices and Utf8/LargeUtf8 values become StringViews into the Arrow data
+/// buffer. Servers can send Utf8View columns to skip the StringView
+/// conversion as well.
+class RecordBatchImporter {
+ public:
+  /// @param outputType Type of the produced RowVectors.
+  /// @param columnNames Name of the Arrow column of each child of
+  /// 'outputType'. The same column may appear several times.
+  RecordBatchImporter(
+      velox::RowTypePtr outputType,
+      std::vector<std::string> columnNames);
+
+  velox::RowVectorPtr importBatch(
+      const std::shared_ptr<arrow::RecordBatch>& input,
+      velox::memory::MemoryPool* pool);
+
+ private:
+  void resolveColumns(const std::shared_ptr<arrow::Schema>& schema);
+
+  const velox::RowTypePtr outputType_;
+  const std::vector<std::string> columnNames_;
+
+  // Schema 'selectedColumns_' and 'childIndices_' were resolved for.
+  std::shared_ptr<arrow::Schema> schema_;
+  // Distinct positions of the requested columns in 'schema_'.
+  std::vector<int> selectedColumns_;
+  // Position in 'selectedColumns_' of each child of 'outputType_'.
+  std::vector<velox::column_index_t> childIndices_;
+};
+
+} // namespace facebook::presto
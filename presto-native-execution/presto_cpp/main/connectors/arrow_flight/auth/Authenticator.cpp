@@ -13,6 +13,8 @@
  */
 #include "presto_cpp/main/connectors/arrow_flight/auth/Authenticator.h"
 #include <arrow/flight/api.h>
+#include <fmt/format.h>
+#include <map>
 #include "velox/common/base/Exceptions.h"
 
 namespace facebook::presto {
@@ -24,6 +26,24 @@ auto& authenticatorFactories() {
 }
 } // namespace
 
+std::string Authenticator::identity(
+    const velox::config::ConfigBase* sessionProperties) {
+  if (sessionProperties == nullptr) {
+    return "";
+  }
+  const auto properties = sessionProperties->rawConfigsCopy();
+  std::map<std::string, std::string> sorted(
+      properties.begin(), properties.end());
+  std::string identity;
+  for (const auto& [key, value] : sorted) {
+    // Lengths are included so that different properties cannot produce the
+    // same identity.
+    identity +=
+        fmt::format("{}:{}={}:{};", key.size(), key, value.size(), value);
+  }
+  return identity;
+}
+
 bool registerAuthenticatorFactory(
     std::shared_ptr<AuthenticatorFactory> factory) {
   bool ok = authenticatorFactories().insert({factory->name(), factory}).second;
@@ -34,6 +34,15 @@ class Authenticator {
       std::unique_ptr<arrow::flight::FlightClient>& client,
       const velox::config::ConfigBase* sessionProperties,
       arrow::flight::AddCallHeaders& headerWriter) = 0;
+
+  /// Returns a string that is equal for two sets of session properties iff
+  /// authenticateClient() produces interchangeable clients for them. Used to
+  /// share authenticated clients between splits. The default includes all
+  /// session properties; override it to only include the properties the
+  /// authentication depends on.
+  /// @param sessionProperties connector session properties
+  virtual std::string identity(
+      const velox::config::ConfigBase* sessionProperties);
 };
 
 class AuthenticatorFactory {
@@ -69,6 +78,11 @@ class NoOpAuthenticator : public Authenticator {
       std::unique_ptr<arrow::flight::FlightClient>& client,
       const velox::config::ConfigBase* sessionProperties,
       arrow::flight::AddCallHeaders& headerWriter) override {}
+
+  std::string identity(
+      const velox::config::ConfigBase* sessionProperties) override {
+    return "";
+  }
 };
 
 class NoOpAuthenticatorFactory : public AuthenticatorFactory {
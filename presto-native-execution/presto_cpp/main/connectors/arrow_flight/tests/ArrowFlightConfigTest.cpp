@@ -29,6 +29,10 @@ TEST(ArrowFlightConfigTest, defaultConfig) {
   ASSERT_EQ(config.serverSslCertificate(), std::nullopt);
   ASSERT_EQ(config.clientSslCertificate(), std::nullopt);
   ASSERT_EQ(config.clientSslKey(), std::nullopt);
+  ASSERT_EQ(config.pushdownEnabled(), false);
+  ASSERT_EQ(config.clientPoolMaxIdleClients(), 8);
+  ASSERT_EQ(config.clientPoolIdleTimeoutMs(), 60'000);
+  ASSERT_EQ(config.clientPoolHealthCheckIntervalMs(), 10'000);
 }
 
 TEST(ArrowFlightConfigTest, overrideConfig) {
@@ -40,7 +44,11 @@ TEST(ArrowFlightConfigTest, overrideConfig) {
       {ArrowFlightConfig::kServerVerify, "false"},
       {ArrowFlightConfig::kServerSslCertificate, "my-cert.crt"},
       {ArrowFlightConfig::kClientSslCertificate, "/path/to/client.crt"},
-      {ArrowFlightConfig::kClientSslKey, "/path/to/client.key"}};
+      {ArrowFlightConfig::kClientSslKey, "/path/to/client.key"},
+      {ArrowFlightConfig::kPushdownEnabled, "true"},
+      {ArrowFlightConfig::kClientPoolMaxIdleClients, "0"},
+      {ArrowFlightConfig::kClientPoolIdleTimeoutMs, "1000"},
+      {ArrowFlightConfig::kClientPoolHealthCheckIntervalMs, "500"}};
   auto config = ArrowFlightConfig(
       std::make_shared<config::ConfigBase>(std::move(configMap)));
   ASSERT_EQ(config.authenticatorName(), "my-authenticator");
@@ -51,4 +59,8 @@ TEST(ArrowFlightConfigTest, overrideConfig) {
   ASSERT_EQ(config.serverSslCertificate(), "my-cert.crt");
   ASSERT_EQ(config.clientSslCertificate(), "/path/to/client.crt");
   ASSERT_EQ(config.clientSslKey(), "/path/to/client.key");
+  ASSERT_EQ(config.pushdownEnabled(), true);
+  ASSERT_EQ(config.clientPoolMaxIdleClients(), 0);
+  ASSERT_EQ(config.clientPoolIdleTimeoutMs(), 1000);
+  ASSERT_EQ(config.clientPoolHealthCheckIntervalMs(), 500);
 }
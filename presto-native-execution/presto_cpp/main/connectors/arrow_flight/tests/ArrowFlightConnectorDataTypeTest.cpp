@@ -184,6 +184,31 @@ TEST_F(ArrowFlightConnectorDataTypeTest, varcharSpecialChars) {
       .assertResults(makeRowVector({vec}));
 }
 
+TEST_F(ArrowFlightConnectorDataTypeTest, dictionaryVarcharType) {
+  std::vector<std::string> data = {
+      "Hello", "World", "Hello", "Hello World!", "World", "Hello World!"};
+
+  arrow::StringDictionaryBuilder builder;
+  for (const auto& value : data) {
+    AFC_RAISE_NOT_OK(builder.Append(value));
+  }
+  AFC_ASSIGN_OR_RAISE(auto dictionaryArray, builder.Finish());
+  updateTable(
+      "sample-data", makeArrowTable({"varchar_col"}, {dictionaryArray}));
+
+  auto vec =
+      makeFlatVector<facebook::velox::StringView>(makeStringViewVector(data));
+
+  core::PlanNodePtr plan;
+  plan = ArrowFlightPlanBuilder()
+             .flightTableScan(velox::ROW({"varchar_col"}, {velox::VARCHAR()}))
+             .planNode();
+
+  AssertQueryBuilder(plan)
+      .splits(makeSplits({"sample-data"}))
+      .assertResults(makeRowVector({vec}));
+}
+
 TEST_F(ArrowFlightConnectorDataTypeTest, varbinaryType) {
   std::vector<std::string> data = {"abc", "defghijk", "lmnopqrstuvwxyz"};
 
@@ -13,15 +13,19 @@
  */
 #include "presto_cpp/main/connectors/arrow_flight/ArrowFlightConnector.h"
 #include <arrow/testing/gtest_util.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/init/Init.h>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <numeric>
 #include "presto_cpp/main/connectors/arrow_flight/Macros.h"
+#include "presto_cpp/main/connectors/arrow_flight/PushdownTicket.h"
 #include "presto_cpp/main/connectors/arrow_flight/tests/utils/ArrowFlightConnectorTestBase.h"
 #include "presto_cpp/main/connectors/arrow_flight/tests/utils/ArrowFlightPlanBuilder.h"
 #include "presto_cpp/main/connectors/arrow_flight/tests/utils/Utils.h"
 #include "velox/common/base/tests/GTestUtils.h"
 #include "velox/common/config/Config.h"
+#include "velox/exec/PlanNodeStats.h"
 #include "velox/exec/tests/utils/AssertQueryBuilder.h"
 #include "velox/exec/tests/utils/PortUtil.h"
 
@@ -230,6 +234,201 @@ TEST_F(ArrowFlightConnectorTest, multipleSplits) {
       .assertResults(makeRowVector({intVec, varcharVec, doubleVec}));
 }
 
+TEST_F(ArrowFlightConnectorTest, reuseClientAcrossSplits) {
+  std::vector<int64_t> idData = {1, 12, 2, 7};
+  updateTable(
+      "sample-data",
+      makeArrowTable({"id"}, {makeNumericArray<arrow::Int64Type>(idData)}));
+
+  core::PlanNodeId scanNodeId;
+  auto plan = ArrowFlightPlanBuilder()
+                  .flightTableScan(velox::ROW({"id"}, {velox::BIGINT()}))
+                  .capturePlanNodeId(scanNodeId)
+                  .planNode();
+
+  std::vector<int64_t> expected;
+  for (auto i = 0; i < 3; ++i) {
+    expected.insert(expected.end(), idData.begin(), idData.end());
+  }
+
+  std::shared_ptr<exec::Task> task;
+  auto result =
+      AssertQueryBuilder(plan)
+          .splits(makeSplits({"sample-data", "sample-data", "sample-data"}))
+          .copyResults(pool(), task);
+  velox::test::assertEqualVectors(
+      makeRowVector({makeFlatVector<int64_t>(expected)}), result);
+
+  // The client of the first split is authenticated once and then reused.
+  auto stats = exec::toPlanStats(task->taskStats()).at(scanNodeId).customStats;
+  ASSERT_EQ(stats.at("flightClientsCreated").sum, 1);
+  ASSERT_EQ(stats.at("flightClientsReused").sum, 2);
+  ASSERT_EQ(stats.at("flightConnectNanos").count, 1);
+}
+
+class ArrowFlightConnectorAsyncTest : public ArrowFlightConnectorTestBase {
+ protected:
+  folly::Executor* connectorIoExecutor() override {
+    return ioExecutor_.get();
+  }
+
+  std::unique_ptr<folly::CPUThreadPoolExecutor> ioExecutor_{
+      std::make_unique<folly::CPUThreadPoolExecutor>(4)};
+};
+
+TEST_F(ArrowFlightConnectorAsyncTest, readAheadAndSplitPreload) {
+  vector_size_t numValues = 100;
+  std::vector<int64_t> idData(numValues);
+  std::iota(idData.begin(), idData.end(), 0);
+  updateTable(
+      "sample-data",
+      makeArrowTable({"id"}, {makeNumericArray<arrow::Int64Type>(idData)}));
+  setBatchSize(7);
+
+  core::PlanNodeId scanNodeId;
+  auto plan = ArrowFlightPlanBuilder()
+                  .flightTableScan(velox::ROW({"id"}, {velox::BIGINT()}))
+                  .capturePlanNodeId(scanNodeId)
+                  .planNode();
+
+  std::vector<int64_t> expected;
+  for (auto i = 0; i < 4; ++i) {
+    expected.insert(expected.end(), idData.begin(), idData.end());
+  }
+
+  std::shared_ptr<exec::Task> task;
+  auto result =
+      AssertQueryBuilder(plan)
+          .config(core::QueryConfig::kMaxSplitPreloadPerDriver, "2")
+          .splits(makeSplits(
+              {"sample-data", "sample-data", "sample-data", "sample-data"}))
+          .copyResults(pool(), task);
+  velox::test::assertEqualVectors(
+      makeRowVector({makeFlatVector<int64_t>(expected)}), result);
+
+  auto stats = exec::toPlanStats(task->taskStats()).at(scanNodeId).customStats;
+  ASSERT_GT(stats.at("flightPreloadedSplits").sum, 0);
+
+  // Unfinished streams are cancelled when the query stops early.
+  auto limitPlan = ArrowFlightPlanBuilder()
+                       .flightTableScan(velox::ROW({"id"}, {velox::BIGINT()}))
+                       .limit(0, 10, false)
+                       .planNode();
+  result = AssertQueryBuilder(limitPlan)
+               .config(core::QueryConfig::kMaxSplitPreloadPerDriver, "2")
+               .splits(makeSplits({"sample-data", "sample-data"}))
+               .copyResults(pool());
+  ASSERT_EQ(result->size(), 10);
+}
+
+class ArrowFlightConnectorPushdownTest : public ArrowFlightConnectorTestBase {
+ public:
+  ArrowFlightConnectorPushdownTest()
+      : ArrowFlightConnectorTestBase(
+            std::make_shared<velox::config::ConfigBase>(
+                std::unordered_map<std::string, std::string>{
+                    {ArrowFlightConfig::kPushdownEnabled, "true"}})) {}
+
+  void SetUp() override {
+    ArrowFlightConnectorTestBase::SetUp();
+    server_->enablePushdown();
+
+    std::vector<int64_t> idData(kNumRows);
+    std::vector<std::string> nameData(kNumRows);
+    std::vector<int32_t> valueData(kNumRows);
+    for (auto i = 0; i < kNumRows; ++i) {
+      idData[i] = i;
+      nameData[i] = fmt::format("name-{}", i);
+      valueData[i] = i * 10;
+    }
+    updateTable(
+        "sample-data",
+        makeArrowTable(
+            {"id", "name", "value"},
+            {makeNumericArray<arrow::Int64Type>(idData),
+             makeStringArray(nameData),
+             makeNumericArray<arrow::Int32Type>(valueData)}));
+  }
+
+ protected:
+  static constexpr int32_t kNumRows = 100;
+};
+
+TEST_F(ArrowFlightConnectorPushdownTest, ticketRoundTrip) {
+  PushdownTicket pushdown;
+  pushdown.ticket = std::string("binary\0ticket", 13);
+  pushdown.columns = {"id", "name"};
+  pushdown.filters["id"] =
+      std::make_shared<velox::common::BigintRange>(10, 19, false);
+
+  auto copy = PushdownTicket::deserialize(pushdown.serialize());
+  ASSERT_EQ(copy.ticket, pushdown.ticket);
+  ASSERT_EQ(copy.columns, pushdown.columns);
+  ASSERT_EQ(copy.filters.size(), 1);
+  ASSERT_TRUE(copy.filters.at("id")->testingEquals(*pushdown.filters["id"]));
+}
+
+TEST_F(ArrowFlightConnectorPushdownTest, subfieldFilters) {
+  velox::common::SubfieldFilters filters;
+  filters[velox::common::Subfield("id")] =
+      std::make_unique<velox::common::BigintRange>(10, 19, false);
+
+  // The plan keeps the predicate, as the filters of the table handle are only
+  // a hint for the server.
+  auto plan =
+      ArrowFlightPlanBuilder()
+          .flightTableScan(
+              velox::ROW({"id", "name"}, {velox::BIGINT(), velox::VARCHAR()}),
+              {},
+              true /*createDefaultColumnHandles*/,
+              std::move(filters))
+          .filter("id between 10 and 19")
+          .project({"id"})
+          .planNode();
+
+  std::vector<int64_t> expected(10);
+  std::iota(expected.begin(), expected.end(), 10);
+  AssertQueryBuilder(plan)
+      .splits(makeSplits({"sample-data"}))
+      .assertResults(makeRowVector({makeFlatVector<int64_t>(expected)}));
+
+  ASSERT_EQ(server_->numRowsSent(), 10);
+  ASSERT_EQ(
+      server_->lastColumnsSent(), (std::vector<std::string>{"id", "name"}));
+}
+
+TEST_F(ArrowFlightConnectorPushdownTest, dynamicFilters) {
+  auto planNodeIdGenerator = std::make_shared<core::PlanNodeIdGenerator>();
+  core::PlanNodeId scanNodeId;
+  auto plan =
+      ArrowFlightPlanBuilder(planNodeIdGenerator)
+          .flightTableScan(velox::ROW({"id"}, {velox::BIGINT()}))
+          .capturePlanNodeId(scanNodeId)
+          .hashJoin(
+              {"id"},
+              {"k"},
+              PlanBuilder(planNodeIdGenerator)
+                  .values({makeRowVector(
+                      {"k"}, {makeFlatVector<int64_t>({3, 50, 70})})})
+                  .planNode(),
+              "",
+              {"id"})
+          .planNode();
+
+  std::shared_ptr<exec::Task> task;
+  auto result = AssertQueryBuilder(plan)
+                    .splits(makeSplits({"sample-data"}))
+                    .copyResults(pool(), task);
+  velox::test::assertEqualVectors(
+      makeRowVector({makeFlatVector<int64_t>({3, 50, 70})}), result);
+
+  auto stats = exec::toPlanStats(task->taskStats()).at(scanNodeId).customStats;
+  ASSERT_EQ(stats.at("dynamicFiltersAccepted").sum, 1);
+  // The build side finishes before the probe side adds its split, so the
+  // server already prunes the rows that do not join.
+  ASSERT_LT(server_->numRowsSent(), kNumRows);
+}
+
 class ArrowFlightConnectorTestDefaultServer
     : public ArrowFlightConnectorTestBase {
  public:
@@ -0,0 +1,188 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <arrow/api.h>
+#include <folly/Benchmark.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+#include <numeric>
+
+#include "presto_cpp/main/connectors/arrow_flight/RecordBatchImporter.h"
+#include "presto_cpp/main/connectors/arrow_flight/tests/utils/Utils.h"
+#include "velox/common/memory/Memory.h"
+
+// Measures the conversion of Flight record batches to Velox vectors. Every
+// benchmark reports the time per row, so the rows/s of a type can be read
+// from the iters/s column.
+
+using namespace facebook::velox;
+
+namespace facebook::presto::test {
+namespace {
+
+constexpr int32_t kNumRows = 64 * 1024;
+
+std::shared_ptr<memory::MemoryPool>& pool() {
+  static auto pool = memory::memoryManager()->addLeafPool();
+  return pool;
+}
+
+std::vector<std::string> makeStrings(int32_t numDistinct) {
+  folly::Random::DefaultGenerator rng(42);
+  std::vector<std::string> strings(kNumRows);
+  for (auto& string : strings) {
+    const auto id = folly::Random::rand32(numDistinct, rng);
+    string = fmt::format("value-{}-{}", id, std::string(id % 20, 'x'));
+  }
+  return strings;
+}
+
+ArrowArrayPtr makeLargeStringArray(const std::vector<std::string>& values) {
+  arrow::LargeStringBuilder builder;
+  AFC_RAISE_NOT_OK(builder.AppendValues(values));
+  AFC_RETURN_OR_RAISE(builder.Finish());
+}
+
+ArrowArrayPtr makeDictionaryArray(const std::vector<std::string>& values) {
+  arrow::StringDictionaryBuilder builder;
+  for (const auto& value : values) {
+    AFC_RAISE_NOT_OK(builder.Append(value));
+  }
+  AFC_RETURN_OR_RAISE(builder.Finish());
+}
+
+struct ImportCase {
+  std::shared_ptr<arrow::RecordBatch> batch;
+  std::unique_ptr<RecordBatchImporter> importer;
+};
+
+ImportCase makeCase(ArrowArrayPtr array, TypePtr type) {
+  ImportCase importCase;
+  importCase.batch = makeRecordBatch({"c0"}, {std::move(array)});
+  importCase.importer = std::make_unique<RecordBatchImporter>(
+      ROW({"c0"}, {std::move(type)}), std::vector<std::string>{"c0"});
+  return importCase;
+}
+
+// One requested column out of 20 BIGINT columns.
+ImportCase makeWideCase() {
+  std::vector<int64_t> values(kNumRows);
+  std::iota(values.begin(), values.end(), 0);
+  std::vector<std::string> names;
+  arrow::ArrayVector arrays;
+  for (auto i = 0; i < 20; ++i) {
+    names.push_back(fmt::format("c{}", i));
+    arrays.push_back(makeNumericArray<arrow::Int64Type>(values));
+  }
+  ImportCase importCase;
+  importCase.batch = makeRecordBatch(names, arrays);
+  importCase.importer = std::make_unique<RecordBatchImporter>(
+      ROW({"c13"}, {BIGINT()}), std::vector<std::string>{"c13"});
+  return importCase;
+}
+
+size_t importRows(ImportCase& importCase) {
+  auto result =
+      importCase.importer->importBatch(importCase.batch, pool().get());
+  folly::doNotOptimizeAway(result);
+  return result->size();
+}
+
+ImportCase& bigintCase() {
+  static auto importCase = [] {
+    std::vector<int64_t> values(kNumRows);
+    std::iota(values.begin(), values.end(), 0);
+    return makeCase(makeNumericArray<arrow::Int64Type>(values), BIGINT());
+  }();
+  return importCase;
+}
+
+ImportCase& doubleCase() {
+  static auto importCase = [] {
+    std::vector<double> values(kNumRows, 1.5);
+    return makeCase(makeNumericArray<arrow::DoubleType>(values), DOUBLE());
+  }();
+  return importCase;
+}
+
+ImportCase& booleanCase() {
+  static auto importCase = [] {
+    std::vector<bool> values(kNumRows);
+    for (auto i = 0; i < kNumRows; ++i) {
+      values[i] = i % 3 == 0;
+    }
+    return makeCase(makeBooleanArray(values), BOOLEAN());
+  }();
+  return importCase;
+}
+
+ImportCase& varcharCase() {
+  static auto importCase =
+      makeCase(makeStringArray(makeStrings(kNumRows)), VARCHAR());
+  return importCase;
+}
+
+ImportCase& largeVarcharCase() {
+  static auto importCase =
+      makeCase(makeLargeStringArray(makeStrings(kNumRows)), VARCHAR());
+  return importCase;
+}
+
+ImportCase& dictionaryVarcharCase() {
+  static auto importCase =
+      makeCase(makeDictionaryArray(makeStrings(100)), VARCHAR());
+  return importCase;
+}
+
+ImportCase& wideCase() {
+  static auto importCase = makeWideCase();
+  return importCase;
+}
+
+BENCHMARK_MULTI(bigintColumn) {
+  return importRows(bigintCase());
+}
+
+BENCHMARK_MULTI(doubleColumn) {
+  return importRows(doubleCase());
+}
+
+BENCHMARK_MULTI(booleanColumn) {
+  return importRows(booleanCase());
+}
+
+BENCHMARK_MULTI(varcharColumn) {
+  return importRows(varcharCase());
+}
+
+BENCHMARK_MULTI(largeVarcharColumn) {
+  return importRows(largeVarcharCase());
+}
+
+BENCHMARK_MULTI(dictionaryVarcharColumn) {
+  return importRows(dictionaryVarcharCase());
+}
+
+BENCHMARK_MULTI(oneOfTwentyColumns) {
+  return importRows(wideCase());
+}
+
+} // namespace
+} // namespace facebook::presto::test
+
+int main(int argc, char** argv) {
+  folly::Init init{&argc, &argv};
+  memory::MemoryManager::initialize(memory::MemoryManager::Options{});
+  folly::runBenchmarks();
+  return 0;
+}
@@ -27,7 +27,8 @@ void ArrowFlightConnectorTestBase::SetUp() {
   OperatorTestBase::SetUp();
   presto::ArrowFlightConnectorFactory factory;
   velox::connector::registerConnector(
-      factory.newConnector(kFlightConnectorId, config_));
+      factory.newConnector(
+          kFlightConnectorId, config_, connectorIoExecutor()));
 
   ArrowFlightConfig config(config_);
   if (config.defaultServerPort().has_value()) {
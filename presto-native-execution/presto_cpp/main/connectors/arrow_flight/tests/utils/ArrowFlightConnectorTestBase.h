@@ -61,6 +61,12 @@ class ArrowFlightConnectorTestBase
   virtual void setFlightServerOptions(
       arrow::flight::FlightServerOptions* serverOptions) {}
 
+  /// Executor passed to the connector as its IO executor. Without one, the
+  /// connector reads synchronously and does not preload splits.
+  virtual folly::Executor* connectorIoExecutor() {
+    return nullptr;
+  }
+
  protected:
   explicit ArrowFlightConnectorTestBase(
       std::shared_ptr<velox::config::ConfigBase> config)
@@ -22,7 +22,8 @@ const std::string kFlightConnectorId = "test-flight";
 velox::exec::test::PlanBuilder& ArrowFlightPlanBuilder::flightTableScan(
     const velox::RowTypePtr& outputType,
     velox::connector::ColumnHandleMap assignments,
-    bool createDefaultColumnHandles) {
+    bool createDefaultColumnHandles,
+    velox::common::SubfieldFilters subfieldFilters) {
   if (createDefaultColumnHandles) {
     for (const auto& name : outputType->names()) {
       // Provide unaliased defaults for unmapped columns.
@@ -34,7 +35,8 @@ velox::exec::test::PlanBuilder& ArrowFlightPlanBuilder::flightTableScan(
   }
 
   return startTableScan()
-      .tableHandle(std::make_shared<ArrowFlightTableHandle>(kFlightConnectorId))
+      .tableHandle(std::make_shared<ArrowFlightTableHandle>(
+          kFlightConnectorId, std::move(subfieldFilters)))
       .outputType(outputType)
       .assignments(std::move(assignments))
       .endTableScan();
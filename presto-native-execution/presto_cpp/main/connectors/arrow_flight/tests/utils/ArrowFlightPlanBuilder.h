@@ -19,15 +19,19 @@ namespace facebook::presto::test {
 
 class ArrowFlightPlanBuilder : public velox::exec::test::PlanBuilder {
  public:
+  using PlanBuilder::PlanBuilder;
+
   /// @brief Add a table scan node to the Plan, using the Flight connector
   /// @param outputType The output type of the table scan node
   /// @param assignments mapping from the column aliases to real column handles
   /// @param createDefaultColumnHandles If true, generate column handles for
   /// for the columns which don't have an entry in assignments
+  /// @param subfieldFilters filters of the table handle
   velox::exec::test::PlanBuilder& flightTableScan(
       const velox::RowTypePtr& outputType,
       velox::connector::ColumnHandleMap assignments = {},
-      bool createDefaultColumnHandles = true);
+      bool createDefaultColumnHandles = true,
+      velox::common::SubfieldFilters subfieldFilters = {});
 };
 
 } // namespace facebook::presto::test
@@ -12,19 +12,106 @@
  * limitations under the License.
  */
 #include "presto_cpp/main/connectors/arrow_flight/tests/utils/TestingArrowFlightServer.h"
+#include <arrow/compute/api_vector.h>
+#include "presto_cpp/main/connectors/arrow_flight/PushdownTicket.h"
 
 namespace facebook::presto::test {
+namespace {
+// Returns false if 'row' of 'column' does not pass 'filter'. Columns of types
+// without support are not filtered.
+bool testRow(
+    const velox::common::Filter& filter,
+    const arrow::Array& column,
+    int64_t row) {
+  if (column.IsNull(row)) {
+    return filter.testNull();
+  }
+  switch (column.type_id()) {
+    case arrow::Type::INT64:
+      return filter.testInt64(
+          static_cast<const arrow::Int64Array&>(column).Value(row));
+    case arrow::Type::INT32:
+      return filter.testInt64(
+          static_cast<const arrow::Int32Array&>(column).Value(row));
+    case arrow::Type::STRING: {
+      const auto value =
+          static_cast<const arrow::StringArray&>(column).GetView(row);
+      return filter.testBytes(value.data(), value.size());
+    }
+    default:
+      return true;
+  }
+}
+
+arrow::Result<std::shared_ptr<arrow::Table>> applyPushdown(
+    const std::shared_ptr<arrow::Table>& table,
+    const PushdownTicket& pushdown) {
+  ARROW_ASSIGN_OR_RAISE(auto batch, table->CombineChunksToBatch());
+
+  arrow::BooleanBuilder mask;
+  ARROW_RETURN_NOT_OK(mask.Reserve(batch->num_rows()));
+  for (int64_t row = 0; row < batch->num_rows(); ++row) {
+    bool pass = true;
+    for (const auto& [name, filter] : pushdown.filters) {
+      auto column = batch->GetColumnByName(name);
+      if (column != nullptr && !testRow(*filter, *column, row)) {
+        pass = false;
+        break;
+      }
+    }
+    mask.UnsafeAppend(pass);
+  }
+  ARROW_ASSIGN_OR_RAISE(auto maskArray, mask.Finish());
+  ARROW_ASSIGN_OR_RAISE(
+      auto filtered, arrow::compute::Filter(batch, maskArray));
+  batch = filtered.record_batch();
+
+  std::vector<int> columns;
+  for (const auto& name : pushdown.columns) {
+    const auto index = batch->schema()->GetFieldIndex(name);
+    if (index < 0) {
+      return arrow::Status::KeyError("requested column does not exist: ", name);
+    }
+    columns.push_back(index);
+  }
+  ARROW_ASSIGN_OR_RAISE(batch, batch->SelectColumns(columns));
+  return arrow::Table::FromRecordBatches(batch->schema(), {batch});
+}
+} // namespace
+
+void TestingArrowFlightServer::enablePushdown() {
+  velox::common::Filter::registerSerDe();
+  pushdownEnabled_ = true;
+}
 
 arrow::Status TestingArrowFlightServer::DoGet(
     const arrow::flight::ServerCallContext& context,
     const arrow::flight::Ticket& request,
     std::unique_ptr<arrow::flight::FlightDataStream>* stream) {
-  auto it = tables_.find(request.ticket);
+  std::optional<PushdownTicket> pushdown;
+  if (pushdownEnabled_) {
+    try {
+      pushdown = PushdownTicket::deserialize(request.ticket);
+    } catch (const std::exception& e) {
+      return arrow::Status::Invalid("invalid pushdown ticket: ", e.what());
+    }
+  }
+  const auto& tableName =
+      pushdown.has_value() ? pushdown->ticket : request.ticket;
+  auto it = tables_.find(tableName);
   if (it == tables_.end()) {
     return arrow::Status::KeyError(
-        "requested table does not exist: ", request.ticket);
+        "requested table does not exist: ", tableName);
+  }
+  auto table = it->second;
+  if (pushdown.has_value()) {
+    ARROW_ASSIGN_OR_RAISE(table, applyPushdown(table, *pushdown));
+  }
+  numRowsSent_ += table->num_rows();
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    lastColumnsSent_ = table->ColumnNames();
   }
-  auto& table = it->second;
   auto reader = std::make_shared<arrow::TableBatchReader>(table);
   if (batchSize_.has_value()) {
     reader->set_chunksize(batchSize_.value());
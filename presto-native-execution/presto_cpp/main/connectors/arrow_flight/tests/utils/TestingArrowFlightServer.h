@@ -15,6 +15,8 @@
 
 #include <arrow/api.h>
 #include <arrow/flight/api.h>
+#include <atomic>
+#include <mutex>
 
 namespace facebook::presto::test {
 
@@ -24,6 +26,10 @@ namespace facebook::presto::test {
 /// Normally, the tickets would be obtained by calling GetFlightInfo,
 /// but since this is done by the coordinator this part is omitted.
 /// Instead, the ticket is simply the name of the table to fetch.
+///
+/// With pushdown enabled, tickets are PushdownTickets wrapping the table name.
+/// The server then only sends the requested columns and the rows that pass
+/// the filters on BIGINT, INTEGER and VARCHAR columns.
 class TestingArrowFlightServer : public arrow::flight::FlightServerBase {
  public:
   TestingArrowFlightServer() = default;
@@ -42,6 +48,19 @@ class TestingArrowFlightServer : public arrow::flight::FlightServerBase {
     batchSize_ = std::make_optional<int64_t>(batchSize);
   }
 
+  void enablePushdown();
+
+  /// Number of rows sent by all DoGet calls.
+  int64_t numRowsSent() const {
+    return numRowsSent_;
+  }
+
+  /// Names of the columns sent by the last DoGet call.
+  std::vector<std::string> lastColumnsSent() const {
+    std::lock_guard<std::mutex> l(mutex_);
+    return lastColumnsSent_;
+  }
+
   arrow::Status DoGet(
       const arrow::flight::ServerCallContext& context,
       const arrow::flight::Ticket& request,
@@ -50,6 +69,11 @@ class TestingArrowFlightServer : public arrow::flight::FlightServerBase {
  private:
   std::unordered_map<std::string, std::shared_ptr<arrow::Table>> tables_;
   std::optional<int64_t> batchSize_;
+  bool pushdownEnabled_{false};
+
+  std::atomic_int64_t numRowsSent_{0};
+  mutable std::mutex mutex_;
+  std::vector<std::string> lastColumnsSent_;
 };
 
 } // namespace facebook::presto::test
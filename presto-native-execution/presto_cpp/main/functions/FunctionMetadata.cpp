@@ -12,6 +12,11 @@
  * limitations under the License.
  */
 #include "presto_cpp/main/functions/FunctionMetadata.h"
+#include <folly/Synchronized.h>
+#include <folly/compression/Compression.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <atomic>
+#include <map>
 #include "presto_cpp/main/common/Utils.h"
 #include "presto_cpp/presto_protocol/core/presto_protocol_core.h"
 #include "velox/exec/Aggregate.h"
@@ -267,6 +272,41 @@ json buildWindowMetadata(
   return j;
 }
 
+std::atomic<uint64_t> metadataVersion{0};
+
+using ResponseCache = std::map<
+    std::optional<std::string>,
+    std::shared_ptr<const FunctionsMetadataResponse>>;
+
+folly::Synchronized<ResponseCache>& responseCache() {
+  static folly::Synchronized<ResponseCache> cache;
+  return cache;
+}
+
+std::shared_ptr<const FunctionsMetadataResponse> buildResponse(
+    const json& metadata,
+    uint64_t version) {
+  auto response = std::make_shared<FunctionsMetadataResponse>();
+  response->version = version;
+  response->body =
+      metadata.dump(-1, ' ', false, nlohmann::detail::error_handler_t::replace);
+
+  uint64_t hash1{0};
+  uint64_t hash2{0};
+  folly::hash::SpookyHashV2::Hash128(
+      response->body.data(), response->body.size(), &hash1, &hash2);
+  response->etag = fmt::format("\"{:016x}{:016x}\"", hash1, hash2);
+
+  try {
+    auto codec =
+        folly::compression::getCodec(folly::compression::CodecType::GZIP);
+    response->gzipBody = codec->compress(response->body);
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to compress function metadata: " << e.what();
+  }
+  return response;
+}
+
 } // namespace
 
 json getFunctionsMetadata(const std::optional<std::string>& catalog) {
@@ -338,4 +378,41 @@ json getFunctionsMetadata(const std::optional<std::string>& catalog) {
   return j;
 }
 
+std::shared_ptr<const FunctionsMetadataResponse> getFunctionsMetadataResponse(
+    const std::optional<std::string>& catalog) {
+  const auto version = functionsMetadataVersion();
+  {
+    auto cache = responseCache().rlock();
+    auto it = cache->find(catalog);
+    if (it != cache->end() && it->second->version == version) {
+      return it->second;
+    }
+  }
+
+  // Concurrent misses may build the same response more than once. This only
+  // happens after an invalidation and is cheaper than holding the lock while
+  // walking the registries.
+  const auto metadata = getFunctionsMetadata(catalog);
+  auto response = buildResponse(metadata, version);
+  if (catalog.has_value() && metadata.empty()) {
+    // Only catalogs with registered functions are cached, so that requests
+    // for arbitrary catalog names cannot grow the cache.
+    return response;
+  }
+  auto cache = responseCache().wlock();
+  auto& cached = (*cache)[catalog];
+  if (cached == nullptr || cached->version < version) {
+    cached = response;
+  }
+  return response;
+}
+
+void invalidateFunctionsMetadata() {
+  ++metadataVersion;
+}
+
+uint64_t functionsMetadataVersion() {
+  return metadataVersion.load();
+}
+
 } // namespace facebook::presto
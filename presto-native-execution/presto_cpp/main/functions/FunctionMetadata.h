@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <memory>
 #include <optional>
 #include "presto_cpp/external/json/nlohmann/json.hpp"
 
@@ -23,4 +24,31 @@ namespace facebook::presto {
 nlohmann::json getFunctionsMetadata(
     const std::optional<std::string>& catalog = std::nullopt);
 
+/// Serialized result of getFunctionsMetadata() as served by the sidecar.
+struct FunctionsMetadataResponse {
+  /// JSON text of the metadata.
+  std::string body;
+  /// 'body' compressed with gzip. Empty if compression failed.
+  std::string gzipBody;
+  /// Quoted strong entity tag derived from 'body'. Equal registries produce
+  /// equal tags, also across restarts.
+  std::string etag;
+  /// Value of functionsMetadataVersion() the response was built for.
+  uint64_t version;
+};
+
+/// Returns the serialized metadata for 'catalog'. The response is built on
+/// first use and cached until invalidateFunctionsMetadata() is called.
+/// Responses for catalogs without functions are not cached.
+std::shared_ptr<const FunctionsMetadataResponse> getFunctionsMetadataResponse(
+    const std::optional<std::string>& catalog = std::nullopt);
+
+/// Drops the responses cached by getFunctionsMetadataResponse(). Must be
+/// called after functions are registered once the server is running, e.g. by
+/// dynamically loaded libraries or remote function registration.
+void invalidateFunctionsMetadata();
+
+/// Incremented by every invalidateFunctionsMetadata() call.
+uint64_t functionsMetadataVersion();
+
 } // namespace facebook::presto
@@ -14,6 +14,7 @@
 #pragma once
 
 #include "presto_cpp/main/common/Configs.h"
+#include "presto_cpp/main/functions/FunctionMetadata.h"
 #include "velox/functions/Macros.h"
 #include "velox/functions/Registerer.h"
 
@@ -36,5 +37,6 @@ void registerPrestoFunction(
   LOG(INFO) << "Registering function: " << functionName;
   facebook::velox::registerFunction<T, TReturn, TArgs...>(
       {functionName}, constraints, false);
+  invalidateFunctionsMetadata();
 }
 } // namespace facebook::presto
@@ -14,11 +14,14 @@
 
 #include "presto_cpp/main/functions/remote/PrestoRestFunctionRegistration.h"
 
+#include <algorithm>
+
 #include <boost/url/encode.hpp>
 #include <boost/url/rfc/unreserved_chars.hpp>
 
 #include "presto_cpp/main/common/Configs.h"
 #include "presto_cpp/main/common/Utils.h"
+#include "presto_cpp/main/functions/FunctionMetadata.h"
 #include "presto_cpp/main/functions/remote/RestRemoteFunction.h"
 #include "presto_cpp/main/functions/remote/client/RestRemoteClient.h"
 
@@ -145,6 +148,24 @@ void PrestoRestFunctionRegistration::registerFunction(
       restFunctionHandle.version);
   metadata.location = functionLocation;
   metadata.serdeFormat = getSerdeFormat();
+  auto* systemConfig = SystemConfig::instance();
+  // Function handles do not tell whether a function is deterministic, so the
+  // result cache is only used by the functions configured to use it.
+  const auto cachedFunctions =
+      systemConfig->remoteFunctionServerRestResultCacheFunctions();
+  if (std::find(cachedFunctions.begin(), cachedFunctions.end(), functionName) !=
+      cachedFunctions.end()) {
+    metadata.resultCacheMaxBytes =
+        systemConfig->remoteFunctionServerRestResultCacheMaxBytes();
+  }
+  metadata.batchTargetBytes =
+      systemConfig->remoteFunctionServerRestBatchTargetBytes();
+  metadata.batchMaxWait = std::chrono::milliseconds(
+      systemConfig->remoteFunctionServerRestBatchMaxWaitMs());
+  metadata.requestMaxRows =
+      systemConfig->remoteFunctionServerRestRequestMaxRows();
+  metadata.maxRequestsInFlight =
+      systemConfig->remoteFunctionServerRestMaxRequestsInFlight();
 
   auto veloxSignature =
       buildVeloxSignatureFromPrestoSignature(restFunctionHandle.signature);
@@ -156,6 +177,7 @@ void PrestoRestFunctionRegistration::registerFunction(
       veloxSignatures,
       metadata,
       remoteClient);
+  invalidateFunctionsMetadata();
 
   // Update registration map
   {
@@ -0,0 +1,183 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/functions/remote/RemoteFunctionBatcher.h"
+
+#include <folly/ScopeGuard.h>
+#include <folly/experimental/coro/BlockingWait.h>
+
+#include "velox/common/memory/Memory.h"
+#include "velox/functions/remote/if/GetSerde.h"
+
+using namespace facebook::velox;
+
+namespace facebook::presto::functions::remote::rest {
+
+RemoteFunctionBatcher::RemoteFunctionBatcher(
+    std::string location,
+    velox::functions::remote::PageFormat serdeFormat,
+    RestRemoteClientPtr client,
+    RowTypePtr inputType,
+    uint64_t targetBytes,
+    std::chrono::milliseconds maxWait)
+    : location_(std::move(location)),
+      serdeFormat_(serdeFormat),
+      client_(std::move(client)),
+      inputType_(std::move(inputType)),
+      targetBytes_(targetBytes),
+      maxWait_(maxWait),
+      serde_(velox::functions::getSerde(serdeFormat_)),
+      pool_(memory::memoryManager()->addLeafPool()) {
+  VELOX_CHECK_NOT_NULL(client_);
+  VELOX_CHECK_GT(targetBytes_, 0);
+}
+
+std::unique_ptr<folly::IOBuf> RemoteFunctionBatcher::invoke(
+    const std::string& queryId,
+    std::unique_ptr<folly::IOBuf> payload,
+    const TypePtr& outputType) {
+  const auto bytes = payload->computeChainDataLength();
+  if (bytes >= targetBytes_) {
+    return send(std::move(payload));
+  }
+
+  std::shared_ptr<Batch> batch;
+  bool leader{false};
+  size_t index{0};
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    auto& state = queries_[queryId];
+    if (state.numInFlight > 0 || state.openBatch != nullptr) {
+      if (state.openBatch == nullptr) {
+        state.openBatch = std::make_shared<Batch>();
+        leader = true;
+      }
+      batch = state.openBatch;
+      index = batch->payloads.size();
+      batch->payloads.push_back(std::move(payload));
+      batch->bytes += bytes;
+      if (batch->bytes >= targetBytes_) {
+        state.openBatch = nullptr;
+        batch->ready.post();
+      }
+    } else {
+      ++state.numInFlight;
+    }
+  }
+
+  if (batch == nullptr) {
+    // No other request of the query to merge with.
+    SCOPE_EXIT {
+      requestDone(queryId);
+    };
+    return send(std::move(payload));
+  }
+
+  auto future = batch->done.getSemiFuture();
+  if (leader) {
+    batch->ready.try_wait_for(maxWait_);
+    {
+      std::lock_guard<std::mutex> l(mutex_);
+      auto& state = queries_[queryId];
+      if (state.openBatch == batch) {
+        state.openBatch = nullptr;
+      }
+      ++state.numInFlight;
+    }
+    SCOPE_EXIT {
+      requestDone(queryId);
+    };
+    run(*batch, outputType);
+  }
+  std::move(future).get();
+  return std::move(batch->responses[index]);
+}
+
+void RemoteFunctionBatcher::requestDone(const std::string& queryId) {
+  std::lock_guard<std::mutex> l(mutex_);
+  auto it = queries_.find(queryId);
+  if (it == queries_.end()) {
+    return;
+  }
+  auto& state = it->second;
+  --state.numInFlight;
+  if (state.openBatch != nullptr) {
+    state.openBatch->ready.post();
+  } else if (state.numInFlight == 0) {
+    queries_.erase(it);
+  }
+}
+
+void RemoteFunctionBatcher::run(Batch& batch, const TypePtr& outputType) {
+  try {
+    if (batch.payloads.size() == 1) {
+      batch.responses.push_back(send(std::move(batch.payloads[0])));
+      batch.done.setValue();
+      return;
+    }
+
+    std::vector<RowVectorPtr> inputs;
+    inputs.reserve(batch.payloads.size());
+    vector_size_t numRows{0};
+    for (auto& payload : batch.payloads) {
+      inputs.push_back(
+          IOBufToRowVector(*payload, inputType_, *pool_, serde_.get()));
+      numRows += inputs.back()->size();
+      payload.reset();
+    }
+    auto merged =
+        BaseVector::create<RowVector>(inputType_, numRows, pool_.get());
+    std::vector<vector_size_t> inputSizes;
+    inputSizes.reserve(inputs.size());
+    vector_size_t offset{0};
+    for (auto& input : inputs) {
+      merged->copy(input.get(), offset, 0, input->size());
+      offset += input->size();
+      inputSizes.push_back(input->size());
+      input.reset();
+    }
+
+    auto response = send(std::make_unique<folly::IOBuf>(
+        rowVectorToIOBuf(merged, numRows, *pool_, serde_.get())));
+    auto result =
+        IOBufToRowVector(*response, ROW({outputType}), *pool_, serde_.get());
+    VELOX_CHECK_EQ(
+        result->size(),
+        numRows,
+        "Remote function returned an unexpected number of rows: {}",
+        location_);
+
+    // Hands each member the rows of its request as a page of its own.
+    offset = 0;
+    for (auto size : inputSizes) {
+      auto rows =
+          std::static_pointer_cast<RowVector>(result->slice(offset, size));
+      batch.responses.push_back(std::make_unique<folly::IOBuf>(
+          rowVectorToIOBuf(rows, size, *pool_, serde_.get())));
+      offset += size;
+    }
+    batch.done.setValue();
+  } catch (const std::exception&) {
+    batch.done.setException(
+        folly::exception_wrapper(std::current_exception()));
+  }
+}
+
+std::unique_ptr<folly::IOBuf> RemoteFunctionBatcher::send(
+    std::unique_ptr<folly::IOBuf> payload) {
+  ++numRequests_;
+  return folly::coro::blockingWait(
+      client_->invokeFunction(location_, serdeFormat_, std::move(payload)));
+}
+
+} // namespace facebook::presto::functions::remote::rest
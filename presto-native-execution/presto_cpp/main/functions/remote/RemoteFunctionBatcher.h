@@ -0,0 +1,112 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include <folly/futures/SharedPromise.h>
+#include <folly/synchronization/SaturatingSemaphore.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "presto_cpp/main/functions/remote/client/RestRemoteClient.h"
+#include "velox/vector/ComplexVector.h"
+#include "velox/vector/VectorStream.h"
+
+namespace facebook::presto::functions::remote::rest {
+
+/// Merges small requests of one remote function that are sent concurrently by
+/// different drivers of the same query into a single request. A request is
+/// sent right away if no other request of the query is outstanding. Otherwise
+/// it opens a batch that later requests join, and the batch is sent when an
+/// outstanding request completes, when it reaches 'targetBytes', or after
+/// 'maxWait', whichever comes first. Requests of at least 'targetBytes' are
+/// always sent right away.
+///
+/// Requests and responses are serialized pages, so that the caller decodes
+/// the response and its errors the same way for batched and unbatched
+/// requests. A failed request fails all requests of the batch.
+class RemoteFunctionBatcher {
+ public:
+  RemoteFunctionBatcher(
+      std::string location,
+      velox::functions::remote::PageFormat serdeFormat,
+      RestRemoteClientPtr client,
+      velox::RowTypePtr inputType,
+      uint64_t targetBytes,
+      std::chrono::milliseconds maxWait);
+
+  /// Sends the request 'payload', which is a page of 'inputType' rows, and
+  /// returns a response page of 'outputType' with one row per request row.
+  /// Blocks until the response of the batch the request was added to
+  /// arrives.
+  std::unique_ptr<folly::IOBuf> invoke(
+      const std::string& queryId,
+      std::unique_ptr<folly::IOBuf> payload,
+      const velox::TypePtr& outputType);
+
+  /// Number of requests sent to the remote server.
+  uint64_t numRequests() const {
+    return numRequests_;
+  }
+
+ private:
+  struct Batch {
+    std::vector<std::unique_ptr<folly::IOBuf>> payloads;
+    uint64_t bytes{0};
+    // Posted when the batch fills up to 'targetBytes_' or an outstanding
+    // request of the query completes.
+    folly::SaturatingSemaphore<> ready;
+    // Response pages, one per entry of 'payloads'. Each member moves out its
+    // own response once 'done' is fulfilled.
+    std::vector<std::unique_ptr<folly::IOBuf>> responses;
+    folly::SharedPromise<folly::Unit> done;
+  };
+
+  struct QueryState {
+    // Number of requests of the query being sent.
+    int32_t numInFlight{0};
+    // Batch accepting new requests. Sent by the member that created it.
+    std::shared_ptr<Batch> openBatch;
+  };
+
+  // Sends the requests of 'batch' and fulfills its 'done' promise.
+  void run(Batch& batch, const velox::TypePtr& outputType);
+
+  // Sends 'payload' to the server.
+  std::unique_ptr<folly::IOBuf> send(std::unique_ptr<folly::IOBuf> payload);
+
+  // Marks a request of 'queryId' as complete. Wakes up the member waiting to
+  // send the open batch of the query, if any.
+  void requestDone(const std::string& queryId);
+
+  const std::string location_;
+  const velox::functions::remote::PageFormat serdeFormat_;
+  const RestRemoteClientPtr client_;
+  const velox::RowTypePtr inputType_;
+  const uint64_t targetBytes_;
+  const std::chrono::milliseconds maxWait_;
+  const std::unique_ptr<velox::VectorSerde> serde_;
+  // Holds the merged requests and responses of batches with several members
+  // while they are sent.
+  const std::shared_ptr<velox::memory::MemoryPool> pool_;
+
+  std::mutex mutex_;
+  // Queries with outstanding requests or an open batch.
+  folly::F14FastMap<std::string, QueryState> queries_;
+
+  std::atomic_uint64_t numRequests_{0};
+};
+
+} // namespace facebook::presto::functions::remote::rest
@@ -0,0 +1,116 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/functions/remote/RemoteFunctionResultCache.h"
+
+#include <cstring>
+
+#include "velox/common/base/Exceptions.h"
+
+namespace facebook::presto::functions::remote::rest {
+
+RemoteFunctionResultCache::RemoteFunctionResultCache(
+    std::shared_ptr<velox::memory::MemoryPool> pool,
+    uint64_t maxBytes)
+    : pool_(std::move(pool)), maxBytes_(maxBytes) {
+  VELOX_CHECK_NOT_NULL(pool_);
+  VELOX_CHECK_GT(maxBytes_, 0);
+}
+
+RemoteFunctionResultCache::~RemoteFunctionResultCache() {
+  clear();
+}
+
+void RemoteFunctionResultCache::get(
+    const std::vector<std::string_view>& keys,
+    std::vector<std::optional<std::string>>& results) {
+  results.resize(keys.size());
+  std::lock_guard<std::mutex> l(mutex_);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto it = entries_.find(keys[i]);
+    if (it == entries_.end()) {
+      results[i] = std::nullopt;
+      ++numMisses_;
+      continue;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    results[i] = std::string(it->second->result());
+    ++numHits_;
+  }
+}
+
+void RemoteFunctionResultCache::put(
+    std::string_view key,
+    std::string_view result) {
+  const uint64_t size = key.size() + result.size();
+  if (size > maxBytes_) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> l(mutex_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    // Another driver added the same result concurrently.
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return;
+  }
+  makeRoom(size);
+
+  Entry entry;
+  entry.data = static_cast<char*>(pool_->allocate(size));
+  entry.keySize = key.size();
+  entry.resultSize = result.size();
+  std::memcpy(entry.data, key.data(), key.size());
+  std::memcpy(entry.data + key.size(), result.data(), result.size());
+  lru_.push_front(entry);
+  entries_.emplace(entry.key(), lru_.begin());
+  usedBytes_ += size;
+}
+
+void RemoteFunctionResultCache::makeRoom(uint64_t bytes) {
+  while (!lru_.empty() && usedBytes_ + bytes > maxBytes_) {
+    const auto& entry = lru_.back();
+    entries_.erase(entry.key());
+    usedBytes_ -= entry.size();
+    free(entry);
+    lru_.pop_back();
+    ++numEvictions_;
+  }
+}
+
+void RemoteFunctionResultCache::free(const Entry& entry) {
+  pool_->free(entry.data, entry.size());
+}
+
+RemoteFunctionResultCache::Stats RemoteFunctionResultCache::stats() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  Stats stats;
+  stats.numHits = numHits_;
+  stats.numMisses = numMisses_;
+  stats.numEvictions = numEvictions_;
+  stats.numEntries = entries_.size();
+  stats.usedBytes = usedBytes_;
+  return stats;
+}
+
+void RemoteFunctionResultCache::clear() {
+  std::lock_guard<std::mutex> l(mutex_);
+  entries_.clear();
+  for (const auto& entry : lru_) {
+    free(entry);
+  }
+  lru_.clear();
+  usedBytes_ = 0;
+}
+
+} // namespace facebook::presto::functions::remote::rest
@@ -0,0 +1,103 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "velox/common/memory/MemoryPool.h"
+
+namespace facebook::presto::functions::remote::rest {
+
+/// LRU cache of remote function results of a deterministic function. Keys are
+/// the serialized argument rows and values the serialized result rows. Entries
+/// are allocated from a dedicated memory pool, and the least recently used
+/// entries are evicted once the pool would exceed 'maxBytes'. Thread-safe.
+class RemoteFunctionResultCache {
+ public:
+  struct Stats {
+    uint64_t numHits{0};
+    uint64_t numMisses{0};
+    uint64_t numEvictions{0};
+    size_t numEntries{0};
+    uint64_t usedBytes{0};
+  };
+
+  RemoteFunctionResultCache(
+      std::shared_ptr<velox::memory::MemoryPool> pool,
+      uint64_t maxBytes);
+
+  ~RemoteFunctionResultCache();
+
+  /// Looks up 'keys' and sets the corresponding entries of 'results' to the
+  /// cached result, or to std::nullopt on a miss. 'results' is resized to the
+  /// size of 'keys'.
+  void get(
+      const std::vector<std::string_view>& keys,
+      std::vector<std::optional<std::string>>& results);
+
+  /// Adds or replaces the result for 'key'. Entries larger than the capacity
+  /// of the cache are not added.
+  void put(std::string_view key, std::string_view result);
+
+  Stats stats() const;
+
+  void clear();
+
+ private:
+  struct Entry {
+    // Start of the pool allocation holding the key followed by the result.
+    char* data;
+    uint32_t keySize;
+    uint32_t resultSize;
+
+    std::string_view key() const {
+      return {data, keySize};
+    }
+
+    std::string_view result() const {
+      return {data + keySize, resultSize};
+    }
+
+    uint64_t size() const {
+      return keySize + resultSize;
+    }
+  };
+
+  using EntryList = std::list<Entry>;
+
+  // Evicts entries from the tail of 'lru_' until 'bytes' more fit.
+  void makeRoom(uint64_t bytes);
+
+  void free(const Entry& entry);
+
+  const std::shared_ptr<velox::memory::MemoryPool> pool_;
+  const uint64_t maxBytes_;
+
+  mutable std::mutex mutex_;
+  // Most recently used entry first.
+  EntryList lru_;
+  folly::F14FastMap<std::string_view, EntryList::iterator> entries_;
+  uint64_t usedBytes_{0};
+  uint64_t numHits_{0};
+  uint64_t numMisses_{0};
+  uint64_t numEvictions_{0};
+};
+
+} // namespace facebook::presto::functions::remote::rest
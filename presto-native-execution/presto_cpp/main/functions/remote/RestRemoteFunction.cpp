@@ -13,13 +13,112 @@
  */
 
 #include "presto_cpp/main/functions/remote/RestRemoteFunction.h"
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/Collect.h>
+#include <algorithm>
+#include <exception>
+
+#include "presto_cpp/main/functions/remote/RemoteFunctionBatcher.h"
+#include "presto_cpp/main/functions/remote/RemoteFunctionResultCache.h"
 #include "presto_cpp/main/functions/remote/client/RestRemoteClient.h"
+#include "velox/common/memory/Memory.h"
+#include "velox/core/QueryCtx.h"
 #include "velox/functions/remote/client/RemoteVectorFunction.h"
+#include "velox/functions/remote/if/GetSerde.h"
+#include "velox/row/CompactRow.h"
 
 using namespace facebook::velox;
 namespace facebook::presto::functions::remote::rest {
 namespace {
 
+// Result caches and batchers are shared by the live instances of a function
+// with the same location, serde and argument types, i.e. across drivers and
+// queries.
+std::string sharedStateKey(
+    const VeloxRemoteFunctionMetadata& metadata,
+    const RowTypePtr& inputType) {
+  return fmt::format(
+      "{}:{}:{}",
+      metadata.location,
+      static_cast<int>(metadata.serdeFormat),
+      inputType->toString());
+}
+
+template <typename T>
+using SharedStates =
+    folly::Synchronized<folly::F14FastMap<std::string, std::weak_ptr<T>>>;
+
+// Returns the state registered under 'key' in 'states', or registers the one
+// returned by 'create' if there is none. A state is destroyed with the last
+// function instance holding it, and the entries of destroyed states are
+// removed when a new state is registered.
+template <typename T, typename Create>
+std::shared_ptr<T> getSharedState(
+    SharedStates<T>& states,
+    const std::string& key,
+    Create&& create) {
+  auto lockedStates = states.wlock();
+  if (auto it = lockedStates->find(key); it != lockedStates->end()) {
+    if (auto state = it->second.lock()) {
+      return state;
+    }
+  }
+  for (auto it = lockedStates->begin(); it != lockedStates->end();) {
+    if (it->second.expired()) {
+      it = lockedStates->erase(it);
+    } else {
+      ++it;
+    }
+  }
+  std::shared_ptr<T> state = create();
+  (*lockedStates)[key] = state;
+  return state;
+}
+
+std::shared_ptr<RemoteFunctionResultCache> getResultCache(
+    const VeloxRemoteFunctionMetadata& metadata,
+    const RowTypePtr& inputType) {
+  if (metadata.resultCacheMaxBytes == 0 || !metadata.deterministic) {
+    return nullptr;
+  }
+  static SharedStates<RemoteFunctionResultCache> caches;
+  return getSharedState(caches, sharedStateKey(metadata, inputType), [&]() {
+    return std::make_shared<RemoteFunctionResultCache>(
+        memory::memoryManager()->addLeafPool(), metadata.resultCacheMaxBytes);
+  });
+}
+
+std::shared_ptr<RemoteFunctionBatcher> getBatcher(
+    const VeloxRemoteFunctionMetadata& metadata,
+    const RowTypePtr& inputType,
+    const RestRemoteClientPtr& restClient) {
+  if (metadata.batchTargetBytes == 0) {
+    return nullptr;
+  }
+  static SharedStates<RemoteFunctionBatcher> batchers;
+  return getSharedState(batchers, sharedStateKey(metadata, inputType), [&]() {
+    return std::make_shared<RemoteFunctionBatcher>(
+        metadata.location,
+        metadata.serdeFormat,
+        restClient,
+        inputType,
+        metadata.batchTargetBytes,
+        metadata.batchMaxWait);
+  });
+}
+
+RowTypePtr toInputType(const std::vector<exec::VectorFunctionArg>& inputArgs) {
+  std::vector<TypePtr> types;
+  types.reserve(inputArgs.size());
+  for (const auto& arg : inputArgs) {
+    types.push_back(arg.type);
+  }
+  return ROW(std::move(types));
+}
+
 class RestRemoteFunction : public velox::functions::RemoteVectorFunction {
  public:
   RestRemoteFunction(
@@ -30,7 +129,75 @@ class RestRemoteFunction : public velox::functions::RemoteVectorFunction {
       : RemoteVectorFunction(functionName, inputArgs, metadata),
         location_(metadata.location),
         serdeFormat_(metadata.serdeFormat),
-        restClient_(std::move(restClient)) {}
+        restClient_(std::move(restClient)),
+        inputType_(toInputType(inputArgs)),
+        resultCache_(getResultCache(metadata, inputType_)),
+        batcher_(getBatcher(metadata, inputType_, restClient_)),
+        requestMaxRows_(metadata.requestMaxRows),
+        maxRequestsInFlight_(metadata.maxRequestsInFlight),
+        serde_(velox::functions::getSerde(serdeFormat_)) {
+    VELOX_CHECK_GE(requestMaxRows_, 0);
+    VELOX_CHECK_GT(maxRequestsInFlight_, 0);
+  }
+
+  void apply(
+      const SelectivityVector& rows,
+      std::vector<VectorPtr>& args,
+      const TypePtr& outputType,
+      exec::EvalCtx& context,
+      VectorPtr& result) const override {
+    if (resultCache_ == nullptr || rows.countSelected() == 0) {
+      evaluate(rows, args, outputType, context, result);
+      return;
+    }
+
+    auto* pool = context.pool();
+    const auto numRows = rows.end();
+    auto input = std::make_shared<RowVector>(
+        pool, inputType_, nullptr, numRows, args);
+
+    // Maps each row to its result: results of the rows evaluated remotely
+    // come first, followed by the cached results.
+    BufferPtr indices = allocateIndices(numRows, pool);
+    auto* rawIndices = indices->asMutable<vector_size_t>();
+    // Rows to evaluate remotely: the first row of each distinct argument
+    // tuple that is not cached.
+    std::vector<vector_size_t> remoteRows;
+    std::vector<std::string> keys;
+    std::vector<std::optional<std::string>> cachedResults;
+    std::vector<std::string_view> hits;
+    lookupCachedResults(
+        rows, input, rawIndices, remoteRows, keys, cachedResults, hits);
+
+    VectorPtr remoteResult;
+    if (!remoteRows.empty()) {
+      std::vector<std::exception_ptr> remoteErrors;
+      remoteResult = evaluateRemotely(
+          remoteRows, args, input, outputType, context, remoteErrors);
+      cacheResults(
+          remoteRows, keys, remoteResult, remoteErrors, outputType, pool);
+      setErrors(rows, rawIndices, remoteErrors, context);
+    }
+
+    VectorPtr results = remoteResult;
+    if (!hits.empty()) {
+      auto cached =
+          row::CompactRow::deserialize(hits, ROW({outputType}), pool)
+              ->childAt(0);
+      if (remoteResult == nullptr) {
+        results = std::move(cached);
+      } else {
+        results = BaseVector::create(
+            outputType, remoteRows.size() + hits.size(), pool);
+        results->copy(remoteResult.get(), 0, 0, remoteRows.size());
+        results->copy(cached.get(), remoteRows.size(), 0, hits.size());
+      }
+    }
+    context.moveOrCopyResult(
+        BaseVector::wrapInDictionary(nullptr, indices, numRows, results),
+        rows,
+        result);
+  }
 
  protected:
   folly::coro::Task<
@@ -43,7 +210,7 @@ class RestRemoteFunction : public velox::functions::RemoteVectorFunction {
     // Clone the request payload for the REST call
     auto requestBody = request.inputs()->payload()->clone();
 
-    auto responseBody = restClient_->invokeFunction(
+    auto responseBody = co_await restClient_->invokeFunction(
         location_, serdeFormat_, std::move(requestBody));
 
     if (!responseBody) {
@@ -64,9 +231,290 @@ class RestRemoteFunction : public velox::functions::RemoteVectorFunction {
   }
 
  private:
+  // Serializes the argument rows as cache keys and looks them up. Sets
+  // 'rawIndices' for the hits and the first row of each distinct missing
+  // key, which is added to 'remoteRows'. The indices of the hits are
+  // relative to the start of the cached results and are rebased once the
+  // number of remote rows is known.
+  void lookupCachedResults(
+      const SelectivityVector& rows,
+      const RowVectorPtr& input,
+      vector_size_t* rawIndices,
+      std::vector<vector_size_t>& remoteRows,
+      std::vector<std::string>& keys,
+      std::vector<std::optional<std::string>>& cachedResults,
+      std::vector<std::string_view>& hits) const {
+    row::CompactRow serializer(input);
+    keys.resize(input->size());
+    std::vector<std::string_view> selectedKeys;
+    selectedKeys.reserve(rows.countSelected());
+    rows.applyToSelected([&](auto row) {
+      keys[row].resize(serializer.rowSize(row));
+      serializer.serialize(row, keys[row].data());
+      selectedKeys.push_back(keys[row]);
+    });
+    resultCache_->get(selectedKeys, cachedResults);
+
+    std::vector<vector_size_t> hitRows;
+    folly::F14FastMap<std::string_view, vector_size_t> distinctMisses;
+    vector_size_t i = 0;
+    rows.applyToSelected([&](auto row) {
+      if (cachedResults[i].has_value()) {
+        rawIndices[row] = hits.size();
+        hits.push_back(*cachedResults[i]);
+        hitRows.push_back(row);
+      } else {
+        auto [it, inserted] =
+            distinctMisses.emplace(keys[row], remoteRows.size());
+        if (inserted) {
+          remoteRows.push_back(row);
+        }
+        rawIndices[row] = it->second;
+      }
+      ++i;
+    });
+    for (auto row : hitRows) {
+      rawIndices[row] += remoteRows.size();
+    }
+  }
+
+  // Evaluates the function on 'rows' of 'args', through 'batcher_' if set.
+  // Otherwise, inputs of more than 'requestMaxRows_' rows are sent in
+  // several concurrent requests.
+  void evaluate(
+      const SelectivityVector& rows,
+      std::vector<VectorPtr>& args,
+      const TypePtr& outputType,
+      exec::EvalCtx& context,
+      VectorPtr& result) const {
+    const bool split = requestMaxRows_ > 0 && rows.end() > requestMaxRows_;
+    if (batcher_ == nullptr && !split) {
+      RemoteVectorFunction::apply(rows, args, outputType, context, result);
+      return;
+    }
+    // Reports failures the same way as RemoteVectorFunction::apply().
+    try {
+      if (batcher_ != nullptr) {
+        evaluateBatched(rows, args, outputType, context, result);
+      } else {
+        evaluateSplit(rows, args, outputType, context, result);
+      }
+    } catch (const VeloxRuntimeError&) {
+      throw;
+    } catch (const std::exception&) {
+      context.setErrors(rows, std::current_exception());
+    }
+  }
+
+  // Sends the rows in requests of up to 'requestMaxRows_' rows, keeping up
+  // to 'maxRequestsInFlight_' of them outstanding. Each request is serialized
+  // when it is about to be sent. The driver thread waits for the last
+  // response.
+  void evaluateSplit(
+      const SelectivityVector& rows,
+      std::vector<VectorPtr>& args,
+      const TypePtr& outputType,
+      exec::EvalCtx& context,
+      VectorPtr& result) const {
+    auto* pool = context.pool();
+    const auto numRows = rows.end();
+    auto input = std::make_shared<RowVector>(
+        pool, inputType_, nullptr, numRows, args);
+
+    std::vector<folly::coro::Task<std::unique_ptr<folly::IOBuf>>> requests;
+    for (vector_size_t offset = 0; offset < numRows;
+         offset += requestMaxRows_) {
+      requests.push_back(sendRows(
+          input, offset, std::min(requestMaxRows_, numRows - offset), pool));
+    }
+    auto responses = folly::coro::blockingWait(folly::coro::collectAllWindowed(
+        std::move(requests), maxRequestsInFlight_));
+
+    auto output = BaseVector::create(outputType, numRows, pool);
+    const auto outputRowType = ROW({outputType});
+    vector_size_t offset = 0;
+    for (const auto& response : responses) {
+      VELOX_CHECK_NOT_NULL(
+          response, "No response received from remote function invocation.");
+      const auto size = std::min(requestMaxRows_, numRows - offset);
+      auto rowsResult =
+          IOBufToRowVector(*response, outputRowType, *pool, serde_.get());
+      VELOX_CHECK_EQ(
+          rowsResult->size(),
+          size,
+          "Remote function returned an unexpected number of rows: {}",
+          location_);
+      output->copy(rowsResult->childAt(0).get(), offset, 0, size);
+      offset += size;
+    }
+    context.moveOrCopyResult(output, rows, result);
+  }
+
+  // Sends 'size' rows of 'input' starting at 'offset'.
+  folly::coro::Task<std::unique_ptr<folly::IOBuf>> sendRows(
+      RowVectorPtr input,
+      vector_size_t offset,
+      vector_size_t size,
+      memory::MemoryPool* pool) const {
+    auto rows = std::static_pointer_cast<RowVector>(input->slice(offset, size));
+    input.reset();
+    auto payload = std::make_unique<folly::IOBuf>(
+        rowVectorToIOBuf(rows, size, *pool, serde_.get()));
+    rows.reset();
+    co_return co_await restClient_->invokeFunction(
+        location_, serdeFormat_, std::move(payload));
+  }
+
+  // Sends the rows through 'batcher_', which blocks the driver thread until
+  // the response of the batch the rows are added to arrives.
+  void evaluateBatched(
+      const SelectivityVector& rows,
+      std::vector<VectorPtr>& args,
+      const TypePtr& outputType,
+      exec::EvalCtx& context,
+      VectorPtr& result) const {
+    auto* pool = context.pool();
+    const auto numRows = rows.end();
+    auto input = std::make_shared<RowVector>(
+        pool, inputType_, nullptr, numRows, args);
+    const auto* queryCtx = context.execCtx()->queryCtx();
+    auto response = batcher_->invoke(
+        queryCtx != nullptr ? queryCtx->queryId() : "",
+        std::make_unique<folly::IOBuf>(
+            rowVectorToIOBuf(input, numRows, *pool, serde_.get())),
+        outputType);
+    VELOX_CHECK_NOT_NULL(
+        response, "No response received from remote function invocation.");
+    auto output =
+        IOBufToRowVector(*response, ROW({outputType}), *pool, serde_.get());
+    VELOX_CHECK_EQ(
+        output->size(),
+        numRows,
+        "Remote function returned an unexpected number of rows: {}",
+        location_);
+    context.moveOrCopyResult(output->childAt(0), rows, result);
+  }
+
+  // Evaluates the function on 'remoteRows' of 'input' and returns a vector
+  // with one result per entry of 'remoteRows'. Uses a separate EvalCtx since
+  // the rows of the evaluation are not the rows of 'context'. Sets
+  // 'remoteErrors' to the error of each entry of 'remoteRows', or to nullptr
+  // for the entries without error.
+  VectorPtr evaluateRemotely(
+      const std::vector<vector_size_t>& remoteRows,
+      const std::vector<VectorPtr>& args,
+      const RowVectorPtr& input,
+      const TypePtr& outputType,
+      exec::EvalCtx& context,
+      std::vector<std::exception_ptr>& remoteErrors) const {
+    auto* pool = context.pool();
+    const vector_size_t numRemoteRows = remoteRows.size();
+    RowVectorPtr remoteInput = input;
+    std::vector<VectorPtr> remoteArgs;
+    if (numRemoteRows == input->size()) {
+      remoteArgs = args;
+    } else {
+      BufferPtr indices = allocateIndices(numRemoteRows, pool);
+      std::copy(
+          remoteRows.begin(),
+          remoteRows.end(),
+          indices->asMutable<vector_size_t>());
+      remoteArgs.reserve(args.size());
+      for (const auto& arg : args) {
+        remoteArgs.push_back(
+            BaseVector::wrapInDictionary(nullptr, indices, numRemoteRows, arg));
+      }
+      remoteInput = std::make_shared<RowVector>(
+          pool, inputType_, nullptr, numRemoteRows, remoteArgs);
+    }
+
+    exec::EvalCtx remoteContext(
+        context.execCtx(), context.exprSet(), remoteInput.get());
+    *remoteContext.mutableThrowOnError() = context.throwOnError();
+    VectorPtr remoteResult;
+    evaluate(
+        SelectivityVector(numRemoteRows),
+        remoteArgs,
+        outputType,
+        remoteContext,
+        remoteResult);
+
+    remoteErrors.assign(numRemoteRows, nullptr);
+    if (const auto& errors = remoteContext.errors()) {
+      for (vector_size_t i = 0; i < numRemoteRows; ++i) {
+        if (!errors->hasErrorAt(i)) {
+          continue;
+        }
+        try {
+          errors->throwIfErrorAt(i);
+        } catch (...) {
+          remoteErrors[i] = std::current_exception();
+        }
+      }
+    }
+    if (remoteResult == nullptr) {
+      // All rows failed.
+      remoteResult =
+          BaseVector::createNullConstant(outputType, numRemoteRows, pool);
+    }
+    return remoteResult;
+  }
+
+  // Sets the errors of the remote rows on all the rows of 'context' that map
+  // to them.
+  static void setErrors(
+      const SelectivityVector& rows,
+      const vector_size_t* rawIndices,
+      const std::vector<std::exception_ptr>& remoteErrors,
+      exec::EvalCtx& context) {
+    if (std::all_of(remoteErrors.begin(), remoteErrors.end(), [](auto& e) {
+          return e == nullptr;
+        })) {
+      return;
+    }
+    rows.applyToSelected([&](auto row) {
+      const auto index = rawIndices[row];
+      if (index < remoteErrors.size() && remoteErrors[index] != nullptr) {
+        context.setError(row, remoteErrors[index]);
+      }
+    });
+  }
+
+  // Caches the results of the remote rows that did not fail.
+  void cacheResults(
+      const std::vector<vector_size_t>& remoteRows,
+      const std::vector<std::string>& keys,
+      const VectorPtr& remoteResult,
+      const std::vector<std::exception_ptr>& remoteErrors,
+      const TypePtr& outputType,
+      memory::MemoryPool* pool) const {
+    auto resultRows = std::make_shared<RowVector>(
+        pool,
+        ROW({outputType}),
+        nullptr,
+        remoteRows.size(),
+        std::vector<VectorPtr>{remoteResult});
+    row::CompactRow serializer(resultRows);
+    std::string serializedResult;
+    for (vector_size_t i = 0; i < remoteRows.size(); ++i) {
+      if (remoteErrors[i] != nullptr) {
+        continue;
+      }
+      serializedResult.resize(serializer.rowSize(i));
+      serializer.serialize(i, serializedResult.data());
+      resultCache_->put(keys[remoteRows[i]], serializedResult);
+    }
+  }
+
   const std::string location_;
   const velox::functions::remote::PageFormat serdeFormat_;
   const RestRemoteClientPtr restClient_;
+  const RowTypePtr inputType_;
+  const std::shared_ptr<RemoteFunctionResultCache> resultCache_;
+  const std::shared_ptr<RemoteFunctionBatcher> batcher_;
+  const vector_size_t requestMaxRows_;
+  const int32_t maxRequestsInFlight_;
+  const std::unique_ptr<VectorSerde> serde_;
 };
 
 std::shared_ptr<exec::VectorFunction> createRestRemoteFunction(
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "presto_cpp/main/functions/remote/client/RestRemoteClient.h"
 #include "velox/functions/remote/client/RemoteVectorFunction.h"
 
@@ -23,6 +25,29 @@ struct VeloxRemoteFunctionMetadata
     : public velox::functions::RemoteVectorFunctionMetadata {
   /// URL of the HTTP/REST server for remote function.
   std::string location;
+
+  /// Capacity in bytes of the result cache shared by all instances of the
+  /// function. The cache is only used for deterministic functions. 0 disables
+  /// the cache.
+  uint64_t resultCacheMaxBytes{0};
+
+  /// Inputs smaller than this are merged with concurrent inputs of the same
+  /// query from other drivers into one request. The driver thread is blocked
+  /// until the response of the batch arrives. 0 disables batching.
+  uint64_t batchTargetBytes{0};
+
+  /// Maximum time the first input of a batch waits for an outstanding request
+  /// of the same query to complete.
+  std::chrono::milliseconds batchMaxWait{5};
+
+  /// Inputs with more rows than this are sent in several requests of up to
+  /// this many rows, which the server evaluates concurrently. Only used
+  /// without batching. 0 sends each input in one request.
+  int32_t requestMaxRows{0};
+
+  /// Maximum number of requests of one input that are outstanding at the
+  /// same time.
+  int32_t maxRequestsInFlight{4};
 };
 
 void registerVeloxRemoteFunction(
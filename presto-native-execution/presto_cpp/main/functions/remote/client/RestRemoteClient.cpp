@@ -31,6 +31,30 @@ inline std::string getContentType(velox::functions::remote::PageFormat fmt) {
       ? remote::CONTENT_TYPE_SPARK_UNSAFE_ROW
       : remote::CONTENT_TYPE_PRESTO_PAGE;
 }
+
+// Hands a response buffer allocated from 'pool' to the caller without a copy.
+// The returned IOBuf returns its memory to 'pool' when it is released, so the
+// response stays accounted for until the caller is done with it.
+std::unique_ptr<folly::IOBuf> takePoolBuffer(
+    std::unique_ptr<folly::IOBuf> buf,
+    const std::shared_ptr<memory::MemoryPool>& pool) {
+  struct Allocation {
+    std::shared_ptr<memory::MemoryPool> pool;
+    uint64_t capacity;
+  };
+  auto* allocation = new Allocation{pool, buf->capacity()};
+  return folly::IOBuf::takeOwnership(
+      buf->writableBuffer(),
+      buf->capacity(),
+      buf->headroom(),
+      buf->length(),
+      [](void* data, void* userData) {
+        auto* allocation = static_cast<Allocation*>(userData);
+        allocation->pool->free(data, allocation->capacity);
+        delete allocation;
+      },
+      allocation);
+}
 } // namespace
 
 RestRemoteClient::RestRemoteClient(const std::string& url) : url_(url) {
@@ -62,32 +86,24 @@ RestRemoteClient::~RestRemoteClient() {
   evbThread_.reset();
 }
 
-std::unique_ptr<folly::IOBuf> RestRemoteClient::invokeFunction(
+folly::coro::Task<std::unique_ptr<folly::IOBuf>>
+RestRemoteClient::invokeFunction(
     const std::string& fullUrl,
     velox::functions::remote::PageFormat serdeFormat,
     std::unique_ptr<folly::IOBuf> requestPayload) const {
+  std::unique_ptr<folly::IOBuf> responseBody;
   try {
     folly::Uri uri(fullUrl);
     const std::string contentType = getContentType(serdeFormat);
-    auto message = std::make_unique<proxygen::HTTPMessage>();
-    message->setMethod(proxygen::HTTPMethod::POST);
-    message->setURL(uri.path());
-    message->setHTTPVersion(1, 1);
-    message->getHeaders().add("Content-Type", contentType);
-    message->getHeaders().add("Accept", contentType);
-
-    requestPayload->coalesce();
-    std::string requestBody = requestPayload->moveToFbString().toStdString();
-
-    auto sendFuture = httpClient_->sendRequest(*message, requestBody);
-    sendFuture.wait();
+    proxygen::HTTPMessage message;
+    message.setMethod(proxygen::HTTPMethod::POST);
+    message.setURL(uri.path());
+    message.setHTTPVersion(1, 1);
+    message.getHeaders().add("Content-Type", contentType);
+    message.getHeaders().add("Accept", contentType);
 
-    VELOX_CHECK(
-        sendFuture.hasValue(),
-        "Invalid response returned from HTTP request to {}.",
-        uri.host());
-
-    std::unique_ptr<http::HttpResponse> resp = std::move(sendFuture).get();
+    std::unique_ptr<http::HttpResponse> resp =
+        co_await httpClient_->sendRequest(message, std::move(requestPayload));
 
     if (!resp) {
       VELOX_FAIL(
@@ -107,11 +123,22 @@ std::unique_ptr<folly::IOBuf> RestRemoteClient::invokeFunction(
           fullUrl);
     }
 
-    return folly::IOBuf::copyBuffer(resp->dumpBodyChain());
+    // Chain the received buffers instead of flattening them into a copy.
+    for (auto& buf : resp->consumeBody()) {
+      auto body = takePoolBuffer(std::move(buf), memPool_);
+      if (responseBody == nullptr) {
+        responseBody = std::move(body);
+      } else {
+        responseBody->appendToChain(std::move(body));
+      }
+    }
+    if (responseBody == nullptr) {
+      responseBody = folly::IOBuf::create(0);
+    }
   } catch (const std::exception& ex) {
     VELOX_FAIL("HTTP invocation failed for URL {}: {}", fullUrl, ex.what());
   }
-  return nullptr;
+  co_return responseBody;
 }
 
 } // namespace facebook::presto::functions::remote::rest
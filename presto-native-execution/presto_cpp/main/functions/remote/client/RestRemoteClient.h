@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <folly/experimental/coro/Task.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
 
 #include "presto_cpp/main/common/Configs.h"
@@ -28,7 +29,12 @@ class RestRemoteClient {
 
   ~RestRemoteClient();
 
-  std::unique_ptr<folly::IOBuf> invokeFunction(
+  /// Posts 'requestPayload' to 'fullUrl' and completes with the response
+  /// payload. Neither the request nor the response body is flattened or
+  /// copied, and no thread is blocked while the request is outstanding. The
+  /// response buffers stay allocated from this client's memory pool until the
+  /// returned IOBuf chain is released.
+  folly::coro::Task<std::unique_ptr<folly::IOBuf>> invokeFunction(
       const std::string& fullUrl,
       velox::functions::remote::PageFormat serdeFormat,
       std::unique_ptr<folly::IOBuf> requestPayload) const;
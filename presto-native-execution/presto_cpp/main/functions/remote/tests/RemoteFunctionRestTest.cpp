@@ -117,6 +117,53 @@ class RemoteFunctionRestTest
     metadata.location = location_ + "/remote_round";
     registerVeloxRemoteFunction(
         "remote_round", roundSignatures, metadata, restClient_);
+    auto strLenSignatures = {exec::FunctionSignatureBuilder()
+                                 .returnType("integer")
+                                 .argumentType("varchar")
+                                 .build()};
+    metadata.location = location_ + "/remote_strlen";
+    metadata.resultCacheMaxBytes = 1 << 20;
+    registerVeloxRemoteFunction(
+        "remote_strlen_cached", strLenSignatures, metadata, restClient_);
+    metadata.location = location_ + "/remote_inverse_cdf";
+    registerVeloxRemoteFunction(
+        "remote_inverse_cdf_cached",
+        {exec::FunctionSignatureBuilder()
+             .returnType("double")
+             .argumentType("double")
+             .argumentType("double")
+             .build()},
+        metadata,
+        restClient_);
+    metadata.location = location_ + "/remote_strlen";
+    metadata.resultCacheMaxBytes = 0;
+    metadata.requestMaxRows = 2;
+    metadata.maxRequestsInFlight = 2;
+    registerVeloxRemoteFunction(
+        "remote_strlen_split", strLenSignatures, metadata, restClient_);
+    metadata.location = location_ + "/remote_round";
+    registerVeloxRemoteFunction(
+        "remote_round_split", roundSignatures, metadata, restClient_);
+    metadata.location = location_ + "/remote_strlen";
+    metadata.requestMaxRows = 0;
+    metadata.batchTargetBytes = 1 << 20;
+    metadata.batchMaxWait = std::chrono::milliseconds(10);
+    registerVeloxRemoteFunction(
+        "remote_strlen_batched", strLenSignatures, metadata, restClient_);
+    metadata.location = location_ + "/remote_round";
+    registerVeloxRemoteFunction(
+        "remote_round_batched", roundSignatures, metadata, restClient_);
+    metadata.resultCacheMaxBytes = 1 << 20;
+    metadata.location = location_ + "/remote_remove_char";
+    registerVeloxRemoteFunction(
+        "remote_remove_char_cached_batched",
+        {exec::FunctionSignatureBuilder()
+             .returnType("varchar")
+             .argumentType("varchar")
+             .argumentType("varchar")
+             .build()},
+        metadata,
+        restClient_);
   }
 
   void initializeServer(uint16_t servicePort) {
@@ -282,6 +329,106 @@ TEST_P(RemoteFunctionRestTest, functionNotAvailable) {
       "Server responded with status 400. Body: 'Function 'remote_round' is not available.'");
 }
 
+TEST_P(RemoteFunctionRestTest, resultCache) {
+  auto inputVector = makeNullableFlatVector<StringView>(
+      {"hello", "from", "hello", std::nullopt, "hello", "remote", "from"});
+  auto expected =
+      makeNullableFlatVector<int32_t>({5, 4, 5, std::nullopt, 5, 6, 4});
+  for (int i = 0; i < 2; ++i) {
+    auto results = evaluate<SimpleVector<int32_t>>(
+        "remote_strlen_cached(c0)", makeRowVector({inputVector}));
+    assertEqualVectors(expected, results);
+  }
+
+  // Mix of cached and new arguments.
+  inputVector = makeFlatVector<StringView>({"server", "hello", "server", "a"});
+  auto results = evaluate<SimpleVector<int32_t>>(
+      "remote_strlen_cached(c0)", makeRowVector({inputVector}));
+  assertEqualVectors(makeFlatVector<int32_t>({6, 5, 6, 1}), results);
+
+  // Only the selected rows are evaluated.
+  results = evaluate<SimpleVector<int32_t>>(
+      "if(length(c0) > 1, remote_strlen_cached(c0), 0)",
+      makeRowVector({inputVector}));
+  assertEqualVectors(makeFlatVector<int32_t>({6, 5, 6, 0}), results);
+}
+
+TEST_P(RemoteFunctionRestTest, resultCacheFailure) {
+  auto data = makeRowVector(
+      {makeFlatVector<double>({0.95, -0.1, 0.95}),
+       makeFlatVector<double>({4, 4, 4})});
+  // Failed evaluations are not cached.
+  for (int i = 0; i < 2; ++i) {
+    VELOX_ASSERT_THROW(
+        evaluate<SimpleVector<double>>(
+            "remote_inverse_cdf_cached(c0, c1)", data),
+        "inverse_chi_squared_cdf: p must be in (0,1)");
+  }
+
+  data = makeRowVector(
+      {makeFlatVector<double>({0.95, 0.95}), makeFlatVector<double>({4, 1})});
+  for (int i = 0; i < 2; ++i) {
+    auto results = evaluate<SimpleVector<double>>(
+        "remote_inverse_cdf_cached(c0, c1)", data);
+    assertEqualVectors(makeFlatVector<double>({9.49, 3.84}), results);
+  }
+}
+
+TEST_P(RemoteFunctionRestTest, splitRequests) {
+  auto inputVector = makeNullableFlatVector<StringView>(
+      {"hello", "from", std::nullopt, "remote", "server", "a", "ab"});
+  auto results = evaluate<SimpleVector<int32_t>>(
+      "remote_strlen_split(c0)", makeRowVector({inputVector}));
+  assertEqualVectors(
+      makeNullableFlatVector<int32_t>({5, 4, std::nullopt, 6, 6, 1, 2}),
+      results);
+
+  // Only the selected rows are returned.
+  results = evaluate<SimpleVector<int32_t>>(
+      "if(length(c0) > 1, remote_strlen_split(c0), 0)",
+      makeRowVector({inputVector}));
+  assertEqualVectors(makeFlatVector<int32_t>({5, 4, 0, 6, 6, 0, 2}), results);
+
+  // Inputs of up to 'requestMaxRows' rows are sent in one request.
+  results = evaluate<SimpleVector<int32_t>>(
+      "remote_strlen_split(c0)",
+      makeRowVector({makeFlatVector<StringView>({"ab"})}));
+  assertEqualVectors(makeFlatVector<int32_t>({2}), results);
+
+  VELOX_ASSERT_THROW(
+      evaluate<SimpleVector<int32_t>>(
+          "remote_round_split(c0)",
+          makeRowVector({makeFlatVector<int32_t>({-10, -20, -30})})),
+      "Server responded with status 400. Body: 'Function 'remote_round' is not available.'");
+}
+
+TEST_P(RemoteFunctionRestTest, batching) {
+  auto inputVector =
+      makeFlatVector<StringView>({"hello", "from", "remote", "server"});
+  auto results = evaluate<SimpleVector<int32_t>>(
+      "remote_strlen_batched(c0)", makeRowVector({inputVector}));
+  assertEqualVectors(makeFlatVector<int32_t>({5, 4, 6, 6}), results);
+
+  auto input = makeFlatVector<StringView>(
+      {"hello from remote server", "testing remote server", "hello"});
+  auto charToRemove = makeFlatVector<StringView>({"o", "e", "o"});
+  auto expected = makeFlatVector<StringView>(
+      {"hell frm remte server", "tsting rmot srvr", "hell"});
+  for (int i = 0; i < 2; ++i) {
+    auto removed = evaluate<SimpleVector<StringView>>(
+        "remote_remove_char_cached_batched(c0, c1)",
+        makeRowVector({input, charToRemove}));
+    assertEqualVectors(expected, removed);
+  }
+
+  // Failed batched requests are reported like unbatched ones.
+  VELOX_ASSERT_THROW(
+      evaluate<SimpleVector<int32_t>>(
+          "remote_round_batched(c0)",
+          makeRowVector({makeFlatVector<int32_t>({-10, -20})})),
+      "Server responded with status 400. Body: 'Function 'remote_round' is not available.'");
+}
+
 VELOX_INSTANTIATE_TEST_SUITE_P(
     RemoteFunctionRestTestFixture,
     RemoteFunctionRestTest,
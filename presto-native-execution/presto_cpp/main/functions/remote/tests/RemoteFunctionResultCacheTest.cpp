@@ -0,0 +1,98 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/functions/remote/RemoteFunctionResultCache.h"
+#include <gtest/gtest.h>
+#include "velox/common/memory/Memory.h"
+
+using namespace facebook::velox;
+
+namespace facebook::presto::functions::remote::rest::test {
+namespace {
+
+class RemoteFunctionResultCacheTest : public testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    memory::MemoryManager::testingSetInstance(memory::MemoryManager::Options{});
+  }
+
+  std::vector<std::optional<std::string>> get(
+      RemoteFunctionResultCache& cache,
+      const std::vector<std::string_view>& keys) {
+    std::vector<std::optional<std::string>> results;
+    cache.get(keys, results);
+    return results;
+  }
+
+  std::shared_ptr<memory::MemoryPool> pool_{
+      memory::memoryManager()->addLeafPool()};
+};
+
+TEST_F(RemoteFunctionResultCacheTest, basic) {
+  RemoteFunctionResultCache cache(pool_, 1 << 20);
+  cache.put("key1", "result1");
+  cache.put("key2", "result2");
+
+  auto results = get(cache, {"key1", "key3", "key2", "key1"});
+  ASSERT_EQ(results.size(), 4);
+  EXPECT_EQ(results[0], "result1");
+  EXPECT_FALSE(results[1].has_value());
+  EXPECT_EQ(results[2], "result2");
+  EXPECT_EQ(results[3], "result1");
+
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.numHits, 3);
+  EXPECT_EQ(stats.numMisses, 1);
+  EXPECT_EQ(stats.numEntries, 2);
+  EXPECT_EQ(stats.usedBytes, 2 * (4 + 7));
+  EXPECT_GT(pool_->usedBytes(), 0);
+
+  cache.clear();
+  EXPECT_EQ(cache.stats().numEntries, 0);
+  EXPECT_EQ(pool_->usedBytes(), 0);
+}
+
+TEST_F(RemoteFunctionResultCacheTest, evictLeastRecentlyUsed) {
+  // Room for three entries of 10 bytes.
+  RemoteFunctionResultCache cache(pool_, 30);
+  cache.put("key01", "res01");
+  cache.put("key02", "res02");
+  cache.put("key03", "res03");
+  // Makes 'key01' the most recently used entry.
+  get(cache, {"key01"});
+
+  cache.put("key04", "res04");
+  auto results = get(cache, {"key01", "key02", "key03", "key04"});
+  EXPECT_EQ(results[0], "res01");
+  EXPECT_FALSE(results[1].has_value());
+  EXPECT_EQ(results[2], "res03");
+  EXPECT_EQ(results[3], "res04");
+  EXPECT_EQ(cache.stats().numEvictions, 1);
+  EXPECT_EQ(cache.stats().usedBytes, 30);
+
+  // Entries larger than the cache are not added.
+  cache.put("key05", std::string(100, 'x'));
+  EXPECT_FALSE(get(cache, {"key05"})[0].has_value());
+  EXPECT_EQ(cache.stats().numEntries, 3);
+}
+
+TEST_F(RemoteFunctionResultCacheTest, putExisting) {
+  RemoteFunctionResultCache cache(pool_, 1 << 20);
+  cache.put("key", "result");
+  cache.put("key", "result");
+  EXPECT_EQ(cache.stats().numEntries, 1);
+  EXPECT_EQ(cache.stats().usedBytes, 9);
+}
+
+} // namespace
+} // namespace facebook::presto::functions::remote::rest::test
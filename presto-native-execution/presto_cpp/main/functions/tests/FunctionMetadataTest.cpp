@@ -16,6 +16,8 @@
 #include "presto_cpp/main/common/tests/test_json.h"
 #include "presto_cpp/main/functions/FunctionMetadata.h"
 #include "presto_cpp/main/types/tests/TestUtils.h"
+#include "velox/functions/Macros.h"
+#include "velox/functions/Registerer.h"
 #include "velox/functions/prestosql/aggregates/RegisterAggregateFunctions.h"
 #include "velox/functions/prestosql/registration/RegistrationFunctions.h"
 #include "velox/functions/prestosql/window/WindowFunctionsRegistration.h"
@@ -27,6 +29,15 @@ using json = nlohmann::json;
 
 static const std::string kPrestoDefaultPrefix = "presto.default.";
 
+template <typename T>
+struct IdentityFunction {
+  VELOX_DEFINE_FUNCTION_TYPES(T);
+
+  void call(int64_t& result, const int64_t& input) {
+    result = input;
+  }
+};
+
 class FunctionMetadataTest : public ::testing::Test {
  protected:
   static void SetUpTestSuite() {
@@ -174,3 +185,41 @@ TEST_F(FunctionMetadataTest, nonExistentCatalog) {
   // The default json() constructor creates a null value
   ASSERT_TRUE(metadata.is_null() || (metadata.is_object() && metadata.empty()));
 }
+
+TEST_F(FunctionMetadataTest, cachedResponse) {
+  auto response = getFunctionsMetadataResponse();
+  EXPECT_EQ(json::parse(response->body), functionMetadata_);
+  EXPECT_FALSE(response->etag.empty());
+  EXPECT_FALSE(response->gzipBody.empty());
+  EXPECT_LT(response->gzipBody.size(), response->body.size());
+
+  // Served from the cache until invalidated.
+  EXPECT_EQ(getFunctionsMetadataResponse(), response);
+  auto catalogResponse = getFunctionsMetadataResponse("presto");
+  EXPECT_NE(catalogResponse, response);
+  EXPECT_EQ(getFunctionsMetadataResponse("presto"), catalogResponse);
+
+  // Unknown catalogs are not cached.
+  auto unknownResponse = getFunctionsMetadataResponse("no_such_catalog");
+  EXPECT_TRUE(json::parse(unknownResponse->body).empty());
+  EXPECT_NE(getFunctionsMetadataResponse("no_such_catalog"), unknownResponse);
+
+  const auto version = functionsMetadataVersion();
+  invalidateFunctionsMetadata();
+  EXPECT_EQ(functionsMetadataVersion(), version + 1);
+  auto rebuilt = getFunctionsMetadataResponse();
+  EXPECT_NE(rebuilt, response);
+  EXPECT_EQ(rebuilt->version, version + 1);
+  // The registry did not change, so neither does the entity tag.
+  EXPECT_EQ(rebuilt->body, response->body);
+  EXPECT_EQ(rebuilt->etag, response->etag);
+
+  // A newly registered function changes the response.
+  registerFunction<IdentityFunction, int64_t, int64_t>(
+      {kPrestoDefaultPrefix + "cached_response_test_function"});
+  invalidateFunctionsMetadata();
+  auto updated = getFunctionsMetadataResponse();
+  EXPECT_NE(updated->etag, response->etag);
+  EXPECT_TRUE(json::parse(updated->body)
+                  .contains("cached_response_test_function"));
+}
@@ -11,11 +11,6 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
-#ifdef PRESTO_ENABLE_JWT
-#include <folly/ssl/OpenSSLHash.h> // @manual
-#include <jwt-cpp/jwt.h> // @manual
-#include <jwt-cpp/traits/nlohmann-json/traits.h> //@manual
-#endif // PRESTO_ENABLE_JWT
 #include <folly/io/async/EventBaseManager.h>
 #include <folly/synchronization/Latch.h>
 #include <proxygen/lib/http/codec/CodecProtocol.h>
@@ -23,6 +18,7 @@
 #include "presto_cpp/main/common/Counters.h"
 #include "presto_cpp/main/common/Utils.h"
 #include "presto_cpp/main/http/HttpClient.h"
+#include "presto_cpp/main/http/JwtCache.h"
 #include "velox/common/base/StatsReporter.h"
 
 namespace facebook::presto::http {
@@ -180,11 +176,11 @@ class ResponseHandler : public proxygen::HTTPTransactionHandler {
   ResponseHandler(
       const proxygen::HTTPMessage& request,
       uint64_t maxResponseAllocBytes,
-      const std::string& body,
+      std::unique_ptr<folly::IOBuf> body,
       std::function<void(int)> reportOnBodyStatsFunc,
       std::shared_ptr<HttpClient> client)
       : request_(request),
-        body_(body),
+        body_(std::move(body)),
         reportOnBodyStatsFunc_(std::move(reportOnBodyStatsFunc)),
         minResponseAllocBytes_(
             client->memoryPool() == nullptr
@@ -279,8 +275,8 @@ class ResponseHandler : public proxygen::HTTPTransactionHandler {
   void sendRequest() {
     if (txn_) {
       txn_->sendHeaders(request_);
-      if (!body_.empty()) {
-        txn_->sendBody(folly::IOBuf::wrapBuffer(body_.c_str(), body_.size()));
+      if (body_ != nullptr && !body_->empty()) {
+        txn_->sendBody(body_->clone());
       }
       txn_->sendEOM();
     }
@@ -288,7 +284,7 @@ class ResponseHandler : public proxygen::HTTPTransactionHandler {
 
  private:
   const proxygen::HTTPMessage request_;
-  const std::string body_;
+  const std::unique_ptr<folly::IOBuf> body_;
   const std::function<void(int)> reportOnBodyStatsFunc_;
   const uint64_t minResponseAllocBytes_;
   const uint64_t maxResponseAllocBytes_;
@@ -578,12 +574,22 @@ folly::SemiFuture<std::unique_ptr<HttpResponse>> HttpClient::sendRequest(
     proxygen::HTTPMessage& request,
     const std::string& body,
     int64_t delayMs) {
+  return sendRequest(
+      request,
+      body.empty() ? nullptr : folly::IOBuf::copyBuffer(body),
+      delayMs);
+}
+
+folly::SemiFuture<std::unique_ptr<HttpResponse>> HttpClient::sendRequest(
+    proxygen::HTTPMessage& request,
+    std::unique_ptr<folly::IOBuf> body,
+    int64_t delayMs) {
   request.setDstAddress(this->address_);
   request.ensureHostHeader();
   auto responseHandler = std::make_shared<ResponseHandler>(
       request,
       options_.maxAllocateBytes,
-      body,
+      std::move(body),
       reportOnBodyStatsFunc_,
       shared_from_this());
   auto future = responseHandler->initialize(responseHandler);
@@ -609,24 +615,7 @@ folly::SemiFuture<std::unique_ptr<HttpResponse>> HttpClient::sendRequest(
 void RequestBuilder::addJwtIfConfigured() {
 #ifdef PRESTO_ENABLE_JWT
   if (jwtOptions_.jwtEnabled) {
-    // If JWT was enabled the secret cannot be empty.
-    auto secretHash = std::vector<uint8_t>(SHA256_DIGEST_LENGTH);
-    folly::ssl::OpenSSLHash::sha256(
-        folly::range(secretHash),
-        folly::ByteRange(folly::StringPiece(jwtOptions_.sharedSecret)));
-
-    const auto time = std::chrono::system_clock::now();
-    const auto token =
-        jwt::create<jwt::traits::nlohmann_json>()
-            .set_subject(jwtOptions_.nodeId)
-            .set_issued_at(time)
-            .set_expires_at(
-                time + std::chrono::seconds{jwtOptions_.jwtExpirationSeconds})
-            .sign(
-                jwt::algorithm::hs256{std::string(
-                    reinterpret_cast<char*>(secretHash.data()),
-                    secretHash.size())});
-    header(kPrestoInternalBearer, token);
+    header(kPrestoInternalBearer, JwtSigner::instance().token(jwtOptions_));
   }
 #endif // PRESTO_ENABLE_JWT
 }
@@ -169,12 +169,18 @@ class HttpClient : public std::enable_shared_from_this<HttpClient> {
 
   ~HttpClient();
 
-  // TODO Avoid copy by using IOBuf for body
   folly::SemiFuture<std::unique_ptr<HttpResponse>> sendRequest(
       proxygen::HTTPMessage& request,
       const std::string& body = "",
       int64_t delayMs = 0);
 
+  /// Same as above, but sends the possibly chained 'body' as is without
+  /// flattening or copying it.
+  folly::SemiFuture<std::unique_ptr<HttpResponse>> sendRequest(
+      proxygen::HTTPMessage& request,
+      std::unique_ptr<folly::IOBuf> body,
+      int64_t delayMs = 0);
+
   const std::shared_ptr<velox::memory::MemoryPool>& memoryPool() {
     return pool_;
   }
@@ -22,6 +22,7 @@ constexpr uint16_t kHttpOk = 200;
 constexpr uint16_t kHttpAccepted = 202;
 constexpr uint16_t kHttpNoContent = 204;
 constexpr uint16_t kHttpMultipleChoices = 300;
+constexpr uint16_t kHttpNotModified = 304;
 constexpr uint16_t kHttpBadRequest = 400;
 constexpr uint16_t kHttpUnauthorized = 401;
 constexpr uint16_t kHttpNotFound = 404;
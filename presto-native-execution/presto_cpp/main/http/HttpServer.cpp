@@ -12,6 +12,8 @@
  * limitations under the License.
  */
 
+#include <folly/Conv.h>
+#include <folly/String.h>
 #include <algorithm>
 
 #include "presto_cpp/main/common/Utils.h"
@@ -97,6 +99,86 @@ void sendResponse(
       .sendWithEOM();
 }
 
+bool matchesEntityTag(std::string_view ifNoneMatch, std::string_view etag) {
+  std::vector<std::string_view> tags;
+  folly::split(',', ifNoneMatch, tags);
+  for (auto tag : tags) {
+    tag = folly::trimWhitespace(tag);
+    // If-None-Match uses the weak comparison.
+    if (tag.starts_with("W/")) {
+      tag.remove_prefix(2);
+    }
+    if (tag == "*" || tag == etag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool acceptsEncoding(
+    std::string_view acceptEncoding,
+    std::string_view encoding) {
+  std::vector<std::string_view> codings;
+  folly::split(',', acceptEncoding, codings);
+  for (auto coding : codings) {
+    std::string_view params;
+    const auto pos = coding.find(';');
+    if (pos != std::string_view::npos) {
+      params = folly::trimWhitespace(coding.substr(pos + 1));
+      coding = coding.substr(0, pos);
+    }
+    coding = folly::trimWhitespace(coding);
+    if (coding != "*" && !folly::caseInsensitiveEqual(coding, encoding)) {
+      continue;
+    }
+    // A coding is refused with a zero quality value, e.g. 'gzip;q=0'.
+    if (params.starts_with("q=") || params.starts_with("Q=")) {
+      const auto quality =
+          folly::tryTo<double>(folly::StringPiece(params.substr(2)));
+      return !quality.hasValue() || quality.value() > 0;
+    }
+    return true;
+  }
+  return false;
+}
+
+void sendOkCachedResponse(
+    proxygen::HTTPMessage* message,
+    proxygen::ResponseHandler* downstream,
+    const std::string& body,
+    const std::string& gzipBody,
+    const std::string& etag) {
+  const auto& headers = message->getHeaders();
+  if (matchesEntityTag(
+          headers.getSingleOrEmpty(proxygen::HTTP_HEADER_IF_NONE_MATCH),
+          etag)) {
+    proxygen::ResponseBuilder(downstream)
+        .status(http::kHttpNotModified, "")
+        .header(proxygen::HTTP_HEADER_ETAG, etag)
+        .sendWithEOM();
+    return;
+  }
+
+  proxygen::ResponseBuilder builder(downstream);
+  builder.status(http::kHttpOk, "")
+      .header(
+          proxygen::HTTP_HEADER_CONTENT_TYPE, http::kMimeTypeApplicationJson)
+      .header(proxygen::HTTP_HEADER_ETAG, etag)
+      .header(proxygen::HTTP_HEADER_VARY, "Accept-Encoding");
+  // The compression filter of the server leaves responses that already have a
+  // Content-Encoding alone.
+  if (!gzipBody.empty() &&
+      acceptsEncoding(
+          headers.getSingleOrEmpty(proxygen::HTTP_HEADER_ACCEPT_ENCODING),
+          "gzip")) {
+    builder.header(proxygen::HTTP_HEADER_CONTENT_ENCODING, "gzip")
+        .body(gzipBody);
+  } else {
+    builder.body(body);
+  }
+  builder.sendWithEOM();
+}
+
 HttpConfig::HttpConfig(const folly::SocketAddress& address, bool reusePort)
     : address_(address), reusePort_(reusePort) {}
 
@@ -205,9 +287,47 @@ proxygen::RequestHandler* EndPoint::checkAndApply(
   return nullptr;
 }
 
+EndPointRouter::EndPointRouter(
+    const std::vector<std::unique_ptr<EndPoint>>& endpoints)
+    : set_(RE2::Options(), RE2::ANCHOR_BOTH) {
+  for (size_t i = 0; i < endpoints.size(); ++i) {
+    std::string error;
+    const auto index = set_.Add(endpoints[i]->pattern(), &error);
+    VELOX_CHECK_EQ(
+        index,
+        static_cast<int>(i),
+        "Failed to add endpoint pattern '{}': {}",
+        endpoints[i]->pattern(),
+        error);
+  }
+  VELOX_CHECK(set_.Compile(), "Failed to compile endpoint patterns");
+}
+
+int32_t EndPointRouter::match(const std::string& path) const {
+  // Reused across requests to avoid an allocation per match.
+  thread_local std::vector<int> indices;
+  indices.clear();
+  if (!set_.Match(path, &indices)) {
+    return -1;
+  }
+  return *std::min_element(indices.begin(), indices.end());
+}
+
+namespace {
+// The endpoint resolved by the last DispatchingRequestHandlerFactory::
+// onRequest() call on this thread.
+struct ResolvedEndPoint {
+  const proxygen::HTTPMessage* message{nullptr};
+  const EndPoint* endpoint{nullptr};
+};
+
+thread_local ResolvedEndPoint lastResolvedEndPoint;
+} // namespace
+
 proxygen::RequestHandler* DispatchingRequestHandlerFactory::onRequest(
     proxygen::RequestHandler*,
     proxygen::HTTPMessage* message) noexcept {
+  lastResolvedEndPoint = {message, nullptr};
   auto it = endpoints_.find(message->getMethod().value());
   if (it == endpoints_.end()) {
     return new ErrorRequestHandler(
@@ -225,10 +345,25 @@ proxygen::RequestHandler* DispatchingRequestHandlerFactory::onRequest(
   std::vector<RE2::Arg> args(4);
   std::vector<RE2::Arg*> argPtrs(4);
 
-  for (const auto& endpoint : it->second) {
-    if (auto handler =
-            endpoint->checkAndApply(path, message, matches, args, argPtrs)) {
-      return handler;
+  auto routerIt = routers_.find(it->first);
+  if (routerIt != routers_.end()) {
+    // Only the resolved endpoint is matched again to extract its captures.
+    const auto index = routerIt->second->match(path);
+    if (index >= 0) {
+      const auto& endpoint = it->second[index];
+      lastResolvedEndPoint.endpoint = endpoint.get();
+      if (auto handler =
+              endpoint->checkAndApply(path, message, matches, args, argPtrs)) {
+        return handler;
+      }
+    }
+  } else {
+    for (const auto& endpoint : it->second) {
+      if (auto handler =
+              endpoint->checkAndApply(path, message, matches, args, argPtrs)) {
+        lastResolvedEndPoint.endpoint = endpoint.get();
+        return handler;
+      }
     }
   }
 
@@ -240,10 +375,23 @@ proxygen::RequestHandler* DispatchingRequestHandlerFactory::onRequest(
           message->getURL()));
 }
 
+// static
+const EndPoint* DispatchingRequestHandlerFactory::resolvedEndPoint(
+    const proxygen::HTTPMessage* message) {
+  if (lastResolvedEndPoint.message != message) {
+    return nullptr;
+  }
+  return lastResolvedEndPoint.endpoint;
+}
+
 void DispatchingRequestHandlerFactory::registerEndPoint(
     proxygen::HTTPMethod method,
     const std::string& pattern,
     const EndpointRequestHandlerFactory& endpoint) {
+  VELOX_CHECK(
+      routers_.empty(),
+      "Cannot register endpoint {} after the server started",
+      pattern);
   auto it = endpoints_.find(method);
   if (it == endpoints_.end()) {
     endpoints_[method].emplace_back(
@@ -253,6 +401,12 @@ void DispatchingRequestHandlerFactory::registerEndPoint(
   }
 }
 
+void DispatchingRequestHandlerFactory::compile() {
+  for (const auto& [method, endpoints] : endpoints_) {
+    routers_.emplace(method, std::make_unique<EndPointRouter>(endpoints));
+  }
+}
+
 const std::
     unordered_map<proxygen::HTTPMethod, std::vector<std::unique_ptr<EndPoint>>>&
     DispatchingRequestHandlerFactory::endpoints() const {
@@ -296,6 +450,7 @@ void HttpServer::start(
     }
   }
 
+  handlerFactory_->compile();
   handlerFactories.addThen(std::move(handlerFactory_));
   options.handlerFactories = handlerFactories.build();
 
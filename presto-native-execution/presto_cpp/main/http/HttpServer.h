@@ -17,6 +17,7 @@
 #include <proxygen/httpserver/RequestHandlerFactory.h>
 #include <proxygen/httpserver/ResponseBuilder.h>
 #include <re2/re2.h>
+#include <re2/set.h>
 #include <wangle/ssl/SSLContextConfig.h>
 #include "presto_cpp/external/json/nlohmann/json.hpp"
 #include "presto_cpp/main/http/HttpConstants.h"
@@ -52,6 +53,25 @@ void sendResponse(
     const json& body,
     uint16_t status);
 
+/// Returns true if the value of an If-None-Match header matches 'etag'.
+bool matchesEntityTag(std::string_view ifNoneMatch, std::string_view etag);
+
+/// Returns true if the value of an Accept-Encoding header allows 'encoding'.
+bool acceptsEncoding(
+    std::string_view acceptEncoding,
+    std::string_view encoding);
+
+/// Sends a JSON response that does not change between requests unless its
+/// 'etag' changes. Responds with 304 Not Modified if 'message' already carries
+/// 'etag' in If-None-Match and sends 'gzipBody' if it is not empty and
+/// 'message' accepts gzip. Otherwise sends 'body'.
+void sendOkCachedResponse(
+    proxygen::HTTPMessage* message,
+    proxygen::ResponseHandler* downstream,
+    const std::string& body,
+    const std::string& gzipBody,
+    const std::string& etag);
+
 class AbstractRequestHandler : public proxygen::RequestHandler {
  public:
   void onRequest(
@@ -217,6 +237,25 @@ class EndPoint {
   EndpointRequestHandlerFactory factory_;
 };
 
+/// Resolves a request path against all the endpoints registered for one HTTP
+/// method in a single pass. The patterns are compiled into one anchored
+/// RE2::Set, so the path is scanned once no matter how many endpoints there
+/// are. Only the winning pattern is then run again to extract its captures.
+/// If several patterns match, the first registered one wins, same as a linear
+/// scan over the endpoints.
+class EndPointRouter {
+ public:
+  explicit EndPointRouter(
+      const std::vector<std::unique_ptr<EndPoint>>& endpoints);
+
+  /// Returns the index of the first endpoint whose pattern fully matches
+  /// 'path', or -1 if there is none.
+  int32_t match(const std::string& path) const;
+
+ private:
+  RE2::Set set_;
+};
+
 class DispatchingRequestHandlerFactory
     : public proxygen::RequestHandlerFactory {
  public:
@@ -238,11 +277,28 @@ class DispatchingRequestHandlerFactory
       std::vector<std::unique_ptr<EndPoint>>>&
   endpoints() const;
 
+  /// Builds an EndPointRouter per HTTP method. Called by HttpServer::start().
+  /// No endpoints can be registered afterwards. Until then, requests are
+  /// matched against the endpoints one by one.
+  void compile();
+
+  /// Returns the endpoint that onRequest() resolved for 'message', or nullptr
+  /// if it did not match any. Filters use this to identify the endpoint
+  /// without matching the path again. Proxygen creates the whole handler chain
+  /// for a request on one thread and creates the dispatching handler first, so
+  /// this is only valid from the onRequest() of a filter factory placed before
+  /// this factory in the chain.
+  static const EndPoint* resolvedEndPoint(
+      const proxygen::HTTPMessage* message);
+
  private:
   std::unordered_map<
       proxygen::HTTPMethod,
       std::vector<std::unique_ptr<EndPoint>>>
       endpoints_;
+
+  std::unordered_map<proxygen::HTTPMethod, std::unique_ptr<EndPointRouter>>
+      routers_;
 };
 
 class HttpConfig {
@@ -0,0 +1,190 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/http/JwtCache.h"
+#ifdef PRESTO_ENABLE_JWT
+#include <folly/container/F14Map.h>
+#include <folly/ssl/OpenSSLHash.h> //@manual
+#include <jwt-cpp/jwt.h> //@manual
+#include <jwt-cpp/traits/nlohmann-json/traits.h> //@manual
+#endif // PRESTO_ENABLE_JWT
+#include "velox/common/base/Exceptions.h"
+
+namespace facebook::presto::http {
+#ifdef PRESTO_ENABLE_JWT
+namespace {
+std::string sha256(std::string_view data) {
+  std::string digest(SHA256_DIGEST_LENGTH, '\0');
+  folly::ssl::OpenSSLHash::sha256(
+      folly::MutableByteRange(
+          reinterpret_cast<uint8_t*>(digest.data()), digest.size()),
+      folly::ByteRange(folly::StringPiece(data)));
+  return digest;
+}
+
+using Verifier = decltype(jwt::verify<jwt::traits::nlohmann_json>());
+} // namespace
+
+struct JwtSigner::SignedToken {
+  JwtOptions options;
+  std::string token;
+  // Time after which 'token' is replaced.
+  std::chrono::system_clock::time_point refreshAt;
+
+  bool matches(const JwtOptions& other) const {
+    return options.sharedSecret == other.sharedSecret &&
+        options.nodeId == other.nodeId &&
+        options.jwtExpirationSeconds == other.jwtExpirationSeconds;
+  }
+};
+
+// static
+JwtSigner& JwtSigner::instance() {
+  static JwtSigner signer;
+  return signer;
+}
+
+// static
+std::chrono::seconds JwtSigner::refreshMargin(const JwtOptions& options) {
+  return std::min(
+      std::chrono::seconds{options.jwtExpirationSeconds} / 2,
+      std::chrono::seconds{30});
+}
+
+std::string JwtSigner::token(const JwtOptions& options) {
+  VELOX_CHECK(options.jwtEnabled);
+  const auto now = std::chrono::system_clock::now();
+  auto isUsable = [&](const std::shared_ptr<const SignedToken>& signedToken) {
+    return signedToken != nullptr && signedToken->matches(options) &&
+        now < signedToken->refreshAt;
+  };
+  {
+    auto signedToken = signedToken_.rlock();
+    if (isUsable(*signedToken)) {
+      return (*signedToken)->token;
+    }
+  }
+
+  auto signedToken = signedToken_.wlock();
+  // Another thread may have refreshed the token while we were waiting.
+  if (isUsable(*signedToken)) {
+    return (*signedToken)->token;
+  }
+  // If JWT was enabled the secret cannot be empty.
+  const auto expiration = std::chrono::seconds{options.jwtExpirationSeconds};
+  auto newToken = std::make_shared<SignedToken>();
+  newToken->options = options;
+  newToken->token = jwt::create<jwt::traits::nlohmann_json>()
+                        .set_subject(options.nodeId)
+                        .set_issued_at(now)
+                        .set_expires_at(now + expiration)
+                        .sign(jwt::algorithm::hs256{
+                            sha256(options.sharedSecret)});
+  newToken->refreshAt = now + expiration - refreshMargin(options);
+  *signedToken = newToken;
+  return newToken->token;
+}
+
+struct JwtVerifier::KeyMaterial {
+  explicit KeyMaterial(const std::string& _sharedSecret)
+      : sharedSecret(_sharedSecret),
+        verifier(jwt::verify<jwt::traits::nlohmann_json>().allow_algorithm(
+            jwt::algorithm::hs256{sha256(sharedSecret)})) {}
+
+  const std::string sharedSecret;
+  const Verifier verifier;
+  // Expiration time of verified tokens keyed by the token digest.
+  mutable folly::Synchronized<
+      folly::F14FastMap<std::string, std::chrono::system_clock::time_point>,
+      std::shared_mutex>
+      verifiedTokens;
+};
+
+// static
+JwtVerifier& JwtVerifier::instance() {
+  static JwtVerifier verifier;
+  return verifier;
+}
+
+std::shared_ptr<const JwtVerifier::KeyMaterial> JwtVerifier::keyMaterial(
+    const std::string& sharedSecret) {
+  {
+    auto keyMaterial = keyMaterial_.rlock();
+    if (*keyMaterial != nullptr &&
+        (*keyMaterial)->sharedSecret == sharedSecret) {
+      return *keyMaterial;
+    }
+  }
+  // The secret changed (or this is the first request). Tokens verified with
+  // the old secret are dropped together with the old key material.
+  auto keyMaterial = keyMaterial_.wlock();
+  if (*keyMaterial == nullptr || (*keyMaterial)->sharedSecret != sharedSecret) {
+    *keyMaterial = std::make_shared<const KeyMaterial>(sharedSecret);
+  }
+  return *keyMaterial;
+}
+
+void JwtVerifier::verify(
+    const std::string& token,
+    const std::string& sharedSecret) {
+  const auto key = keyMaterial(sharedSecret);
+  const auto digest = sha256(token);
+  const auto now = std::chrono::system_clock::now();
+  {
+    auto verifiedTokens = key->verifiedTokens.rlock();
+    auto it = verifiedTokens->find(digest);
+    if (it != verifiedTokens->end() && now < it->second) {
+      return;
+    }
+  }
+
+  // Decode and verify the JWT.
+  auto decodedJwt = jwt::decode<jwt::traits::nlohmann_json>(token);
+  key->verifier.verify(decodedJwt);
+
+  // The nodeId of the requester is the subject. Check if it was set.
+  if (decodedJwt.get_subject().empty()) {
+    std::error_code ec{jwt::error::token_verification_error::missing_claim};
+    throw jwt::error::token_verification_exception(ec);
+  }
+
+  // Tokens without expiration are verified every time.
+  if (!decodedJwt.has_expires_at()) {
+    return;
+  }
+  const auto expiresAt = decodedJwt.get_expires_at();
+  auto verifiedTokens = key->verifiedTokens.wlock();
+  if (verifiedTokens->size() >= kMaxCachedTokens) {
+    for (auto it = verifiedTokens->begin(); it != verifiedTokens->end();) {
+      if (it->second <= now) {
+        it = verifiedTokens->erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (verifiedTokens->size() >= kMaxCachedTokens) {
+      verifiedTokens->clear();
+    }
+  }
+  verifiedTokens->insert_or_assign(digest, expiresAt);
+}
+
+size_t JwtVerifier::numCachedTokens() const {
+  auto keyMaterial = keyMaterial_.rlock();
+  if (*keyMaterial == nullptr) {
+    return 0;
+  }
+  return (*keyMaterial)->verifiedTokens.rlock()->size();
+}
+#endif // PRESTO_ENABLE_JWT
+} // namespace facebook::presto::http
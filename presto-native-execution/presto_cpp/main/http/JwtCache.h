@@ -0,0 +1,78 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include "presto_cpp/main/http/JwtOptions.h"
+
+namespace facebook::presto::http {
+
+/// Process-wide signer of the internal communication JWTs. Signing hashes the
+/// shared secret and serializes the claims, which is too expensive to do for
+/// every exchange request. A signed token is reused for all requests with the
+/// same 'JwtOptions' until it is close to its expiration. Only available if
+/// built with PRESTO_ENABLE_JWT.
+class JwtSigner {
+ public:
+  static JwtSigner& instance();
+
+  /// Returns a token for 'options' that is valid for at least
+  /// refreshMargin(options) more.
+  std::string token(const JwtOptions& options);
+
+  /// Time before expiration at which a cached token is replaced by a new one:
+  /// half of the token lifetime, capped at 30 seconds.
+  static std::chrono::seconds refreshMargin(const JwtOptions& options);
+
+ private:
+  struct SignedToken;
+
+  folly::Synchronized<std::shared_ptr<const SignedToken>, std::shared_mutex>
+      signedToken_;
+};
+
+/// Process-wide verifier of the internal communication JWTs. The signing key
+/// is derived once per shared secret, and tokens that passed the full
+/// verification are remembered by their SHA-256 digest until they expire, so
+/// that the repeated tokens sent by JwtSigner are neither decoded nor
+/// re-verified. Only available if built with PRESTO_ENABLE_JWT.
+class JwtVerifier {
+ public:
+  /// Maximum number of verified tokens remembered per shared secret.
+  static constexpr size_t kMaxCachedTokens{10'000};
+
+  static JwtVerifier& instance();
+
+  /// Verifies 'token' against 'sharedSecret' and checks that it carries a
+  /// subject. Throws the jwt-cpp verification exceptions on failure.
+  void verify(const std::string& token, const std::string& sharedSecret);
+
+  /// Returns the number of verified tokens currently cached.
+  size_t numCachedTokens() const;
+
+ private:
+  struct KeyMaterial;
+
+  std::shared_ptr<const KeyMaterial> keyMaterial(
+      const std::string& sharedSecret);
+
+  folly::Synchronized<std::shared_ptr<const KeyMaterial>, std::shared_mutex>
+      keyMaterial_;
+};
+
+} // namespace facebook::presto::http
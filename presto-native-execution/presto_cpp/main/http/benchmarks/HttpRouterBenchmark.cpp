@@ -0,0 +1,157 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <folly/Benchmark.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+
+#include "presto_cpp/main/http/HttpServer.h"
+
+namespace facebook::presto::http {
+namespace {
+
+class DummyRequestHandler : public proxygen::RequestHandler {
+ public:
+  void onRequest(std::unique_ptr<proxygen::HTTPMessage>) noexcept override {}
+  void onBody(std::unique_ptr<folly::IOBuf>) noexcept override {}
+  void onEOM() noexcept override {}
+  void onUpgrade(proxygen::UpgradeProtocol) noexcept override {}
+  void requestComplete() noexcept override {}
+  void onError(proxygen::ProxygenError) noexcept override {}
+};
+
+DummyRequestHandler& dummyHandler() {
+  static DummyRequestHandler handler;
+  return handler;
+}
+
+// Registers the endpoints of the worker in the same order as PrestoServer and
+// TaskResource do, so that a linear scan visits the same number of patterns.
+void registerWorkerEndPoints(DispatchingRequestHandlerFactory& factory) {
+  const std::vector<std::pair<proxygen::HTTPMethod, std::string>> endpoints{
+      {proxygen::HTTPMethod::GET, "/v1/operation/.*"},
+      {proxygen::HTTPMethod::POST, "/v1/memory"},
+      {proxygen::HTTPMethod::GET, "/v1/info"},
+      {proxygen::HTTPMethod::GET, "/v1/info/state"},
+      {proxygen::HTTPMethod::GET, "/v1/info/stats"},
+      {proxygen::HTTPMethod::PUT, "/v1/info/state"},
+      {proxygen::HTTPMethod::GET, "/v1/status"},
+      {proxygen::HTTPMethod::HEAD, "/v1/status"},
+      {proxygen::HTTPMethod::GET, "/v1/info/metrics"},
+      {proxygen::HTTPMethod::GET, "/v1/properties/session"},
+      {proxygen::HTTPMethod::GET, "/v1/functions"},
+      {proxygen::HTTPMethod::GET, R"(/v1/functions/([^/]+))"},
+      {proxygen::HTTPMethod::POST, "/v1/expressions"},
+      {proxygen::HTTPMethod::POST, "/v1/velox/plan"},
+      {proxygen::HTTPMethod::DELETE, R"(/v1/task/(.+)/results/(.+))"},
+      {proxygen::HTTPMethod::GET,
+       R"(/v1/task/(.+)/results/([0-9]+)/([0-9]+)/acknowledge)"},
+      {proxygen::HTTPMethod::POST, R"(/v1/task/(.+)/batch)"},
+      {proxygen::HTTPMethod::POST, R"(/v1/task/(.+))"},
+      {proxygen::HTTPMethod::DELETE, R"(/v1/task/(.+)/remote-source/(.+))"},
+      {proxygen::HTTPMethod::DELETE, R"(/v1/task/(.+))"},
+      {proxygen::HTTPMethod::GET, R"(/v1/task/(.+)/status)"},
+      {proxygen::HTTPMethod::HEAD,
+       R"(/v1/task/(.+)/results/([0-9]+)/([0-9]+))"},
+      {proxygen::HTTPMethod::GET,
+       R"(/v1/task/(.+)/results/([0-9]+)/([0-9]+))"},
+      {proxygen::HTTPMethod::GET, R"(/v1/task/(.+))"}};
+  for (const auto& [method, pattern] : endpoints) {
+    factory.registerEndPoint(
+        method,
+        pattern,
+        [](proxygen::HTTPMessage* /*message*/,
+           const std::vector<std::string>& /*args*/) {
+          return &dummyHandler();
+        });
+  }
+}
+
+// Request mix of a busy worker: exchange data fetches and acknowledgements
+// dominate, followed by status polls and task updates.
+std::vector<std::unique_ptr<proxygen::HTTPMessage>> makeRequests() {
+  const std::vector<std::tuple<proxygen::HTTPMethod, std::string, int>> mix{
+      {proxygen::HTTPMethod::GET, "/v1/task/{}/results/{}/{}", 50},
+      {proxygen::HTTPMethod::GET, "/v1/task/{}/results/{}/{}/acknowledge", 25},
+      {proxygen::HTTPMethod::GET, "/v1/task/{}/status", 10},
+      {proxygen::HTTPMethod::POST, "/v1/task/{}", 5},
+      {proxygen::HTTPMethod::GET, "/v1/task/{}", 4},
+      {proxygen::HTTPMethod::DELETE, "/v1/task/{}/results/{}", 3},
+      {proxygen::HTTPMethod::HEAD, "/v1/task/{}/results/{}/{}", 2},
+      {proxygen::HTTPMethod::GET, "/v1/info", 1}};
+  std::vector<std::unique_ptr<proxygen::HTTPMessage>> requests;
+  folly::Random::DefaultGenerator rng(42);
+  for (const auto& [method, format, weight] : mix) {
+    for (int i = 0; i < weight * 20; ++i) {
+      const auto taskId = fmt::format(
+          "20250101_{:06}_{:05}_abcde.{}.0.{}.0",
+          folly::Random::rand32(1'000'000, rng),
+          folly::Random::rand32(100'000, rng),
+          folly::Random::rand32(10, rng),
+          folly::Random::rand32(1'000, rng));
+      auto message = std::make_unique<proxygen::HTTPMessage>();
+      message->setMethod(method);
+      message->setURL(fmt::format(
+          fmt::runtime(format),
+          taskId,
+          folly::Random::rand32(64, rng),
+          folly::Random::rand32(100'000, rng)));
+      requests.push_back(std::move(message));
+    }
+  }
+  std::shuffle(requests.begin(), requests.end(), rng);
+  return requests;
+}
+
+struct BenchmarkState {
+  BenchmarkState() : requests(makeRequests()) {
+    registerWorkerEndPoints(linear);
+    registerWorkerEndPoints(compiled);
+    compiled.compile();
+  }
+
+  DispatchingRequestHandlerFactory linear;
+  DispatchingRequestHandlerFactory compiled;
+  const std::vector<std::unique_ptr<proxygen::HTTPMessage>> requests;
+};
+
+BenchmarkState& state() {
+  static BenchmarkState state;
+  return state;
+}
+
+void dispatch(DispatchingRequestHandlerFactory& factory, uint32_t n) {
+  const auto& requests = state().requests;
+  for (uint32_t i = 0; i < n; ++i) {
+    auto* handler =
+        factory.onRequest(nullptr, requests[i % requests.size()].get());
+    folly::doNotOptimizeAway(handler);
+  }
+}
+
+BENCHMARK(linearScan, n) {
+  dispatch(state().linear, n);
+}
+
+BENCHMARK_RELATIVE(compiledRouter, n) {
+  dispatch(state().compiled, n);
+}
+
+} // namespace
+} // namespace facebook::presto::http
+
+int main(int argc, char** argv) {
+  folly::Init init{&argc, &argv};
+  folly::runBenchmarks();
+  return 0;
+}
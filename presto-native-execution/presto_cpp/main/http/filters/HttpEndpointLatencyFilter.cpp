@@ -21,8 +21,11 @@ HttpEndpointLatencyFilter::HttpEndpointLatencyFilter(
     proxygen::RequestHandler* upstream,
     const std::shared_ptr<std::unordered_map<
         proxygen::HTTPMethod,
-        std::vector<std::unique_ptr<EndPoint>>>>& endpoints)
-    : Filter(upstream), endpoints_(endpoints) {}
+        std::vector<std::unique_ptr<EndPoint>>>>& endpoints,
+    const EndPoint* resolvedEndPoint)
+    : Filter(upstream),
+      endpoints_(endpoints),
+      resolvedEndPoint_(resolvedEndPoint) {}
 
 // static
 void HttpEndpointLatencyFilter::updateLatency(
@@ -66,19 +69,24 @@ HttpEndpointLatencyFilter::retrieveLatencies() {
 
 void HttpEndpointLatencyFilter::onRequest(
     std::unique_ptr<proxygen::HTTPMessage> msg) noexcept {
-  auto path = msg->getPath();
   const auto method = msg->getMethod().value();
-  const auto& endpoints = endpoints_->at(method);
+  if (resolvedEndPoint_ != nullptr) {
+    requestEndpoint_ =
+        methodToString(method) + " " + resolvedEndPoint_->pattern();
+  } else {
+    const auto& path = msg->getPath();
+    const auto& endpoints = endpoints_->at(method);
 
-  // Allocate vector outside of loop to avoid repeated alloc/free.
-  std::vector<std::string> matches(4);
-  std::vector<RE2::Arg> args(4);
-  std::vector<RE2::Arg*> argPtrs(4);
+    // Allocate vector outside of loop to avoid repeated alloc/free.
+    std::vector<std::string> matches(4);
+    std::vector<RE2::Arg> args(4);
+    std::vector<RE2::Arg*> argPtrs(4);
 
-  for (const auto& endpoint : endpoints) {
-    if (endpoint->check(path, matches, args, argPtrs)) {
-      requestEndpoint_ = methodToString(method) + " " + endpoint->pattern();
-      break;
+    for (const auto& endpoint : endpoints) {
+      if (endpoint->check(path, matches, args, argPtrs)) {
+        requestEndpoint_ = methodToString(method) + " " + endpoint->pattern();
+        break;
+      }
     }
   }
   VELOX_CHECK(!requestEndpoint_.empty());
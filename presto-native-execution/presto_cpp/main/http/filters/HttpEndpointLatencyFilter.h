@@ -47,11 +47,14 @@ class HttpEndpointLatencyFilter : public proxygen::Filter {
     }
   };
 
+  /// 'resolvedEndPoint' is the endpoint the dispatcher already resolved for
+  /// this request. If null, the request path is matched against 'endpoints'.
   HttpEndpointLatencyFilter(
       proxygen::RequestHandler* upstream,
       const std::shared_ptr<std::unordered_map<
           proxygen::HTTPMethod,
-          std::vector<std::unique_ptr<EndPoint>>>>& endpoints);
+          std::vector<std::unique_ptr<EndPoint>>>>& endpoints,
+      const EndPoint* resolvedEndPoint = nullptr);
 
   static std::vector<EndPointMetrics> retrieveLatencies();
 
@@ -78,6 +81,9 @@ class HttpEndpointLatencyFilter : public proxygen::Filter {
       std::vector<std::unique_ptr<EndPoint>>>>
       endpoints_;
 
+  // The endpoint resolved by DispatchingRequestHandlerFactory, if any.
+  const EndPoint* const resolvedEndPoint_;
+
   // The http endpoint of this request
   std::string requestEndpoint_;
 
@@ -104,8 +110,11 @@ class HttpEndpointLatencyFilterFactory
 
   proxygen::RequestHandler* onRequest(
       proxygen::RequestHandler* handler,
-      proxygen::HTTPMessage*) noexcept override {
-    return new HttpEndpointLatencyFilter(handler, endpoints_);
+      proxygen::HTTPMessage* message) noexcept override {
+    return new HttpEndpointLatencyFilter(
+        handler,
+        endpoints_,
+        DispatchingRequestHandlerFactory::resolvedEndPoint(message));
   }
 
  private:
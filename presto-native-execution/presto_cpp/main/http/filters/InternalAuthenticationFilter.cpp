@@ -14,13 +14,13 @@
 
 #include "presto_cpp/main/http/filters/InternalAuthenticationFilter.h"
 #ifdef PRESTO_ENABLE_JWT
-#include <folly/ssl/OpenSSLHash.h> //@manual
 #include <jwt-cpp/jwt.h> //@manual
 #include <jwt-cpp/traits/nlohmann-json/traits.h> //@manual
 #endif // PRESTO_ENABLE_JWT
 #include <proxygen/httpserver/ResponseBuilder.h>
 #include "presto_cpp/main/common/Configs.h"
 #include "presto_cpp/main/http/HttpConstants.h"
+#include "presto_cpp/main/http/JwtCache.h"
 
 namespace facebook::presto::http::filters {
 
@@ -130,28 +130,10 @@ void InternalAuthenticationFilter::processAndVerifyJwt(
     std::unique_ptr<proxygen::HTTPMessage> msg) {
 #ifdef PRESTO_ENABLE_JWT
   try {
-    // Build the signature key from the secret and validate the signature.
-    auto secretHash = std::vector<uint8_t>(SHA256_DIGEST_LENGTH);
-    folly::ssl::OpenSSLHash::sha256(
-        folly::range(secretHash),
-        folly::ByteRange(
-            folly::StringPiece(
-                SystemConfig::instance()
-                    ->internalCommunicationSharedSecret())));
-
-    // Decode and verify the JWT.
-    auto decodedJwt = jwt::decode<jwt::traits::nlohmann_json>(token);
-    auto verifier = jwt::verify<jwt::traits::nlohmann_json>().allow_algorithm(
-        jwt::algorithm::hs256{std::string(
-            reinterpret_cast<char*>(secretHash.data()), secretHash.size())});
-    verifier.verify(decodedJwt);
-
-    auto subject = decodedJwt.get_subject();
-    // The nodeId of the requester is the subject. Check if it was set.
-    if (subject.empty()) {
-      std::error_code ec{jwt::error::token_verification_error::missing_claim};
-      throw jwt::error::token_verification_exception(ec);
-    }
+    // Verified tokens are cached until they expire, so repeated tokens from
+    // the same node skip the decoding and signature check.
+    http::JwtVerifier::instance().verify(
+        token, SystemConfig::instance()->internalCommunicationSharedSecret());
     // Passed the verification, move the message along.
     Filter::onRequest(std::move(msg));
   } catch (const jwt::error::token_verification_exception&) {
@@ -539,6 +539,69 @@ TEST_P(HttpTestSuite, testReportOnBodyStatsFunc) {
   wrapper.stop();
 }
 
+TEST(HttpRouterTest, firstRegisteredWins) {
+  // Same order as TaskResource registers its GET endpoints. The patterns
+  // overlap, so the router must keep the registration order.
+  const std::vector<std::string> patterns{
+      R"(/v1/task/(.+)/results/([0-9]+)/([0-9]+)/acknowledge)",
+      R"(/v1/task/(.+)/status)",
+      R"(/v1/task/(.+)/results/([0-9]+)/([0-9]+))",
+      R"(/v1/task/(.+))"};
+  std::vector<std::unique_ptr<http::EndPoint>> endpoints;
+  for (const auto& pattern : patterns) {
+    endpoints.push_back(std::make_unique<http::EndPoint>(pattern, nullptr));
+  }
+  http::EndPointRouter router(endpoints);
+  const std::string taskUri{"/v1/task/20240101_000000_00000_abcde.1.0.0.0"};
+  EXPECT_EQ(router.match(taskUri + "/results/3/17/acknowledge"), 0);
+  EXPECT_EQ(router.match(taskUri + "/status"), 1);
+  EXPECT_EQ(router.match(taskUri + "/results/3/17"), 2);
+  EXPECT_EQ(router.match(taskUri), 3);
+  // Patterns are anchored at both ends.
+  EXPECT_EQ(router.match("/v1/info"), -1);
+  EXPECT_EQ(router.match("/prefix/v1/task/x"), -1);
+
+  http::EndPointRouter emptyRouter({});
+  EXPECT_EQ(emptyRouter.match("/v1/task/x"), -1);
+}
+
+TEST(HttpRouterTest, resolvedEndPoint) {
+  http::DispatchingRequestHandlerFactory factory;
+  std::vector<std::string> captured;
+  factory.registerEndPoint(
+      proxygen::HTTPMethod::GET,
+      R"(/v1/task/(.+)/status)",
+      [&](proxygen::HTTPMessage* /*message*/,
+          const std::vector<std::string>& args) {
+        captured = args;
+        return new http::ErrorRequestHandler(http::kHttpOk, "");
+      });
+  factory.compile();
+
+  proxygen::HTTPMessage message;
+  message.setMethod(proxygen::HTTPMethod::GET);
+  message.setURL("/v1/task/q.1.0.0.0/status");
+  std::unique_ptr<proxygen::RequestHandler> handler(
+      factory.onRequest(nullptr, &message));
+  ASSERT_EQ(captured.size(), 2);
+  EXPECT_EQ(captured[1], "q.1.0.0.0");
+  const auto* endpoint =
+      http::DispatchingRequestHandlerFactory::resolvedEndPoint(&message);
+  ASSERT_NE(endpoint, nullptr);
+  EXPECT_EQ(endpoint->pattern(), R"(/v1/task/(.+)/status)");
+
+  proxygen::HTTPMessage unknown;
+  unknown.setMethod(proxygen::HTTPMethod::GET);
+  unknown.setURL("/v1/unknown");
+  handler.reset(factory.onRequest(nullptr, &unknown));
+  EXPECT_EQ(
+      http::DispatchingRequestHandlerFactory::resolvedEndPoint(&unknown),
+      nullptr);
+  EXPECT_EQ(
+      http::DispatchingRequestHandlerFactory::resolvedEndPoint(&message),
+      nullptr);
+}
+
 INSTANTIATE_TEST_CASE_P(
     HTTPTest,
     HttpTestSuite,
@@ -548,3 +611,25 @@ INSTANTIATE_TEST_CASE_P(
 folly::Singleton<facebook::velox::BaseStatsReporter> reporter([]() {
   return new facebook::velox::DummyStatsReporter();
 });
+
+TEST(HttpCachedResponseTest, matchesEntityTag) {
+  const std::string etag{"\"0123abcd\""};
+  EXPECT_TRUE(http::matchesEntityTag(etag, etag));
+  EXPECT_TRUE(http::matchesEntityTag("W/\"0123abcd\"", etag));
+  EXPECT_TRUE(http::matchesEntityTag("\"other\", \"0123abcd\"", etag));
+  EXPECT_TRUE(http::matchesEntityTag("*", etag));
+  EXPECT_FALSE(http::matchesEntityTag("", etag));
+  EXPECT_FALSE(http::matchesEntityTag("\"other\"", etag));
+  EXPECT_FALSE(http::matchesEntityTag("0123abcd", etag));
+}
+
+TEST(HttpCachedResponseTest, acceptsEncoding) {
+  EXPECT_TRUE(http::acceptsEncoding("gzip", "gzip"));
+  EXPECT_TRUE(http::acceptsEncoding("zstd, GZIP", "gzip"));
+  EXPECT_TRUE(http::acceptsEncoding("deflate, gzip;q=0.5", "gzip"));
+  EXPECT_TRUE(http::acceptsEncoding("*", "gzip"));
+  EXPECT_FALSE(http::acceptsEncoding("", "gzip"));
+  EXPECT_FALSE(http::acceptsEncoding("zstd, deflate", "gzip"));
+  EXPECT_FALSE(http::acceptsEncoding("gzip;q=0", "gzip"));
+  EXPECT_FALSE(http::acceptsEncoding("gzip; q=0.0, zstd", "gzip"));
+}
@@ -0,0 +1,114 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/http/JwtCache.h"
+#include <folly/ssl/OpenSSLHash.h> //@manual
+#include <gtest/gtest.h>
+#include <jwt-cpp/jwt.h> //@manual
+#include <jwt-cpp/traits/nlohmann-json/traits.h> //@manual
+#include <thread>
+
+using namespace facebook::presto::http;
+
+namespace {
+JwtOptions jwtOptions(
+    const std::string& sharedSecret,
+    int32_t expirationSeconds = 300) {
+  JwtOptions options;
+  options.jwtEnabled = true;
+  options.sharedSecret = sharedSecret;
+  options.jwtExpirationSeconds = expirationSeconds;
+  options.nodeId = "testnode";
+  return options;
+}
+} // namespace
+
+TEST(JwtCacheTest, signerReusesToken) {
+  auto& signer = JwtSigner::instance();
+  const auto options = jwtOptions("signerSecret");
+  const auto token = signer.token(options);
+  EXPECT_EQ(signer.token(options), token);
+
+  auto decoded = jwt::decode<jwt::traits::nlohmann_json>(token);
+  EXPECT_EQ(decoded.get_subject(), "testnode");
+
+  // Any change of the options produces a new token.
+  auto otherOptions = options;
+  otherOptions.nodeId = "othernode";
+  const auto otherToken = signer.token(otherOptions);
+  EXPECT_NE(otherToken, token);
+  EXPECT_EQ(
+      jwt::decode<jwt::traits::nlohmann_json>(otherToken).get_subject(),
+      "othernode");
+}
+
+TEST(JwtCacheTest, refreshMargin) {
+  EXPECT_EQ(
+      JwtSigner::refreshMargin(jwtOptions("secret", 300)),
+      std::chrono::seconds(30));
+  EXPECT_EQ(
+      JwtSigner::refreshMargin(jwtOptions("secret", 10)),
+      std::chrono::seconds(5));
+  EXPECT_EQ(
+      JwtSigner::refreshMargin(jwtOptions("secret", 1)),
+      std::chrono::seconds(0));
+}
+
+TEST(JwtCacheTest, verifierCachesVerifiedTokens) {
+  auto& signer = JwtSigner::instance();
+  auto& verifier = JwtVerifier::instance();
+  const std::string secret{"verifierSecret"};
+  const auto token = signer.token(jwtOptions(secret));
+
+  verifier.verify(token, secret);
+  EXPECT_EQ(verifier.numCachedTokens(), 1);
+  verifier.verify(token, secret);
+  EXPECT_EQ(verifier.numCachedTokens(), 1);
+
+  // A different secret must not accept tokens verified with the old secret.
+  EXPECT_THROW(
+      verifier.verify(token, "otherSecret"),
+      jwt::error::signature_verification_exception);
+  EXPECT_EQ(verifier.numCachedTokens(), 0);
+}
+
+TEST(JwtCacheTest, verifierHonorsExpiration) {
+  auto& verifier = JwtVerifier::instance();
+  const std::string secret{"expiringSecret"};
+  const auto token = JwtSigner::instance().token(jwtOptions(secret, 1));
+  verifier.verify(token, secret);
+  EXPECT_EQ(verifier.numCachedTokens(), 1);
+
+  // The cached entry expires together with the token.
+  std::this_thread::sleep_for(std::chrono::milliseconds(2'100));
+  EXPECT_THROW(
+      verifier.verify(token, secret),
+      jwt::error::token_verification_exception);
+}
+
+TEST(JwtCacheTest, verifierRequiresSubject) {
+  const std::string secret{"subjectSecret"};
+  std::string signingKey(SHA256_DIGEST_LENGTH, '\0');
+  folly::ssl::OpenSSLHash::sha256(
+      folly::MutableByteRange(
+          reinterpret_cast<uint8_t*>(signingKey.data()), signingKey.size()),
+      folly::ByteRange(folly::StringPiece(secret)));
+  const auto now = std::chrono::system_clock::now();
+  const auto token = jwt::create<jwt::traits::nlohmann_json>()
+                         .set_issued_at(now)
+                         .set_expires_at(now + std::chrono::seconds(60))
+                         .sign(jwt::algorithm::hs256{signingKey});
+  EXPECT_THROW(
+      JwtVerifier::instance().verify(token, secret),
+      jwt::error::token_verification_exception);
+}
@@ -12,6 +12,9 @@
  * limitations under the License.
  */
 #include "presto_cpp/main/operators/BinarySortableSerializer.h"
+#include <folly/lang/Bits.h>
+#include <numeric>
+#include <string_view>
 #include "velox/common/base/SimdUtil.h"
 #include "velox/exec/Operator.h"
 
@@ -57,54 +60,171 @@ FOLLY_ALWAYS_INLINE void writeByte(T* out, int8_t value, bool isDescending) {
   }
 }
 
+// Appends 'size' bytes of 'data' as is. Uses the bulk append of 'out' if it
+// has one.
+template <typename T>
+FOLLY_ALWAYS_INLINE void appendBytes(T* out, const char* data, size_t size) {
+  if constexpr (requires { out->appendBytes(data, size); }) {
+    out->appendBytes(data, size);
+  } else {
+    for (size_t i = 0; i < size; ++i) {
+      out->appendByte(data[i]);
+    }
+  }
+}
+
+// Appends 'size' bytes of 'data', inverting all bits if 'isDescending'.
+template <typename T>
+void writeRun(T* out, const char* data, size_t size, bool isDescending) {
+  if (!isDescending) {
+    appendBytes(out, data, size);
+    return;
+  }
+  using Batch = xsimd::batch<uint8_t>;
+  constexpr size_t kChunkSize = 16 * Batch::size;
+  uint8_t inverted[kChunkSize];
+  const Batch ones(0xff);
+  while (size > 0) {
+    const auto chunkSize = std::min(size, kChunkSize);
+    size_t i = 0;
+    for (; i + Batch::size <= chunkSize; i += Batch::size) {
+      (Batch::load_unaligned(reinterpret_cast<const uint8_t*>(data) + i) ^
+       ones)
+          .store_unaligned(inverted + i);
+    }
+    for (; i < chunkSize; ++i) {
+      inverted[i] = ~static_cast<uint8_t>(data[i]);
+    }
+    appendBytes(out, reinterpret_cast<const char*>(inverted), chunkSize);
+    data += chunkSize;
+    size -= chunkSize;
+  }
+}
+
+// Appends the bytes of the big endian 'value', inverting all bits if
+// 'isDescending'.
+template <typename T, typename U>
+FOLLY_ALWAYS_INLINE void writeBigEndian(T* out, U value, bool isDescending) {
+  static_assert(std::is_unsigned_v<U>);
+  value = folly::Endian::big(isDescending ? static_cast<U>(~value) : value);
+  appendBytes(out, reinterpret_cast<const char*>(&value), sizeof(U));
+}
+
 template <typename T>
 FOLLY_ALWAYS_INLINE void writeLong(T* out, int64_t value, bool isDescending) {
-  writeByte(out, static_cast<int8_t>((value >> 56) ^ 0x80), isDescending);
-  writeByte(out, static_cast<int8_t>(value >> 48), isDescending);
-  writeByte(out, static_cast<int8_t>(value >> 40), isDescending);
-  writeByte(out, static_cast<int8_t>(value >> 32), isDescending);
-  writeByte(out, static_cast<int8_t>(value >> 24), isDescending);
-  writeByte(out, static_cast<int8_t>(value >> 16), isDescending);
-  writeByte(out, static_cast<int8_t>(value >> 8), isDescending);
-  writeByte(out, static_cast<int8_t>(value), isDescending);
+  // Flips the sign bit so that negative values sort first.
+  writeBigEndian(
+      out, static_cast<uint64_t>(value) ^ (1ULL << 63), isDescending);
 }
 
 template <typename T>
 FOLLY_ALWAYS_INLINE void
 writeInteger(T* out, int32_t value, bool isDescending) {
-  writeByte(out, static_cast<int8_t>((value >> 24) ^ 0x80), isDescending);
-  writeByte(out, static_cast<int8_t>(value >> 16), isDescending);
-  writeByte(out, static_cast<int8_t>(value >> 8), isDescending);
-  writeByte(out, static_cast<int8_t>(value), isDescending);
+  writeBigEndian(out, static_cast<uint32_t>(value) ^ (1U << 31), isDescending);
+}
+
+template <typename T>
+FOLLY_ALWAYS_INLINE void
+writeHugeInt(T* out, velox::int128_t value, bool isDescending) {
+  const auto bits = static_cast<velox::uint128_t>(value);
+  // Flips the sign bit so that negative values sort first.
+  writeBigEndian(
+      out, static_cast<uint64_t>(bits >> 64) ^ (1ULL << 63), isDescending);
+  writeBigEndian(out, static_cast<uint64_t>(bits), isDescending);
+}
+
+template <typename T>
+FOLLY_ALWAYS_INLINE void writeDouble(T* out, double value, bool isDescending) {
+  int64_t longValue = doubleToLong(value);
+
+  if ((longValue & (1L << 63)) != 0) {
+    // negative number, flip all bits
+    longValue = ~longValue;
+  } else {
+    // positive number, flip the first bit
+    longValue = longValue ^ (1L << 63);
+  }
+  writeBigEndian(out, static_cast<uint64_t>(longValue), isDescending);
 }
 
 template <typename T>
-FOLLY_ALWAYS_INLINE void writeBytes(
+FOLLY_ALWAYS_INLINE void writeFloat(T* out, float value, bool isDescending) {
+  int32_t intValue = floatToInt(value);
+
+  if ((intValue & (1L << 31)) != 0) {
+    // negative number, flip all bits
+    intValue = ~intValue;
+  } else {
+    // positive number, flip the first bit
+    intValue = intValue ^ (1L << 31);
+  }
+  writeBigEndian(out, static_cast<uint32_t>(intValue), isDescending);
+}
+
+template <typename T>
+FOLLY_ALWAYS_INLINE void
+writeSmallInt(T* out, int16_t value, bool isDescending) {
+  writeBigEndian(
+      out,
+      static_cast<uint16_t>(static_cast<uint16_t>(value) ^ 0x8000),
+      isDescending);
+}
+
+// Returns a bit mask of the bytes in 'bytes' that need escaping, i.e. 0 and 1.
+FOLLY_ALWAYS_INLINE uint64_t escapedBytesMask(xsimd::batch<uint8_t> bytes) {
+  const auto mask = velox::simd::toBitMask(bytes <= xsimd::batch<uint8_t>(1));
+  return static_cast<std::make_unsigned_t<decltype(mask)>>(mask);
+}
+
+// Writes 'data' followed by an end marker, prefixing each 0 and 1 with a 1
+// byte. The runs in between are appended in bulk.
+template <typename T>
+void writeBytes(
     T* out,
     const char* data,
     size_t offset,
     size_t size,
     bool isDescending) {
-  for (auto i = 0; i < size; ++i) {
-    if (data[offset + i] == 0 || data[offset + i] == 1) {
-      writeByte(out, 1, isDescending);
-      writeByte(out, data[offset + i], isDescending);
-    } else {
-      writeByte(out, data[offset + i], isDescending);
+  using Batch = xsimd::batch<uint8_t>;
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data + offset);
+  size_t runStart = 0;
+  auto escape = [&](size_t pos) {
+    writeRun(out, data + offset + runStart, pos - runStart, isDescending);
+    writeByte(out, 1, isDescending);
+    writeByte(out, bytes[pos], isDescending);
+    runStart = pos + 1;
+  };
+
+  size_t i = 0;
+  for (; i + Batch::size <= size; i += Batch::size) {
+    auto mask = escapedBytesMask(Batch::load_unaligned(bytes + i));
+    while (mask != 0) {
+      escape(i + __builtin_ctzll(mask));
+      mask &= mask - 1;
     }
   }
+  for (; i < size; ++i) {
+    if (bytes[i] <= 1) {
+      escape(i);
+    }
+  }
+  writeRun(out, data + offset + runStart, size - runStart, isDescending);
   writeByte(out, 0, isDescending);
 }
 
 FOLLY_ALWAYS_INLINE size_t
 getBytesSerializedSize(const char* data, size_t offset, size_t size) {
-  size_t count = 0;
-  for (auto i = 0; i < size; ++i) {
-    if (data[offset + i] == 0 || data[offset + i] == 1) {
-      count += 2;
-    } else {
-      ++count;
-    }
+  using Batch = xsimd::batch<uint8_t>;
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data + offset);
+  // Each byte takes one byte and the escaped ones one more.
+  size_t count = size;
+  size_t i = 0;
+  for (; i + Batch::size <= size; i += Batch::size) {
+    count += __builtin_popcountll(
+        escapedBytesMask(Batch::load_unaligned(bytes + i)));
+  }
+  for (; i < size; ++i) {
+    count += bytes[i] <= 1;
   }
   // One additional byte for end marker.
   return count + 1;
@@ -154,6 +274,26 @@ void serializeBigInt(
   }
 }
 
+template <typename T>
+void serializeHugeInt(
+    const velox::BaseVector& vector,
+    velox::vector_size_t index,
+    T* out,
+    bool isNullLast,
+    bool isDescending) {
+  if (vector.isNullAt(index)) {
+    writeBool(out, isNullLast);
+  } else {
+    writeBool(out, !isNullLast);
+    const auto value =
+        vector
+            .asUnchecked<velox::SimpleVector<
+                velox::TypeTraits<velox::TypeKind::HUGEINT>::NativeType>>()
+            ->valueAt(index);
+    writeHugeInt(out, value, isDescending);
+  }
+}
+
 template <typename T>
 void serializeDouble(
     const velox::BaseVector& vector,
@@ -170,23 +310,7 @@ void serializeDouble(
             .asUnchecked<velox::SimpleVector<
                 velox::TypeTraits<velox::TypeKind::DOUBLE>::NativeType>>()
             ->valueAt(index);
-    int64_t longValue = doubleToLong(value);
-
-    if ((longValue & (1L << 63)) != 0) {
-      // negative number, flip all bits
-      longValue = ~longValue;
-    } else {
-      // positive number, flip the first bit
-      longValue = longValue ^ (1L << 63);
-    }
-    writeByte(out, static_cast<int8_t>(longValue >> 56), isDescending);
-    writeByte(out, static_cast<int8_t>(longValue >> 48), isDescending);
-    writeByte(out, static_cast<int8_t>(longValue >> 40), isDescending);
-    writeByte(out, static_cast<int8_t>(longValue >> 32), isDescending);
-    writeByte(out, static_cast<int8_t>(longValue >> 24), isDescending);
-    writeByte(out, static_cast<int8_t>(longValue >> 16), isDescending);
-    writeByte(out, static_cast<int8_t>(longValue >> 8), isDescending);
-    writeByte(out, static_cast<int8_t>(longValue), isDescending);
+    writeDouble(out, value, isDescending);
   }
 }
 
@@ -206,19 +330,7 @@ void serializeReal(
             .asUnchecked<velox::SimpleVector<
                 velox::TypeTraits<velox::TypeKind::REAL>::NativeType>>()
             ->valueAt(index);
-    int32_t intValue = floatToInt(value);
-
-    if ((intValue & (1L << 31)) != 0) {
-      // negative number, flip all bits
-      intValue = ~intValue;
-    } else {
-      // positive number, flip the first bit
-      intValue = intValue ^ (1L << 31);
-    }
-    writeByte(out, static_cast<int8_t>(intValue >> 24), isDescending);
-    writeByte(out, static_cast<int8_t>(intValue >> 16), isDescending);
-    writeByte(out, static_cast<int8_t>(intValue >> 8), isDescending);
-    writeByte(out, static_cast<int8_t>(intValue), isDescending);
+    writeFloat(out, value, isDescending);
   }
 }
 
@@ -258,8 +370,7 @@ void serializeSmallInt(
             .asUnchecked<velox::SimpleVector<
                 velox::TypeTraits<velox::TypeKind::SMALLINT>::NativeType>>()
             ->valueAt(index);
-    writeByte(out, static_cast<int8_t>((value >> 8) ^ 0x80), isDescending);
-    writeByte(out, static_cast<int8_t>(value), isDescending);
+    writeSmallInt(out, value, isDescending);
   }
 }
 
@@ -576,6 +687,132 @@ void calculateSerializedSizeArrayBatch(
   }
 }
 
+// Collects serialized bytes in a string.
+struct StringWriter {
+  std::string& buffer;
+
+  void appendByte(int8_t value) {
+    buffer.push_back(static_cast<char>(value));
+  }
+
+  void appendBytes(const char* data, size_t size) {
+    buffer.append(data, size);
+  }
+};
+
+// Serializes a map like an array of (key, value) entries. Entries are written
+// in the order of their serialized keys so that equal maps produce the same
+// bytes however their entries are stored.
+template <typename T>
+void serializeMap(
+    const velox::BaseVector& vector,
+    velox::vector_size_t index,
+    T* out,
+    bool isNullLast,
+    bool isDescending) {
+  if (vector.isNullAt(index)) {
+    writeBool(out, isNullLast);
+  } else {
+    writeBool(out, !isNullLast);
+    const velox::DecodedVector decoded(vector);
+    const auto* mapBase = decoded.base()->as<velox::MapVector>();
+    const auto decodedIndex = decoded.index(index);
+    const auto offset = mapBase->offsetAt(decodedIndex);
+    const auto size = mapBase->sizeAt(decodedIndex);
+    const auto& keys = *mapBase->mapKeys();
+    const auto& values = *mapBase->mapValues();
+
+    std::string keyBytes;
+    std::vector<size_t> keyOffsets(size + 1);
+    StringWriter keyWriter{keyBytes};
+    for (auto i = 0; i < size; ++i) {
+      keyOffsets[i] = keyBytes.size();
+      serializeSwitch(keys, offset + i, &keyWriter, isNullLast, isDescending);
+    }
+    keyOffsets[size] = keyBytes.size();
+    const auto keyAt = [&](velox::vector_size_t i) {
+      return std::string_view(
+          keyBytes.data() + keyOffsets[i], keyOffsets[i + 1] - keyOffsets[i]);
+    };
+
+    // Compares as unsigned bytes, like the comparison of serialized rows.
+    std::vector<velox::vector_size_t> order(size);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](auto left, auto right) {
+      return keyAt(left) < keyAt(right);
+    });
+
+    for (const auto i : order) {
+      writeByte(out, 1, isDescending);
+      const auto key = keyAt(i);
+      appendBytes(out, key.data(), key.size());
+      serializeSwitch(values, offset + i, out, isNullLast, isDescending);
+    }
+    writeByte(out, 0, isDescending);
+  }
+}
+
+size_t getSerializedMapSize(
+    const velox::BaseVector& vector,
+    velox::vector_size_t index) {
+  const velox::DecodedVector decoded(vector);
+  const auto* mapBase = decoded.base()->as<velox::MapVector>();
+  const auto decodedIndex = decoded.index(index);
+  const auto offset = mapBase->offsetAt(decodedIndex);
+  const auto size = mapBase->sizeAt(decodedIndex);
+  // One byte per entry and one additional byte for end marker.
+  size_t serializedSize = size + 1;
+  for (auto i = offset; i < offset + size; ++i) {
+    serializedSize += serializedSizeSwitch(*mapBase->mapKeys(), i) +
+        serializedSizeSwitch(*mapBase->mapValues(), i);
+  }
+  return serializedSize;
+}
+
+void calculateSerializedSizeMapBatch(
+    const velox::BaseVector& source,
+    const folly::Range<const velox::vector_size_t*>& rows,
+    velox::vector_size_t** sizes,
+    velox::Scratch& scratch) {
+  const auto numRows = rows.size();
+
+  const velox::DecodedVector decoded(source);
+  const auto* mapBase = decoded.base()->as<velox::MapVector>();
+
+  velox::vector_size_t totalEntries = 0;
+  for (auto i = 0; i < numRows; ++i) {
+    totalEntries += mapBase->sizeAt(decoded.index(rows[i]));
+  }
+
+  velox::ScratchPtr<velox::vector_size_t, 1> entryRowsHolder(scratch);
+  velox::ScratchPtr<velox::vector_size_t*, 1> entrySizesHolder(scratch);
+  auto entryRows = entryRowsHolder.get(totalEntries);
+  auto entrySizes = entrySizesHolder.get(totalEntries);
+
+  size_t entryIndex = 0;
+  for (auto i = 0; i < numRows; ++i) {
+    const auto decodedIndex = decoded.index(rows[i]);
+    const auto offset = mapBase->offsetAt(decodedIndex);
+    const auto size = mapBase->sizeAt(decodedIndex);
+    for (auto j = 0; j < size; ++j) {
+      entryRows[entryIndex] = offset + j;
+      entrySizes[entryIndex] = sizes[i];
+      ++entryIndex;
+    }
+    // One byte per entry and one additional byte for end marker.
+    *sizes[i] += size + 1;
+  }
+
+  if (totalEntries > 0) {
+    const folly::Range<const velox::vector_size_t*> entries(
+        entryRows, totalEntries);
+    serializedSizeSwitchBatch(
+        *mapBase->mapKeys(), entries, entrySizes, scratch);
+    serializedSizeSwitchBatch(
+        *mapBase->mapValues(), entries, entrySizes, scratch);
+  }
+}
+
 template <typename T>
 void serializeSwitch(
     const velox::BaseVector& source,
@@ -590,6 +827,8 @@ void serializeSwitch(
   switch (source.typeKind()) {
     case velox::TypeKind::BIGINT:
       return serializeBigInt(source, index, out, isNullLast, isDescending);
+    case velox::TypeKind::HUGEINT:
+      return serializeHugeInt(source, index, out, isNullLast, isDescending);
     case velox::TypeKind::BOOLEAN:
       return serializeBoolean(source, index, out, isNullLast, isDescending);
     case velox::TypeKind::DOUBLE:
@@ -612,6 +851,11 @@ void serializeSwitch(
       return serializeRow(source, index, out, isNullLast, isDescending);
     case velox::TypeKind::ARRAY:
       return serializeArray(source, index, out, isNullLast, isDescending);
+    case velox::TypeKind::MAP:
+      return serializeMap(source, index, out, isNullLast, isDescending);
+    case velox::TypeKind::UNKNOWN:
+      // All values are null.
+      return writeBool(out, isNullLast);
     default:
       VELOX_NYI("Unsupported type: {}", source.typeKind());
   }
@@ -630,6 +874,8 @@ size_t serializedSizeSwitch(
   switch (source.typeKind()) {
     case velox::TypeKind::BIGINT:
       [[fallthrough]];
+    case velox::TypeKind::HUGEINT:
+      [[fallthrough]];
     case velox::TypeKind::BOOLEAN:
       [[fallthrough]];
     case velox::TypeKind::DOUBLE:
@@ -667,6 +913,8 @@ size_t serializedSizeSwitch(
       return getSerializedRowSize(source, index);
     case velox::TypeKind::ARRAY:
       return kNullByteSize + getSerializedArraySize(source, index);
+    case velox::TypeKind::MAP:
+      return kNullByteSize + getSerializedMapSize(source, index);
     default:
       VELOX_NYI("Unsupported type: {}", source.typeKind());
   }
@@ -727,6 +975,7 @@ void serializedSizeSwitchBatch(
 
   switch (source.typeKind()) {
     case velox::TypeKind::BIGINT:
+    case velox::TypeKind::HUGEINT:
     case velox::TypeKind::BOOLEAN:
     case velox::TypeKind::DOUBLE:
     case velox::TypeKind::REAL:
@@ -771,11 +1020,202 @@ void serializedSizeSwitchBatch(
           source, nonNullRows, nonNullSizes, scratch);
       break;
     }
+    case velox::TypeKind::MAP: {
+      for (auto i = 0; i < nonNullRows.size(); ++i) {
+        *nonNullSizes[i] += kNullByteSize;
+      }
+      calculateSerializedSizeMapBatch(
+          source, nonNullRows, nonNullSizes, scratch);
+      break;
+    }
+    case velox::TypeKind::UNKNOWN:
+      // All values are null.
+      break;
     default:
       VELOX_NYI("Unsupported type: {}", source.typeKind());
   }
 }
 
+// Output of the columnar serialization. Appends to a row of a raw buffer
+// that is sized by serializedSizeInBytes(). Debug builds check every write
+// against the end of the row.
+struct RawRowWriter {
+  char* pos;
+  const char* end;
+
+  void appendByte(int8_t value) {
+    VELOX_DCHECK(pos < end, "Serialized key overflows its row buffer");
+    *pos++ = value;
+  }
+
+  void appendBytes(const char* data, size_t size) {
+    VELOX_DCHECK(
+        size <= static_cast<size_t>(end - pos),
+        "Serialized key overflows its row buffer");
+    memcpy(pos, data, size);
+    pos += size;
+  }
+};
+
+void serializeColumn(
+    const velox::BaseVector& column,
+    folly::Range<const velox::vector_size_t*> rows,
+    RawRowWriter* const* writers,
+    bool isNullLast,
+    bool isDescending,
+    velox::Scratch& scratch);
+
+// Writes the null byte and the value of 'rows' of a primitive 'column' with
+// 'writeValue'. 'column' is decoded once for all rows.
+template <typename TValue, typename TWriteValue>
+void serializePrimitiveColumn(
+    const velox::BaseVector& column,
+    folly::Range<const velox::vector_size_t*> rows,
+    RawRowWriter* const* writers,
+    bool isNullLast,
+    TWriteValue writeValue) {
+  const velox::DecodedVector decoded(column);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    auto* out = writers[i];
+    if (decoded.isNullAt(rows[i])) {
+      writeBool(out, isNullLast);
+    } else {
+      writeBool(out, !isNullLast);
+      writeValue(out, decoded.valueAt<TValue>(rows[i]));
+    }
+  }
+}
+
+// Serializes the fields of the non-null rows of a ROW 'column' field by field.
+void serializeRowColumn(
+    const velox::BaseVector& column,
+    folly::Range<const velox::vector_size_t*> rows,
+    RawRowWriter* const* writers,
+    bool isNullLast,
+    bool isDescending,
+    velox::Scratch& scratch) {
+  const velox::DecodedVector decoded(column);
+  const auto* rowBase = decoded.base()->as<velox::RowVector>();
+  const auto childrenSize = rowBase->type()->size();
+  const auto& children = rowBase->children();
+
+  velox::ScratchPtr<velox::vector_size_t, 1> nonNullRowsHolder(scratch);
+  velox::ScratchPtr<RawRowWriter*, 1> nonNullWritersHolder(scratch);
+  auto* nonNullRows = nonNullRowsHolder.get(rows.size());
+  auto* nonNullWriters = nonNullWritersHolder.get(rows.size());
+  size_t numNonNull = 0;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    if (decoded.isNullAt(rows[i])) {
+      writeBool(writers[i], isNullLast);
+    } else {
+      nonNullRows[numNonNull] = decoded.index(rows[i]);
+      nonNullWriters[numNonNull] = writers[i];
+      ++numNonNull;
+    }
+  }
+
+  for (int32_t child = 0; child < childrenSize; ++child) {
+    const bool present = child < children.size() && children[child];
+    for (size_t i = 0; i < numNonNull; ++i) {
+      writeBool(nonNullWriters[i], present ? !isNullLast : isNullLast);
+    }
+    if (present) {
+      serializeColumn(
+          *children[child],
+          folly::Range<const velox::vector_size_t*>(nonNullRows, numNonNull),
+          nonNullWriters,
+          isNullLast,
+          isDescending,
+          scratch);
+    }
+  }
+}
+
+// Serializes 'rows' of 'column' to 'writers'. Primitive and ROW columns are
+// serialized for all rows at once, ARRAY and MAP columns row by row.
+void serializeColumn(
+    const velox::BaseVector& column,
+    folly::Range<const velox::vector_size_t*> rows,
+    RawRowWriter* const* writers,
+    bool isNullLast,
+    bool isDescending,
+    velox::Scratch& scratch) {
+  // DATE is an INTEGER and serialized the same way.
+  switch (column.typeKind()) {
+    case velox::TypeKind::BIGINT:
+      return serializePrimitiveColumn<int64_t>(
+          column, rows, writers, isNullLast, [&](auto* out, int64_t value) {
+            writeLong(out, value, isDescending);
+          });
+    case velox::TypeKind::HUGEINT:
+      return serializePrimitiveColumn<velox::int128_t>(
+          column,
+          rows,
+          writers,
+          isNullLast,
+          [&](auto* out, velox::int128_t value) {
+            writeHugeInt(out, value, isDescending);
+          });
+    case velox::TypeKind::INTEGER:
+      return serializePrimitiveColumn<int32_t>(
+          column, rows, writers, isNullLast, [&](auto* out, int32_t value) {
+            writeInteger(out, value, isDescending);
+          });
+    case velox::TypeKind::SMALLINT:
+      return serializePrimitiveColumn<int16_t>(
+          column, rows, writers, isNullLast, [&](auto* out, int16_t value) {
+            writeSmallInt(out, value, isDescending);
+          });
+    case velox::TypeKind::TINYINT:
+      return serializePrimitiveColumn<int8_t>(
+          column, rows, writers, isNullLast, [&](auto* out, int8_t value) {
+            writeByte(out, static_cast<int8_t>(value ^ 0x80), isDescending);
+          });
+    case velox::TypeKind::BOOLEAN:
+      return serializePrimitiveColumn<bool>(
+          column, rows, writers, isNullLast, [&](auto* out, bool value) {
+            writeByte(out, static_cast<int8_t>(value ? 2 : 1), isDescending);
+          });
+    case velox::TypeKind::DOUBLE:
+      return serializePrimitiveColumn<double>(
+          column, rows, writers, isNullLast, [&](auto* out, double value) {
+            writeDouble(out, value, isDescending);
+          });
+    case velox::TypeKind::REAL:
+      return serializePrimitiveColumn<float>(
+          column, rows, writers, isNullLast, [&](auto* out, float value) {
+            writeFloat(out, value, isDescending);
+          });
+    case velox::TypeKind::TIMESTAMP:
+      return serializePrimitiveColumn<velox::Timestamp>(
+          column,
+          rows,
+          writers,
+          isNullLast,
+          [&](auto* out, const velox::Timestamp& value) {
+            writeLong(out, value.toNanos(), isDescending);
+          });
+    case velox::TypeKind::VARCHAR:
+    case velox::TypeKind::VARBINARY:
+      return serializePrimitiveColumn<velox::StringView>(
+          column,
+          rows,
+          writers,
+          isNullLast,
+          [&](auto* out, const velox::StringView& value) {
+            writeBytes(
+                out, value.data(), /*offset=*/0, value.size(), isDescending);
+          });
+    case velox::TypeKind::ROW:
+      return serializeRowColumn(
+          column, rows, writers, isNullLast, isDescending, scratch);
+    default:
+      for (size_t i = 0; i < rows.size(); ++i) {
+        serializeSwitch(column, rows[i], writers[i], isNullLast, isDescending);
+      }
+  }
+}
+
 std::vector<std::pair<int32_t, velox::column_index_t>> computeSortChannels(
     const std::vector<velox::core::FieldAccessTypedExprPtr>& sortFields,
     const velox::RowTypePtr& inputRowType) {
@@ -828,6 +1268,68 @@ void BinarySortableSerializer::serialize(
   }
 }
 
+void BinarySortableSerializer::serialize(
+    velox::vector_size_t offset,
+    velox::vector_size_t size,
+    char* const* rowBuffers,
+    const velox::vector_size_t* rowSizes,
+    velox::Scratch& scratch,
+    char** rowEnds) const {
+  if (size == 0) {
+    return;
+  }
+  VELOX_CHECK_LE(offset + size, input_->size(), "Invalid offset or size");
+
+  const velox::DecodedVector decoded(*input_, /*loadLazy=*/true);
+  const auto* rowBase = decoded.base()->as<velox::RowVector>();
+  const auto& children = rowBase->children();
+
+  velox::ScratchPtr<RawRowWriter, 1> rowWritersHolder(scratch);
+  velox::ScratchPtr<RawRowWriter*, 1> writersHolder(scratch);
+  velox::ScratchPtr<velox::vector_size_t, 1> decodedRowsHolder(scratch);
+  auto* rowWriters = rowWritersHolder.get(size);
+  auto* writers = writersHolder.get(size);
+  auto* decodedRows = decodedRowsHolder.get(size);
+  for (auto i = 0; i < size; ++i) {
+    rowWriters[i].pos = rowBuffers[i];
+    rowWriters[i].end = rowBuffers[i] + rowSizes[i];
+    writers[i] = &rowWriters[i];
+    decodedRows[i] = decoded.index(offset + i);
+  }
+
+  for (const auto& [idx, channel] : sortChannels_) {
+    const bool isNullLast = !sortOrders_[idx].isNullsFirst();
+    const bool isDescending = !sortOrders_[idx].isAscending();
+    if (channel >= children.size()) {
+      VELOX_CHECK_EQ(
+          channel,
+          velox::kConstantChannel,
+          "Channel must be field access or constant");
+      for (auto i = 0; i < size; ++i) {
+        writeBool(writers[i], isNullLast);
+      }
+      continue;
+    }
+    VELOX_CHECK_NOT_NULL(children[channel]);
+    for (auto i = 0; i < size; ++i) {
+      writeBool(writers[i], !isNullLast);
+    }
+    serializeColumn(
+        *children[channel],
+        folly::Range<const velox::vector_size_t*>(decodedRows, size),
+        writers,
+        isNullLast,
+        isDescending,
+        scratch);
+  }
+
+  if (rowEnds != nullptr) {
+    for (auto i = 0; i < size; ++i) {
+      rowEnds[i] = rowWriters[i].pos;
+    }
+  }
+}
+
 size_t BinarySortableSerializer::serializedSizeInBytes(
     velox::vector_size_t rowId) const {
   const velox::DecodedVector decoded(*input_, /*loadLazy=*/true);
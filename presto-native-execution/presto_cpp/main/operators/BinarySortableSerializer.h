@@ -40,6 +40,23 @@ class BinarySortableSerializer {
   void serialize(velox::vector_size_t rowId, velox::StringVectorBuffer* out)
       const;
 
+  /// Serializes the keys of the rows in [offset, offset + size) key column by
+  /// key column. The key of the i-th row is written to 'rowBuffers[i]', which
+  /// must have room for serializedSizeInBytes() of the row. Dictionary and
+  /// constant encoded key columns are decoded once per call.
+  /// @param rowSizes Size of each of 'rowBuffers'. Debug builds fail if a key
+  /// is written past it.
+  /// @param scratch Scratch memory for temporary allocations
+  /// @param rowEnds If not null, receives the end of the written key of each
+  /// row so the caller can verify it against the precomputed size.
+  void serialize(
+      velox::vector_size_t offset,
+      velox::vector_size_t size,
+      char* const* rowBuffers,
+      const velox::vector_size_t* rowSizes,
+      velox::Scratch& scratch,
+      char** rowEnds = nullptr) const;
+
   /// Returns the serialized byte size of a given input row at 'rowId'.
   size_t serializedSizeInBytes(velox::vector_size_t rowId) const;
 
@@ -0,0 +1,478 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/operators/CompactRowBatchDeserializer.h"
+
+#include <folly/lang/Bits.h>
+#include <algorithm>
+#include <cstring>
+
+#include "velox/row/CompactRow.h"
+#include "velox/serializers/RowSerializer.h"
+#include "velox/vector/LazyVector.h"
+
+using namespace facebook::velox;
+
+namespace facebook::presto::operators {
+
+namespace {
+using RowRun = CompactRowBatchDeserializer::RowRun;
+using FixedWidthColumn = CompactRowBatchDeserializer::FixedWidthColumn;
+
+// Width of a value in a CompactRow row, or std::nullopt if 'type' is not
+// serialized at a fixed width.
+std::optional<int32_t> fixedValueWidth(const TypePtr& type) {
+  switch (type->kind()) {
+    case TypeKind::BOOLEAN:
+    case TypeKind::TINYINT:
+      return 1;
+    case TypeKind::SMALLINT:
+      return 2;
+    case TypeKind::INTEGER:
+    case TypeKind::REAL:
+      return 4;
+    case TypeKind::BIGINT:
+    case TypeKind::DOUBLE:
+    // Timestamps are serialized as micros.
+    case TypeKind::TIMESTAMP:
+      return 8;
+    case TypeKind::HUGEINT:
+      return 16;
+    default:
+      return std::nullopt;
+  }
+}
+
+uint32_t readRowSize(const char* ptr) {
+  uint32_t rowSize;
+  std::memcpy(&rowSize, ptr, sizeof(uint32_t));
+  return folly::Endian::big(rowSize);
+}
+
+// Rows added by addPage() for a fixed-width row type: runs of rows with a
+// fixed stride.
+struct StridedRows {
+  const std::vector<RowRun>& runs;
+  const int32_t stride;
+
+  // Calls 'func' with the index and the start of each row.
+  template <typename Func>
+  void forEach(Func func) const {
+    vector_size_t i = 0;
+    for (const auto& run : runs) {
+      const char* row = run.rows;
+      for (vector_size_t j = 0; j < run.numRows; ++j, row += stride) {
+        func(i++, row);
+      }
+    }
+  }
+};
+
+// Start of each row.
+struct RowPointers {
+  const std::vector<const char*>& rows;
+
+  template <typename Func>
+  void forEach(Func func) const {
+    for (vector_size_t i = 0; i < rows.size(); ++i) {
+      func(i, rows[i]);
+    }
+  }
+};
+
+template <TypeKind Kind, typename Rows>
+void copyColumn(const Rows& rows, int32_t offset, BaseVector& vector) {
+  using T = typename TypeTraits<Kind>::NativeType;
+  auto* values = vector.asUnchecked<FlatVector<T>>()->mutableRawValues();
+  if constexpr (Kind == TypeKind::BOOLEAN) {
+    auto* bits = reinterpret_cast<uint64_t*>(values);
+    rows.forEach([&](vector_size_t i, const char* row) {
+      bits::setBit(bits, i, row[offset] != 0);
+    });
+  } else if constexpr (Kind == TypeKind::TIMESTAMP) {
+    rows.forEach([&](vector_size_t i, const char* row) {
+      int64_t micros;
+      std::memcpy(&micros, row + offset, sizeof(int64_t));
+      values[i] = Timestamp::fromMicros(micros);
+    });
+  } else {
+    rows.forEach([&](vector_size_t i, const char* row) {
+      std::memcpy(values + i, row + offset, sizeof(T));
+    });
+  }
+}
+
+// Sets the rows whose null bit for 'channel' is set to null in 'vector'. Null
+// fixed-width values keep their slot in the row, so the values copied for
+// them are ignored.
+template <typename Rows>
+void copyNulls(const Rows& rows, column_index_t channel, BaseVector& vector) {
+  const int32_t nullByte = channel / 8;
+  const uint8_t nullMask = 1 << (channel % 8);
+  rows.forEach([&](vector_size_t i, const char* row) {
+    if (FOLLY_UNLIKELY((row[nullByte] & nullMask) != 0)) {
+      vector.setNull(i, true);
+    }
+  });
+}
+
+template <typename Rows>
+VectorPtr deserializeColumn(
+    const Rows& rows,
+    const FixedWidthColumn& column,
+    vector_size_t numRows,
+    memory::MemoryPool* pool) {
+  auto vector = BaseVector::create(column.type, numRows, pool);
+  switch (column.type->kind()) {
+    case TypeKind::BOOLEAN:
+      copyColumn<TypeKind::BOOLEAN>(rows, column.offset, *vector);
+      break;
+    case TypeKind::TINYINT:
+      copyColumn<TypeKind::TINYINT>(rows, column.offset, *vector);
+      break;
+    case TypeKind::SMALLINT:
+      copyColumn<TypeKind::SMALLINT>(rows, column.offset, *vector);
+      break;
+    case TypeKind::INTEGER:
+      copyColumn<TypeKind::INTEGER>(rows, column.offset, *vector);
+      break;
+    case TypeKind::BIGINT:
+      copyColumn<TypeKind::BIGINT>(rows, column.offset, *vector);
+      break;
+    case TypeKind::HUGEINT:
+      copyColumn<TypeKind::HUGEINT>(rows, column.offset, *vector);
+      break;
+    case TypeKind::REAL:
+      copyColumn<TypeKind::REAL>(rows, column.offset, *vector);
+      break;
+    case TypeKind::DOUBLE:
+      copyColumn<TypeKind::DOUBLE>(rows, column.offset, *vector);
+      break;
+    case TypeKind::TIMESTAMP:
+      copyColumn<TypeKind::TIMESTAMP>(rows, column.offset, *vector);
+      break;
+    default:
+      VELOX_UNREACHABLE("Not a fixed-width type: {}", column.type->toString());
+  }
+  copyNulls(rows, column.channel, *vector);
+  return vector;
+}
+
+// Row runs of one output batch shared by the lazy columns of the batch.
+struct LazyBatch {
+  // Owns the memory 'runs' point into.
+  std::shared_ptr<const void> pages;
+  std::vector<RowRun> runs;
+  int32_t stride;
+  vector_size_t numRows;
+};
+
+class FixedWidthColumnLoader : public VectorLoader {
+ public:
+  FixedWidthColumnLoader(
+      std::shared_ptr<const LazyBatch> batch,
+      FixedWidthColumn column,
+      memory::MemoryPool* pool)
+      : batch_(std::move(batch)), column_(std::move(column)), pool_(pool) {}
+
+ protected:
+  void loadInternal(
+      RowSet /*rows*/,
+      ValueHook* hook,
+      vector_size_t resultSize,
+      VectorPtr* result) override {
+    VELOX_CHECK_NULL(hook);
+    VELOX_CHECK_EQ(resultSize, batch_->numRows);
+    // Copying all rows of the column is as cheap as copying a subset.
+    *result = deserializeColumn(
+        StridedRows{batch_->runs, batch_->stride},
+        column_,
+        batch_->numRows,
+        pool_);
+  }
+
+ private:
+  const std::shared_ptr<const LazyBatch> batch_;
+  const FixedWidthColumn column_;
+  memory::MemoryPool* const pool_;
+};
+} // namespace
+
+CompactRowBatchDeserializer::CompactRowBatchDeserializer(RowTypePtr rowType)
+    : rowType_(std::move(rowType)) {
+  // Values are stored in column order after the null bits, so the leading
+  // fixed-width columns are at the same offset in every row.
+  int32_t rowSize = bits::nbytes(rowType_->size());
+  std::vector<TypePtr> fixedWidthTypes;
+  for (column_index_t i = 0; i < rowType_->size(); ++i) {
+    const auto& type = rowType_->childAt(i);
+    const auto width = fixedValueWidth(type);
+    if (!width.has_value()) {
+      break;
+    }
+    columns_.push_back({rowSize, i, type});
+    fixedWidthTypes.push_back(type);
+    rowSize += width.value();
+  }
+  // Only use the layout computed here if it matches the serialized one.
+  const auto fixedWidthSize =
+      row::CompactRow::fixedRowSize(ROW(std::move(fixedWidthTypes)));
+  if (fixedWidthSize.value_or(-1) - bits::nbytes(columns_.size()) !=
+      rowSize - bits::nbytes(rowType_->size())) {
+    columns_.clear();
+    return;
+  }
+  if (columns_.size() == rowType_->size()) {
+    rowSize_ = rowSize;
+  }
+}
+
+void CompactRowBatchDeserializer::addPage(std::string_view pageData) {
+  const size_t kPageHeaderSize = serializer::detail::RowGroupHeader::size();
+
+  const char* ptr = pageData.data();
+  size_t remaining = pageData.size();
+
+  // Iterate over one or more RowGroupHeaders in the buffer.
+  while (remaining > 0) {
+    VELOX_CHECK_GE(remaining, kPageHeaderSize, "Truncated RowGroupHeader");
+    int32_t uncompressedSize;
+    std::memcpy(&uncompressedSize, ptr, sizeof(int32_t));
+    ptr += kPageHeaderSize;
+    remaining -= kPageHeaderSize;
+
+    VELOX_CHECK_GE(
+        remaining,
+        static_cast<size_t>(uncompressedSize),
+        "Page data truncated: expected {} bytes, got {}",
+        uncompressedSize,
+        remaining);
+
+    if (rowSize_.has_value()) {
+      // All rows have the same size, so the row group is a single run.
+      VELOX_CHECK(rows_.empty(), "Cannot mix rows and framed pages");
+      VELOX_CHECK_EQ(
+          uncompressedSize % stride(),
+          0,
+          "Row group size {} is not a multiple of the row size {}",
+          uncompressedSize,
+          stride());
+      const vector_size_t numRows = uncompressedSize / stride();
+      if (numRows > 0) {
+        // The rows are not parsed one by one. Checks the framing of the first
+        // and the last row.
+        VELOX_CHECK_EQ(readRowSize(ptr), rowSize_.value(), "Bad row size");
+        VELOX_CHECK_EQ(
+            readRowSize(ptr + uncompressedSize - stride()),
+            rowSize_.value(),
+            "Bad row size");
+        runOffsets_.push_back(numRows_);
+        runs_.push_back({ptr + sizeof(uint32_t), numRows});
+        numRows_ += numRows;
+      }
+      ptr += uncompressedSize;
+      remaining -= uncompressedSize;
+      continue;
+    }
+
+    // Parse TRowSize-framed rows within this RowGroup.
+    size_t pageRemaining = uncompressedSize;
+    while (pageRemaining > 0) {
+      VELOX_CHECK_GE(pageRemaining, sizeof(uint32_t), "Truncated TRowSize");
+      const uint32_t rowSize = readRowSize(ptr);
+      ptr += sizeof(uint32_t);
+      pageRemaining -= sizeof(uint32_t);
+
+      VELOX_CHECK_GE(pageRemaining, rowSize, "Truncated row data");
+      rows_.emplace_back(ptr, rowSize);
+      ptr += rowSize;
+      pageRemaining -= rowSize;
+    }
+    numRows_ = rows_.size();
+
+    remaining -= uncompressedSize;
+  }
+}
+
+void CompactRowBatchDeserializer::addRow(std::string_view row) {
+  VELOX_CHECK(runs_.empty(), "Cannot mix rows and framed pages");
+  rows_.push_back(row);
+  ++numRows_;
+}
+
+std::vector<RowRun> CompactRowBatchDeserializer::runsForRange(
+    vector_size_t offset,
+    vector_size_t numRows) const {
+  std::vector<RowRun> runs;
+  // Index of the run containing row 'offset'.
+  size_t runIndex =
+      std::upper_bound(runOffsets_.begin(), runOffsets_.end(), offset) -
+      runOffsets_.begin() - 1;
+  while (numRows > 0) {
+    VELOX_CHECK_LT(runIndex, runs_.size());
+    const auto& run = runs_[runIndex];
+    const vector_size_t skip = offset - runOffsets_[runIndex];
+    const vector_size_t count = std::min(numRows, run.numRows - skip);
+    runs.push_back({run.rows + static_cast<int64_t>(skip) * stride(), count});
+    offset += count;
+    numRows -= count;
+    ++runIndex;
+  }
+  return runs;
+}
+
+std::vector<const char*> CompactRowBatchDeserializer::rowPointers(
+    vector_size_t offset,
+    vector_size_t numRows,
+    const std::vector<vector_size_t>* rows) const {
+  std::vector<const char*> pointers;
+  if (runs_.empty()) {
+    const auto* views = rows_.data() + offset;
+    if (rows == nullptr) {
+      pointers.reserve(numRows);
+      for (vector_size_t i = 0; i < numRows; ++i) {
+        pointers.push_back(views[i].data());
+      }
+    } else {
+      pointers.reserve(rows->size());
+      for (auto row : *rows) {
+        pointers.push_back(views[row].data());
+      }
+    }
+    return pointers;
+  }
+
+  pointers.reserve(numRows);
+  const auto runs = runsForRange(offset, numRows);
+  StridedRows{runs, stride()}.forEach(
+      [&](vector_size_t /*i*/, const char* row) { pointers.push_back(row); });
+  if (rows != nullptr) {
+    for (vector_size_t i = 0; i < rows->size(); ++i) {
+      pointers[i] = pointers[(*rows)[i]];
+    }
+    pointers.resize(rows->size());
+  }
+  return pointers;
+}
+
+RowVectorPtr CompactRowBatchDeserializer::deserialize(
+    vector_size_t offset,
+    vector_size_t numRows,
+    memory::MemoryPool* pool,
+    std::shared_ptr<const void> pages) const {
+  VELOX_CHECK_LE(offset + numRows, numRows_);
+  if (!rowSize_.has_value()) {
+    if (offset == 0 && numRows == rows_.size()) {
+      return row::CompactRow::deserialize(rows_, rowType_, pool);
+    }
+    std::vector<std::string_view> rows(
+        rows_.begin() + offset, rows_.begin() + offset + numRows);
+    return row::CompactRow::deserialize(rows, rowType_, pool);
+  }
+
+  std::vector<VectorPtr> children;
+  children.reserve(columns_.size());
+  if (runs_.empty()) {
+    const auto pointers = rowPointers(offset, numRows, nullptr);
+    for (const auto& column : columns_) {
+      children.push_back(
+          deserializeColumn(RowPointers{pointers}, column, numRows, pool));
+    }
+  } else if (pages == nullptr) {
+    const auto runs = runsForRange(offset, numRows);
+    for (const auto& column : columns_) {
+      children.push_back(deserializeColumn(
+          StridedRows{runs, stride()}, column, numRows, pool));
+    }
+  } else {
+    auto batch = std::make_shared<const LazyBatch>(LazyBatch{
+        std::move(pages), runsForRange(offset, numRows), stride(), numRows});
+    for (const auto& column : columns_) {
+      children.push_back(std::make_shared<LazyVector>(
+          pool,
+          column.type,
+          numRows,
+          std::make_unique<FixedWidthColumnLoader>(batch, column, pool)));
+    }
+  }
+  return std::make_shared<RowVector>(
+      pool, rowType_, nullptr, numRows, std::move(children));
+}
+
+std::vector<VectorPtr> CompactRowBatchDeserializer::deserializeColumns(
+    vector_size_t offset,
+    vector_size_t numRows,
+    const std::vector<column_index_t>& channels,
+    const std::vector<vector_size_t>* rows,
+    memory::MemoryPool* pool) const {
+  VELOX_CHECK_LE(offset + numRows, numRows_);
+  const vector_size_t numOutputRows =
+      rows == nullptr ? numRows : rows->size();
+  std::vector<VectorPtr> columns(channels.size());
+
+  // Copies the columns at a fixed offset directly out of the rows. Runs of
+  // rows are only used if all rows in the range are deserialized.
+  const bool useRuns = rows == nullptr && !runs_.empty();
+  std::vector<RowRun> runs;
+  std::vector<const char*> pointers;
+  std::vector<column_index_t> otherColumns;
+  for (column_index_t i = 0; i < channels.size(); ++i) {
+    if (!hasFixedOffset(channels[i])) {
+      otherColumns.push_back(i);
+      continue;
+    }
+    const auto& column = columns_[channels[i]];
+    if (useRuns) {
+      if (runs.empty()) {
+        runs = runsForRange(offset, numRows);
+      }
+      columns[i] = deserializeColumn(
+          StridedRows{runs, stride()}, column, numOutputRows, pool);
+    } else {
+      if (pointers.empty()) {
+        pointers = rowPointers(offset, numRows, rows);
+      }
+      columns[i] = deserializeColumn(
+          RowPointers{pointers}, column, numOutputRows, pool);
+    }
+  }
+  if (otherColumns.empty()) {
+    return columns;
+  }
+
+  // The offsets of the other columns depend on the preceding values in each
+  // row, so the rows are deserialized in full.
+  std::vector<std::string_view> views;
+  views.reserve(numOutputRows);
+  if (rows == nullptr) {
+    views.assign(rows_.begin() + offset, rows_.begin() + offset + numRows);
+  } else {
+    for (auto row : *rows) {
+      views.push_back(rows_[offset + row]);
+    }
+  }
+  auto rowVector = row::CompactRow::deserialize(views, rowType_, pool);
+  for (auto i : otherColumns) {
+    columns[i] = rowVector->childAt(channels[i]);
+  }
+  return columns;
+}
+
+void CompactRowBatchDeserializer::clear() {
+  numRows_ = 0;
+  runs_.clear();
+  runOffsets_.clear();
+  rows_.clear();
+}
+
+} // namespace facebook::presto::operators
@@ -0,0 +1,140 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "velox/vector/ComplexVector.h"
+
+namespace facebook::presto::operators {
+
+/// Deserializes CompactRow rows into RowVectors. Rows are added either in the
+/// RowGroupHeader + TRowSize framing written by MaterializedOutput or one by
+/// one.
+///
+/// Values are stored in column order after the null bits, so the leading
+/// fixed-width columns of the row type are at the same offset in every row.
+/// These columns are copied out of the rows in a single pass at an offset
+/// computed once from the row type. When all columns are fixed width, every
+/// row has the same size and a framed row group is a dense run of rows with a
+/// fixed stride. Such pages are parsed into one entry per row group instead
+/// of one string_view per row, and columns can also be returned as lazy
+/// vectors that are only copied when loaded. Other columns are deserialized
+/// by row::CompactRow::deserialize().
+class CompactRowBatchDeserializer {
+ public:
+  explicit CompactRowBatchDeserializer(velox::RowTypePtr rowType);
+
+  /// Size of a row if the row type is deserialized by the fixed-width path,
+  /// std::nullopt otherwise.
+  std::optional<int32_t> fixedRowSize() const {
+    return rowSize_;
+  }
+
+  /// True if column 'channel' is at the same offset in every row and is
+  /// copied directly out of the rows.
+  bool hasFixedOffset(velox::column_index_t channel) const {
+    return channel < columns_.size();
+  }
+
+  /// Appends the rows of the one or more row groups in 'pageData'. The data
+  /// must stay alive until the rows are deserialized and clear() is called.
+  void addPage(std::string_view pageData);
+
+  /// Appends one serialized row. Cannot be mixed with addPage(). The data
+  /// must stay alive until the rows are deserialized and clear() is called.
+  void addRow(std::string_view row);
+
+  /// Number of rows added since the last clear().
+  velox::vector_size_t numRows() const {
+    return numRows_;
+  }
+
+  /// Deserializes 'numRows' rows starting at row 'offset'. If 'pages' is set,
+  /// the row type is fixed width and the rows were added by addPage(), returns
+  /// lazy columns that share ownership of 'pages' and copy their values out of
+  /// the rows when loaded. 'pages' must own the data passed to addPage().
+  velox::RowVectorPtr deserialize(
+      velox::vector_size_t offset,
+      velox::vector_size_t numRows,
+      velox::memory::MemoryPool* pool,
+      std::shared_ptr<const void> pages = nullptr) const;
+
+  /// Deserializes the columns 'channels' of the rows in [offset, offset +
+  /// numRows), or only of the rows at the indices 'rows' relative to
+  /// 'offset' if 'rows' is not null. Columns at a fixed offset are copied
+  /// directly out of the selected rows. If any other column is needed, the
+  /// selected rows are deserialized in full.
+  std::vector<velox::VectorPtr> deserializeColumns(
+      velox::vector_size_t offset,
+      velox::vector_size_t numRows,
+      const std::vector<velox::column_index_t>& channels,
+      const std::vector<velox::vector_size_t>* rows,
+      velox::memory::MemoryPool* pool) const;
+
+  /// Drops all rows.
+  void clear();
+
+  /// Dense run of fixed-width rows. 'rows' points at the first row, after
+  /// its TRowSize prefix. Consecutive rows are TRowSize + row size apart.
+  struct RowRun {
+    const char* rows;
+    velox::vector_size_t numRows;
+  };
+
+  /// Location of a column at a fixed offset in every row.
+  struct FixedWidthColumn {
+    /// Byte offset of the value from the start of the row.
+    int32_t offset;
+    /// Index of the null bit in the null bitmap at the start of the row.
+    velox::column_index_t channel;
+    velox::TypePtr type;
+  };
+
+ private:
+  // Distance between consecutive rows of a run.
+  int32_t stride() const {
+    return sizeof(uint32_t) + rowSize_.value();
+  }
+
+  // Returns the row runs covering rows [offset, offset + numRows).
+  std::vector<RowRun> runsForRange(
+      velox::vector_size_t offset,
+      velox::vector_size_t numRows) const;
+
+  // Returns the start of the rows in [offset, offset + numRows), or of the
+  // rows at 'rows' relative to 'offset' if 'rows' is not null.
+  std::vector<const char*> rowPointers(
+      velox::vector_size_t offset,
+      velox::vector_size_t numRows,
+      const std::vector<velox::vector_size_t>* rows) const;
+
+  const velox::RowTypePtr rowType_;
+  // Size of a row for a fixed-width row type, not including TRowSize.
+  std::optional<int32_t> rowSize_;
+  // Layout of the leading fixed-width columns.
+  std::vector<FixedWidthColumn> columns_;
+
+  velox::vector_size_t numRows_{0};
+  // Pages of fixed-width row types: one run per row group and the index of
+  // its first row.
+  std::vector<RowRun> runs_;
+  std::vector<velox::vector_size_t> runOffsets_;
+  // Other row types and rows added by addRow(): one view per row.
+  std::vector<std::string_view> rows_;
+};
+
+} // namespace facebook::presto::operators
@@ -15,8 +15,18 @@
 #include "presto_cpp/external/json/nlohmann/json.hpp"
 #include "presto_cpp/main/common/Configs.h"
 
+#include <folly/Conv.h>
+#include <folly/Random.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/lang/Bits.h>
+#include <chrono>
+#include <limits>
+
 #include "velox/common/Casts.h"
+#include "velox/common/base/BitUtil.h"
 #include "velox/common/file/FileInputStream.h"
+#include "velox/exec/Driver.h"
 
 #include <boost/range/algorithm/sort.hpp>
 
@@ -31,13 +41,51 @@ using TStreamIdx = uint16_t;
 // Default buffer size for SortedFileInputStream
 // This buffer is used for streaming reads from shuffle files during k-way
 // merge.
-constexpr uint64_t kDefaultInputStreamBufferSize = 8 * 1024 * 1024; // 8MB
+constexpr uint64_t kDefaultInputStreamBufferSize =
+    LocalShuffleReader::kMaxMergeBufferSize;
+
+/// Stream of sorted (key, data) pairs of one block for the k-way merge.
+class SortedRowStream : public velox::MergeStream {
+ public:
+  explicit SortedRowStream(TStreamIdx streamIdx) : streamIdx_(streamIdx) {}
+
+  /// Advances to the next row. Returns false at the end of the block.
+  virtual bool next() = 0;
+
+  virtual std::string_view currentKey() const = 0;
+
+  /// Valid until the next call to next().
+  virtual std::string_view currentValue() const = 0;
+
+  bool operator<(const velox::MergeStream& other) const override {
+    const auto* otherStream = static_cast<const SortedRowStream*>(&other);
+    if (currentKeyPrefix_ != otherStream->currentKeyPrefix_) {
+      return currentKeyPrefix_ < otherStream->currentKeyPrefix_;
+    }
+    const auto key = currentKey();
+    const auto otherKey = otherStream->currentKey();
+    if (key != otherKey) {
+      return compareKeys(key, otherKey);
+    }
+    return streamIdx_ < otherStream->streamIdx_;
+  }
+
+ protected:
+  // Called by next() after loading a row.
+  void updateKeyPrefix() {
+    currentKeyPrefix_ = normalizedKeyPrefix(currentKey());
+  }
+
+ private:
+  const TStreamIdx streamIdx_;
+  uint64_t currentKeyPrefix_{0};
+};
 
 /// SortedFileInputStream reads sorted (key, data) pairs from a single
 /// shuffle file with buffered I/O. It extends FileInputStream for efficient
 /// buffered I/O and implements MergeStream interface for k-way merge.
 class SortedFileInputStream final : public velox::common::FileInputStream,
-                                    public velox::MergeStream {
+                                    public SortedRowStream {
  public:
   SortedFileInputStream(
       const std::string& filePath,
@@ -49,13 +97,13 @@ class SortedFileInputStream final : public velox::common::FileInputStream,
                 ->openFileForRead(filePath),
             bufferSize,
             pool),
-        streamIdx_(streamIdx) {
+        SortedRowStream(streamIdx) {
     next();
   }
 
   ~SortedFileInputStream() override = default;
 
-  bool next() {
+  bool next() override {
     if (atEnd()) {
       currentKey_.clear();
       currentValue_.clear();
@@ -67,14 +115,15 @@ class SortedFileInputStream final : public velox::common::FileInputStream,
     // TODO: Optimize with zero-copy approach when data is contiguous in buffer.
     readString(currentKey_, keySize);
     readString(currentValue_, valueSize);
+    updateKeyPrefix();
     return true;
   }
 
-  std::string_view currentKey() const {
+  std::string_view currentKey() const override {
     return currentKey_;
   }
 
-  std::string_view currentValue() const {
+  std::string_view currentValue() const override {
     return currentValue_;
   }
 
@@ -82,14 +131,6 @@ class SortedFileInputStream final : public velox::common::FileInputStream,
     return !currentValue_.empty() || !atEnd();
   }
 
-  bool operator<(const velox::MergeStream& other) const override {
-    const auto* otherReader = static_cast<const SortedFileInputStream*>(&other);
-    if (currentKey_ != otherReader->currentKey_) {
-      return compareKeys(currentKey_, otherReader->currentKey_);
-    }
-    return streamIdx_ < otherReader->streamIdx_;
-  }
-
  private:
   void readString(std::string& target, TRowSize size) {
     if (size > 0) {
@@ -100,11 +141,115 @@ class SortedFileInputStream final : public velox::common::FileInputStream,
     }
   }
 
-  const TStreamIdx streamIdx_;
   std::string currentKey_;
   std::string currentValue_;
 };
 
+/// Reads the sorted (key, data) pairs of a segment of a consolidated data
+/// file. The segments of a file share one open file. Rows are returned as
+/// views into the read buffer.
+class SortedSegmentInputStream final : public SortedRowStream {
+ public:
+  SortedSegmentInputStream(
+      std::shared_ptr<velox::ReadFile> file,
+      uint64_t offset,
+      uint64_t length,
+      TStreamIdx streamIdx,
+      velox::memory::MemoryPool* pool,
+      size_t bufferSize = kDefaultInputStreamBufferSize)
+      : SortedRowStream(streamIdx),
+        file_(std::move(file)),
+        fileOffset_(offset),
+        fileEnd_(offset + length),
+        buffer_(velox::AlignedBuffer::allocate<char>(
+            std::min<uint64_t>(bufferSize, length),
+            pool,
+            0)) {
+    next();
+  }
+
+  bool next() override {
+    bufferPos_ += rowSize_;
+    rowSize_ = 0;
+    if (bufferPos_ == bufferEnd_ && fileOffset_ == fileEnd_) {
+      hasRow_ = false;
+      return false;
+    }
+    ensureBuffered(kUint32Size * 2);
+    const char* row = buffer_->as<char>() + bufferPos_;
+    const TRowSize keySize =
+        folly::Endian::big(folly::loadUnaligned<TRowSize>(row));
+    const TRowSize valueSize =
+        folly::Endian::big(folly::loadUnaligned<TRowSize>(row + kUint32Size));
+    ensureBuffered(kUint32Size * 2 + keySize + valueSize);
+    row = buffer_->as<char>() + bufferPos_;
+    currentKey_ = {row + kUint32Size * 2, keySize};
+    currentValue_ = {row + kUint32Size * 2 + keySize, valueSize};
+    rowSize_ = kUint32Size * 2 + keySize + valueSize;
+    hasRow_ = true;
+    updateKeyPrefix();
+    return true;
+  }
+
+  std::string_view currentKey() const override {
+    return currentKey_;
+  }
+
+  std::string_view currentValue() const override {
+    return currentValue_;
+  }
+
+  bool hasData() const override {
+    return hasRow_;
+  }
+
+ private:
+  // Makes sure that 'size' bytes from 'bufferPos_' are in 'buffer_'.
+  void ensureBuffered(uint64_t size) {
+    if (bufferEnd_ - bufferPos_ >= size) {
+      return;
+    }
+    char* data = buffer_->asMutable<char>();
+    const auto numBuffered = bufferEnd_ - bufferPos_;
+    if (numBuffered > 0 && bufferPos_ > 0) {
+      memmove(data, data + bufferPos_, numBuffered);
+    }
+    bufferPos_ = 0;
+    bufferEnd_ = numBuffered;
+    if (buffer_->capacity() < size) {
+      velox::AlignedBuffer::reallocate<char>(&buffer_, size);
+      data = buffer_->asMutable<char>();
+    }
+    const auto readSize =
+        std::min(buffer_->capacity() - bufferEnd_, fileEnd_ - fileOffset_);
+    VELOX_CHECK_GE(
+        numBuffered + readSize,
+        size,
+        "Corrupted shuffle data: row of {} bytes exceeds the segment ending at "
+        "{} in {}",
+        size,
+        fileEnd_,
+        file_->getName());
+    file_->pread(fileOffset_, readSize, data + bufferEnd_);
+    fileOffset_ += readSize;
+    bufferEnd_ += readSize;
+  }
+
+  const std::shared_ptr<velox::ReadFile> file_;
+  // Offset of the next byte to read from 'file_'.
+  uint64_t fileOffset_;
+  const uint64_t fileEnd_;
+  velox::BufferPtr buffer_;
+  // Range of read but not consumed bytes in 'buffer_'.
+  uint64_t bufferPos_{0};
+  uint64_t bufferEnd_{0};
+  // Size of the current row, which starts at 'bufferPos_'.
+  uint64_t rowSize_{0};
+  std::string_view currentKey_;
+  std::string_view currentValue_;
+  bool hasRow_{false};
+};
+
 class LocalShuffleSerializedPage : public ShuffleSerializedPage {
  public:
   LocalShuffleSerializedPage(
@@ -159,7 +304,10 @@ extractRowMetadata(const char* buffer, size_t bufferSize, bool sortedShuffle) {
 
       rows.push_back(
           RowMetadata{
-              .rowStart = rowStart, .keySize = keySize, .dataSize = dataSize});
+              .rowStart = rowStart,
+              .keySize = keySize,
+              .dataSize = dataSize,
+              .keyPrefix = normalizedKeyPrefix({buffer + offset, keySize})});
 
       offset += keySize + dataSize;
     }
@@ -192,6 +340,26 @@ extractRowMetadata(const char* buffer, size_t bufferSize, bool sortedShuffle) {
   return rows;
 }
 
+// Writes a row of a sorted shuffle block: keySize | dataSize | key | data.
+void writeSortedRow(
+    char* writePos,
+    std::string_view key,
+    std::string_view data) {
+  folly::storeUnaligned(
+      writePos, folly::Endian::big(static_cast<TRowSize>(key.size())));
+  writePos += kUint32Size;
+  folly::storeUnaligned(
+      writePos, folly::Endian::big(static_cast<TRowSize>(data.size())));
+  writePos += kUint32Size;
+  if (!key.empty()) {
+    memcpy(writePos, key.data(), key.size());
+    writePos += key.size();
+  }
+  if (!data.empty()) {
+    memcpy(writePos, data.data(), data.size());
+  }
+}
+
 inline std::string_view
 extractRowData(const RowMetadata& row, const char* buffer, bool sortedShuffle) {
   const auto dataOffset = row.rowStart +
@@ -210,7 +378,9 @@ std::vector<RowMetadata> extractAndSortRowMetadata(
           const char* lhsKey = buffer + lhs.rowStart + (kUint32Size * 2);
           const char* rhsKey = buffer + rhs.rowStart + (kUint32Size * 2);
           return compareKeys(
+              lhs.keyPrefix,
               std::string_view(lhsKey, lhs.keySize),
+              rhs.keyPrefix,
               std::string_view(rhsKey, rhs.keySize));
         });
   }
@@ -234,6 +404,83 @@ inline std::string createShuffleFileName(
       fileIndex,
       id);
 }
+
+constexpr std::string_view kDataFileExtension{".data"};
+constexpr std::string_view kIndexFileExtension{".index"};
+constexpr std::string_view kTempFileExtension{".tmp"};
+
+// Prefix of the consolidated data and index files of all writers of a shuffle.
+// 'shuffle' has the form shuffle_<SHUFFLE_ID>_0 as in the partition ids.
+inline std::string consolidatedFilePrefix(
+    const std::string& rootPath,
+    const std::string& queryId,
+    std::string_view shuffle) {
+  return fmt::format("{}/{}_{}.", rootPath, queryId, shuffle);
+}
+
+// Splits a partition id of the form shuffle_<SHUFFLE_ID>_0_<PARTITION> into
+// the shuffle and the partition number.
+std::optional<std::pair<std::string_view, uint32_t>> parsePartitionId(
+    std::string_view partitionId) {
+  const auto pos = partitionId.rfind('_');
+  if (pos == std::string_view::npos) {
+    return std::nullopt;
+  }
+  const auto partition =
+      folly::tryTo<uint32_t>(folly::StringPiece(partitionId.substr(pos + 1)));
+  if (!partition.hasValue()) {
+    return std::nullopt;
+  }
+  return std::make_pair(partitionId.substr(0, pos), partition.value());
+}
+
+std::string serializeIndex(const std::vector<ShuffleIndexEntry>& index) {
+  std::string serialized(index.size() * ShuffleIndexEntry::kSerializedSize, 0);
+  char* pos = serialized.data();
+  for (const auto& entry : index) {
+    folly::storeUnaligned(pos, folly::Endian::big(entry.partition));
+    pos += sizeof(uint32_t);
+    folly::storeUnaligned(pos, folly::Endian::big(entry.offset));
+    pos += sizeof(uint64_t);
+    folly::storeUnaligned(pos, folly::Endian::big(entry.length));
+    pos += sizeof(uint64_t);
+  }
+  return serialized;
+}
+
+std::vector<ShuffleIndexEntry> readIndex(velox::ReadFile& file) {
+  const auto size = file.size();
+  VELOX_CHECK_EQ(
+      size % ShuffleIndexEntry::kSerializedSize,
+      0,
+      "Corrupted shuffle index: {}",
+      file.getName());
+  std::string serialized(size, 0);
+  file.pread(0, size, serialized.data());
+  std::vector<ShuffleIndexEntry> index(
+      size / ShuffleIndexEntry::kSerializedSize);
+  const char* pos = serialized.data();
+  for (auto& entry : index) {
+    entry.partition = folly::Endian::big(folly::loadUnaligned<uint32_t>(pos));
+    pos += sizeof(uint32_t);
+    entry.offset = folly::Endian::big(folly::loadUnaligned<uint64_t>(pos));
+    pos += sizeof(uint64_t);
+    entry.length = folly::Endian::big(folly::loadUnaligned<uint64_t>(pos));
+    pos += sizeof(uint64_t);
+  }
+  return index;
+}
+
+// Returns a section that suspends the driver running on this thread, if any,
+// so that its task can be paused and its memory arbitrated while it waits.
+std::unique_ptr<velox::exec::SuspendedSection> suspendDriver() {
+  const auto* driverThreadContext = velox::exec::driverThreadContext();
+  if (driverThreadContext == nullptr) {
+    return nullptr;
+  }
+  return std::make_unique<velox::exec::SuspendedSection>(
+      driverThreadContext->driverCtx()->driver);
+}
 } // namespace
 
 std::string LocalShuffleWriteInfo::serialize() const {
@@ -285,7 +532,10 @@ LocalShuffleWriter::LocalShuffleWriter(
     uint32_t numPartitions,
     uint64_t maxBytesPerPartition,
     bool sortedShuffle,
-    velox::memory::MemoryPool* pool)
+    velox::memory::MemoryPool* pool,
+    bool consolidateFiles,
+    folly::Executor* flushExecutor,
+    uint64_t maxPendingFlushBytes)
     : threadId_(std::this_thread::get_id()),
       pool_(pool),
       numPartitions_(numPartitions),
@@ -293,43 +543,219 @@ LocalShuffleWriter::LocalShuffleWriter(
       sortedShuffle_(sortedShuffle),
       rootPath_(rootPath),
       queryId_(queryId),
-      shuffleId_(shuffleId) {
+      shuffleId_(shuffleId),
+      consolidateFiles_(consolidateFiles),
+      flushExecutor_(
+          flushExecutor == nullptr
+              ? folly::Executor::KeepAlive<folly::SerialExecutor>{}
+              : folly::SerialExecutor::create(
+                    folly::getKeepAliveToken(flushExecutor))),
+      maxPendingFlushBytes_(std::min<uint64_t>(
+          maxPendingFlushBytes,
+          std::max<int64_t>(pool->maxCapacity(), 0))) {
   inProgressPartitions_.assign(numPartitions_, nullptr);
   inProgressSizes_.assign(numPartitions_, 0);
   fileSystem_ = velox::filesystems::getFileSystem(rootPath_, nullptr);
+  if (consolidateFiles_) {
+    // Writers of other processes may use the same root path and thread ids.
+    consolidatedFilePrefix_ = fmt::format(
+        "{}{}_{:016x}",
+        consolidatedFilePrefix(
+            rootPath_, queryId_, fmt::format("shuffle_{}_0", shuffleId_)),
+        threadId_,
+        folly::Random::secureRand64());
+  }
 }
 
-void LocalShuffleWriter::writeBlock(int32_t partition) {
-  auto& buffer = inProgressPartitions_[partition];
-  const auto bufferSize = inProgressSizes_[partition];
+LocalShuffleWriter::~LocalShuffleWriter() {
+  // Pending flushes use this writer. The task may be terminating, so the
+  // driver is not suspended.
+  waitForFlushes(/*suspend=*/false);
+}
+
+void LocalShuffleWriter::flushBlock(int32_t partition) {
+  VELOX_DCHECK_NOT_NULL(
+      inProgressPartitions_[partition],
+      "Buffer should be allocated before flushBlock");
+  const auto size = inProgressSizes_[partition];
+  inProgressSizes_[partition] = 0;
+  if (!flushExecutor_) {
+    writeBlock(partition, *inProgressPartitions_[partition], size);
+    return;
+  }
 
-  VELOX_DCHECK_NOT_NULL(buffer, "Buffer should be allocated before writeBlock");
-  VELOX_DCHECK_GT(bufferSize, 0, "Buffer size should be positive");
+  auto buffer = std::move(inProgressPartitions_[partition]);
+  const uint64_t bytes = buffer->capacity();
+  waitForFlushCapacity(bytes);
+  {
+    std::lock_guard<std::mutex> l(flushMutex_);
+    pendingFlushBytes_ += bytes;
+    ++numPendingFlushes_;
+  }
+  flushExecutor_->add(
+      [this, partition, buffer = std::move(buffer), size, bytes]() mutable {
+        std::exception_ptr error;
+        try {
+          bool failed;
+          {
+            std::lock_guard<std::mutex> l(flushMutex_);
+            failed = flushError_ != nullptr;
+          }
+          if (!failed) {
+            writeBlock(partition, *buffer, size);
+          }
+        } catch (...) {
+          error = std::current_exception();
+        }
+        // Frees the block before the next one may be allocated.
+        buffer.reset();
+        {
+          std::lock_guard<std::mutex> l(flushMutex_);
+          if (error != nullptr && flushError_ == nullptr) {
+            flushError_ = error;
+          }
+          pendingFlushBytes_ -= bytes;
+          --numPendingFlushes_;
+          // Notifies under the lock: the writer may be destroyed as soon as
+          // the lock is released.
+          flushCv_.notify_all();
+        }
+      });
+}
 
-  auto file = getNextOutputFile(partition);
-  const char* data = buffer->as<char>();
+void LocalShuffleWriter::waitForFlushCapacity(uint64_t bytes) {
+  // A single block larger than the limit is always let through.
+  waitUntil(/*suspend=*/true, [&]() {
+    return numPendingFlushes_ == 0 ||
+        pendingFlushBytes_ + bytes <= maxPendingFlushBytes_;
+  });
+}
+
+void LocalShuffleWriter::waitForFlushes(bool suspend) {
+  waitUntil(suspend, [&]() { return numPendingFlushes_ == 0; });
+}
 
+void LocalShuffleWriter::waitUntil(
+    bool suspend,
+    const std::function<bool()>& done) {
+  {
+    std::lock_guard<std::mutex> l(flushMutex_);
+    if (done()) {
+      return;
+    }
+  }
+  const auto start = std::chrono::steady_clock::now();
+  {
+    // Entering and leaving the suspended section may wait for the task, so
+    // 'flushMutex_' is not held meanwhile.
+    auto suspended = suspend ? suspendDriver() : nullptr;
+    std::unique_lock<std::mutex> l(flushMutex_);
+    flushCv_.wait(l, done);
+  }
+  std::lock_guard<std::mutex> l(flushMutex_);
+  flushWaitNanos_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+}
+
+void LocalShuffleWriter::checkFlushError() {
+  std::lock_guard<std::mutex> l(flushMutex_);
+  if (flushError_ != nullptr) {
+    std::rethrow_exception(flushError_);
+  }
+}
+
+void LocalShuffleWriter::writeBlock(
+    int32_t partition,
+    const velox::Buffer& buffer,
+    size_t size) {
+  VELOX_DCHECK_GT(size, 0, "Buffer size should be positive");
+
+  if (consolidateFiles_) {
+    if (dataFile_ == nullptr) {
+      dataFile_ = fileSystem_->openFileForWrite(
+          fmt::format("{}{}", consolidatedFilePrefix_, kDataFileExtension));
+      ++numFilesCreated_;
+    }
+    index_.push_back({static_cast<uint32_t>(partition), dataFileSize_, size});
+    appendBlock(buffer.as<char>(), size, *dataFile_);
+    dataFileSize_ += index_.back().length;
+  } else {
+    auto file = getNextOutputFile(partition);
+    appendBlock(buffer.as<char>(), size, *file);
+    file->close();
+  }
+  ++numBlocksWritten_;
+}
+
+void LocalShuffleWriter::appendBlock(
+    const char* data,
+    size_t size,
+    velox::WriteFile& file) {
   // For non-sorted shuffle, write buffer directly
   if (!sortedShuffle_) {
-    file->append(std::string_view(data, bufferSize));
-  } else {
-    // For sorted shuffle, parse and sort rows, then write
-    const auto sortedRows =
-        extractAndSortRowMetadata(data, bufferSize, sortedShuffle_);
-    for (const auto& row : sortedRows) {
-      const size_t rowLen = sortedShuffle_
-          ? (kUint32Size * 2) + row.keySize + row.dataSize
-          : kUint32Size + row.dataSize;
-      file->append(std::string_view(data + row.rowStart, rowLen));
+    file.append(std::string_view(data, size));
+    return;
+  }
+  // For sorted shuffle, parse and sort rows, then write them in order through
+  // a bounded staging buffer. Rows larger than the buffer are written as is.
+  const auto sortedRows = extractAndSortRowMetadata(data, size, sortedShuffle_);
+  const auto stagingSize = std::min<uint64_t>(size, kMaxSortedWriteBufferSize);
+  if (sortedWriteBuffer_ == nullptr ||
+      sortedWriteBuffer_->capacity() < stagingSize) {
+    sortedWriteBuffer_ =
+        velox::AlignedBuffer::allocate<char>(stagingSize, pool_, 0);
+  }
+  auto* staging = sortedWriteBuffer_->asMutable<char>();
+  const auto stagingCapacity = sortedWriteBuffer_->capacity();
+  size_t stagedBytes{0};
+  size_t writtenBytes{0};
+  const auto flushStaging = [&]() {
+    if (stagedBytes > 0) {
+      file.append(std::string_view(staging, stagedBytes));
+      writtenBytes += stagedBytes;
+      stagedBytes = 0;
     }
+  };
+  for (const auto& row : sortedRows) {
+    const size_t rowLen = (kUint32Size * 2) + row.keySize + row.dataSize;
+    if (stagedBytes + rowLen > stagingCapacity) {
+      flushStaging();
+      if (rowLen > stagingCapacity) {
+        file.append(std::string_view(data + row.rowStart, rowLen));
+        writtenBytes += rowLen;
+        continue;
+      }
+    }
+    memcpy(staging + stagedBytes, data + row.rowStart, rowLen);
+    stagedBytes += rowLen;
   }
-  file->close();
-  inProgressSizes_[partition] = 0;
+  flushStaging();
+  VELOX_CHECK_EQ(writtenBytes, size);
+}
+
+void LocalShuffleWriter::finishConsolidatedFile() {
+  if (dataFile_ == nullptr) {
+    return;
+  }
+  dataFile_->close();
+  dataFile_.reset();
+  // Readers list the index files, so the index is written under a temporary
+  // name and renamed once complete.
+  const auto indexPath =
+      fmt::format("{}{}", consolidatedFilePrefix_, kIndexFileExtension);
+  const auto tempIndexPath = fmt::format("{}{}", indexPath, kTempFileExtension);
+  auto indexFile = fileSystem_->openFileForWrite(tempIndexPath);
+  ++numFilesCreated_;
+  indexFile->append(serializeIndex(index_));
+  indexFile->close();
+  fileSystem_->rename(tempIndexPath, indexPath);
 }
 
 std::unique_ptr<velox::WriteFile> LocalShuffleWriter::getNextOutputFile(
     int32_t partition) {
   auto filename = nextAvailablePartitionFileName(rootPath_, partition);
+  ++numFilesCreated_;
   return fileSystem_->openFileForWrite(filename);
 }
 
@@ -397,16 +823,22 @@ void LocalShuffleWriter::collect(
   velox::common::testutil::TestValue::adjust(
       "facebook::presto::operators::LocalShuffleWriter::collect", this);
 
+  if (flushExecutor_) {
+    checkFlushError();
+  }
+
   const auto rowSize = this->rowSize(key.size(), data.size());
   auto& buffer = inProgressPartitions_[partition];
-  if (buffer == nullptr) {
+  if (buffer != nullptr && inProgressSizes_[partition] > 0 &&
+      inProgressSizes_[partition] + rowSize >= buffer->capacity()) {
+    flushBlock(partition);
+  }
+  if (buffer == nullptr || buffer->capacity() < rowSize) {
     buffer = velox::AlignedBuffer::allocate<char>(
         std::max(static_cast<uint64_t>(rowSize), maxBytesPerPartition_),
         pool_,
         0);
     inProgressSizes_[partition] = 0;
-  } else if (inProgressSizes_[partition] + rowSize >= buffer->capacity()) {
-    writeBlock(partition);
   }
   auto* rawBuffer = buffer->asMutable<char>();
   auto* writePos = rawBuffer + inProgressSizes_[partition];
@@ -415,15 +847,29 @@ void LocalShuffleWriter::collect(
 }
 
 void LocalShuffleWriter::noMoreData(bool success) {
-  // Delete all shuffle files on failure.
   if (!success) {
+    // Drops the blocks not written yet and deletes all shuffle files. Nothing
+    // may be written after the cleanup. The task is failing, so the driver is
+    // not suspended.
+    waitForFlushes(/*suspend=*/false);
+    dataFile_.reset();
+    index_.clear();
+    dataFileSize_ = 0;
+    inProgressPartitions_.assign(numPartitions_, nullptr);
+    inProgressSizes_.assign(numPartitions_, 0);
     cleanup();
+    return;
   }
   for (auto i = 0; i < numPartitions_; ++i) {
     if (inProgressSizes_[i] > 0) {
-      writeBlock(i);
+      flushBlock(i);
     }
   }
+  waitForFlushes(/*suspend=*/true);
+  checkFlushError();
+  if (consolidateFiles_) {
+    finishConsolidatedFile();
+  }
 }
 
 LocalShuffleReader::LocalShuffleReader(
@@ -431,47 +877,211 @@ LocalShuffleReader::LocalShuffleReader(
     const std::string& queryId,
     std::vector<std::string> partitionIds,
     bool sortedShuffle,
-    velox::memory::MemoryPool* pool)
+    velox::memory::MemoryPool* pool,
+    uint64_t mergeMemoryBytes)
     : rootPath_(rootPath),
       queryId_(queryId),
       partitionIds_(std::move(partitionIds)),
       sortedShuffle_(sortedShuffle),
-      pool_(pool) {
+      pool_(pool),
+      mergeMemoryBytes_(mergeMemoryBytes) {
   fileSystem_ = velox::filesystems::getFileSystem(rootPath_, nullptr);
+  // Does not match the prefix of any partition, so other readers skip the
+  // runs.
+  mergeRunPrefix_ = fmt::format(
+      "{}/{}_merge_{:016x}_",
+      rootPath_,
+      queryId_,
+      folly::Random::secureRand64());
+}
+
+LocalShuffleReader::~LocalShuffleReader() {
+  try {
+    removeMergeRuns();
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to remove shuffle merge runs: " << e.what();
+  }
 }
 
 void LocalShuffleReader::initialize() {
   VELOX_CHECK(!initialized_, "LocalShuffleReader already initialized");
-  readPartitionFiles_ = getReadPartitionFiles();
-  if (sortedShuffle_ && !readPartitionFiles_.empty()) {
+  readSegments_ = getReadSegments();
+  if (sortedShuffle_ && !readSegments_.empty()) {
     initSortedShuffleRead();
   }
 
   initialized_ = true;
 }
 
+std::shared_ptr<velox::ReadFile> LocalShuffleReader::openDataFile(
+    const std::string& path) {
+  auto& file = dataFiles_[path];
+  if (file == nullptr) {
+    file = fileSystem_->openFileForRead(path);
+    ++numFilesOpened_;
+  }
+  return file;
+}
+
 void LocalShuffleReader::initSortedShuffleRead() {
-  std::vector<std::unique_ptr<velox::MergeStream>> streams;
-  streams.reserve(readPartitionFiles_.size());
-  TStreamIdx streamIdx = 0;
-  for (const auto& filename : readPartitionFiles_) {
+  std::vector<ReadSegment> runs;
+  runs.reserve(readSegments_.size());
+  for (const auto& segment : readSegments_) {
     VELOX_CHECK(
-        !filename.empty(),
+        !segment.file.empty(),
         "Invalid empty shuffle file path for query {}, partitions: [{}]",
         queryId_,
         folly::join(", ", partitionIds_));
-    auto reader =
-        std::make_unique<SortedFileInputStream>(filename, streamIdx, pool_);
-    if (reader->hasData()) {
-      streams.push_back(std::move(reader));
-      ++streamIdx;
+    if (segment.length.value_or(1) > 0) {
+      runs.push_back(segment);
+    }
+  }
+  if (runs.empty()) {
+    return;
+  }
+
+  // Without a memory limit, the fan-in is only limited by the stream index.
+  uint64_t bufferSize = kMaxMergeBufferSize;
+  size_t maxStreams = std::numeric_limits<TStreamIdx>::max();
+  uint64_t memoryBytes{0};
+  if (mergeMemoryBytes_ > 0) {
+    memoryBytes = std::min<uint64_t>(
+        mergeMemoryBytes_, std::max<int64_t>(pool_->maxCapacity(), 0));
+    bufferSize = std::clamp<uint64_t>(
+        memoryBytes / runs.size(), kMinMergeBufferSize, kMaxMergeBufferSize);
+    maxStreams = std::clamp<uint64_t>(memoryBytes / bufferSize, 2, maxStreams);
+  }
+  if (runs.size() > maxStreams) {
+    // An intermediate pass also needs a write buffer.
+    const auto fanIn = std::max<size_t>(maxStreams - 1, 2);
+    do {
+      runs = mergeRuns(runs, fanIn, bufferSize);
+      ++numMergePasses_;
+    } while (runs.size() > maxStreams);
+    if (memoryBytes > 0) {
+      // Fewer runs are left, so each gets a larger buffer.
+      bufferSize = std::clamp<uint64_t>(
+          memoryBytes / runs.size(), kMinMergeBufferSize, kMaxMergeBufferSize);
+    }
+  }
+
+  std::vector<std::unique_ptr<velox::MergeStream>> streams;
+  streams.reserve(runs.size());
+  for (const auto& run : runs) {
+    if (auto stream = openSortedStream(
+            run, static_cast<TStreamIdx>(streams.size()), bufferSize)) {
+      streams.push_back(std::move(stream));
     }
   }
   if (!streams.empty()) {
     merge_ =
         std::make_unique<velox::TreeOfLosers<velox::MergeStream, uint16_t>>(
             std::move(streams));
+    ++numMergePasses_;
+  }
+}
+
+std::unique_ptr<velox::MergeStream> LocalShuffleReader::openSortedStream(
+    const ReadSegment& segment,
+    TStreamIdx streamIdx,
+    uint64_t bufferSize) {
+  std::unique_ptr<SortedRowStream> reader;
+  if (segment.length.has_value()) {
+    reader = std::make_unique<SortedSegmentInputStream>(
+        openDataFile(segment.file),
+        segment.offset,
+        segment.length.value(),
+        streamIdx,
+        pool_,
+        bufferSize);
+  } else {
+    reader = std::make_unique<SortedFileInputStream>(
+        segment.file, streamIdx, pool_, bufferSize);
+    ++numFilesOpened_;
+  }
+  if (!reader->hasData()) {
+    return nullptr;
+  }
+  return reader;
+}
+
+std::vector<LocalShuffleReader::ReadSegment> LocalShuffleReader::mergeRuns(
+    const std::vector<ReadSegment>& runs,
+    size_t fanIn,
+    uint64_t bufferSize) {
+  std::vector<ReadSegment> mergedRuns;
+  mergedRuns.reserve(velox::bits::divRoundUp(runs.size(), fanIn));
+  for (size_t start = 0; start < runs.size(); start += fanIn) {
+    const auto end = std::min(start + fanIn, runs.size());
+    if (end - start == 1) {
+      mergedRuns.push_back(runs[start]);
+      continue;
+    }
+    std::vector<std::unique_ptr<velox::MergeStream>> streams;
+    streams.reserve(end - start);
+    for (auto i = start; i < end; ++i) {
+      if (auto stream = openSortedStream(
+              runs[i], static_cast<TStreamIdx>(streams.size()), bufferSize)) {
+        streams.push_back(std::move(stream));
+      }
+    }
+    if (!streams.empty()) {
+      mergedRuns.push_back(writeMergedRun(std::move(streams), bufferSize));
+    }
+    // Intermediate runs are read once.
+    for (auto i = start; i < end; ++i) {
+      if (mergeRuns_.erase(runs[i].file) > 0) {
+        fileSystem_->remove(runs[i].file);
+      }
+    }
   }
+  return mergedRuns;
+}
+
+LocalShuffleReader::ReadSegment LocalShuffleReader::writeMergedRun(
+    std::vector<std::unique_ptr<velox::MergeStream>> streams,
+    uint64_t bufferSize) {
+  auto path =
+      fmt::format("{}{}.bin", mergeRunPrefix_, numMergeRunsCreated_++);
+  auto file = fileSystem_->openFileForWrite(path);
+  mergeRuns_.insert(path);
+
+  velox::TreeOfLosers<velox::MergeStream, TStreamIdx> merge(std::move(streams));
+  auto buffer = velox::AlignedBuffer::allocate<char>(bufferSize, pool_, 0);
+  char* rawBuffer = buffer->asMutable<char>();
+  uint64_t bufferUsed{0};
+  while (auto* stream = merge.next()) {
+    auto* reader = velox::checkedPointerCast<SortedRowStream>(stream);
+    const auto key = reader->currentKey();
+    const auto data = reader->currentValue();
+    const auto rowSize = kUint32Size * 2 + key.size() + data.size();
+    if (bufferUsed + rowSize > bufferSize) {
+      file->append(std::string_view(rawBuffer, bufferUsed));
+      numMergeSpilledBytes_ += bufferUsed;
+      bufferUsed = 0;
+      if (rowSize > bufferSize) {
+        velox::AlignedBuffer::reallocate<char>(&buffer, rowSize);
+        bufferSize = rowSize;
+        rawBuffer = buffer->asMutable<char>();
+      }
+    }
+    writeSortedRow(rawBuffer + bufferUsed, key, data);
+    bufferUsed += rowSize;
+    reader->next();
+  }
+  if (bufferUsed > 0) {
+    file->append(std::string_view(rawBuffer, bufferUsed));
+    numMergeSpilledBytes_ += bufferUsed;
+  }
+  file->close();
+  return {std::move(path)};
+}
+
+void LocalShuffleReader::removeMergeRuns() {
+  for (const auto& run : mergeRuns_) {
+    fileSystem_->remove(run);
+  }
+  mergeRuns_.clear();
 }
 
 std::vector<std::unique_ptr<ShuffleSerializedPage>>
@@ -487,7 +1097,7 @@ LocalShuffleReader::nextSorted(uint64_t maxBytes) {
   uint64_t bufferUsed = 0;
 
   while (auto* stream = merge_->next()) {
-    auto* reader = velox::checkedPointerCast<SortedFileInputStream>(stream);
+    auto* reader = velox::checkedPointerCast<SortedRowStream>(stream);
     const auto data = reader->currentValue();
 
     if (bufferUsed + data.size() > maxBytes) {
@@ -525,10 +1135,16 @@ LocalShuffleReader::nextUnsorted(uint64_t maxBytes) {
   std::vector<std::unique_ptr<ShuffleSerializedPage>> batches;
   uint64_t totalBytes{0};
 
-  while (readPartitionFileIndex_ < readPartitionFiles_.size()) {
-    const auto filename = readPartitionFiles_[readPartitionFileIndex_];
-    auto file = fileSystem_->openFileForRead(filename);
-    const auto fileSize = file->size();
+  while (readSegmentIndex_ < readSegments_.size()) {
+    const auto& segment = readSegments_[readSegmentIndex_];
+    std::shared_ptr<velox::ReadFile> file;
+    if (segment.length.has_value()) {
+      file = openDataFile(segment.file);
+    } else {
+      file = fileSystem_->openFileForRead(segment.file);
+      ++numFilesOpened_;
+    }
+    const auto fileSize = segment.length.value_or(file->size());
 
     // TODO: Refactor to use streaming I/O with bounded buffer size instead of
     // loading entire files into memory at once. A streaming approach would
@@ -539,8 +1155,8 @@ LocalShuffleReader::nextUnsorted(uint64_t maxBytes) {
     }
 
     auto buffer = velox::AlignedBuffer::allocate<char>(fileSize, pool_, 0);
-    file->pread(0, fileSize, buffer->asMutable<void>());
-    ++readPartitionFileIndex_;
+    file->pread(segment.offset, fileSize, buffer->asMutable<void>());
+    ++readSegmentIndex_;
 
     const char* data = buffer->as<char>();
     const auto parsedRows = extractRowMetadata(data, fileSize, sortedShuffle_);
@@ -574,11 +1190,14 @@ LocalShuffleReader::next(uint64_t maxBytes) {
 void LocalShuffleReader::noMoreData(bool success) {
   // On failure, reset the index of the files to be read.
   if (!success) {
-    readPartitionFileIndex_ = 0;
+    readSegmentIndex_ = 0;
   }
+  merge_.reset();
+  removeMergeRuns();
 }
 
-std::vector<std::string> LocalShuffleReader::getReadPartitionFiles() const {
+std::vector<LocalShuffleReader::ReadSegment>
+LocalShuffleReader::getReadSegments() {
   // Get rid of excess '/' characters in the path.
   auto trimmedRootPath = rootPath_;
   while (trimmedRootPath.length() > 0 &&
@@ -586,19 +1205,62 @@ std::vector<std::string> LocalShuffleReader::getReadPartitionFiles() const {
     trimmedRootPath.erase(trimmedRootPath.length() - 1, 1);
   }
 
-  std::vector<std::string> partitionFiles;
-  for (const auto& partitionId : partitionIds_) {
-    auto prefix =
-        fmt::format("{}/{}_{}_", trimmedRootPath, queryId_, partitionId);
-    auto files = fileSystem_->list(fmt::format("{}/", rootPath_));
-    for (const auto& file : files) {
-      if (file.starts_with(prefix)) {
-        partitionFiles.push_back(file);
+  // Segments per partition in the order of 'partitionIds_'. Partitions of
+  // consolidated files are looked up by shuffle and partition number.
+  std::vector<std::vector<ReadSegment>> partitionSegments(
+      partitionIds_.size());
+  std::vector<std::string> partitionPrefixes;
+  partitionPrefixes.reserve(partitionIds_.size());
+  folly::F14FastMap<std::string, folly::F14FastMap<uint32_t, size_t>>
+      shufflePartitions;
+  for (size_t i = 0; i < partitionIds_.size(); ++i) {
+    partitionPrefixes.push_back(
+        fmt::format("{}/{}_{}_", trimmedRootPath, queryId_, partitionIds_[i]));
+    if (auto parsed = parsePartitionId(partitionIds_[i])) {
+      shufflePartitions[consolidatedFilePrefix(
+          trimmedRootPath, queryId_, parsed->first)][parsed->second] = i;
+    }
+  }
+
+  const auto files = fileSystem_->list(fmt::format("{}/", rootPath_));
+  for (const auto& file : files) {
+    for (size_t i = 0; i < partitionPrefixes.size(); ++i) {
+      if (file.starts_with(partitionPrefixes[i])) {
+        partitionSegments[i].push_back({file});
+      }
+    }
+
+    if (!file.ends_with(kIndexFileExtension)) {
+      continue;
+    }
+    for (const auto& [prefix, partitions] : shufflePartitions) {
+      if (!file.starts_with(prefix)) {
+        continue;
+      }
+      const auto dataFile = fmt::format(
+          "{}{}",
+          std::string_view(file).substr(
+              0, file.size() - kIndexFileExtension.size()),
+          kDataFileExtension);
+      auto indexFile = fileSystem_->openFileForRead(file);
+      ++numFilesOpened_;
+      for (const auto& entry : readIndex(*indexFile)) {
+        auto it = partitions.find(entry.partition);
+        if (it != partitions.end()) {
+          partitionSegments[it->second].push_back(
+              {dataFile, entry.offset, entry.length});
+        }
       }
     }
   }
 
-  return partitionFiles;
+  std::vector<ReadSegment> segments;
+  for (auto& partition : partitionSegments) {
+    for (auto& segment : partition) {
+      segments.push_back(std::move(segment));
+    }
+  }
+  return segments;
 }
 
 void LocalShuffleWriter::cleanup() {
@@ -612,6 +1274,8 @@ std::shared_ptr<ShuffleReader> LocalPersistentShuffleFactory::createReader(
     const std::string& serializedStr,
     const int32_t /*partition*/,
     velox::memory::MemoryPool* pool) {
+  static const uint64_t mergeMemoryBytes =
+      SystemConfig::instance()->localShuffleMergeMemoryBytes();
   const operators::LocalShuffleReadInfo readInfo =
       operators::LocalShuffleReadInfo::deserialize(serializedStr);
 
@@ -620,7 +1284,8 @@ std::shared_ptr<ShuffleReader> LocalPersistentShuffleFactory::createReader(
       readInfo.queryId,
       readInfo.partitionIds,
       readInfo.sortedShuffle,
-      pool);
+      pool,
+      mergeMemoryBytes);
   reader->initialize();
   return reader;
 }
@@ -630,6 +1295,21 @@ std::shared_ptr<ShuffleWriter> LocalPersistentShuffleFactory::createWriter(
     velox::memory::MemoryPool* pool) {
   static const uint64_t maxBytesPerPartition =
       SystemConfig::instance()->localShuffleMaxPartitionBytes();
+  static const bool consolidateFiles =
+      SystemConfig::instance()->localShuffleConsolidateFiles();
+  static const uint64_t maxPendingFlushBytes =
+      SystemConfig::instance()->localShuffleMaxPendingFlushBytes();
+  // Shared by all writers. Never destroyed as writers may outlive statics.
+  static folly::Executor* const flushExecutor = []() -> folly::Executor* {
+    const auto numThreads =
+        SystemConfig::instance()->localShuffleFlushThreads();
+    if (numThreads == 0) {
+      return nullptr;
+    }
+    return new folly::CPUThreadPoolExecutor(
+        numThreads,
+        std::make_shared<folly::NamedThreadFactory>("LocalShuffleFlush"));
+  }();
   const operators::LocalShuffleWriteInfo writeInfo =
       operators::LocalShuffleWriteInfo::deserialize(serializedStr);
 
@@ -640,6 +1320,9 @@ std::shared_ptr<ShuffleWriter> LocalPersistentShuffleFactory::createWriter(
       writeInfo.numPartitions,
       maxBytesPerPartition,
       writeInfo.sortedShuffle,
-      pool);
+      pool,
+      consolidateFiles,
+      flushExecutor,
+      maxPendingFlushBytes);
 }
 } // namespace facebook::presto::operators
@@ -13,7 +13,17 @@
  */
 #pragma once
 
+#include <folly/container/F14Set.h>
+#include <folly/executors/SerialExecutor.h>
+#include <folly/lang/Bits.h>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -35,6 +45,7 @@ struct RowMetadata {
   size_t rowStart; // Offset to the start of this row
   uint32_t keySize; // Size of key (0 for non-sorted)
   uint32_t dataSize; // Size of data
+  uint64_t keyPrefix{0}; // normalizedKeyPrefix() of key (0 for non-sorted)
 };
 
 inline bool compareKeys(std::string_view key1, std::string_view key2) noexcept {
@@ -48,6 +59,39 @@ inline bool compareKeys(std::string_view key1, std::string_view key2) noexcept {
   return key1.size() < key2.size();
 }
 
+/// Returns the first 8 bytes of 'key' as a big endian integer, padded with
+/// zeros. If the prefixes of two keys differ, they order the keys like
+/// compareKeys(). Otherwise compareKeys() has to decide.
+inline uint64_t normalizedKeyPrefix(std::string_view key) noexcept {
+  uint64_t prefix{0};
+  std::memcpy(&prefix, key.data(), std::min(key.size(), sizeof(prefix)));
+  return folly::Endian::big(prefix);
+}
+
+/// Same as compareKeys() for keys with normalized prefixes 'prefix1' and
+/// 'prefix2'. Most keys only need an integer comparison of the prefixes.
+inline bool compareKeys(
+    uint64_t prefix1,
+    std::string_view key1,
+    uint64_t prefix2,
+    std::string_view key2) noexcept {
+  if (prefix1 != prefix2) {
+    return prefix1 < prefix2;
+  }
+  return compareKeys(key1, key2);
+}
+
+/// Entry of the index of a consolidated shuffle data file. Stored as big
+/// endian integers.
+struct ShuffleIndexEntry {
+  uint32_t partition;
+  uint64_t offset;
+  uint64_t length;
+
+  static constexpr size_t kSerializedSize =
+      sizeof(uint32_t) + 2 * sizeof(uint64_t);
+};
+
 // LocalShuffleWriteInfo is used for containing shuffle write information.
 // This struct is a 1:1 strict API mapping to
 // presto-spark-base/src/main/java/com/facebook/presto/spark/execution/PrestoSparkLocalShuffleWriteInfo.java
@@ -101,6 +145,25 @@ struct LocalShuffleReadInfo {
 /// multi-process use scenarios as long as each producer or consumer is assigned
 /// to a distinct group of partition IDs. Each of them can create an instance of
 /// this class (pointing to the same root path) to read and write shuffle data.
+///
+/// With 'consolidateFiles', the blocks of all partitions are instead appended
+/// to a single data file per writer, e.g.
+/// <ROOT_PATH>/<QUERY_ID>_shuffle_0_0.<WRITER_ID>.data. An index file with the
+/// same name and the '.index' extension lists the (partition, offset, length)
+/// of each block. It is written by noMoreData(), so readers only see complete
+/// data files. This keeps the number of files per writer constant, no matter
+/// how many partitions and blocks there are.
+///
+/// noMoreData(false) drops the blocks that are not written yet and deletes
+/// all files under the root path without writing an index.
+///
+/// With a 'flushExecutor', full blocks are sorted and written on the executor
+/// instead of the thread that calls collect(), which continues with a new
+/// block. The blocks of one writer are written one at a time in order. The
+/// blocks waiting to be written may take at most 'maxPendingFlushBytes',
+/// capped by the capacity of 'pool', after which collect() waits for earlier
+/// blocks to be written. noMoreData() waits for all blocks to be written. The
+/// driver is suspended while it waits.
 class LocalShuffleWriter : public ShuffleWriter {
  public:
   LocalShuffleWriter(
@@ -110,7 +173,16 @@ class LocalShuffleWriter : public ShuffleWriter {
       uint32_t numPartitions,
       uint64_t maxBytesPerPartition,
       bool sortedShuffle,
-      velox::memory::MemoryPool* pool);
+      velox::memory::MemoryPool* pool,
+      bool consolidateFiles = false,
+      folly::Executor* flushExecutor = nullptr,
+      uint64_t maxPendingFlushBytes = 0);
+
+  ~LocalShuffleWriter() override;
+
+  /// Largest buffer the rows of a sorted block are copied to in sorted order
+  /// before they are written.
+  static constexpr uint64_t kMaxSortedWriteBufferSize{1 << 20};
 
   void collect(int32_t partition, std::string_view key, std::string_view data)
       override;
@@ -118,8 +190,12 @@ class LocalShuffleWriter : public ShuffleWriter {
   void noMoreData(bool success) override;
 
   folly::F14FastMap<std::string, int64_t> stats() const override {
-    // Fake counter for testing only.
-    return {{"local.write", 2345}};
+    // 'local.write' is a fake counter for testing only.
+    return {
+        {"local.write", 2345},
+        {"local.write.files", numFilesCreated_.load()},
+        {"local.write.blocks", numBlocksWritten_.load()},
+        {"local.write.flushWaitNanos", flushWaitNanos_}};
   }
 
  private:
@@ -131,8 +207,36 @@ class LocalShuffleWriter : public ShuffleWriter {
   // given 'partition'.
   std::unique_ptr<velox::WriteFile> getNextOutputFile(int32_t partition);
 
-  // Writes the in-progress block to the given partition.
-  void writeBlock(int32_t partition);
+  // Writes the in-progress block of 'partition', on 'flushExecutor_' if set.
+  // The in-progress buffer is kept for the next block if the block is written
+  // synchronously. Otherwise the buffer is handed to the flush and a new one
+  // is allocated by the next collect().
+  void flushBlock(int32_t partition);
+
+  // Writes the first 'size' bytes of 'buffer' as a block of 'partition'.
+  void writeBlock(int32_t partition, const velox::Buffer& buffer, size_t size);
+
+  // Appends a block to 'file', sorting the rows for a sorted shuffle. The
+  // sorted rows are written through 'sortedWriteBuffer_'.
+  void appendBlock(const char* data, size_t size, velox::WriteFile& file);
+
+  // Waits until a block of 'bytes' fits in 'maxPendingFlushBytes_'.
+  void waitForFlushCapacity(uint64_t bytes);
+
+  // Waits until all blocks handed to 'flushExecutor_' are written. If
+  // 'suspend' is true, the driver of the calling thread is suspended while
+  // it waits.
+  void waitForFlushes(bool suspend);
+
+  // Waits until 'done' returns true under 'flushMutex_'. Adds the time waited
+  // to 'flushWaitNanos_'.
+  void waitUntil(bool suspend, const std::function<bool()>& done);
+
+  // Throws the first error of a background flush.
+  void checkFlushError();
+
+  // Writes the index of the consolidated data file and closes it.
+  void finishConsolidatedFile();
 
   // Deletes all the files in the root directory.
   void cleanup();
@@ -153,12 +257,55 @@ class LocalShuffleWriter : public ShuffleWriter {
   const std::string queryId_;
   const uint32_t shuffleId_;
 
+  const bool consolidateFiles_;
+  // Writes blocks in order in the background. Not set if blocks are written
+  // by collect() and noMoreData().
+  folly::Executor::KeepAlive<folly::SerialExecutor> flushExecutor_;
+  const uint64_t maxPendingFlushBytes_;
+
   /// The latest written block buffers and sizes.
   std::vector<velox::BufferPtr> inProgressPartitions_;
   std::vector<size_t> inProgressSizes_;
   std::shared_ptr<velox::filesystems::FileSystem> fileSystem_;
+
+  // Path of the consolidated data file without extension. Unique across
+  // writers of all threads and processes.
+  std::string consolidatedFilePrefix_;
+  // The consolidated data file. Opened on the first block.
+  std::unique_ptr<velox::WriteFile> dataFile_;
+  uint64_t dataFileSize_{0};
+  // Segments of 'dataFile_' in the order they were written.
+  std::vector<ShuffleIndexEntry> index_;
+  // Staging buffer of at most kMaxSortedWriteBufferSize bytes for the sorted
+  // rows of a block. Blocks are written one at a time, so it is reused.
+  velox::BufferPtr sortedWriteBuffer_;
+
+  std::atomic<int64_t> numFilesCreated_{0};
+  std::atomic<int64_t> numBlocksWritten_{0};
+
+  // Protect the state of the background flushes below.
+  std::mutex flushMutex_;
+  std::condition_variable flushCv_;
+  // Buffer bytes and number of the blocks handed to 'flushExecutor_' and not
+  // written yet.
+  uint64_t pendingFlushBytes_{0};
+  int32_t numPendingFlushes_{0};
+  // First error of a background flush. Later blocks are dropped.
+  std::exception_ptr flushError_;
+  // Time collect() and noMoreData() waited for background flushes.
+  int64_t flushWaitNanos_{0};
 };
 
+/// Reads the blocks of a list of partitions written by LocalShuffleWriter.
+///
+/// For a sorted shuffle, the sorted blocks are merged with a k-way merge that
+/// keeps one read buffer per block. If 'mergeMemoryBytes' is not 0, the read
+/// buffers of the merge are limited to that many bytes (and to the capacity of
+/// 'pool'). The buffers are first made smaller, down to
+/// kMinMergeBufferSize. If there are still too many blocks, groups of blocks
+/// are merged into intermediate sorted runs under the root path until the
+/// runs can be merged in one pass. The runs are deleted by noMoreData() or
+/// the destructor.
 class LocalShuffleReader : public ShuffleReader {
  public:
   LocalShuffleReader(
@@ -166,11 +313,22 @@ class LocalShuffleReader : public ShuffleReader {
       const std::string& queryId,
       std::vector<std::string> partitionIds,
       bool sortedShuffle,
-      velox::memory::MemoryPool* pool);
+      velox::memory::MemoryPool* pool,
+      uint64_t mergeMemoryBytes = 0);
+
+  ~LocalShuffleReader() override;
+
+  /// Read buffer size of each block of a sorted shuffle without a merge
+  /// memory limit.
+  static constexpr uint64_t kMaxMergeBufferSize{8 << 20};
+  /// Smallest read buffer size of a block before intermediate runs are
+  /// written.
+  static constexpr uint64_t kMinMergeBufferSize{64 << 10};
 
   /// Initializes the reader by discovering shuffle files and setting up merge
   /// infrastructure for sorted shuffle. Must be called before next().
-  /// For sorted shuffle, this opens all shuffle files and prepares k-way merge.
+  /// For sorted shuffle, this opens the shuffle files, writes intermediate runs
+  /// if needed and prepares the final k-way merge.
   void initialize();
 
   folly::SemiFuture<std::vector<std::unique_ptr<ShuffleSerializedPage>>> next(
@@ -179,18 +337,58 @@ class LocalShuffleReader : public ShuffleReader {
   void noMoreData(bool success) override;
 
   folly::F14FastMap<std::string, int64_t> stats() const override {
-    // Fake counter for testing only.
-    return {{"local.read", 123}};
+    // 'local.read' is a fake counter for testing only.
+    return {
+        {"local.read", 123},
+        {"local.read.files", numFilesOpened_},
+        {"local.read.segments", static_cast<int64_t>(readSegments_.size())},
+        {"local.read.mergePasses", numMergePasses_},
+        {"local.read.mergeSpilledBytes", numMergeSpilledBytes_}};
   }
 
  private:
-  // Returns all created shuffle files for 'partition_'.
-  std::vector<std::string> getReadPartitionFiles() const;
+  // Rows of one block of a partition to read. Either a whole block file or a
+  // segment of a consolidated data file.
+  struct ReadSegment {
+    std::string file;
+    uint64_t offset{0};
+    // Not set for a whole file.
+    std::optional<uint64_t> length;
+  };
+
+  // Returns the blocks of the partitions to read. Lists the root directory
+  // once and reads the index of each consolidated data file of the shuffle.
+  std::vector<ReadSegment> getReadSegments();
+
+  // Returns the open data file 'path', shared by the segments in it.
+  std::shared_ptr<velox::ReadFile> openDataFile(const std::string& path);
 
   // Initializes sorted shuffle read by creating input streams and setting up
   // k-way merge infrastructure.
   void initSortedShuffleRead();
 
+  // Returns the stream of the rows of 'segment' with a read buffer of
+  // 'bufferSize' bytes, or nullptr if 'segment' is empty.
+  std::unique_ptr<velox::MergeStream> openSortedStream(
+      const ReadSegment& segment,
+      uint16_t streamIdx,
+      uint64_t bufferSize);
+
+  // Merges consecutive groups of 'fanIn' runs into intermediate runs. Returns
+  // the runs for the next pass, in the same order.
+  std::vector<ReadSegment> mergeRuns(
+      const std::vector<ReadSegment>& runs,
+      size_t fanIn,
+      uint64_t bufferSize);
+
+  // Merges 'streams' into a new intermediate run file.
+  ReadSegment writeMergedRun(
+      std::vector<std::unique_ptr<velox::MergeStream>> streams,
+      uint64_t bufferSize);
+
+  // Deletes the intermediate run files that are still there.
+  void removeMergeRuns();
+
   // Reads sorted shuffle data using k-way merge with TreeOfLosers.
   std::vector<std::unique_ptr<ShuffleSerializedPage>> nextSorted(
       uint64_t maxBytes);
@@ -204,12 +402,17 @@ class LocalShuffleReader : public ShuffleReader {
   const std::vector<std::string> partitionIds_;
   const bool sortedShuffle_;
   velox::memory::MemoryPool* pool_;
+  const uint64_t mergeMemoryBytes_;
+
+  // Latest read block index in 'readSegments_'.
+  size_t readSegmentIndex_{0};
 
-  // Latest read block (file) index in 'readPartitionFiles_' for 'partition_'.
-  size_t readPartitionFileIndex_{0};
+  // Blocks of the partitions to read.
+  std::vector<ReadSegment> readSegments_;
 
-  // List of generated files for 'partition_'.
-  std::vector<std::string> readPartitionFiles_;
+  // Open consolidated data files by path.
+  folly::F14FastMap<std::string, std::shared_ptr<velox::ReadFile>> dataFiles_;
+  int64_t numFilesOpened_{0};
 
   // The top directory of the shuffle files and its file system.
   std::shared_ptr<velox::filesystems::FileSystem> fileSystem_;
@@ -217,6 +420,14 @@ class LocalShuffleReader : public ShuffleReader {
   // Used to merge sorted streams from multiple shuffle files for k-way merge.
   std::unique_ptr<velox::TreeOfLosers<velox::MergeStream, uint16_t>> merge_;
 
+  // Path prefix of the intermediate runs of the merge. Unique per reader.
+  std::string mergeRunPrefix_;
+  // Intermediate runs that have not been deleted yet.
+  folly::F14FastSet<std::string> mergeRuns_;
+  int32_t numMergeRunsCreated_{0};
+  int64_t numMergePasses_{0};
+  int64_t numMergeSpilledBytes_{0};
+
   bool initialized_{false};
 };
 
@@ -13,12 +13,8 @@
  */
 #include "presto_cpp/main/operators/MaterializedExchange.h"
 
-#include <folly/lang/Bits.h>
-#include <cstring>
-
+#include "presto_cpp/main/common/Configs.h"
 #include "presto_cpp/main/operators/ShuffleExchangeSource.h"
-#include "velox/row/CompactRow.h"
-#include "velox/serializers/RowSerializer.h"
 
 using namespace facebook::velox;
 using namespace facebook::velox::exec;
@@ -35,15 +31,33 @@ core::PlanNodeId deserializeMaterializedExchangeNodeId(
 folly::dynamic MaterializedExchangeNode::serialize() const {
   auto obj = PlanNode::serialize();
   obj["outputType"] = outputType_->serialize();
+  if (serializedType_ != outputType_) {
+    obj["serializedType"] = serializedType_->serialize();
+  }
+  if (filter_ != nullptr) {
+    obj["filter"] = filter_->serialize();
+  }
   return obj;
 }
 
 core::PlanNodePtr MaterializedExchangeNode::create(
     const folly::dynamic& obj,
     void* context) {
+  RowTypePtr serializedType;
+  if (obj.count("serializedType")) {
+    serializedType =
+        ISerializable::deserialize<RowType>(obj["serializedType"], context);
+  }
+  core::TypedExprPtr filter;
+  if (obj.count("filter")) {
+    filter =
+        ISerializable::deserialize<core::ITypedExpr>(obj["filter"], context);
+  }
   return std::make_shared<MaterializedExchangeNode>(
       deserializeMaterializedExchangeNodeId(obj),
-      ISerializable::deserialize<RowType>(obj["outputType"], context));
+      ISerializable::deserialize<RowType>(obj["outputType"], context),
+      std::move(serializedType),
+      std::move(filter));
 }
 
 MaterializedExchange::MaterializedExchange(
@@ -60,17 +74,37 @@ MaterializedExchange::MaterializedExchange(
               materializedExchangeNode->outputType(),
               "CompactRow"),
           exchangeClient,
-          "MaterializedExchange") {}
+          "MaterializedExchange"),
+      deserializer_(materializedExchangeNode->serializedType()),
+      lazyColumns_(
+          materializedExchangeNode->serializedType() == outputType_ &&
+          materializedExchangeNode->filter() == nullptr &&
+          deserializer_.fixedRowSize().has_value() &&
+          SystemConfig::instance()
+              ->exchangeMaterializationLazyColumnsEnabled()) {
+  if (materializedExchangeNode->filter() != nullptr ||
+      materializedExchangeNode->serializedType()->size() !=
+          outputType_->size()) {
+    pushdown_ = std::make_unique<ShuffleReadPushdown>(
+        materializedExchangeNode->serializedType(),
+        outputType_,
+        materializedExchangeNode->filter(),
+        operatorCtx_->execCtx());
+  }
+}
 
 void MaterializedExchange::resetOutputState() {
+  if (lazyPages_ != nullptr) {
+    *lazyPages_ = std::move(currentPages_);
+    lazyPages_.reset();
+  }
   currentPages_.clear();
-  rows_.clear();
+  deserializer_.clear();
   nextRow_ = 0;
 }
 
 uint64_t MaterializedExchange::parseCurrentPages() {
   uint64_t rawInputBytes = 0;
-  rows_.reserve(1024);
   for (const auto& page : currentPages_) {
     auto* batch = checkedPointerCast<ShuffleSerializedPage>(page.get());
     rawInputBytes += page->size();
@@ -84,9 +118,12 @@ uint64_t MaterializedExchange::parseCurrentPages() {
       if (value.empty()) {
         continue;
       }
-      expandBatchedPage(value);
+      deserializer_.addPage(value);
     }
   }
+  if (lazyColumns_) {
+    lazyPages_ = std::make_shared<Pages>();
+  }
   ++numInputBatches_;
   return rawInputBytes;
 }
@@ -98,23 +135,28 @@ RowVectorPtr MaterializedExchange::deserializeNextBatch() {
         preferredOutputBatchBytes_ / estimatedRowSize_.value(),
         kInitialOutputRows);
   }
-  numOutputRows = std::min<uint64_t>(numOutputRows, rows_.size() - nextRow_);
+  numOutputRows = std::min<uint64_t>(
+      numOutputRows, deserializer_.numRows() - nextRow_);
 
-  RowVectorPtr resultRowVector;
-  if (numOutputRows == rows_.size()) {
-    resultRowVector = row::CompactRow::deserialize(rows_, outputType_, pool());
-  } else {
-    std::vector<std::string_view> outputRows(
-        rows_.begin() + nextRow_, rows_.begin() + nextRow_ + numOutputRows);
-    resultRowVector =
-        row::CompactRow::deserialize(outputRows, outputType_, pool());
-  }
+  auto resultRowVector = pushdown_ != nullptr
+      ? pushdown_->read(deserializer_, nextRow_, numOutputRows, pool())
+      : deserializer_.deserialize(nextRow_, numOutputRows, pool(), lazyPages_);
 
   nextRow_ += numOutputRows;
   totalRows_ += numOutputRows;
-  estimatedRowSize_ = std::max(
-      resultRowVector->estimateFlatSize() / numOutputRows,
-      estimatedRowSize_.value_or(1L));
+  if (resultRowVector == nullptr) {
+    return nullptr;
+  }
+  if (lazyColumns_) {
+    // Lazy columns have no size until loaded. The serialized size of a
+    // fixed-width row is close to its flat size.
+    estimatedRowSize_ =
+        std::max<uint64_t>(deserializer_.fixedRowSize().value(), 1);
+  } else {
+    estimatedRowSize_ = std::max(
+        resultRowVector->estimateFlatSize() / resultRowVector->size(),
+        estimatedRowSize_.value_or(1L));
+  }
   return resultRowVector;
 }
 
@@ -124,27 +166,34 @@ RowVectorPtr MaterializedExchange::getOutput() {
   }
 
   SCOPE_EXIT {
-    if (nextRow_ == rows_.size()) {
+    if (nextRow_ == deserializer_.numRows()) {
       resetOutputState();
     }
   };
 
   uint64_t rawInputBytes{0};
-  if (rows_.empty()) {
+  if (deserializer_.numRows() == 0) {
     VELOX_CHECK_EQ(nextRow_, 0);
     rawInputBytes = parseCurrentPages();
   }
 
-  if (rows_.empty()) {
+  if (deserializer_.numRows() == 0) {
     return nullptr;
   }
 
-  result_ = deserializeNextBatch();
+  // Skips batches where no row passes the filter.
+  do {
+    result_ = deserializeNextBatch();
+  } while (result_ == nullptr && nextRow_ < deserializer_.numRows());
   recordInputStats(rawInputBytes);
   return result_;
 }
 
 void MaterializedExchange::close() {
+  if (lazyPages_ != nullptr) {
+    // Keeps the pages alive for the lazy columns returned so far.
+    resetOutputState();
+  }
   Exchange::close();
   if (numInputBatches_ != 0) {
     auto lockedStats = stats_.wlock();
@@ -153,45 +202,10 @@ void MaterializedExchange::close() {
     lockedStats->addRuntimeStat(
         std::string(kTotalRows), RuntimeCounter(totalRows_));
   }
-}
-
-void MaterializedExchange::expandBatchedPage(std::string_view pageData) {
-  const size_t kPageHeaderSize = serializer::detail::RowGroupHeader::size();
-
-  const char* ptr = pageData.data();
-  size_t remaining = pageData.size();
-
-  // Iterate over one or more RowGroupHeaders in the buffer.
-  while (remaining > 0) {
-    int32_t uncompressedSize;
-    std::memcpy(&uncompressedSize, ptr, sizeof(int32_t));
-    ptr += kPageHeaderSize;
-    remaining -= kPageHeaderSize;
-
-    VELOX_CHECK_GE(
-        remaining,
-        static_cast<size_t>(uncompressedSize),
-        "Page data truncated: expected {} bytes, got {}",
-        uncompressedSize,
-        remaining);
-
-    // Parse TRowSize-framed rows within this RowGroup.
-    size_t pageRemaining = uncompressedSize;
-    while (pageRemaining > 0) {
-      VELOX_CHECK_GE(pageRemaining, sizeof(uint32_t), "Truncated TRowSize");
-      uint32_t rowSize;
-      std::memcpy(&rowSize, ptr, sizeof(uint32_t));
-      rowSize = folly::Endian::big(rowSize);
-      ptr += sizeof(uint32_t);
-      pageRemaining -= sizeof(uint32_t);
-
-      VELOX_CHECK_GE(pageRemaining, rowSize, "Truncated row data");
-      rows_.emplace_back(ptr, rowSize);
-      ptr += rowSize;
-      pageRemaining -= rowSize;
-    }
-
-    remaining -= uncompressedSize;
+  if (pushdown_ != nullptr && pushdown_->numFilteredRows() != 0) {
+    stats_.wlock()->addRuntimeStat(
+        std::string(kFilteredRows),
+        RuntimeCounter(pushdown_->numFilteredRows()));
   }
 }
 
@@ -13,6 +13,8 @@
  */
 #pragma once
 
+#include "presto_cpp/main/operators/CompactRowBatchDeserializer.h"
+#include "presto_cpp/main/operators/ShuffleReadPushdown.h"
 #include "velox/core/PlanNode.h"
 #include "velox/exec/Exchange.h"
 #include "velox/exec/Operator.h"
@@ -23,15 +25,37 @@ namespace facebook::presto::operators {
 /// Paired with MaterializedOutputNode for symmetric A/B switching.
 class MaterializedExchangeNode : public velox::core::PlanNode {
  public:
+  /// @param outputType Output type. A subset of the columns of
+  /// 'serializedType'.
+  /// @param serializedType Type of the rows written by MaterializedOutput.
+  /// Same as 'outputType' if null.
+  /// @param filter Filter over the columns of 'serializedType' that the rows
+  /// must pass to be returned. May be null.
   MaterializedExchangeNode(
       const velox::core::PlanNodeId& id,
-      velox::RowTypePtr outputType)
-      : PlanNode(id), outputType_(std::move(outputType)) {}
+      velox::RowTypePtr outputType,
+      velox::RowTypePtr serializedType = nullptr,
+      velox::core::TypedExprPtr filter = nullptr)
+      : PlanNode(id),
+        outputType_(std::move(outputType)),
+        serializedType_(
+            serializedType ? std::move(serializedType) : outputType_),
+        filter_(std::move(filter)) {
+    checkShuffleReadPushdown(serializedType_, outputType_, filter_);
+  }
 
   const velox::RowTypePtr& outputType() const override {
     return outputType_;
   }
 
+  const velox::RowTypePtr& serializedType() const {
+    return serializedType_;
+  }
+
+  const velox::core::TypedExprPtr& filter() const {
+    return filter_;
+  }
+
   /// Leaf node — no child plan nodes. Data comes from ExchangeClient via
   /// splits (RemoteConnectorSplit), not from upstream operators.
   const std::vector<velox::core::PlanNodePtr>& sources() const override {
@@ -58,9 +82,15 @@ class MaterializedExchangeNode : public velox::core::PlanNode {
       void* context);
 
  private:
-  void addDetails(std::stringstream& /* stream */) const override {}
+  void addDetails(std::stringstream& stream) const override {
+    if (filter_ != nullptr) {
+      stream << "filter: " << filter_->toString();
+    }
+  }
 
   const velox::RowTypePtr outputType_;
+  const velox::RowTypePtr serializedType_;
+  const velox::core::TypedExprPtr filter_;
 };
 
 /// Operator for reading shuffle data written by MaterializedOutput.
@@ -70,17 +100,22 @@ class MaterializedExchangeNode : public velox::core::PlanNode {
 /// CompactRow data into RowVectors. Only handles batched format — no
 /// kFormatRaw/legacy support (that's in ShuffleRead).
 ///
-/// Deserializes CompactRow data directly via expandBatchedPage() using the
-/// fixed RowGroupHeader + TRowSize framing, bypassing the VectorSerde
+/// Deserializes CompactRow data directly via CompactRowBatchDeserializer using
+/// the fixed RowGroupHeader + TRowSize framing, bypassing the VectorSerde
 /// abstraction. This avoids VectorStreamGroup's column-by-column
 /// deserialization overhead since the framing format is fixed and known
-/// at compile time (written by MaterializedOutput).
+/// at compile time (written by MaterializedOutput). Fixed-width row types are
+/// copied out of the pages column by column, optionally as lazy columns (see
+/// SystemConfig::kExchangeMaterializationLazyColumnsEnabled). A column subset
+/// or filter pushed into the node is applied by ShuffleReadPushdown.
 class MaterializedExchange : public velox::exec::Exchange {
  public:
   static constexpr std::string_view kInputBatches =
       "materializedExchangeInputBatches";
   static constexpr std::string_view kTotalRows =
       "materializedExchangeTotalRows";
+  static constexpr std::string_view kFilteredRows =
+      "materializedExchangeFilteredRows";
 
   MaterializedExchange(
       int32_t operatorId,
@@ -95,25 +130,19 @@ class MaterializedExchange : public velox::exec::Exchange {
 
  private:
   // Not used — MaterializedExchange deserializes CompactRow directly via
-  // expandBatchedPage(), bypassing the VectorSerde abstraction.
+  // CompactRowBatchDeserializer, bypassing the VectorSerde abstraction.
   velox::VectorSerde* getSerde() override {
     VELOX_UNSUPPORTED("MaterializedExchange doesn't use serde");
   }
 
-  // Parse RowGroupHeader + TRowSize-framed CompactRow data written by
-  // MaterializedOutput into row string_views. Operates directly on the framed
-  // byte layout (RowGroupHeader followed by big-endian TRowSize + row bytes)
-  // rather than going through VectorStreamGroup deserialization, since the
-  // framing format is fixed and known at compile time.
-  void expandBatchedPage(std::string_view pageData);
-
   // Clear accumulated page and row state after all rows are consumed.
   void resetOutputState();
 
-  // Expand all current pages into row string_views.
+  // Add the rows of all current pages to 'deserializer_'.
   uint64_t parseCurrentPages();
 
-  // Compute output batch size and deserialize rows into a RowVector.
+  // Compute output batch size and deserialize rows into a RowVector. Returns
+  // nullptr if no row passes the filter.
   velox::RowVectorPtr deserializeNextBatch();
 
   // Cumulative stats.
@@ -122,8 +151,18 @@ class MaterializedExchange : public velox::exec::Exchange {
 
   // Row parsing state — populated by parseCurrentPages(), consumed by
   // deserializeNextBatch(). Reset when all rows are consumed.
-  std::vector<std::string_view> rows_;
-  size_t nextRow_{0};
+  CompactRowBatchDeserializer deserializer_;
+  velox::vector_size_t nextRow_{0};
+
+  // Set if a column subset or a filter is pushed into the node.
+  std::unique_ptr<ShuffleReadPushdown> pushdown_;
+
+  // Set if fixed-width columns are returned as lazy vectors. Receives the
+  // current pages when all their rows are consumed, so that the lazy vectors
+  // can still read from them.
+  using Pages = std::vector<std::unique_ptr<velox::exec::SerializedPageBase>>;
+  const bool lazyColumns_;
+  std::shared_ptr<Pages> lazyPages_;
 };
 
 /// Translator that creates MaterializedExchange operators from
@@ -47,6 +47,9 @@ folly::dynamic MaterializedOutputNode::serialize() const {
   obj["replicateNullsAndAny"] = replicateNullsAndAny_;
   obj["outputType"] = outputType_->serialize();
   obj["sources"] = ISerializable::serialize(sources_);
+  if (skewSplit_.enabled()) {
+    obj["skewSplit"] = skewSplit_.serialize();
+  }
   return obj;
 }
 
@@ -78,6 +81,11 @@ core::PlanNodePtr MaterializedOutputNode::create(
       ? obj["replicateNullsAndAny"].asBool()
       : false;
 
+  SkewSplitSpec skewSplit;
+  if (obj.count("skewSplit") != 0) {
+    skewSplit = SkewSplitSpec::create(obj["skewSplit"]);
+  }
+
   return std::make_shared<MaterializedOutputNode>(
       deserializePlanNodeId(obj),
       std::move(keyPtrs),
@@ -86,7 +94,8 @@ core::PlanNodePtr MaterializedOutputNode::create(
       std::move(partitionFunctionSpec),
       replicateNullsAndAny,
       ShuffleWriterMetadata{},
-      std::move(source));
+      std::move(source),
+      skewSplit);
 }
 
 MaterializedOutput::MaterializedOutput(
@@ -126,6 +135,10 @@ MaterializedOutput::MaterializedOutput(
                   planNode->outputType()))) {
   VELOX_CHECK_GT(numDestinations_, 0);
   VELOX_CHECK_NOT_NULL(buffer_);
+  if (planNode->skewSplit().enabled() && numDestinations_ > 1) {
+    skewSplitter_ = std::make_unique<SkewedPartitionSplitter>(
+        planNode->skewSplit(), numDestinations_);
+  }
 }
 
 void MaterializedOutput::initializeInput(RowVectorPtr input) {
@@ -176,6 +189,10 @@ void MaterializedOutput::computePartitions(
           partitions_.begin(), partitions_.end(), singlePartition.value());
     }
   }
+  if (skewSplitter_ != nullptr &&
+      skewSplitter_->spec().mode == SkewSplitMode::kSalt) {
+    skewSplitter_->salt(partitions_.data(), numRows);
+  }
 }
 
 void MaterializedOutput::serializeFixedWidthRows(
@@ -349,14 +366,51 @@ void MaterializedOutput::appendReplicaEntries(
   }
 }
 
-void MaterializedOutput::expandReplicateRows(
+std::vector<int32_t> MaterializedOutput::expandReplicateRows(
     int32_t serializeStartRow,
     int32_t numInputRows) {
-  const auto rowsToExpand = selectRowsToReplicate(numInputRows);
-  if (rowsToExpand.empty()) {
+  auto rowsToExpand = selectRowsToReplicate(numInputRows);
+  if (!rowsToExpand.empty()) {
+    appendReplicaEntries(serializeStartRow, rowsToExpand);
+  }
+  return rowsToExpand;
+}
+
+void MaterializedOutput::appendSkewReplicaEntries(
+    int32_t serializeStartRow,
+    int32_t numInputRows,
+    const std::vector<int32_t>& replicatedRows) {
+  if (!skewSplitter_->replicates()) {
     return;
   }
-  appendReplicaEntries(serializeStartRow, rowsToExpand);
+  int64_t numReplicatedRows = 0;
+  auto nextReplicated = replicatedRows.begin();
+  for (int32_t i = 0; i < numInputRows; ++i) {
+    if (nextReplicated != replicatedRows.end() && *nextReplicated == i) {
+      ++nextReplicated;
+      continue;
+    }
+    const int32_t rowIdx = serializeStartRow + i;
+    const uint32_t partition = rowPartitions_[rowIdx];
+    const auto numReplicas = skewSplitter_->numReplicas(partition);
+    if (numReplicas == 1) {
+      continue;
+    }
+    const int64_t offset = rowOffsets_[rowIdx];
+    const int32_t size = rowSizes_[rowIdx];
+    for (uint32_t j = 1; j < numReplicas; ++j) {
+      rowOffsets_.push_back(offset);
+      rowSizes_.push_back(size);
+      rowPartitions_.push_back(skewSplitter_->destination(partition, j));
+      ++rowCount_;
+    }
+    numReplicatedRows += numReplicas - 1;
+  }
+  if (numReplicatedRows > 0) {
+    addRuntimeStat(
+        std::string(SkewedPartitionSplitter::kReplicatedRows),
+        RuntimeCounter(numReplicatedRows));
+  }
 }
 
 void MaterializedOutput::addInput(RowVectorPtr input) {
@@ -386,8 +440,12 @@ void MaterializedOutput::addInput(RowVectorPtr input) {
   row::CompactRow compactRow(output_);
   serializeRows(compactRow, numRows);
 
+  std::vector<int32_t> replicatedRows;
   if (shouldReplicate()) {
-    expandReplicateRows(serializeStartRow, numRows);
+    replicatedRows = expandReplicateRows(serializeStartRow, numRows);
+  }
+  if (skewSplitter_ != nullptr) {
+    appendSkewReplicaEntries(serializeStartRow, numRows, replicatedRows);
   }
 
   output_.reset();
@@ -472,6 +530,11 @@ void MaterializedOutput::flushBatch() {
     }
   }
 
+  if (skewSplitter_ != nullptr) {
+    // Samples the partition sizes of all the drivers of the task.
+    skewSplitter_->updateSizes(buffer_->partitionBytes());
+  }
+
   // Reset accumulated state.
   rowOffsets_.clear();
   rowSizes_.clear();
@@ -507,6 +570,14 @@ void MaterializedOutput::recordBufferStats() {
   for (const auto& [key, metric] : buffer_->stats()) {
     addRuntimeStat(key, velox::RuntimeCounter(metric.sum, metric.unit));
   }
+  if (skewSplitter_ != nullptr && skewSplitter_->numSplitPartitions() > 0) {
+    addRuntimeStat(
+        std::string(SkewedPartitionSplitter::kSplitPartitions),
+        velox::RuntimeCounter(skewSplitter_->numSplitPartitions()));
+    addRuntimeStat(
+        std::string(SkewedPartitionSplitter::kSaltedRows),
+        velox::RuntimeCounter(skewSplitter_->numSaltedRows()));
+  }
 }
 
 void MaterializedOutput::close() {
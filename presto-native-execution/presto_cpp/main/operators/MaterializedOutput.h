@@ -14,6 +14,7 @@
 #pragma once
 
 #include "presto_cpp/main/operators/MaterializedOutputBuffer.h"
+#include "presto_cpp/main/operators/SkewedPartitionSplitter.h"
 #include "velox/core/Expressions.h"
 #include "velox/core/PlanNode.h"
 #include "velox/exec/Operator.h"
@@ -41,7 +42,8 @@ class MaterializedOutputNode : public velox::core::PlanNode {
           partitionFunctionSpec,
       bool replicateNullsAndAny,
       ShuffleWriterMetadata shuffleWriterMetadata,
-      velox::core::PlanNodePtr source)
+      velox::core::PlanNodePtr source,
+      SkewSplitSpec skewSplit = {})
       : velox::core::PlanNode(id),
         numPartitions_(numPartitions),
         keys_(std::move(keys)),
@@ -49,7 +51,8 @@ class MaterializedOutputNode : public velox::core::PlanNode {
         partitionFunctionSpec_(std::move(partitionFunctionSpec)),
         replicateNullsAndAny_(replicateNullsAndAny),
         shuffleWriterMetadata_(std::move(shuffleWriterMetadata)),
-        sources_{std::move(source)} {}
+        sources_{std::move(source)},
+        skewSplit_(skewSplit) {}
 
   std::string_view name() const override {
     return "MaterializedOutput";
@@ -75,6 +78,12 @@ class MaterializedOutputNode : public velox::core::PlanNode {
     return shuffleWriterMetadata_;
   }
 
+  /// How partitions much larger than the others are split across
+  /// destinations.
+  const SkewSplitSpec& skewSplit() const {
+    return skewSplit_;
+  }
+
   const velox::RowTypePtr& outputType() const override {
     return outputType_;
   }
@@ -92,6 +101,9 @@ class MaterializedOutputNode : public velox::core::PlanNode {
  private:
   void addDetails(std::stringstream& stream) const override {
     stream << numPartitions_;
+    if (skewSplit_.enabled()) {
+      stream << " skew split: " << skewSplit_.toString();
+    }
   }
 
   const int numPartitions_;
@@ -102,6 +114,7 @@ class MaterializedOutputNode : public velox::core::PlanNode {
   const bool replicateNullsAndAny_;
   const ShuffleWriterMetadata shuffleWriterMetadata_;
   const std::vector<velox::core::PlanNodePtr> sources_;
+  const SkewSplitSpec skewSplit_;
 };
 
 class MaterializedOutput : public velox::exec::Operator {
@@ -142,7 +155,8 @@ class MaterializedOutput : public velox::exec::Operator {
   // reached.
   void flushBatch();
 
-  // Assign partition IDs for all rows using the partition function.
+  // Assign partition IDs for all rows using the partition function. Rows of
+  // partitions split by 'skewSplitter_' are salted.
   void computePartitions(const velox::RowVector& rawInput, int32_t numRows);
 
   // Serialize all rows into the flat buffer using CompactRow. Dispatches
@@ -189,8 +203,19 @@ class MaterializedOutput : public velox::exec::Operator {
       int32_t serializeStartRow,
       const std::vector<int32_t>& rowsToExpand);
 
-  // Orchestrates selectRowsToReplicate + appendReplicaEntries.
-  void expandReplicateRows(int32_t serializeStartRow, int32_t numInputRows);
+  // Orchestrates selectRowsToReplicate + appendReplicaEntries. Returns the
+  // rows that were replicated to all destinations in ascending order.
+  std::vector<int32_t> expandReplicateRows(
+      int32_t serializeStartRow,
+      int32_t numInputRows);
+
+  // In SkewSplitMode::kReplicate, appends entries that write each row of a
+  // skewed partition to the other destinations of its partition, except for
+  // 'replicatedRows' that already go to all destinations.
+  void appendSkewReplicaEntries(
+      int32_t serializeStartRow,
+      int32_t numInputRows,
+      const std::vector<int32_t>& replicatedRows);
 
   // Immutable config — declaration order must match constructor init order.
   const int32_t numDestinations_;
@@ -199,6 +224,8 @@ class MaterializedOutput : public velox::exec::Operator {
   std::unique_ptr<velox::core::PartitionFunction> partitionFunction_;
   const bool replicateNullsAndAny_;
   const std::shared_ptr<MaterializedOutputBuffer> buffer_;
+  // Set if the node splits skewed partitions.
+  std::unique_ptr<SkewedPartitionSplitter> skewSplitter_;
 
   // Flush threshold: clamp(numPartitions * kDefaultAvgRowSize, 1MB, 10MB).
   int64_t targetSizeInBytes_;
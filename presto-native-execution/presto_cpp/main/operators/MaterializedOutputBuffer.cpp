@@ -162,7 +162,8 @@ MaterializedOutputBuffer::MaterializedOutputBuffer(
           std::make_unique<Reclaimer>(this))),
       writer_(
           shuffleWriterFactory->createWriter(shuffleWriterInfo, pool_.get())),
-      collectCountPerPartition_(numPartitions) {
+      collectCountPerPartition_(numPartitions),
+      enqueuedBytesPerPartition_(numPartitions) {
   initPartitionBuffers(numPartitions);
 }
 
@@ -208,6 +209,7 @@ void MaterializedOutputBuffer::enqueue(
   VELOX_CHECK_EQ(state_, State::kActive, "enqueue called after noMoreData()");
 
   auto rowGroupBytes = static_cast<int64_t>(rowGroup->computeChainDataLength());
+  enqueuedBytesPerPartition_[partition] += rowGroupBytes;
   auto currentBytes = (bufferedBytes_ += rowGroupBytes);
   int64_t peak = peakBufferedBytes_;
   while (currentBytes > peak &&
@@ -245,6 +247,14 @@ void MaterializedOutputBuffer::flushToWriter(
   ++collectCountPerPartition_[partition];
 }
 
+std::vector<int64_t> MaterializedOutputBuffer::partitionBytes() const {
+  std::vector<int64_t> bytes(numPartitions_);
+  for (int32_t i = 0; i < numPartitions_; ++i) {
+    bytes[i] = enqueuedBytesPerPartition_[i];
+  }
+  return bytes;
+}
+
 void MaterializedOutputBuffer::updateDrainStats(int64_t drainedBytes) {
   ++drainCount_;
   drainedBytes_ += drainedBytes;
@@ -408,8 +418,11 @@ MaterializedOutputBuffer::stats() const {
 
   // Buffer stats with typed units.
   int64_t totalCollects = 0;
+  int64_t maxPartitionBytes = 0;
   for (int32_t i = 0; i < numPartitions_; ++i) {
     totalCollects += collectCountPerPartition_[i];
+    maxPartitionBytes =
+        std::max<int64_t>(maxPartitionBytes, enqueuedBytesPerPartition_[i]);
   }
   result[std::string(kDrainedBytes)] =
       velox::RuntimeMetric(drainedBytes_, Unit::kBytes);
@@ -426,6 +439,8 @@ MaterializedOutputBuffer::stats() const {
   result[std::string(kReclaimCount)] = velox::RuntimeMetric(reclaimCount_);
   result[std::string(kReclaimedBytes)] =
       velox::RuntimeMetric(reclaimedBytes_, Unit::kBytes);
+  result[std::string(kMaxPartitionBytes)] =
+      velox::RuntimeMetric(maxPartitionBytes, Unit::kBytes);
   return result;
 }
 
@@ -78,6 +78,8 @@ class MaterializedOutputBuffer {
       "materializedOutputBuffer.reclaimCount";
   static constexpr std::string_view kReclaimedBytes =
       "materializedOutputBuffer.reclaimedBytes";
+  static constexpr std::string_view kMaxPartitionBytes =
+      "materializedOutputBuffer.maxPartitionBytes";
 
   /// Memory reclaimer for the exchange writer pool. Nested inside
   /// MaterializedOutputBuffer so the raw back-pointer is always valid — the
@@ -213,6 +215,10 @@ class MaterializedOutputBuffer {
     return numPartitions_;
   }
 
+  /// Returns the bytes enqueued for each partition so far by all the
+  /// MaterializedOutput drivers of the task.
+  std::vector<int64_t> partitionBytes() const;
+
   velox::memory::MemoryPool* pool() const {
     return pool_.get();
   }
@@ -302,6 +308,7 @@ class MaterializedOutputBuffer {
   std::atomic_int64_t reclaimedBytes_{0};
   std::atomic_int64_t lastLoggedDrainedGB_{0};
   std::vector<std::atomic<int64_t>> collectCountPerPartition_;
+  std::vector<std::atomic<int64_t>> enqueuedBytesPerPartition_;
 
   // Process-wide registry of buffers keyed by taskId, following the same
   // pattern as Velox OutputBufferManager. Buffer creation is done under
@@ -84,6 +84,11 @@ class PartitionAndSerializeOperator : public Operator {
         sortingOrders_(planNode->sortingOrders()),
         sortingKeys_(planNode->sortingKeys()),
         sorted_(sortingOrders_ && sortingKeys_) {
+    if (planNode->skewSplit().enabled() && numPartitions_ > 1) {
+      skewSplitter_ = std::make_unique<SkewedPartitionSplitter>(
+          planNode->skewSplit(), numPartitions_);
+      destinationBytes_.resize(numPartitions_, 0);
+    }
     // Ensure that sortingOrders and sortingKeys cannot be set without each
     // other.
     VELOX_CHECK(
@@ -182,6 +187,10 @@ class PartitionAndSerializeOperator : public Operator {
           std::move(childrenVectors));
     }
 
+    if (skewSplitter_ != nullptr && skewSplitter_->replicates()) {
+      outputBatch = replicateToSubPartitions(outputBatch);
+    }
+
     nextOutputRow_ = endOutputRow;
     if (nextOutputRow_ == input_->size()) {
       input_ = nullptr;
@@ -189,6 +198,22 @@ class PartitionAndSerializeOperator : public Operator {
     return outputBatch;
   }
 
+  void close() override {
+    if (skewSplitter_ != nullptr) {
+      auto lockedStats = stats_.wlock();
+      lockedStats->addRuntimeStat(
+          std::string(SkewedPartitionSplitter::kSplitPartitions),
+          RuntimeCounter(skewSplitter_->numSplitPartitions()));
+      lockedStats->addRuntimeStat(
+          std::string(SkewedPartitionSplitter::kSaltedRows),
+          RuntimeCounter(skewSplitter_->numSaltedRows()));
+      lockedStats->addRuntimeStat(
+          std::string(SkewedPartitionSplitter::kReplicatedRows),
+          RuntimeCounter(numReplicatedRows_));
+    }
+    Operator::close();
+  }
+
   BlockingReason isBlocked(ContinueFuture* future) override {
     return BlockingReason::kNotBlocked;
   }
@@ -312,11 +337,84 @@ class PartitionAndSerializeOperator : public Operator {
       }
     }
 
+    if (skewSplitter_ != nullptr) {
+      splitSkewedPartitions();
+    }
+
     // TODO Avoid copy.
     auto rawPartitions = partitionsVector.mutableRawValues();
     ::memcpy(rawPartitions, partitions_.data(), sizeof(int32_t) * numInput);
   }
 
+  // Spreads the rows of oversized partitions over their sub-partitions in
+  // SkewSplitMode::kSalt and accounts the bytes written to each destination.
+  // Partition sizes are sampled from the rows this operator has written so
+  // far, so a partition is only split from the next input on.
+  void splitSkewedPartitions() {
+    const auto numInput = input_->size();
+    if (skewSplitter_->spec().mode == SkewSplitMode::kSalt) {
+      skewSplitter_->salt(partitions_.data(), numInput);
+    }
+    for (auto i = 0; i < numInput; ++i) {
+      destinationBytes_[partitions_[i]] += rowSizes_[i];
+    }
+    skewSplitter_->updateSizes(destinationBytes_);
+  }
+
+  // Returns 'batch' with each row of a skewed partition written to all the
+  // destinations of its partition in SkewSplitMode::kReplicate. Rows of other
+  // partitions and rows flagged for replication to all partitions are kept as
+  // is. The key, data and replicate columns are wrapped in a dictionary
+  // rather than copied.
+  RowVectorPtr replicateToSubPartitions(const RowVectorPtr& batch) {
+    const auto numRows = batch->size();
+    const auto* partitions = batch->childAt(0)->as<SimpleVector<int32_t>>();
+    const auto* replicate = replicateNullsAndAny_
+        ? batch->childAt(3)->as<SimpleVector<bool>>()
+        : nullptr;
+    const auto numCopies = [&](vector_size_t row) -> uint32_t {
+      if (replicate != nullptr && replicate->valueAt(row)) {
+        return 1;
+      }
+      return skewSplitter_->numReplicas(partitions->valueAt(row));
+    };
+
+    vector_size_t size = 0;
+    for (vector_size_t row = 0; row < numRows; ++row) {
+      size += numCopies(row);
+    }
+    if (size == numRows) {
+      return batch;
+    }
+
+    auto indices = allocateIndices(size, pool());
+    auto* rawIndices = indices->asMutable<vector_size_t>();
+    auto partitionVector =
+        BaseVector::create<FlatVector<int32_t>>(INTEGER(), size, pool());
+    auto* rawPartitions = partitionVector->mutableRawValues();
+    vector_size_t next = 0;
+    for (vector_size_t row = 0; row < numRows; ++row) {
+      const auto partition = partitions->valueAt(row);
+      const auto copies = numCopies(row);
+      for (uint32_t i = 0; i < copies; ++i) {
+        rawIndices[next] = row;
+        rawPartitions[next] = skewSplitter_->destination(partition, i);
+        ++next;
+      }
+    }
+    numReplicatedRows_ += size - numRows;
+
+    std::vector<VectorPtr> children;
+    children.reserve(batch->childrenSize());
+    children.push_back(std::move(partitionVector));
+    for (auto i = 1; i < batch->childrenSize(); ++i) {
+      children.push_back(BaseVector::wrapInDictionary(
+          nullptr, indices, size, batch->childAt(i)));
+    }
+    return std::make_shared<RowVector>(
+        pool(), outputType_, nullptr, size, std::move(children));
+  }
+
   RowVectorPtr reorderInputsIfNeeded() {
     if (serializedColumnIndices_.empty()) {
       return input_;
@@ -384,14 +482,15 @@ class PartitionAndSerializeOperator : public Operator {
     binarySortableSerializer_ = std::make_unique<BinarySortableSerializer>(
         input_, sortingOrders_.value(), sortingKeys_.value());
 
-    // Calculate sort key size for each row.
+    // Calculate sort key size for each row, key column by key column.
     const auto numInput = input_->size();
-    sortKeySizes_.resize(numInput);
+    sortKeySizes_.assign(numInput, 0);
+    sortKeySizePointers_.resize(numInput);
     for (auto i = 0; i < numInput; ++i) {
-      const size_t keySize =
-          binarySortableSerializer_->serializedSizeInBytes(i);
-      sortKeySizes_[i] = keySize;
+      sortKeySizePointers_[i] = &sortKeySizes_[i];
     }
+    binarySortableSerializer_->serializedSizeInBytes(
+        0, numInput, sortKeySizePointers_.data(), scratch_);
   }
 
   void serializeKeys(
@@ -405,17 +504,37 @@ class PartitionAndSerializeOperator : public Operator {
     VELOX_CHECK_NOT_NULL(binarySortableSerializer_);
     const vector_size_t batchSize = to - from;
 
-    // Serialize keys.
-    // Note: avoid reallocating memory for keyVectorBuffer by setting
-    // initialCapacity to be keyBufferSize.
-    auto keyVectorBuffer = std::make_unique<velox::StringVectorBuffer>(
-        &keyVector,
-        /*initialCapacity=*/keyBufferSize,
-        /*maxCapacity=*/keyBufferSize);
-    for (size_t row = 0; row < batchSize; ++row) {
-      binarySortableSerializer_->serialize(from + row, keyVectorBuffer.get());
-      keyVectorBuffer->flushRow(row);
-      VELOX_CHECK_EQ(keyVector.valueAt(row).size(), sortKeySizes_[from + row]);
+    // Allocate memory for all the keys and lay them out back to back.
+    auto buffer = keyVector.getBufferWithSpace(keyBufferSize);
+    auto* rawBuffer = buffer->asMutable<char>() + buffer->size();
+    buffer->setSize(buffer->size() + keyBufferSize);
+
+    ScratchPtr<char*, 1> rowBuffersHolder(scratch_);
+    auto* rowBuffers = rowBuffersHolder.get(batchSize);
+    size_t offset = 0;
+    for (auto row = 0; row < batchSize; ++row) {
+      rowBuffers[row] = rawBuffer + offset;
+      offset += sortKeySizes_[from + row];
+    }
+    VELOX_CHECK_EQ(offset, keyBufferSize);
+
+    // Serialize keys key column by key column, then verify each key filled
+    // exactly the space reserved for it by serializedSizeInBytes().
+    ScratchPtr<char*, 1> rowEndsHolder(scratch_);
+    auto* rowEnds = rowEndsHolder.get(batchSize);
+    binarySortableSerializer_->serialize(
+        from, batchSize, rowBuffers, &sortKeySizes_[from], scratch_, rowEnds);
+    size_t writtenBytes = 0;
+    for (auto row = 0; row < batchSize; ++row) {
+      const size_t keySize = rowEnds[row] - rowBuffers[row];
+      VELOX_DCHECK_EQ(
+          keySize, static_cast<size_t>(sortKeySizes_[from + row]));
+      writtenBytes += keySize;
+    }
+    VELOX_CHECK_EQ(writtenBytes, keyBufferSize);
+    for (auto row = 0; row < batchSize; ++row) {
+      keyVector.setNoCopy(
+          row, StringView(rowBuffers[row], sortKeySizes_[from + row]));
     }
   }
 
@@ -428,6 +547,11 @@ class PartitionAndSerializeOperator : public Operator {
   const std::optional<std::vector<velox::core::FieldAccessTypedExprPtr>>
       sortingKeys_;
   const bool sorted_;
+  // Set if the node splits skewed partitions.
+  std::unique_ptr<SkewedPartitionSplitter> skewSplitter_;
+  // Bytes written to each destination. Only maintained with 'skewSplitter_'.
+  std::vector<int64_t> destinationBytes_;
+  int64_t numReplicatedRows_{0};
   bool replicatedAny_{false};
   std::vector<column_index_t> serializedColumnIndices_;
   // Holder for partitionVector and replicateVector.
@@ -442,7 +566,10 @@ class PartitionAndSerializeOperator : public Operator {
   // Reusable vector for storing serialised row size for each input row.
   std::vector<uint32_t> rowSizes_;
   // Reusable vector for storing sort key buffer size for each input row.
-  std::vector<size_t> sortKeySizes_;
+  std::vector<vector_size_t> sortKeySizes_;
+  // Pointers to 'sortKeySizes_' for the batched size calculation.
+  std::vector<vector_size_t*> sortKeySizePointers_;
+  Scratch scratch_;
   vector_size_t nextOutputRow_{0};
 };
 } // namespace
@@ -479,6 +606,9 @@ void PartitionAndSerializeNode::addDetails(std::stringstream& stream) const {
   }
   stream << ") " << numPartitions_ << " " << partitionFunctionSpec_->toString()
          << " " << serializedRowType_->toString();
+  if (skewSplit_.enabled()) {
+    stream << " skew split: " << skewSplit_.toString();
+  }
 }
 
 folly::dynamic PartitionAndSerializeNode::serialize() const {
@@ -495,6 +625,9 @@ folly::dynamic PartitionAndSerializeNode::serialize() const {
   if (sortingKeys_) {
     obj["sortingKeys"] = ISerializable::serialize(sortingKeys_.value());
   }
+  if (skewSplit_.enabled()) {
+    obj["skewSplit"] = skewSplit_.serialize();
+  }
   return obj;
 }
 
@@ -511,6 +644,10 @@ velox::core::PlanNodePtr PartitionAndSerializeNode::create(
   if (obj.count("sortingKeys")) {
     sortingKeys = deserializeFields(obj["sortingKeys"], context);
   }
+  SkewSplitSpec skewSplit;
+  if (obj.count("skewSplit")) {
+    skewSplit = SkewSplitSpec::create(obj["skewSplit"]);
+  }
   return std::make_shared<PartitionAndSerializeNode>(
       deserializePlanNodeId(obj),
       ISerializable::deserialize<std::vector<velox::core::ITypedExpr>>(
@@ -523,6 +660,7 @@ velox::core::PlanNodePtr PartitionAndSerializeNode::create(
       ISerializable::deserialize<velox::core::PartitionFunctionSpec>(
           obj["partitionFunctionSpec"], context),
       sortingOrders,
-      sortingKeys);
+      sortingKeys,
+      skewSplit);
 }
 } // namespace facebook::presto::operators
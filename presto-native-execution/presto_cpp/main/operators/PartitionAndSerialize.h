@@ -13,6 +13,7 @@
  */
 #pragma once
 
+#include "presto_cpp/main/operators/SkewedPartitionSplitter.h"
 #include "velox/core/PlanNode.h"
 #include "velox/exec/Operator.h"
 
@@ -23,7 +24,8 @@ namespace facebook::presto::operators {
 /// number (INTEGER) serialized key (VARBINARY), and serialized row (VARBINARY).
 /// If 'replicateNullsAndAny' is true, the output includes a third boolean
 /// column which indicates whether a row needs to be replicated to all
-/// partitions.
+/// partitions. If 'skewSplit' is enabled, partitions much larger than the
+/// others are spread over several destinations (see SkewedPartitionSplitter).
 class PartitionAndSerializeNode : public velox::core::PlanNode {
  public:
   PartitionAndSerializeNode(
@@ -37,7 +39,8 @@ class PartitionAndSerializeNode : public velox::core::PlanNode {
       std::optional<std::vector<velox::core::SortOrder>> sortingOrders =
           std::nullopt,
       std::optional<std::vector<velox::core::FieldAccessTypedExprPtr>>
-          sortingKeys = std::nullopt)
+          sortingKeys = std::nullopt,
+      SkewSplitSpec skewSplit = {})
       : velox::core::PlanNode(id),
         keys_(std::move(keys)),
         numPartitions_(numPartitions),
@@ -46,9 +49,13 @@ class PartitionAndSerializeNode : public velox::core::PlanNode {
         replicateNullsAndAny_(replicateNullsAndAny && numPartitions > 1),
         partitionFunctionSpec_(std::move(partitionFunctionFactory)),
         sortingOrders_(std::move(sortingOrders)),
-        sortingKeys_(std::move(sortingKeys)) {
+        sortingKeys_(std::move(sortingKeys)),
+        skewSplit_(skewSplit) {
     VELOX_USER_CHECK_NOT_NULL(
         partitionFunctionSpec_, "Partition function factory cannot be null.");
+    VELOX_USER_CHECK(
+        skewSplit_.mode != SkewSplitMode::kSalt || !sortingKeys_.has_value(),
+        "Sorted shuffle cannot salt skewed partitions");
   }
 
   class Builder {
@@ -65,6 +72,7 @@ class PartitionAndSerializeNode : public velox::core::PlanNode {
       partitionFunctionFactory_ = other.partitionFunctionFactory();
       sortingOrders_ = other.sortingOrders();
       sortingKeys_ = other.sortingKeys();
+      skewSplit_ = other.skewSplit();
     }
 
     Builder& id(velox::core::PlanNodeId id) {
@@ -116,6 +124,11 @@ class PartitionAndSerializeNode : public velox::core::PlanNode {
       return *this;
     }
 
+    Builder& skewSplit(SkewSplitSpec skewSplit) {
+      skewSplit_ = skewSplit;
+      return *this;
+    }
+
     std::shared_ptr<PartitionAndSerializeNode> build() const {
       VELOX_USER_CHECK(
           id_.has_value(), "PartitionAndSerializeNode id is not set");
@@ -145,7 +158,8 @@ class PartitionAndSerializeNode : public velox::core::PlanNode {
           replicateNullsAndAny_.value(),
           partitionFunctionFactory_.value(),
           sortingOrders_,
-          sortingKeys_);
+          sortingKeys_,
+          skewSplit_);
     }
 
    private:
@@ -160,6 +174,7 @@ class PartitionAndSerializeNode : public velox::core::PlanNode {
     std::optional<std::vector<velox::core::SortOrder>> sortingOrders_;
     std::optional<std::vector<velox::core::FieldAccessTypedExprPtr>>
         sortingKeys_;
+    SkewSplitSpec skewSplit_;
   };
 
   folly::dynamic serialize() const override;
@@ -227,6 +242,12 @@ class PartitionAndSerializeNode : public velox::core::PlanNode {
     return sortingOrders_;
   }
 
+  /// How partitions much larger than the others are split across
+  /// destinations.
+  const SkewSplitSpec& skewSplit() const {
+    return skewSplit_;
+  }
+
  private:
   void addDetails(std::stringstream& stream) const override;
 
@@ -239,6 +260,7 @@ class PartitionAndSerializeNode : public velox::core::PlanNode {
   const std::optional<std::vector<velox::core::SortOrder>> sortingOrders_;
   const std::optional<std::vector<velox::core::FieldAccessTypedExprPtr>>
       sortingKeys_;
+  const SkewSplitSpec skewSplit_;
 };
 
 class PartitionAndSerializeTranslator
@@ -37,7 +37,16 @@ ShuffleRead::ShuffleRead(
               shuffleReadNode->outputType(),
               "CompactRow"),
           exchangeClient,
-          "ShuffleRead") {
+          "ShuffleRead"),
+      deserializer_(shuffleReadNode->serializedType()) {
+  if (shuffleReadNode->filter() != nullptr ||
+      shuffleReadNode->serializedType()->size() != outputType_->size()) {
+    pushdown_ = std::make_unique<ShuffleReadPushdown>(
+        shuffleReadNode->serializedType(),
+        outputType_,
+        shuffleReadNode->filter(),
+        operatorCtx_->execCtx());
+  }
   initStats();
 }
 
@@ -52,28 +61,34 @@ void ShuffleRead::initStats() {
 
 void ShuffleRead::resetOutputState() {
   currentPages_.clear();
-  rows_.clear();
+  deserializer_.clear();
   pageRows_.clear();
   nextRow_ = 0;
   nextPage_ = 0;
 }
 
+RowVectorPtr ShuffleRead::deserializeRows(vector_size_t numRows) {
+  if (pushdown_ != nullptr) {
+    return pushdown_->read(deserializer_, nextRow_, numRows, pool());
+  }
+  return deserializer_.deserialize(nextRow_, numRows, pool());
+}
+
 RowVectorPtr ShuffleRead::getOutput() {
   if (currentPages_.empty()) {
     return nullptr;
   }
 
   SCOPE_EXIT {
-    if (nextRow_ == rows_.size()) {
+    if (nextRow_ == deserializer_.numRows()) {
       VELOX_CHECK_EQ(nextPage_, currentPages_.size());
       resetOutputState();
     }
   };
 
   uint64_t rawInputBytes{0};
-  if (rows_.empty()) {
+  if (deserializer_.numRows() == 0) {
     VELOX_CHECK_EQ(nextRow_, 0);
-    size_t numRows{0};
     for (const auto& page : currentPages_) {
       auto* batch = checkedPointerCast<ShuffleSerializedPage>(page.get());
       VELOX_CHECK_LE(batch->size(), std::numeric_limits<int32_t>::max());
@@ -81,15 +96,13 @@ RowVectorPtr ShuffleRead::getOutput() {
       const auto pageRows = page->numRows().value();
       pageRows_.emplace_back(
           (pageRows_.empty() ? 0 : pageRows_.back()) + pageRows);
-      numRows += pageRows;
     }
-    rows_.reserve(numRows);
     const int32_t driverId = operatorCtx()->driverCtx()->driverId;
     for (const auto& page : currentPages_) {
       auto* batch = checkedPointerCast<ShuffleSerializedPage>(page.get());
       const auto& rows = batch->rows(driverId);
       for (const auto& row : rows) {
-        rows_.emplace_back(row);
+        deserializer_.addRow(row);
       }
     }
     if (!currentPages_.empty()) {
@@ -97,8 +110,9 @@ RowVectorPtr ShuffleRead::getOutput() {
       ++numInputBatches_;
     }
   }
-  VELOX_CHECK_LE(nextRow_, rows_.size());
-  if (rows_.empty()) {
+  const size_t numRows = deserializer_.numRows();
+  VELOX_CHECK_LE(nextRow_, numRows);
+  if (numRows == 0) {
     return nullptr;
   }
 
@@ -108,34 +122,35 @@ RowVectorPtr ShuffleRead::getOutput() {
         (preferredOutputBatchBytes_ / estimatedRowSize_.value()),
         kInitialOutputRows);
   }
-  numOutputRows = std::min<uint64_t>(numOutputRows, rows_.size() - nextRow_);
 
   uint64_t decodeTimeNs{0};
+  result_ = nullptr;
   {
     velox::NanosecondTimer timer(&decodeTimeNs);
-    // Create a view of the rows to deserialize from nextRow_ to nextRow_ +
-    // numOutputRows.
-    if (numOutputRows == rows_.size()) {
-      result_ = row::CompactRow::deserialize(rows_, outputType_, pool());
-    } else {
-      std::vector<std::string_view> outputRows(
-          rows_.begin() + nextRow_, rows_.begin() + nextRow_ + numOutputRows);
-      result_ = row::CompactRow::deserialize(outputRows, outputType_, pool());
+    // Deserializes batches of up to 'numOutputRows' rows until one has rows
+    // that pass the filter.
+    while (result_ == nullptr && nextRow_ < numRows) {
+      const auto batchRows =
+          std::min<uint64_t>(numOutputRows, numRows - nextRow_);
+      result_ = deserializeRows(batchRows);
+      nextRow_ += batchRows;
     }
   }
   runtimeStats_[kShuffleDecodeTime].addValue(decodeTimeNs);
 
-  nextRow_ += numOutputRows;
   for (; nextPage_ < currentPages_.size(); ++nextPage_) {
     if (pageRows_[nextPage_] > nextRow_) {
       break;
     }
     currentPages_[nextPage_].reset();
   }
+  recordInputStats(rawInputBytes);
+  if (result_ == nullptr) {
+    return nullptr;
+  }
   estimatedRowSize_ = std::max(
-      result_->estimateFlatSize() / numOutputRows,
+      result_->estimateFlatSize() / result_->size(),
       estimatedRowSize_.value_or(1L));
-  recordInputStats(rawInputBytes);
   return result_;
 }
 
@@ -152,20 +167,42 @@ void ShuffleRead::close() {
     lockedStats->addRuntimeStat(
         kShuffleInputBatches, RuntimeCounter(numInputBatches_));
   }
+  if (pushdown_ != nullptr && pushdown_->numFilteredRows() != 0) {
+    lockedStats->addRuntimeStat(
+        kShuffleFilteredRows, RuntimeCounter(pushdown_->numFilteredRows()));
+  }
 }
 
 folly::dynamic ShuffleReadNode::serialize() const {
   auto obj = PlanNode::serialize();
   obj["outputType"] = outputType_->serialize();
+  if (serializedType_ != outputType_) {
+    obj["serializedType"] = serializedType_->serialize();
+  }
+  if (filter_ != nullptr) {
+    obj["filter"] = filter_->serialize();
+  }
   return obj;
 }
 
 velox::core::PlanNodePtr ShuffleReadNode::create(
     const folly::dynamic& obj,
     void* context) {
+  RowTypePtr serializedType;
+  if (obj.count("serializedType")) {
+    serializedType =
+        ISerializable::deserialize<RowType>(obj["serializedType"], context);
+  }
+  core::TypedExprPtr filter;
+  if (obj.count("filter")) {
+    filter =
+        ISerializable::deserialize<core::ITypedExpr>(obj["filter"], context);
+  }
   return std::make_shared<ShuffleReadNode>(
       deserializePlanNodeId(obj),
-      ISerializable::deserialize<RowType>(obj["outputType"], context));
+      ISerializable::deserialize<RowType>(obj["outputType"], context),
+      std::move(serializedType),
+      std::move(filter));
 }
 
 std::unique_ptr<Operator> ShuffleReadTranslator::toOperator(
@@ -13,6 +13,7 @@
  */
 #pragma once
 
+#include "presto_cpp/main/operators/ShuffleReadPushdown.h"
 #include "velox/core/PlanNode.h"
 #include "velox/exec/Exchange.h"
 #include "velox/exec/Operator.h"
@@ -20,8 +21,22 @@
 namespace facebook::presto::operators {
 class ShuffleReadNode : public velox::core::PlanNode {
  public:
-  ShuffleReadNode(const velox::core::PlanNodeId& id, velox::RowTypePtr type)
-      : PlanNode(id), outputType_(type) {}
+  /// @param type Output type. A subset of the columns of 'serializedType'.
+  /// @param serializedType Type of the rows in the shuffle. Same as 'type' if
+  /// null.
+  /// @param filter Filter over the columns of 'serializedType' that the rows
+  /// must pass to be returned. May be null.
+  ShuffleReadNode(
+      const velox::core::PlanNodeId& id,
+      velox::RowTypePtr type,
+      velox::RowTypePtr serializedType = nullptr,
+      velox::core::TypedExprPtr filter = nullptr)
+      : PlanNode(id),
+        outputType_(type),
+        serializedType_(serializedType ? std::move(serializedType) : type),
+        filter_(std::move(filter)) {
+    checkShuffleReadPushdown(serializedType_, outputType_, filter_);
+  }
 
   class Builder {
    public:
@@ -30,6 +45,8 @@ class ShuffleReadNode : public velox::core::PlanNode {
     explicit Builder(const ShuffleReadNode& other) {
       id_ = other.id();
       outputType_ = other.outputType();
+      serializedType_ = other.serializedType();
+      filter_ = other.filter();
     }
 
     Builder& id(velox::core::PlanNodeId id) {
@@ -42,18 +59,30 @@ class ShuffleReadNode : public velox::core::PlanNode {
       return *this;
     }
 
+    Builder& serializedType(velox::RowTypePtr serializedType) {
+      serializedType_ = std::move(serializedType);
+      return *this;
+    }
+
+    Builder& filter(velox::core::TypedExprPtr filter) {
+      filter_ = std::move(filter);
+      return *this;
+    }
+
     std::shared_ptr<ShuffleReadNode> build() const {
       VELOX_USER_CHECK(id_.has_value(), "ShuffleReadNode id is not set");
       VELOX_USER_CHECK(
           outputType_.has_value(), "ShuffleReadNode outputType is not set");
 
       return std::make_shared<ShuffleReadNode>(
-          id_.value(), outputType_.value());
+          id_.value(), outputType_.value(), serializedType_, filter_);
     }
 
    private:
     std::optional<velox::core::PlanNodeId> id_;
     std::optional<velox::RowTypePtr> outputType_;
+    velox::RowTypePtr serializedType_;
+    velox::core::TypedExprPtr filter_;
   };
 
   folly::dynamic serialize() const override;
@@ -66,6 +95,14 @@ class ShuffleReadNode : public velox::core::PlanNode {
     return outputType_;
   }
 
+  const velox::RowTypePtr& serializedType() const {
+    return serializedType_;
+  }
+
+  const velox::core::TypedExprPtr& filter() const {
+    return filter_;
+  }
+
   const std::vector<velox::core::PlanNodePtr>& sources() const override {
     static const std::vector<velox::core::PlanNodePtr> kEmptySources;
     return kEmptySources;
@@ -85,10 +122,14 @@ class ShuffleReadNode : public velox::core::PlanNode {
 
  private:
   void addDetails(std::stringstream& stream) const override {
-    // Nothing to add
+    if (filter_ != nullptr) {
+      stream << "filter: " << filter_->toString();
+    }
   }
 
   const velox::RowTypePtr outputType_;
+  const velox::RowTypePtr serializedType_;
+  const velox::core::TypedExprPtr filter_;
 };
 
 class ShuffleRead : public velox::exec::Exchange {
@@ -107,6 +148,7 @@ class ShuffleRead : public velox::exec::Exchange {
   static inline const std::string kShufflePagesPerInputBatch{
       "shuffleNumPagesPerInputBatch"};
   static inline const std::string kShuffleInputBatches{"shuffleInputBatches"};
+  static inline const std::string kShuffleFilteredRows{"shuffleFilteredRows"};
 
  protected:
   velox::VectorSerde* getSerde() override {
@@ -118,13 +160,21 @@ class ShuffleRead : public velox::exec::Exchange {
 
   void resetOutputState();
 
+  // Returns the next batch of at most 'numRows' rows starting at 'nextRow_'.
+  // Returns nullptr if no row passes the filter.
+  velox::RowVectorPtr deserializeRows(velox::vector_size_t numRows);
+
   int64_t numInputBatches_{0};
   std::unordered_map<std::string, velox::RuntimeMetric> runtimeStats_;
 
+  // Set if a column subset or a filter is pushed into the node.
+  std::unique_ptr<ShuffleReadPushdown> pushdown_;
+
   size_t nextRow_{0};
   size_t nextPage_{0};
+  // Rows of the current pages.
+  CompactRowBatchDeserializer deserializer_;
   // Reusable buffers.
-  std::vector<std::string_view> rows_;
   std::vector<size_t> pageRows_;
 };
 
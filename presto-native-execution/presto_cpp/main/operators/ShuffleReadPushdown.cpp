@@ -0,0 +1,236 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/operators/ShuffleReadPushdown.h"
+
+#include <algorithm>
+
+#include "velox/expression/EvalCtx.h"
+
+using namespace facebook::velox;
+
+namespace facebook::presto::operators {
+
+void collectInputColumns(
+    const core::TypedExprPtr& expr,
+    folly::F14FastSet<std::string>& names) {
+  if (auto field =
+          std::dynamic_pointer_cast<const core::FieldAccessTypedExpr>(expr)) {
+    if (field->isInputColumn()) {
+      names.insert(field->name());
+      return;
+    }
+  }
+  if (auto lambda =
+          std::dynamic_pointer_cast<const core::LambdaTypedExpr>(expr)) {
+    // The lambda arguments are not input columns. A column shadowed by an
+    // argument inside the body is not read there either.
+    folly::F14FastSet<std::string> bodyNames;
+    collectInputColumns(lambda->body(), bodyNames);
+    for (const auto& argument : lambda->signature()->names()) {
+      bodyNames.erase(argument);
+    }
+    names.insert(bodyNames.begin(), bodyNames.end());
+    return;
+  }
+  for (const auto& input : expr->inputs()) {
+    collectInputColumns(input, names);
+  }
+}
+
+void checkShuffleReadPushdown(
+    const RowTypePtr& serializedType,
+    const RowTypePtr& outputType,
+    const core::TypedExprPtr& filter) {
+  for (column_index_t i = 0; i < outputType->size(); ++i) {
+    const auto& name = outputType->nameOf(i);
+    const auto channel = serializedType->getChildIdxIfExists(name);
+    VELOX_USER_CHECK(
+        channel.has_value(),
+        "Shuffle read output column {} is not in the serialized row type {}",
+        name,
+        serializedType->toString());
+    VELOX_USER_CHECK(
+        serializedType->childAt(channel.value())
+            ->equivalent(*outputType->childAt(i)),
+        "Shuffle read output column {} has type {} instead of {}",
+        name,
+        outputType->childAt(i)->toString(),
+        serializedType->childAt(channel.value())->toString());
+  }
+  if (filter == nullptr) {
+    return;
+  }
+  VELOX_USER_CHECK(
+      filter->type()->isBoolean(),
+      "Shuffle read filter must be boolean: {}",
+      filter->toString());
+  folly::F14FastSet<std::string> names;
+  collectInputColumns(filter, names);
+  for (const auto& name : names) {
+    VELOX_USER_CHECK(
+        serializedType->containsChild(name),
+        "Shuffle read filter column {} is not in the serialized row type {}",
+        name,
+        serializedType->toString());
+  }
+}
+
+ShuffleReadPushdown::ShuffleReadPushdown(
+    const RowTypePtr& serializedType,
+    RowTypePtr outputType,
+    const core::TypedExprPtr& filter,
+    core::ExecCtx* execCtx)
+    : outputType_(std::move(outputType)), execCtx_(execCtx) {
+  outputChannels_.reserve(outputType_->size());
+  for (const auto& name : outputType_->names()) {
+    outputChannels_.push_back(serializedType->getChildIdx(name));
+  }
+  if (filter == nullptr) {
+    return;
+  }
+
+  filter_ = std::make_unique<exec::ExprSet>(
+      std::vector<core::TypedExprPtr>{filter}, execCtx_);
+  folly::F14FastSet<std::string> filterColumns;
+  collectInputColumns(filter, filterColumns);
+  std::vector<std::string> names;
+  std::vector<TypePtr> types;
+  for (column_index_t i = 0; i < serializedType->size(); ++i) {
+    if (filterColumns.contains(serializedType->nameOf(i))) {
+      filterChannels_.push_back(i);
+      names.push_back(serializedType->nameOf(i));
+      types.push_back(serializedType->childAt(i));
+    }
+  }
+  filterInputType_ = ROW(std::move(names), std::move(types));
+
+  outputToFilterInput_.resize(outputChannels_.size(), -1);
+  for (column_index_t i = 0; i < outputChannels_.size(); ++i) {
+    const auto it = std::find(
+        filterChannels_.begin(), filterChannels_.end(), outputChannels_[i]);
+    if (it != filterChannels_.end()) {
+      outputToFilterInput_[i] = it - filterChannels_.begin();
+    } else {
+      otherOutputColumns_.push_back(i);
+      otherOutputChannels_.push_back(outputChannels_[i]);
+    }
+  }
+  allChannels_ = filterChannels_;
+  allChannels_.insert(
+      allChannels_.end(),
+      otherOutputChannels_.begin(),
+      otherOutputChannels_.end());
+}
+
+RowVectorPtr ShuffleReadPushdown::read(
+    const CompactRowBatchDeserializer& deserializer,
+    vector_size_t offset,
+    vector_size_t numRows,
+    memory::MemoryPool* pool) {
+  if (filter_ == nullptr) {
+    return std::make_shared<RowVector>(
+        pool,
+        outputType_,
+        nullptr,
+        numRows,
+        deserializer.deserializeColumns(
+            offset, numRows, outputChannels_, nullptr, pool));
+  }
+
+  // If a filter column is not at a fixed offset, the filter step decodes the
+  // rows in full. The other output columns are then taken from that same
+  // decode instead of decoding the passing rows a second time.
+  const bool singlePass = std::any_of(
+      filterChannels_.begin(), filterChannels_.end(), [&](auto channel) {
+        return !deserializer.hasFixedOffset(channel);
+      });
+  auto columns = deserializer.deserializeColumns(
+      offset,
+      numRows,
+      singlePass ? allChannels_ : filterChannels_,
+      nullptr,
+      pool);
+  std::vector<VectorPtr> otherColumns;
+  if (singlePass) {
+    otherColumns.assign(
+        std::make_move_iterator(columns.begin() + filterChannels_.size()),
+        std::make_move_iterator(columns.end()));
+    columns.resize(filterChannels_.size());
+  }
+  auto filterInput = std::make_shared<RowVector>(
+      pool, filterInputType_, nullptr, numRows, std::move(columns));
+  evaluateFilter(filterInput);
+  const vector_size_t numPassingRows = passingRows_.size();
+  numFilteredRows_ += numRows - numPassingRows;
+  if (numPassingRows == 0) {
+    return nullptr;
+  }
+
+  const bool allRowsPass = numPassingRows == numRows;
+  if (!singlePass) {
+    otherColumns = deserializer.deserializeColumns(
+        offset,
+        numRows,
+        otherOutputChannels_,
+        allRowsPass ? nullptr : &passingRows_,
+        pool);
+  }
+  BufferPtr indices;
+  if (!allRowsPass) {
+    indices = allocateIndices(numPassingRows, pool);
+    std::copy(
+        passingRows_.begin(),
+        passingRows_.end(),
+        indices->asMutable<vector_size_t>());
+  }
+  // Wraps a column of all 'numRows' rows in a dictionary of the passing rows.
+  const auto selectPassingRows = [&](const VectorPtr& column) {
+    return allRowsPass ? column
+                       : BaseVector::wrapInDictionary(
+                             nullptr, indices, numPassingRows, column);
+  };
+
+  std::vector<VectorPtr> children(outputType_->size());
+  for (column_index_t i = 0; i < otherOutputColumns_.size(); ++i) {
+    children[otherOutputColumns_[i]] = singlePass
+        ? selectPassingRows(otherColumns[i])
+        : std::move(otherColumns[i]);
+  }
+  for (column_index_t i = 0; i < children.size(); ++i) {
+    if (outputToFilterInput_[i] >= 0) {
+      children[i] =
+          selectPassingRows(filterInput->childAt(outputToFilterInput_[i]));
+    }
+  }
+  return std::make_shared<RowVector>(
+      pool, outputType_, nullptr, numPassingRows, std::move(children));
+}
+
+void ShuffleReadPushdown::evaluateFilter(const RowVectorPtr& input) {
+  const auto numRows = input->size();
+  filterRows_.resizeFill(numRows, true);
+  exec::EvalCtx evalCtx(execCtx_, filter_.get(), input.get());
+  filter_->eval(filterRows_, evalCtx, filterResult_);
+  decodedFilterResult_.decode(*filterResult_[0], filterRows_);
+
+  passingRows_.clear();
+  for (vector_size_t row = 0; row < numRows; ++row) {
+    if (!decodedFilterResult_.isNullAt(row) &&
+        decodedFilterResult_.valueAt<bool>(row)) {
+      passingRows_.push_back(row);
+    }
+  }
+}
+
+} // namespace facebook::presto::operators
@@ -0,0 +1,105 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <folly/container/F14Set.h>
+
+#include "presto_cpp/main/operators/CompactRowBatchDeserializer.h"
+#include "velox/core/Expressions.h"
+#include "velox/expression/Expr.h"
+#include "velox/vector/DecodedVector.h"
+
+namespace facebook::presto::operators {
+
+/// Adds the names of the input columns 'expr' reads to 'names'. Lambda
+/// arguments are not input columns and are not added.
+void collectInputColumns(
+    const velox::core::TypedExprPtr& expr,
+    folly::F14FastSet<std::string>& names);
+
+/// Checks that the columns pushed into a shuffle read are valid. Every column
+/// of 'outputType' and every column 'filter' reads must be a column of
+/// 'serializedType' with the same type. 'filter' may be null.
+void checkShuffleReadPushdown(
+    const velox::RowTypePtr& serializedType,
+    const velox::RowTypePtr& outputType,
+    const velox::core::TypedExprPtr& filter);
+
+/// Produces the output of ShuffleRead and MaterializedExchange when a column
+/// subset or a filter is pushed into them.
+///
+/// Only the output columns and the columns the filter reads are deserialized.
+/// The filter columns, typically join or grouping keys, are deserialized and
+/// evaluated first. The other output columns are then only deserialized for
+/// the rows that pass. If a filter column is not at a fixed offset in the
+/// rows, evaluating the filter already deserializes the rows in full, so all
+/// columns are taken from that pass and the passing rows are selected by a
+/// dictionary.
+class ShuffleReadPushdown {
+ public:
+  /// @param serializedType Type of the serialized rows.
+  /// @param outputType Subset of the columns of 'serializedType' to return.
+  /// @param filter Filter over the columns of 'serializedType'. May be null.
+  ShuffleReadPushdown(
+      const velox::RowTypePtr& serializedType,
+      velox::RowTypePtr outputType,
+      const velox::core::TypedExprPtr& filter,
+      velox::core::ExecCtx* execCtx);
+
+  /// Returns the output for rows [offset, offset + numRows) of
+  /// 'deserializer'. Returns nullptr if no row passes the filter.
+  velox::RowVectorPtr read(
+      const CompactRowBatchDeserializer& deserializer,
+      velox::vector_size_t offset,
+      velox::vector_size_t numRows,
+      velox::memory::MemoryPool* pool);
+
+  /// Number of rows dropped by the filter.
+  uint64_t numFilteredRows() const {
+    return numFilteredRows_;
+  }
+
+ private:
+  // Evaluates the filter on 'input' and sets 'passingRows_' to the rows that
+  // pass.
+  void evaluateFilter(const velox::RowVectorPtr& input);
+
+  const velox::RowTypePtr outputType_;
+  velox::core::ExecCtx* const execCtx_;
+  // Columns of the serialized rows that are returned, in output order.
+  std::vector<velox::column_index_t> outputChannels_;
+
+  // Set if there is a filter.
+  std::unique_ptr<velox::exec::ExprSet> filter_;
+  // Columns of the serialized rows the filter reads and their type.
+  std::vector<velox::column_index_t> filterChannels_;
+  velox::RowTypePtr filterInputType_;
+  // For each output column, its index in 'filterChannels_' or -1.
+  std::vector<int32_t> outputToFilterInput_;
+  // Output columns that the filter does not read.
+  std::vector<velox::column_index_t> otherOutputColumns_;
+  std::vector<velox::column_index_t> otherOutputChannels_;
+  // 'filterChannels_' followed by 'otherOutputChannels_'.
+  std::vector<velox::column_index_t> allChannels_;
+
+  // Reusable buffers.
+  velox::SelectivityVector filterRows_;
+  std::vector<velox::VectorPtr> filterResult_;
+  velox::DecodedVector decodedFilterResult_;
+  std::vector<velox::vector_size_t> passingRows_;
+
+  uint64_t numFilteredRows_{0};
+};
+
+} // namespace facebook::presto::operators
@@ -0,0 +1,169 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/operators/SkewedPartitionSplitter.h"
+
+#include <fmt/format.h>
+#include <folly/String.h>
+#include <algorithm>
+#include <cmath>
+
+#include "velox/common/base/Exceptions.h"
+
+namespace facebook::presto::operators {
+
+std::string skewSplitModeName(SkewSplitMode mode) {
+  switch (mode) {
+    case SkewSplitMode::kNone:
+      return "NONE";
+    case SkewSplitMode::kSalt:
+      return "SALT";
+    case SkewSplitMode::kReplicate:
+      return "REPLICATE";
+  }
+  VELOX_UNREACHABLE();
+}
+
+SkewSplitMode skewSplitModeFromName(const std::string& name) {
+  if (name == "NONE") {
+    return SkewSplitMode::kNone;
+  }
+  if (name == "SALT") {
+    return SkewSplitMode::kSalt;
+  }
+  if (name == "REPLICATE") {
+    return SkewSplitMode::kReplicate;
+  }
+  VELOX_USER_FAIL("Unknown skew split mode: {}", name);
+}
+
+folly::dynamic SkewSplitSpec::serialize() const {
+  folly::dynamic obj = folly::dynamic::object;
+  obj["mode"] = skewSplitModeName(mode);
+  obj["maxSubPartitions"] = maxSubPartitions;
+  obj["skewFactor"] = skewFactor;
+  obj["minPartitionBytes"] = minPartitionBytes;
+  folly::dynamic partitions = folly::dynamic::array;
+  for (auto partition : skewedPartitions) {
+    partitions.push_back(partition);
+  }
+  obj["skewedPartitions"] = std::move(partitions);
+  return obj;
+}
+
+SkewSplitSpec SkewSplitSpec::create(const folly::dynamic& obj) {
+  SkewSplitSpec spec;
+  spec.mode = skewSplitModeFromName(obj["mode"].asString());
+  spec.maxSubPartitions = obj["maxSubPartitions"].asInt();
+  spec.skewFactor = obj["skewFactor"].asDouble();
+  spec.minPartitionBytes = obj["minPartitionBytes"].asInt();
+  if (obj.count("skewedPartitions") != 0) {
+    for (const auto& partition : obj["skewedPartitions"]) {
+      spec.skewedPartitions.push_back(partition.asInt());
+    }
+  }
+  return spec;
+}
+
+std::string SkewSplitSpec::toString() const {
+  return fmt::format(
+      "{} maxSubPartitions: {}, skewFactor: {}, minPartitionBytes: {}, "
+      "skewedPartitions: [{}]",
+      skewSplitModeName(mode),
+      maxSubPartitions,
+      skewFactor,
+      minPartitionBytes,
+      folly::join(", ", skewedPartitions));
+}
+
+SkewedPartitionSplitter::SkewedPartitionSplitter(
+    const SkewSplitSpec& spec,
+    uint32_t numPartitions)
+    : spec_(spec),
+      numPartitions_(numPartitions),
+      maxSubPartitions_(std::clamp<uint32_t>(
+          spec.maxSubPartitions,
+          1,
+          std::max<uint32_t>(numPartitions, 1))),
+      skewed_(numPartitions, false),
+      subPartitions_(numPartitions, 1),
+      nextSubPartition_(numPartitions, 0) {
+  VELOX_USER_CHECK_GT(numPartitions_, 0);
+  VELOX_USER_CHECK_GT(spec_.skewFactor, 0);
+  VELOX_USER_CHECK(
+      spec_.mode == SkewSplitMode::kNone || !spec_.skewedPartitions.empty(),
+      "Skew split requires the list of skewed partitions");
+  for (auto partition : spec_.skewedPartitions) {
+    VELOX_USER_CHECK_LT(partition, numPartitions_, "Invalid skewed partition");
+    skewed_[partition] = true;
+  }
+}
+
+void SkewedPartitionSplitter::updateSizes(
+    const std::vector<int64_t>& destinationBytes) {
+  VELOX_CHECK_EQ(destinationBytes.size(), numPartitions_);
+  if (spec_.mode != SkewSplitMode::kSalt || maxSubPartitions_ == 1) {
+    return;
+  }
+  int64_t totalBytes{0};
+  for (auto bytes : destinationBytes) {
+    totalBytes += bytes;
+  }
+  const auto threshold = std::max<double>(
+      spec_.minPartitionBytes,
+      spec_.skewFactor * totalBytes / numPartitions_);
+  if (threshold <= 0) {
+    return;
+  }
+  for (auto partition : spec_.skewedPartitions) {
+    const auto bytes = destinationBytes[partition];
+    if (bytes <= threshold) {
+      continue;
+    }
+    const auto numSubPartitions = std::min<uint32_t>(
+        maxSubPartitions_,
+        static_cast<uint32_t>(std::ceil(bytes / threshold)));
+    if (numSubPartitions > subPartitions_[partition]) {
+      if (subPartitions_[partition] == 1) {
+        ++numSplitPartitions_;
+      }
+      subPartitions_[partition] = numSubPartitions;
+    }
+  }
+}
+
+void SkewedPartitionSplitter::salt(
+    uint32_t* partitions,
+    velox::vector_size_t numRows) {
+  VELOX_CHECK(spec_.mode == SkewSplitMode::kSalt);
+  if (numSplitPartitions_ == 0) {
+    return;
+  }
+  for (velox::vector_size_t row = 0; row < numRows; ++row) {
+    const auto partition = partitions[row];
+    const auto numSubPartitions = subPartitions_[partition];
+    if (numSubPartitions == 1) {
+      continue;
+    }
+    auto& next = nextSubPartition_[partition];
+    if (next != 0) {
+      partitions[row] = destination(partition, next);
+      ++numSaltedRows_;
+    }
+    if (++next == numSubPartitions) {
+      next = 0;
+    }
+  }
+}
+
+} // namespace facebook::presto::operators
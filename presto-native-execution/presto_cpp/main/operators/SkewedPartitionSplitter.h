@@ -0,0 +1,163 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <folly/dynamic.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "velox/vector/TypeAliases.h"
+
+namespace facebook::presto::operators {
+
+/// How a shuffle write splits partitions that are much larger than the
+/// others.
+enum class SkewSplitMode : uint8_t {
+  /// Partitions are never split.
+  kNone,
+  /// The rows of an oversized skewed partition are spread over several
+  /// destinations. Only valid for the probe side of an inner or left join
+  /// whose build side uses kReplicate. Consumers that need all the rows of a
+  /// key in one destination, e.g. aggregations, right or full joins and
+  /// sorted shuffles, must not read a salted side.
+  kSalt,
+  /// The rows of the skewed partitions are written to all the destinations a
+  /// salted side may spread these partitions over. The rows of the other
+  /// partitions are written once.
+  kReplicate,
+};
+
+std::string skewSplitModeName(SkewSplitMode mode);
+
+SkewSplitMode skewSplitModeFromName(const std::string& name);
+
+/// Skew splitting settings of PartitionAndSerializeNode and
+/// MaterializedOutputNode.
+struct SkewSplitSpec {
+  SkewSplitMode mode{SkewSplitMode::kNone};
+
+  /// Maximum number of destinations a partition is spread over. Both sides of
+  /// a join must use the same value.
+  uint32_t maxSubPartitions{4};
+
+  /// Partitions a salted side may split and a replicated side replicates,
+  /// e.g. the partitions of the heavy hitter keys found by the coordinator.
+  /// Both sides of a join must use the same list. Required unless 'mode' is
+  /// kNone.
+  std::vector<uint32_t> skewedPartitions;
+
+  /// A partition is oversized once it has more than 'skewFactor' times the
+  /// average partition size and at least 'minPartitionBytes'.
+  double skewFactor{4.0};
+  int64_t minPartitionBytes{64L << 20};
+
+  bool enabled() const {
+    return mode != SkewSplitMode::kNone;
+  }
+
+  folly::dynamic serialize() const;
+
+  static SkewSplitSpec create(const folly::dynamic& obj);
+
+  std::string toString() const;
+};
+
+/// Maps the partitions computed by the partition function of a shuffle write
+/// to destinations according to a SkewSplitSpec.
+///
+/// Sub-partition j of partition p is written to destination (p + j) %
+/// numPartitions. Only the partitions listed in the 'skewedPartitions' of the
+/// spec have sub-partitions. In kSalt mode, the number of sub-partitions of a
+/// skewed partition starts at 1 and grows with the sampled size of the
+/// partition up to 'maxSubPartitions', and the rows of a split partition are
+/// assigned to its sub-partitions round-robin. Only rows written after a
+/// partition is split are spread. In kReplicate mode, each row of a skewed
+/// partition p is written to all of the 'maxSubPartitions' destinations of p,
+/// so that the matching rows of a salted side are found wherever they are
+/// read. The rows of the other partitions are written once.
+///
+/// The list of skewed partitions is the split metadata shared by both sides:
+/// a join reading destination d finds the salted probe rows of a skewed
+/// partition together with all the build rows of that partition, so readers
+/// need no merge step and read the rows written to them as regular rows.
+class SkewedPartitionSplitter {
+ public:
+  SkewedPartitionSplitter(const SkewSplitSpec& spec, uint32_t numPartitions);
+
+  /// Updates the number of sub-partitions of each partition from the bytes
+  /// written to each destination so far. Partitions are never merged back.
+  void updateSizes(const std::vector<int64_t>& destinationBytes);
+
+  /// Replaces the partitions of split partitions in 'partitions' by the
+  /// destination of the next sub-partition. kSalt mode only.
+  void salt(uint32_t* partitions, velox::vector_size_t numRows);
+
+  /// True if the rows of the skewed partitions are written to more than one
+  /// destination in kReplicate mode.
+  bool replicates() const {
+    return spec_.mode == SkewSplitMode::kReplicate && maxSubPartitions_ > 1;
+  }
+
+  /// Number of destinations each row of 'partition' is written to.
+  uint32_t numReplicas(uint32_t partition) const {
+    return replicates() && skewed_[partition] ? maxSubPartitions_ : 1;
+  }
+
+  /// Destination of sub-partition 'subPartition' of 'partition'.
+  uint32_t destination(uint32_t partition, uint32_t subPartition) const {
+    const auto destination = partition + subPartition;
+    return destination < numPartitions_ ? destination
+                                        : destination - numPartitions_;
+  }
+
+  const SkewSplitSpec& spec() const {
+    return spec_;
+  }
+
+  /// Number of sub-partitions of each partition.
+  const std::vector<uint32_t>& subPartitions() const {
+    return subPartitions_;
+  }
+
+  /// Number of partitions split into more than one sub-partition.
+  int64_t numSplitPartitions() const {
+    return numSplitPartitions_;
+  }
+
+  /// Number of rows written to another destination than their partition.
+  int64_t numSaltedRows() const {
+    return numSaltedRows_;
+  }
+
+  /// Runtime stat names.
+  static constexpr std::string_view kSplitPartitions{"skewSplitPartitions"};
+  static constexpr std::string_view kSaltedRows{"skewSaltedRows"};
+  static constexpr std::string_view kReplicatedRows{"skewReplicatedRows"};
+
+ private:
+  const SkewSplitSpec spec_;
+  const uint32_t numPartitions_;
+  const uint32_t maxSubPartitions_;
+
+  // True for the partitions listed in 'skewedPartitions' of 'spec_'.
+  std::vector<bool> skewed_;
+  std::vector<uint32_t> subPartitions_;
+  // Next sub-partition of each partition.
+  std::vector<uint32_t> nextSubPartition_;
+  int64_t numSplitPartitions_{0};
+  int64_t numSaltedRows_{0};
+};
+
+} // namespace facebook::presto::operators
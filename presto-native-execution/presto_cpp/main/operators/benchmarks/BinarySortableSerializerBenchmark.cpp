@@ -58,6 +58,35 @@ class BinarySortableSerializerBenchmark {
     VELOX_CHECK_EQ(outputVec_->size(), data_->size());
   }
 
+  void serializeColumnar() {
+    BinarySortableSerializer binarySortableSerializer(
+        data_, ordering_, fields_);
+    const auto numRows = data_->size();
+    std::vector<vector_size_t> sizes(numRows, 0);
+    std::vector<vector_size_t*> sizePointers(numRows);
+    for (vector_size_t i = 0; i < numRows; ++i) {
+      sizePointers[i] = &sizes[i];
+    }
+    velox::Scratch scratch;
+    binarySortableSerializer.serializedSizeInBytes(
+        0, numRows, sizePointers.data(), scratch);
+    const size_t bufferSize = std::accumulate(sizes.begin(), sizes.end(), 0L);
+
+    auto buffer = outputVec_->getBufferWithSpace(bufferSize);
+    auto* rawBuffer = buffer->asMutable<char>() + buffer->size();
+    buffer->setSize(buffer->size() + bufferSize);
+    std::vector<char*> rowBuffers(numRows);
+    for (vector_size_t i = 0; i < numRows; ++i) {
+      rowBuffers[i] = rawBuffer;
+      rawBuffer += sizes[i];
+    }
+    binarySortableSerializer.serialize(
+        0, numRows, rowBuffers.data(), sizes.data(), scratch);
+    for (vector_size_t i = 0; i < numRows; ++i) {
+      outputVec_->setNoCopy(i, StringView(rowBuffers[i], sizes[i]));
+    }
+  }
+
   void calculateSerializedSize() {
     BinarySortableSerializer binarySortableSerializer(
         data_, ordering_, fields_);
@@ -204,6 +233,223 @@ BENCHMARK_COUNTERS_RELATIVE(decimalsSerializeWithSizeCalculation, counters) {
   counters["memUsage"] = benchmark.pool()->stats().usedBytes;
 }
 
+BENCHMARK_COUNTERS_RELATIVE(decimalsSerializeColumnar, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), DECIMAL(12, 2), DECIMAL(38, 18)}), ordering);
+
+  benchmark.serializeColumnar();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
+BENCHMARK_DRAW_TEXT("=============Serialize fixed width=============");
+
+BENCHMARK(fixedWidthSizeCalculation) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.calculateSerializedSize();
+}
+
+BENCHMARK_RELATIVE(fixedWidthSizeCalculationBatched) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.calculateSerializedSizeBatched();
+}
+
+BENCHMARK_COUNTERS(fixedWidthSerialize, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.serializeWithStringVectorBuffer();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
+BENCHMARK_COUNTERS_RELATIVE(fixedWidthSerializeWithSizeCalculation, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.serializeWithSizeCalculation();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
+BENCHMARK_COUNTERS_RELATIVE(fixedWidthSerializeColumnar, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.serializeColumnar();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
+BENCHMARK_DRAW_TEXT("=============Serialize fixed width desc=============");
+
+BENCHMARK(fixedWidthDescendingSizeCalculation) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.calculateSerializedSize();
+}
+
+BENCHMARK_RELATIVE(fixedWidthDescendingSizeCalculationBatched) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.calculateSerializedSizeBatched();
+}
+
+BENCHMARK_COUNTERS(fixedWidthDescendingSerialize, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.serializeWithStringVectorBuffer();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
+BENCHMARK_COUNTERS_RELATIVE(
+    fixedWidthDescendingSerializeWithSizeCalculation,
+    counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.serializeWithSizeCalculation();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
+BENCHMARK_COUNTERS_RELATIVE(fixedWidthDescendingSerializeColumnar, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast),
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), INTEGER(), SMALLINT(), DOUBLE(), REAL()}), ordering);
+
+  benchmark.serializeColumnar();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
+BENCHMARK_DRAW_TEXT("=============Serialize string descending=============");
+
+BENCHMARK(stringDescendingSizeCalculation) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(ROW({VARCHAR()}), ordering);
+
+  benchmark.calculateSerializedSize();
+}
+
+BENCHMARK_RELATIVE(stringDescendingSizeCalculationBatched) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(ROW({VARCHAR()}), ordering);
+
+  benchmark.calculateSerializedSizeBatched();
+}
+
+BENCHMARK_COUNTERS(stringDescendingSerialize, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(ROW({VARCHAR()}), ordering);
+
+  benchmark.serializeWithStringVectorBuffer();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
+BENCHMARK_COUNTERS_RELATIVE(
+    stringDescendingSerializeWithSizeCalculation,
+    counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(ROW({VARCHAR()}), ordering);
+
+  benchmark.serializeWithSizeCalculation();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
+BENCHMARK_COUNTERS_RELATIVE(stringDescendingSerializeColumnar, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(ROW({VARCHAR()}), ordering);
+
+  benchmark.serializeColumnar();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
 BENCHMARK_DRAW_TEXT("=============Serialize string1=============");
 
 BENCHMARK(string1SizeCalculation) {
@@ -252,6 +498,18 @@ BENCHMARK_COUNTERS_RELATIVE(string1SerializeWithSizeCalculation, counters) {
   counters["memUsage"] = benchmark.pool()->stats().usedBytes;
 }
 
+BENCHMARK_COUNTERS_RELATIVE(string1SerializeColumnar, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kDescNullsFirst)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), VARCHAR()}), ordering);
+
+  benchmark.serializeColumnar();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
 BENCHMARK_DRAW_TEXT("=============Serialize string5=============");
 
 BENCHMARK(strings5SizeCalculation) {
@@ -320,6 +578,23 @@ BENCHMARK_COUNTERS_RELATIVE(strings5SerializeWithSizeCalculation, counters) {
   counters["memUsage"] = benchmark.pool()->stats().usedBytes;
 }
 
+BENCHMARK_COUNTERS_RELATIVE(strings5SerializeColumnar, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsLast),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsLast),
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), VARCHAR(), VARCHAR(), VARCHAR(), VARCHAR(), VARCHAR()}),
+      ordering);
+
+  benchmark.serializeColumnar();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
 BENCHMARK_DRAW_TEXT("=============Serialize array=============");
 
 BENCHMARK(arraysSizeCalculation) {
@@ -368,6 +643,18 @@ BENCHMARK_COUNTERS_RELATIVE(arraysSerializeWithSizeCalculation, counters) {
   counters["memUsage"] = benchmark.pool()->stats().usedBytes;
 }
 
+BENCHMARK_COUNTERS_RELATIVE(arraysSerializeColumnar, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsFirst)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), ARRAY(BIGINT())}), ordering);
+
+  benchmark.serializeColumnar();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
 BENCHMARK_DRAW_TEXT("=============Serialize nested array=============");
 
 BENCHMARK(nestedArraysSizeCalculation) {
@@ -418,6 +705,18 @@ BENCHMARK_COUNTERS_RELATIVE(
   counters["memUsage"] = benchmark.pool()->stats().usedBytes;
 }
 
+BENCHMARK_COUNTERS_RELATIVE(nestedArraysSerializeColumnar, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kAscNullsFirst),
+      velox::core::SortOrder(velox::core::kAscNullsLast)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), ARRAY(ARRAY(BIGINT()))}), ordering);
+
+  benchmark.serializeColumnar();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
 BENCHMARK_DRAW_TEXT("=============Serialize struct=============");
 
 BENCHMARK(structsSizeCalculation) {
@@ -470,6 +769,19 @@ BENCHMARK_COUNTERS_RELATIVE(structsSerializeWithSizeCalculation, counters) {
   counters["memUsage"] = benchmark.pool()->stats().usedBytes;
 }
 
+BENCHMARK_COUNTERS_RELATIVE(structsSerializeColumnar, counters) {
+  const auto ordering = {
+      velox::core::SortOrder(velox::core::kDescNullsFirst),
+      velox::core::SortOrder(velox::core::kDescNullsFirst)};
+
+  BinarySortableSerializerBenchmark benchmark(
+      ROW({BIGINT(), ROW({BIGINT(), DOUBLE(), BOOLEAN(), TINYINT(), REAL()})}),
+      ordering);
+
+  benchmark.serializeColumnar();
+  counters["memUsage"] = benchmark.pool()->stats().usedBytes;
+}
+
 } // namespace
 } // namespace facebook::presto::operators
 
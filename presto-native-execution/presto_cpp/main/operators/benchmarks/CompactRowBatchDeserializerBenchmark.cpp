@@ -0,0 +1,155 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the time to deserialize a page of fixed-width CompactRow rows in
+// the framing written by MaterializedOutput:
+//
+//   rowViews: splits the page into one view per row and calls
+//       CompactRow::deserialize(), as MaterializedExchange did before
+//       CompactRowBatchDeserializer.
+//   batchDeserializer: CompactRowBatchDeserializer::deserialize().
+
+#include <folly/Benchmark.h>
+#include <folly/init/Init.h>
+#include <folly/lang/Bits.h>
+
+#include "presto_cpp/main/operators/CompactRowBatchDeserializer.h"
+#include "velox/row/CompactRow.h"
+#include "velox/serializers/RowSerializer.h"
+#include "velox/vector/fuzzer/VectorFuzzer.h"
+
+using namespace facebook::velox;
+
+namespace facebook::presto::operators {
+namespace {
+
+constexpr vector_size_t kNumRows = 100'000;
+constexpr vector_size_t kRowsPerGroup = 1'000;
+constexpr vector_size_t kBatchSize = 10'000;
+
+class CompactRowBatchDeserializerBenchmark {
+ public:
+  CompactRowBatchDeserializerBenchmark() {
+    folly::BenchmarkSuspender suspender;
+    VectorFuzzer::Options options;
+    options.vectorSize = kNumRows;
+    options.nullRatio = 0.1;
+    VectorFuzzer fuzzer(options, pool_.get(), 1);
+    auto data = fuzzer.fuzzInputFlatRow(
+        ROW({BIGINT(), INTEGER(), DOUBLE(), SMALLINT(), BOOLEAN()}));
+    rowType_ = asRowType(data->type());
+    page_ = serializeRowGroups(data);
+  }
+
+  void deserializeRowViews() {
+    std::vector<std::string_view> rows;
+    splitRows(rows);
+    for (vector_size_t offset = 0; offset < kNumRows; offset += kBatchSize) {
+      auto result = row::CompactRow::deserialize(
+          std::vector<std::string_view>(
+              rows.begin() + offset, rows.begin() + offset + kBatchSize),
+          rowType_,
+          pool_.get());
+      folly::doNotOptimizeAway(result);
+    }
+  }
+
+  void deserializeBatch() {
+    CompactRowBatchDeserializer deserializer(rowType_);
+    deserializer.addPage(page_);
+    for (vector_size_t offset = 0; offset < kNumRows; offset += kBatchSize) {
+      auto result = deserializer.deserialize(offset, kBatchSize, pool_.get());
+      folly::doNotOptimizeAway(result);
+    }
+  }
+
+ private:
+  // Serializes 'data' in the RowGroupHeader + TRowSize framing written by
+  // MaterializedOutput.
+  static std::string serializeRowGroups(const RowVectorPtr& data) {
+    row::CompactRow compactRow(data);
+    std::string page;
+    for (vector_size_t start = 0; start < data->size();
+         start += kRowsPerGroup) {
+      const auto end = std::min(start + kRowsPerGroup, data->size());
+      std::string rowGroup;
+      for (auto row = start; row < end; ++row) {
+        const uint32_t rowSize = compactRow.rowSize(row);
+        const uint32_t bigEndianRowSize = folly::Endian::big(rowSize);
+        rowGroup.append(
+            reinterpret_cast<const char*>(&bigEndianRowSize),
+            sizeof(uint32_t));
+        const auto offset = rowGroup.size();
+        rowGroup.resize(offset + rowSize);
+        compactRow.serialize(row, rowGroup.data() + offset);
+      }
+      std::string header(serializer::detail::RowGroupHeader::size(), '\0');
+      const int32_t uncompressedSize = rowGroup.size();
+      std::memcpy(header.data(), &uncompressedSize, sizeof(int32_t));
+      page += header;
+      page += rowGroup;
+    }
+    return page;
+  }
+
+  void splitRows(std::vector<std::string_view>& rows) const {
+    const auto headerSize = serializer::detail::RowGroupHeader::size();
+    const char* ptr = page_.data();
+    const char* end = page_.data() + page_.size();
+    while (ptr < end) {
+      int32_t uncompressedSize;
+      std::memcpy(&uncompressedSize, ptr, sizeof(int32_t));
+      ptr += headerSize;
+      const char* rowGroupEnd = ptr + uncompressedSize;
+      while (ptr < rowGroupEnd) {
+        uint32_t rowSize;
+        std::memcpy(&rowSize, ptr, sizeof(uint32_t));
+        rowSize = folly::Endian::big(rowSize);
+        ptr += sizeof(uint32_t);
+        rows.emplace_back(ptr, rowSize);
+        ptr += rowSize;
+      }
+    }
+  }
+
+  std::shared_ptr<memory::MemoryPool> rootPool_{
+      memory::memoryManager()->addRootPool()};
+  std::shared_ptr<memory::MemoryPool> pool_{rootPool_->addLeafChild("data")};
+  RowTypePtr rowType_;
+  std::string page_;
+};
+
+std::unique_ptr<CompactRowBatchDeserializerBenchmark> deserializerBenchmark;
+
+BENCHMARK(rowViews) {
+  deserializerBenchmark->deserializeRowViews();
+}
+
+BENCHMARK_RELATIVE(batchDeserializer) {
+  deserializerBenchmark->deserializeBatch();
+}
+
+} // namespace
+} // namespace facebook::presto::operators
+
+int main(int argc, char** argv) {
+  folly::Init init{&argc, &argv};
+  facebook::velox::memory::MemoryManager::initialize(
+      facebook::velox::memory::MemoryManager::Options{});
+  facebook::presto::operators::deserializerBenchmark = std::make_unique<
+      facebook::presto::operators::CompactRowBatchDeserializerBenchmark>();
+  folly::runBenchmarks();
+  facebook::presto::operators::deserializerBenchmark.reset();
+  return 0;
+}
@@ -0,0 +1,513 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// End-to-end shuffle benchmarks. Each iteration writes the input to a local
+// shuffle in a fresh directory and reads every partition back:
+//
+//   localShuffle: Values -> PartitionAndSerialize -> LocalPartition ->
+//       ShuffleWrite, then ShuffleRead per partition.
+//   localShuffleSorted: same with sort keys and a sorted shuffle.
+//   materializedExchange: Values -> MaterializedOutput, then
+//       MaterializedExchange per partition.
+//
+// partitionAndSerialize and partitionAndSerializeSorted run only
+// Values -> PartitionAndSerialize, without and with the sort keys c0 and c1,
+// and report rows/s and serialized bytes/s of the operator.
+//
+// The number of rows read is checked against the number of rows written.
+// Each benchmark reports rows/s and bytes/s of the write and the read, the
+// peak memory of the write and of the reads, and the number and size of the
+// shuffle files as counters. Use --bm_json_verbose=<file> to save the
+// results, counters included, as JSON for comparison across releases.
+
+#include <folly/Benchmark.h>
+#include <folly/Uri.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include <boost/range/algorithm/find_if.hpp>
+
+#include "presto_cpp/main/operators/LocalShuffle.h"
+#include "presto_cpp/main/operators/MaterializedExchange.h"
+#include "presto_cpp/main/operators/MaterializedOutput.h"
+#include "presto_cpp/main/operators/MaterializedOutputBuffer.h"
+#include "presto_cpp/main/operators/PartitionAndSerialize.h"
+#include "presto_cpp/main/operators/ShuffleExchangeSource.h"
+#include "presto_cpp/main/operators/ShuffleRead.h"
+#include "presto_cpp/main/operators/ShuffleWrite.h"
+#include "presto_cpp/main/operators/tests/PlanBuilder.h"
+#include "velox/common/file/FileSystems.h"
+#include "velox/exec/Exchange.h"
+#include "velox/exec/HashPartitionFunction.h"
+#include "velox/exec/tests/utils/Cursor.h"
+#include "velox/exec/tests/utils/PlanBuilder.h"
+#include "velox/exec/tests/utils/TempDirectoryPath.h"
+#include "velox/vector/DecodedVector.h"
+#include "velox/vector/fuzzer/VectorFuzzer.h"
+
+DEFINE_int64(shuffle_bench_rows, 1'000'000, "Number of rows to shuffle");
+DEFINE_int32(shuffle_bench_batch_rows, 10'000, "Rows per input vector");
+DEFINE_int32(shuffle_bench_partitions, 16, "Number of shuffle partitions");
+DEFINE_int32(shuffle_bench_drivers, 4, "Number of drivers of the write");
+DEFINE_string(
+    shuffle_bench_schema,
+    "mixed",
+    "Payload columns besides the INTEGER key: 'fixed' (BIGINT, DOUBLE), "
+    "'varchar' (VARCHAR, VARCHAR) or 'mixed' (BIGINT, VARCHAR, "
+    "ARRAY(BIGINT))");
+DEFINE_int32(shuffle_bench_string_length, 32, "Length of VARCHAR values");
+DEFINE_double(
+    shuffle_bench_skew,
+    0,
+    "Fraction of rows that have the same key and go to one partition");
+DEFINE_int32(
+    shuffle_bench_read_repeats,
+    1,
+    "Number of times each partition is read, to measure replays");
+DEFINE_int32(shuffle_bench_seed, 1, "Seed of the generated data");
+
+using namespace facebook::velox;
+
+namespace facebook::presto::operators {
+namespace {
+
+constexpr std::string_view kQueryId{"query_id"};
+
+std::string makeTaskId(
+    const std::string& prefix,
+    int num,
+    const std::string& shuffleInfo = "") {
+  auto url = fmt::format("batch://{}-{}", prefix, num);
+  if (shuffleInfo.empty()) {
+    return url;
+  }
+  return url + "?shuffleInfo=" + shuffleInfo;
+}
+
+// Creates a ShuffleExchangeSource for splits of the form
+// batch://...?shuffleInfo=<read info>.
+void registerExchangeSource(const std::string& shuffleName) {
+  exec::ExchangeSource::factories().clear();
+  exec::ExchangeSource::registerFactory(
+      [shuffleName](
+          const std::string& taskId,
+          int destination,
+          const std::shared_ptr<exec::ExchangeQueue>& queue,
+          memory::MemoryPool* pool) -> std::shared_ptr<exec::ExchangeSource> {
+        if (!taskId.starts_with("batch://")) {
+          return nullptr;
+        }
+        auto uri = folly::Uri(taskId);
+        auto queryParams = uri.getQueryParams();
+        auto it = boost::range::find_if(queryParams, [](const auto& pair) {
+          return pair.first == "shuffleInfo";
+        });
+        VELOX_CHECK(
+            it != queryParams.end(), "No shuffle read info in {}", taskId);
+        return std::make_shared<ShuffleExchangeSource>(
+            taskId,
+            destination,
+            queue,
+            ShuffleInterfaceFactory::factory(shuffleName)
+                ->createReader(it->second, destination, pool),
+            pool);
+      });
+}
+
+enum class ShufflePath { kLocalShuffle, kLocalShuffleSorted, kMaterialized };
+
+class ShuffleBenchmark {
+ public:
+  ShuffleBenchmark() {
+    folly::BenchmarkSuspender suspender;
+    filesystems::registerLocalFileSystem();
+    exec::Operator::registerOperator(
+        std::make_unique<PartitionAndSerializeTranslator>());
+    exec::Operator::registerOperator(
+        std::make_unique<ShuffleWriteTranslator>());
+    exec::Operator::registerOperator(std::make_unique<ShuffleReadTranslator>());
+    exec::Operator::registerOperator(
+        std::make_unique<MaterializedOutputTranslator>());
+    exec::Operator::registerOperator(
+        std::make_unique<MaterializedExchangeTranslator>());
+    shuffleName_ = std::string(LocalPersistentShuffleFactory::kShuffleName);
+    ShuffleInterfaceFactory::registerFactory(
+        shuffleName_, std::make_unique<LocalPersistentShuffleFactory>());
+    registerExchangeSource(shuffleName_);
+
+    data_ = makeData();
+    for (const auto& vector : data_) {
+      numRows_ += vector->size();
+    }
+  }
+
+  void run(ShufflePath path, folly::UserCounters& counters) {
+    folly::BenchmarkSuspender suspender;
+    auto tempDir = exec::test::TempDirectoryPath::create();
+    const auto rootPath = tempDir->getPath();
+    const bool sorted = path == ShufflePath::kLocalShuffleSorted;
+    suspender.dismiss();
+
+    const auto writeStart = std::chrono::steady_clock::now();
+    const auto writePeakBytes = path == ShufflePath::kMaterialized
+        ? writeMaterialized(rootPath)
+        : writeLocalShuffle(rootPath, sorted);
+    const auto writeNanos = elapsedNanos(writeStart);
+
+    suspender.rehire();
+    int64_t numFiles{0};
+    int64_t numBytes{0};
+    auto fileSystem = filesystems::getFileSystem(rootPath, nullptr);
+    for (const auto& file : fileSystem->list(rootPath)) {
+      ++numFiles;
+      numBytes += fileSystem->openFileForRead(file)->size();
+    }
+    suspender.dismiss();
+
+    int64_t readPeakBytes{0};
+    const auto readStart = std::chrono::steady_clock::now();
+    for (auto i = 0; i < FLAGS_shuffle_bench_read_repeats; ++i) {
+      const auto [numRowsRead, peakBytes] = read(rootPath, path);
+      VELOX_CHECK_EQ(
+          numRowsRead,
+          numRows_ * FLAGS_shuffle_bench_drivers,
+          "Rows read do not match the rows written");
+      readPeakBytes = std::max(readPeakBytes, peakBytes);
+    }
+    const auto readNanos =
+        elapsedNanos(readStart) / FLAGS_shuffle_bench_read_repeats;
+
+    const auto numRowsWritten = numRows_ * FLAGS_shuffle_bench_drivers;
+    counters["writeRowsPerSec"] = perSecond(numRowsWritten, writeNanos);
+    counters["writeBytesPerSec"] = perSecond(numBytes, writeNanos);
+    counters["readRowsPerSec"] = perSecond(numRowsWritten, readNanos);
+    counters["readBytesPerSec"] = perSecond(numBytes, readNanos);
+    counters["writePeakBytes"] = writePeakBytes;
+    counters["readPeakBytes"] = readPeakBytes;
+    counters["shuffleFiles"] = numFiles;
+    counters["shuffleBytes"] = numBytes;
+    suspender.rehire();
+  }
+
+  // Runs PartitionAndSerialize alone. The serialized rows and keys are
+  // counted but not written anywhere.
+  void runPartitionAndSerialize(bool sorted, folly::UserCounters& counters) {
+    std::optional<std::vector<core::SortOrder>> sortOrders;
+    std::optional<std::vector<core::FieldAccessTypedExprPtr>> sortKeys;
+    if (sorted) {
+      const auto type = rowType();
+      sortOrders = std::vector<core::SortOrder>{
+          core::kAscNullsFirst, core::kDescNullsLast};
+      sortKeys = std::vector<core::FieldAccessTypedExprPtr>{
+          std::make_shared<core::FieldAccessTypedExpr>(type->childAt(0), "c0"),
+          std::make_shared<core::FieldAccessTypedExpr>(
+              type->childAt(1), "c1")};
+    }
+    auto plan = exec::test::PlanBuilder()
+                    .values(data_, true)
+                    .addNode(addPartitionAndSerializeNode(
+                        FLAGS_shuffle_bench_partitions,
+                        false,
+                        {},
+                        sortOrders,
+                        sortKeys))
+                    .planNode();
+
+    exec::CursorParameters params;
+    params.planNode = plan;
+    params.queryCtx = makeQueryCtx();
+    params.maxDrivers = FLAGS_shuffle_bench_drivers;
+    const auto start = std::chrono::steady_clock::now();
+    auto [cursor, results] = exec::test::readCursor(params);
+    const auto nanos = elapsedNanos(start);
+
+    folly::BenchmarkSuspender suspender;
+    int64_t numRows{0};
+    int64_t numBytes{0};
+    for (const auto& result : results) {
+      numRows += result->size();
+      // Column 0 is the partition, the others are the serialized row and key.
+      for (auto i = 1; i < result->childrenSize(); ++i) {
+        DecodedVector decoded(*result->childAt(i));
+        for (vector_size_t row = 0; row < result->size(); ++row) {
+          numBytes += decoded.valueAt<StringView>(row).size();
+        }
+      }
+    }
+    VELOX_CHECK_EQ(numRows, numRows_ * FLAGS_shuffle_bench_drivers);
+    counters["rowsPerSec"] = perSecond(numRows, nanos);
+    counters["bytesPerSec"] = perSecond(numBytes, nanos);
+    counters["peakBytes"] = params.queryCtx->pool()->peakBytes();
+  }
+
+ private:
+  static uint64_t elapsedNanos(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+
+  static int64_t perSecond(int64_t count, uint64_t nanos) {
+    return nanos == 0 ? 0
+                      : static_cast<int64_t>(count * 1'000'000'000.0 / nanos);
+  }
+
+  RowTypePtr payloadType() const {
+    if (FLAGS_shuffle_bench_schema == "fixed") {
+      return ROW({"c1", "c2"}, {BIGINT(), DOUBLE()});
+    }
+    if (FLAGS_shuffle_bench_schema == "varchar") {
+      return ROW({"c1", "c2"}, {VARCHAR(), VARCHAR()});
+    }
+    VELOX_CHECK_EQ(
+        FLAGS_shuffle_bench_schema,
+        "mixed",
+        "Unknown --shuffle_bench_schema");
+    return ROW({"c1", "c2", "c3"}, {BIGINT(), VARCHAR(), ARRAY(BIGINT())});
+  }
+
+  // Makes the input. Column c0 is the INTEGER partition and sort key. A
+  // '--shuffle_bench_skew' fraction of the rows has key 0.
+  std::vector<RowVectorPtr> makeData() {
+    VectorFuzzer::Options options;
+    options.vectorSize = FLAGS_shuffle_bench_batch_rows;
+    options.stringLength = FLAGS_shuffle_bench_string_length;
+    options.stringVariableLength = true;
+    options.containerLength = 5;
+    options.nullRatio = 0.05;
+    VectorFuzzer fuzzer(options, pool_.get(), FLAGS_shuffle_bench_seed);
+    folly::Random::DefaultGenerator rng(FLAGS_shuffle_bench_seed);
+
+    const auto payload = payloadType();
+    std::vector<std::string> names{"c0"};
+    std::vector<TypePtr> types{INTEGER()};
+    for (auto i = 0; i < payload->size(); ++i) {
+      names.push_back(payload->nameOf(i));
+      types.push_back(payload->childAt(i));
+    }
+    const auto rowType = ROW(std::move(names), std::move(types));
+
+    std::vector<RowVectorPtr> data;
+    for (int64_t numRows = 0; numRows < FLAGS_shuffle_bench_rows;
+         numRows += FLAGS_shuffle_bench_batch_rows) {
+      const vector_size_t size = std::min<int64_t>(
+          FLAGS_shuffle_bench_batch_rows, FLAGS_shuffle_bench_rows - numRows);
+      auto keys = BaseVector::create<FlatVector<int32_t>>(
+          INTEGER(), size, pool_.get());
+      for (vector_size_t row = 0; row < size; ++row) {
+        keys->set(
+            row,
+            folly::Random::randDouble01(rng) < FLAGS_shuffle_bench_skew
+                ? 0
+                : folly::Random::rand32(rng));
+      }
+      auto payloadVector = fuzzer.fuzzInputFlatRow(payload);
+      std::vector<VectorPtr> children{keys};
+      for (auto i = 0; i < payload->size(); ++i) {
+        children.push_back(payloadVector->childAt(i)->slice(0, size));
+      }
+      data.push_back(std::make_shared<RowVector>(
+          pool_.get(), rowType, nullptr, size, std::move(children)));
+    }
+    return data;
+  }
+
+  std::shared_ptr<core::QueryCtx> makeQueryCtx() {
+    return core::QueryCtx::create(executor_.get(), core::QueryConfig({}));
+  }
+
+  RowTypePtr rowType() const {
+    return asRowType(data_[0]->type());
+  }
+
+  // Returns the peak memory of the write.
+  int64_t writeLocalShuffle(const std::string& rootPath, bool sorted) {
+    const auto numPartitions = FLAGS_shuffle_bench_partitions;
+    const auto writeInfo = LocalShuffleWriteInfo{
+        .rootPath = rootPath,
+        .queryId = std::string(kQueryId),
+        .numPartitions = static_cast<uint32_t>(numPartitions),
+        .shuffleId = 0,
+        .sortedShuffle = sorted}
+                               .serialize();
+    std::optional<std::vector<core::SortOrder>> sortOrders;
+    std::optional<std::vector<core::FieldAccessTypedExprPtr>> sortKeys;
+    if (sorted) {
+      sortOrders = std::vector<core::SortOrder>{core::kAscNullsFirst};
+      sortKeys = std::vector<core::FieldAccessTypedExprPtr>{
+          std::make_shared<core::FieldAccessTypedExpr>(INTEGER(), "c0")};
+    }
+    auto plan =
+        exec::test::PlanBuilder()
+            .values(data_, true)
+            .addNode(addPartitionAndSerializeNode(
+                numPartitions, false, {}, sortOrders, sortKeys))
+            .localPartition(std::vector<std::string>{})
+            .addNode(
+                addShuffleWriteNode(numPartitions, shuffleName_, writeInfo))
+            .planNode();
+
+    exec::CursorParameters params;
+    params.planNode = plan;
+    params.queryCtx = makeQueryCtx();
+    params.maxDrivers = FLAGS_shuffle_bench_drivers;
+    exec::test::readCursor(params);
+    return params.queryCtx->pool()->peakBytes();
+  }
+
+  // Returns the peak memory of the write, including the output buffer.
+  int64_t writeMaterialized(const std::string& rootPath) {
+    const auto numPartitions = FLAGS_shuffle_bench_partitions;
+    const auto writeInfo = LocalShuffleWriteInfo{
+        .rootPath = rootPath,
+        .queryId = std::string(kQueryId),
+        .numPartitions = static_cast<uint32_t>(numPartitions),
+        .shuffleId = 0,
+        .sortedShuffle = false}
+                               .serialize();
+    auto bufferPool = memory::memoryManager()->addRootPool();
+    auto buffer = std::make_shared<MaterializedOutputBuffer>(
+        numPartitions,
+        writeInfo,
+        ShuffleInterfaceFactory::factory(shuffleName_),
+        "shuffleBenchmark.0.0.0.0",
+        bufferPool.get());
+
+    std::vector<core::TypedExprPtr> keys{
+        std::make_shared<core::FieldAccessTypedExpr>(INTEGER(), "c0")};
+    auto plan = std::make_shared<MaterializedOutputNode>(
+        "materializedOutput",
+        keys,
+        numPartitions,
+        rowType(),
+        std::make_shared<exec::HashPartitionFunctionSpec>(
+            rowType(), std::vector<column_index_t>{0}),
+        false,
+        ShuffleWriterMetadata{},
+        exec::test::PlanBuilder().values(data_, true).planNode());
+
+    const auto taskId = makeTaskId("write", numWriteTasks_++);
+    MaterializedOutputBuffer::registerBuffer(taskId, buffer);
+    auto queryCtx = makeQueryCtx();
+    auto task = exec::Task::create(
+        taskId,
+        core::PlanFragment{plan},
+        0,
+        queryCtx,
+        exec::Task::ExecutionMode::kParallel);
+    task->start(FLAGS_shuffle_bench_drivers);
+    VELOX_CHECK(exec::test::waitForTaskCompletion(task.get(), 600'000'000));
+    MaterializedOutputBuffer::removeBuffer(taskId);
+    task.reset();
+    buffer.reset();
+    return queryCtx->pool()->peakBytes() + bufferPool->peakBytes();
+  }
+
+  // Reads all partitions. Returns the number of rows read and the largest
+  // peak memory of a read.
+  std::pair<int64_t, int64_t> read(
+      const std::string& rootPath,
+      ShufflePath path) {
+    const bool sorted = path == ShufflePath::kLocalShuffleSorted;
+    int64_t numRowsRead{0};
+    int64_t peakBytes{0};
+    for (auto partition = 0; partition < FLAGS_shuffle_bench_partitions;
+         ++partition) {
+      const auto readInfo = LocalShuffleReadInfo{
+          .rootPath = rootPath,
+          .queryId = std::string(kQueryId),
+          .partitionIds = {fmt::format("shuffle_0_0_{}", partition)},
+          .sortedShuffle = sorted}
+                                .serialize();
+      const auto type = rowType();
+      auto plan = exec::test::PlanBuilder()
+                      .addNode(
+                          path == ShufflePath::kMaterialized
+                              ? addMaterializedExchangeNode(type)
+                              : addShuffleReadNode(type))
+                      .planNode();
+
+      exec::CursorParameters params;
+      params.planNode = plan;
+      params.queryCtx = makeQueryCtx();
+      params.destination = partition;
+      auto [cursor, results] =
+          exec::test::readCursor(params, [&](exec::TaskCursor* taskCursor) {
+            if (taskCursor->noMoreSplits()) {
+              return;
+            }
+            auto& task = taskCursor->task();
+            task->addSplit(
+                "0",
+                exec::Split{std::make_shared<exec::RemoteConnectorSplit>(
+                    makeTaskId("read", partition, readInfo))});
+            task->noMoreSplits("0");
+            taskCursor->setNoMoreSplits();
+          });
+      for (const auto& result : results) {
+        numRowsRead += result->size();
+      }
+      peakBytes = std::max(peakBytes, params.queryCtx->pool()->peakBytes());
+    }
+    return {numRowsRead, peakBytes};
+  }
+
+  std::shared_ptr<memory::MemoryPool> rootPool_{
+      memory::memoryManager()->addRootPool()};
+  std::shared_ptr<memory::MemoryPool> pool_{rootPool_->addLeafChild("data")};
+  std::unique_ptr<folly::CPUThreadPoolExecutor> executor_{
+      std::make_unique<folly::CPUThreadPoolExecutor>(
+          std::thread::hardware_concurrency())};
+  std::string shuffleName_;
+  std::vector<RowVectorPtr> data_;
+  int64_t numRows_{0};
+  int32_t numWriteTasks_{0};
+};
+
+std::unique_ptr<ShuffleBenchmark> shuffleBenchmark;
+
+BENCHMARK_COUNTERS(localShuffle, counters) {
+  shuffleBenchmark->run(ShufflePath::kLocalShuffle, counters);
+}
+
+BENCHMARK_COUNTERS(localShuffleSorted, counters) {
+  shuffleBenchmark->run(ShufflePath::kLocalShuffleSorted, counters);
+}
+
+BENCHMARK_COUNTERS(materializedExchange, counters) {
+  shuffleBenchmark->run(ShufflePath::kMaterialized, counters);
+}
+
+BENCHMARK_COUNTERS(partitionAndSerialize, counters) {
+  shuffleBenchmark->runPartitionAndSerialize(false, counters);
+}
+
+BENCHMARK_COUNTERS(partitionAndSerializeSorted, counters) {
+  shuffleBenchmark->runPartitionAndSerialize(true, counters);
+}
+
+} // namespace
+} // namespace facebook::presto::operators
+
+int main(int argc, char** argv) {
+  folly::Init init{&argc, &argv};
+  facebook::velox::memory::MemoryManager::initialize(
+      facebook::velox::memory::MemoryManager::Options{});
+  facebook::presto::operators::shuffleBenchmark =
+      std::make_unique<facebook::presto::operators::ShuffleBenchmark>();
+  folly::runBenchmarks();
+  facebook::presto::operators::shuffleBenchmark.reset();
+  return 0;
+}
@@ -173,6 +173,7 @@ class BinarySortableSerializerFuzzerTest : public ::testing::Test,
     checkSizeCalculation(rowVector, fields, testOrdering);
     checkBatchedSizeCalculation(
         rowVector, /*offset=*/0, rowVector->size(), fields, testOrdering);
+    checkColumnarSerialization(rowVector, fields, testOrdering);
     ensureSorted(rowVector, fields, testOrdering);
   }
 
@@ -304,6 +305,44 @@ class BinarySortableSerializerFuzzerTest : public ::testing::Test,
     }
   }
 
+  // Checks that the columnar serialization produces the same keys as the row
+  // by row one.
+  void checkColumnarSerialization(
+      const velox::RowVectorPtr& input,
+      const std::vector<
+          std::shared_ptr<const velox::core::FieldAccessTypedExpr>>& keys,
+      const std::vector<velox::core::SortOrder>& ordering) {
+    BinarySortableSerializer binarySortableSerializer(input, ordering, keys);
+    const auto numRows = input->size();
+    auto vec = velox::BaseVector::create<velox::FlatVector<velox::StringView>>(
+        velox::VARBINARY(), numRows, pool_.get());
+    velox::StringVectorBuffer buffer(vec.get(), 1024, 1 << 20);
+    std::vector<size_t> offsets(numRows + 1, 0);
+    for (velox::vector_size_t i = 0; i < numRows; ++i) {
+      serializeRow(
+          binarySortableSerializer, /*index=*/i, /*offset=*/0, &buffer);
+      offsets[i + 1] = offsets[i] + vec->valueAt(i).size();
+    }
+
+    std::string columnar(offsets.back(), '\0');
+    std::vector<char*> rowBuffers(numRows);
+    std::vector<velox::vector_size_t> rowSizes(numRows);
+    for (velox::vector_size_t i = 0; i < numRows; ++i) {
+      rowBuffers[i] = columnar.data() + offsets[i];
+      rowSizes[i] = offsets[i + 1] - offsets[i];
+    }
+    velox::Scratch scratch;
+    binarySortableSerializer.serialize(
+        /*offset=*/0, numRows, rowBuffers.data(), rowSizes.data(), scratch);
+    for (velox::vector_size_t i = 0; i < numRows; ++i) {
+      EXPECT_EQ(
+          std::string_view(
+              columnar.data() + offsets[i], offsets[i + 1] - offsets[i]),
+          std::string_view(vec->valueAt(i)))
+          << "Columnar serialization mismatch at row " << i;
+    }
+  }
+
   velox::RowVectorPtr makeData(const velox::RowTypePtr& rowType) {
     velox::VectorFuzzer::Options options;
     options.vectorSize = 1'000;
@@ -353,6 +392,45 @@ TEST_F(BinarySortableSerializerFuzzerTest, fuzzerTestString) {
   runFuzzerTest(rowType);
 }
 
+TEST_F(BinarySortableSerializerFuzzerTest, fuzzerTestPrimitives) {
+  const auto rowType = velox::ROW(
+      {"c0", "c1", "c2", "c3", "c4", "c5"},
+      {velox::SMALLINT(),
+       velox::INTEGER(),
+       velox::DATE(),
+       velox::TIMESTAMP(),
+       velox::VARBINARY(),
+       velox::BOOLEAN()});
+  runFuzzerTest(rowType);
+}
+
+TEST_F(BinarySortableSerializerFuzzerTest, fuzzerTestDecimal) {
+  const auto rowType = velox::ROW(
+      {"c0", "c1"}, {velox::DECIMAL(12, 2), velox::DECIMAL(38, 18)});
+  runFuzzerTest(rowType);
+}
+
+TEST_F(BinarySortableSerializerFuzzerTest, fuzzerTestMap) {
+  // Maps are not orderable, so only the sizes and the columnar serialization
+  // are checked.
+  const auto rowType = velox::ROW(
+      {"c0", "c1"},
+      {velox::MAP(velox::BIGINT(), velox::VARCHAR()),
+       velox::ROW(
+           {velox::MAP(velox::VARCHAR(), velox::ARRAY(velox::BIGINT())),
+            velox::DECIMAL(38, 18)})});
+  const auto rowVector = makeData(rowType);
+  const auto fields = getFields(rowType);
+  for (const auto& ordering : sortingOrders_) {
+    const std::vector<velox::core::SortOrder> testOrdering(
+        rowType->size(), ordering);
+    checkSizeCalculation(rowVector, fields, testOrdering);
+    checkBatchedSizeCalculation(
+        rowVector, /*offset=*/0, rowVector->size(), fields, testOrdering);
+    checkColumnarSerialization(rowVector, fields, testOrdering);
+  }
+}
+
 TEST_F(BinarySortableSerializerFuzzerTest, fuzzerTestArray) {
   const auto rowType = velox::ROW(
       {"c1", "c2", "c3"},
@@ -1018,6 +1096,127 @@ TEST_F(BinarySortableSerializerTest, StringTypeSingleFieldTests) {
           {std::nullopt, ""}, velox::core::kAscNullsFirst) < 0);
 }
 
+TEST_F(BinarySortableSerializerTest, HugeIntTypeSingleFieldTests) {
+  const velox::int128_t kMax = std::numeric_limits<velox::int128_t>::max();
+  const velox::int128_t kMin = std::numeric_limits<velox::int128_t>::min();
+
+  EXPECT_TRUE(
+      singlePrimitiveFieldCompare<velox::int128_t>(
+          {-1, 1}, velox::core::kAscNullsFirst) < 0);
+  EXPECT_TRUE(
+      singlePrimitiveFieldCompare<velox::int128_t>(
+          {kMin, -1}, velox::core::kAscNullsFirst) < 0);
+  // The lower 64 bits of 1 << 64 are smaller than those of 1.
+  EXPECT_TRUE(
+      singlePrimitiveFieldCompare<velox::int128_t>(
+          {1, static_cast<velox::int128_t>(1) << 64},
+          velox::core::kAscNullsFirst) < 0);
+  EXPECT_TRUE(
+      singlePrimitiveFieldCompare<velox::int128_t>(
+          {kMax, kMax}, velox::core::kAscNullsFirst) == 0);
+  EXPECT_TRUE(
+      singlePrimitiveFieldCompare<velox::int128_t>(
+          {kMax, kMin}, velox::core::kDescNullsFirst) < 0);
+  EXPECT_TRUE(
+      singlePrimitiveFieldCompare<velox::int128_t>(
+          {std::nullopt, kMin}, velox::core::kAscNullsFirst) < 0);
+}
+
+TEST_F(BinarySortableSerializerTest, MapTypeSingleFieldTests) {
+  using Map = std::vector<std::pair<int64_t, std::optional<int64_t>>>;
+  const auto compareMaps = [&](const std::optional<Map>& left,
+                               const std::optional<Map>& right,
+                               const velox::core::SortOrder& ordering) {
+    const auto rowVector = vectorMaker_.rowVector(
+        {makeNullableMapVector<int64_t, int64_t>({left, right})});
+    const std::vector<
+        std::shared_ptr<const velox::core::FieldAccessTypedExpr>>
+        fields{std::make_shared<velox::core::FieldAccessTypedExpr>(
+            velox::MAP(velox::BIGINT(), velox::BIGINT()), "c0")};
+    return compareRowVector(rowVector, fields, {ordering});
+  };
+  const auto kAsc = velox::core::kAscNullsFirst;
+
+  EXPECT_EQ(compareMaps(Map{{1, 2}}, Map{{1, 2}}, kAsc), 0);
+  EXPECT_LT(compareMaps(Map{{1, 2}}, Map{{1, 3}}, kAsc), 0);
+  EXPECT_LT(compareMaps(Map{{1, std::nullopt}}, Map{{1, 2}}, kAsc), 0);
+  EXPECT_LT(compareMaps(Map{}, Map{{1, 2}}, kAsc), 0);
+  EXPECT_LT(compareMaps(Map{{1, 2}}, Map{{1, 2}, {3, 4}}, kAsc), 0);
+  EXPECT_LT(
+      compareMaps(
+          Map{{1, 2}, {3, 4}}, Map{{1, 2}}, velox::core::kDescNullsLast),
+      0);
+  EXPECT_LT(compareMaps(std::nullopt, Map{}, kAsc), 0);
+
+  // Equal maps with entries stored in different orders serialize to the same
+  // bytes.
+  const Map map{{-5, 6}, {1, std::nullopt}, {3, 4}, {1'000, 7}};
+  for (const auto& ordering :
+       {velox::core::kAscNullsFirst,
+        velox::core::kAscNullsLast,
+        velox::core::kDescNullsFirst,
+        velox::core::kDescNullsLast}) {
+    EXPECT_EQ(
+        compareMaps(
+            map, Map{{3, 4}, {1'000, 7}, {1, std::nullopt}, {-5, 6}}, ordering),
+        0);
+    EXPECT_EQ(
+        compareMaps(
+            map, Map{{1'000, 7}, {3, 4}, {1, std::nullopt}, {-5, 6}}, ordering),
+        0);
+    EXPECT_NE(
+        compareMaps(map, Map{{3, 4}, {1'000, 7}, {1, 2}, {-5, 6}}, ordering),
+        0);
+  }
+}
+
+TEST_F(BinarySortableSerializerTest, StringEscapedBytes) {
+  // Bytes to escape at the start, at the end and around SIMD batch
+  // boundaries, in strings shorter and longer than a batch.
+  std::vector<std::string> values;
+  for (const auto size : {0, 1, 7, 31, 32, 33, 100, 1'000}) {
+    std::string value(size, 'x');
+    for (auto i = 0; i < size; i += 15) {
+      value[i] = static_cast<char>(i % 2);
+    }
+    if (size > 0) {
+      value.back() = '\0';
+    }
+    values.push_back(std::move(value));
+  }
+  const auto rowVector =
+      vectorMaker_.rowVector({vectorMaker_.flatVector(values)});
+  const std::vector<std::shared_ptr<const velox::core::FieldAccessTypedExpr>>
+      fields{std::make_shared<velox::core::FieldAccessTypedExpr>(
+          velox::VARCHAR(), "c0")};
+
+  for (const auto& ordering :
+       {velox::core::kAscNullsFirst, velox::core::kDescNullsFirst}) {
+    const uint8_t mask = ordering.isAscending() ? 0 : 0xff;
+    BinarySortableSerializer serializer(rowVector, {ordering}, fields);
+    auto vector =
+        velox::BaseVector::create<velox::FlatVector<velox::StringView>>(
+            velox::VARBINARY(), values.size(), pool_.get());
+    velox::StringVectorBuffer buffer(vector.get(), 1024, 1 << 20);
+    for (velox::vector_size_t i = 0; i < values.size(); ++i) {
+      serializeRow(serializer, /*index=*/i, /*offset=*/0, &buffer);
+
+      // Null byte of the key and of the value, then the escaped bytes and the
+      // end marker.
+      std::string expected{1, 1};
+      for (const char c : values[i]) {
+        if (c == 0 || c == 1) {
+          expected.push_back(1 ^ mask);
+        }
+        expected.push_back(c ^ mask);
+      }
+      expected.push_back(mask);
+      EXPECT_EQ(vector->valueAt(i).str(), expected) << values[i].size();
+      EXPECT_EQ(serializer.serializedSizeInBytes(i), expected.size());
+    }
+  }
+}
+
 TEST_F(BinarySortableSerializerTest, ArrayTypeSingleFieldTests) {
   // [1, 1] == [1, 1]
   EXPECT_TRUE(
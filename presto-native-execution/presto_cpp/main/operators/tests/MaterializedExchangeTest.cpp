@@ -13,11 +13,13 @@
  */
 #include <folly/Uri.h>
 #include <folly/init/Init.h>
+#include <folly/lang/Bits.h>
 
 #include <boost/range/algorithm/find_if.hpp>
 
 #include "presto_cpp/main/common/Configs.h"
 #include "presto_cpp/main/common/tests/MutableConfigs.h"
+#include "presto_cpp/main/operators/CompactRowBatchDeserializer.h"
 #include "presto_cpp/main/operators/LocalShuffle.h"
 #include "presto_cpp/main/operators/MaterializedExchange.h"
 #include "presto_cpp/main/operators/MaterializedOutput.h"
@@ -33,6 +35,8 @@
 #include "velox/exec/tests/utils/OperatorTestBase.h"
 #include "velox/exec/tests/utils/PlanBuilder.h"
 #include "velox/exec/tests/utils/TempDirectoryPath.h"
+#include "velox/row/CompactRow.h"
+#include "velox/serializers/RowSerializer.h"
 #include "velox/vector/fuzzer/VectorFuzzer.h"
 
 using namespace facebook::velox;
@@ -107,6 +111,56 @@ std::string localShuffleReadInfo(
       .serialize();
 }
 
+// Serializes the rows of 'data' in the RowGroupHeader + TRowSize framing
+// written by MaterializedOutput, 'rowsPerGroup' rows per row group.
+std::string serializeRowGroups(
+    const RowVectorPtr& data,
+    vector_size_t rowsPerGroup) {
+  row::CompactRow compactRow(data);
+  std::string page;
+  for (vector_size_t start = 0; start < data->size(); start += rowsPerGroup) {
+    const auto end = std::min(start + rowsPerGroup, data->size());
+    std::string rowGroup;
+    for (auto row = start; row < end; ++row) {
+      const uint32_t rowSize = compactRow.rowSize(row);
+      const uint32_t bigEndianRowSize = folly::Endian::big(rowSize);
+      rowGroup.append(
+          reinterpret_cast<const char*>(&bigEndianRowSize), sizeof(uint32_t));
+      const auto offset = rowGroup.size();
+      rowGroup.resize(offset + rowSize);
+      compactRow.serialize(row, rowGroup.data() + offset);
+    }
+    std::string header(serializer::detail::RowGroupHeader::size(), '\0');
+    const int32_t uncompressedSize = rowGroup.size();
+    std::memcpy(header.data(), &uncompressedSize, sizeof(int32_t));
+    page += header;
+    page += rowGroup;
+  }
+  return page;
+}
+
+// Splits 'page' into one view per row, as MaterializedExchange did before
+// CompactRowBatchDeserializer.
+void splitRows(std::string_view page, std::vector<std::string_view>& rows) {
+  const auto headerSize = serializer::detail::RowGroupHeader::size();
+  const char* ptr = page.data();
+  const char* end = page.data() + page.size();
+  while (ptr < end) {
+    int32_t uncompressedSize;
+    std::memcpy(&uncompressedSize, ptr, sizeof(int32_t));
+    ptr += headerSize;
+    const char* rowGroupEnd = ptr + uncompressedSize;
+    while (ptr < rowGroupEnd) {
+      uint32_t rowSize;
+      std::memcpy(&rowSize, ptr, sizeof(uint32_t));
+      rowSize = folly::Endian::big(rowSize);
+      ptr += sizeof(uint32_t);
+      rows.emplace_back(ptr, rowSize);
+      ptr += rowSize;
+    }
+  }
+}
+
 // ShuffleWriter that delegates all operations to a real writer but throws
 // from noMoreData(success=true) to simulate a writer close failure.
 class FailingCloseShuffleWriter : public ShuffleWriter {
@@ -272,7 +326,8 @@ class MaterializedExchangeTest : public exec::test::OperatorTestBase {
       const std::vector<RowVectorPtr>& data,
       int numPartitions,
       int numDrivers,
-      bool replicateNullsAndAny = false) {
+      bool replicateNullsAndAny = false,
+      const SkewSplitSpec& skewSplit = {}) {
     auto dataType = asRowType(data[0]->type());
     auto writeInfoStr =
         localShuffleWriteInfo(tempDir_->getPath(), numPartitions);
@@ -303,7 +358,8 @@ class MaterializedExchangeTest : public exec::test::OperatorTestBase {
         partitionFunctionSpec,
         replicateNullsAndAny,
         ShuffleWriterMetadata{},
-        valuesNode);
+        valuesNode,
+        skewSplit);
 
     auto taskId = makeTaskId("write", 0);
     MaterializedOutputBuffer::registerBuffer(taskId, buffer);
@@ -324,10 +380,15 @@ class MaterializedExchangeTest : public exec::test::OperatorTestBase {
   }
 
   /// Read data from shuffle for all partitions using MaterializedExchangeNode.
-  /// Returns all output vectors across all partitions.
+  /// Returns all output vectors across all partitions. 'serializedType' and
+  /// 'filter' are pushed into the node if set. If 'partitions' is set, it
+  /// receives the partition each output vector was read from.
   std::vector<RowVectorPtr> runExchangeRead(
       int numPartitions,
-      const RowTypePtr& dataType) {
+      const RowTypePtr& dataType,
+      const RowTypePtr& serializedType = nullptr,
+      const core::TypedExprPtr& filter = nullptr,
+      std::vector<int>* partitions = nullptr) {
     std::vector<RowVectorPtr> outputVectors;
 
     for (int partition = 0; partition < numPartitions; ++partition) {
@@ -337,11 +398,10 @@ class MaterializedExchangeTest : public exec::test::OperatorTestBase {
       auto plan =
           exec::test::PlanBuilder()
               .addNode(
-                  [&dataType](
-                      core::PlanNodeId nodeId,
+                  [&](core::PlanNodeId nodeId,
                       core::PlanNodePtr /* source */) -> core::PlanNodePtr {
                     return std::make_shared<MaterializedExchangeNode>(
-                        nodeId, dataType);
+                        nodeId, dataType, serializedType, filter);
                   })
               .planNode();
 
@@ -366,6 +426,9 @@ class MaterializedExchangeTest : public exec::test::OperatorTestBase {
       for (const auto& result : results) {
         auto copied = copyResultVector(result);
         outputVectors.push_back(copied);
+        if (partitions != nullptr) {
+          partitions->push_back(partition);
+        }
       }
     }
 
@@ -543,6 +606,236 @@ TEST_F(MaterializedExchangeTest, emptyInput) {
   cleanupDirectory(tempDir_->getPath());
 }
 
+TEST_F(MaterializedExchangeTest, fixedWidthEndToEnd) {
+  const int numRows = 10000;
+  auto data = makeRowVector({
+      makeFlatVector<int64_t>(numRows, [](auto row) { return row; }),
+      makeFlatVector<bool>(
+          numRows, [](auto row) { return row % 3 == 0; }, nullEvery(7)),
+      makeFlatVector<int16_t>(
+          numRows, [](auto row) { return row % 1000; }, nullEvery(11)),
+      makeFlatVector<int32_t>(
+          numRows, [](auto row) { return row * 3; }, nullEvery(5), DATE()),
+      makeFlatVector<double>(numRows, [](auto row) { return row * 1.5; }),
+      makeFlatVector<Timestamp>(
+          numRows,
+          [](auto row) { return Timestamp(row, row * 1'000); },
+          nullEvery(13)),
+      makeFlatVector<int128_t>(
+          numRows,
+          [](auto row) { return HugeInt::build(row, row * 7); },
+          nullEvery(17),
+          DECIMAL(30, 2)),
+  });
+
+  const int numPartitions = 4;
+  const int numDrivers = 2;
+
+  auto expected = runExchangeWrite({data}, numPartitions, numDrivers);
+  auto actual = runExchangeRead(numPartitions, asRowType(data->type()));
+  exec::test::assertEqualResults(expected, actual);
+
+  // Same results with lazily deserialized columns.
+  facebook::presto::test::setupMutableSystemConfig();
+  SystemConfig::instance()->setValue(
+      std::string(SystemConfig::kExchangeMaterializationLazyColumnsEnabled),
+      "true");
+  actual = runExchangeRead(numPartitions, asRowType(data->type()));
+  exec::test::assertEqualResults(expected, actual);
+  SystemConfig::instance()->setValue(
+      std::string(SystemConfig::kExchangeMaterializationLazyColumnsEnabled),
+      "false");
+  cleanupDirectory(tempDir_->getPath());
+}
+
+// Compares CompactRowBatchDeserializer with CompactRow::deserialize() on
+// ranges of rows that span row groups and pages.
+TEST_F(MaterializedExchangeTest, batchDeserializer) {
+  VectorFuzzer::Options options;
+  options.vectorSize = 1000;
+  options.nullRatio = 0.1;
+  options.timestampPrecision =
+      VectorFuzzer::Options::TimestampPrecision::kMicroSeconds;
+  VectorFuzzer fuzzer(options, pool());
+
+  const auto fixedWidthType =
+      ROW({BOOLEAN(),
+           TINYINT(),
+           SMALLINT(),
+           INTEGER(),
+           BIGINT(),
+           REAL(),
+           DOUBLE(),
+           TIMESTAMP(),
+           DATE(),
+           DECIMAL(10, 2),
+           DECIMAL(30, 5)});
+  const auto variableWidthType = ROW({BIGINT(), VARCHAR(), ARRAY(INTEGER())});
+  for (const auto& rowType : {fixedWidthType, variableWidthType}) {
+    SCOPED_TRACE(rowType->toString());
+    auto data = fuzzer.fuzzInputFlatRow(rowType);
+    const auto pages = std::make_shared<std::vector<std::string>>(
+        std::vector<std::string>{
+            serializeRowGroups(data, 100), serializeRowGroups(data, 300)});
+
+    CompactRowBatchDeserializer deserializer(rowType);
+    ASSERT_EQ(
+        deserializer.fixedRowSize(), row::CompactRow::fixedRowSize(rowType));
+    std::vector<std::string_view> rows;
+    for (const auto& page : *pages) {
+      deserializer.addPage(page);
+      splitRows(page, rows);
+    }
+    ASSERT_EQ(deserializer.numRows(), static_cast<vector_size_t>(rows.size()));
+
+    for (const auto& [offset, numRows] :
+         std::vector<std::pair<vector_size_t, vector_size_t>>{
+             {0, 2'000}, {0, 10}, {50, 120}, {950, 100}, {1'999, 1}}) {
+      SCOPED_TRACE(fmt::format("offset {}, numRows {}", offset, numRows));
+      auto expected = row::CompactRow::deserialize(
+          std::vector<std::string_view>(
+              rows.begin() + offset, rows.begin() + offset + numRows),
+          rowType,
+          pool());
+      assertEqualVectors(
+          expected, deserializer.deserialize(offset, numRows, pool()));
+
+      auto lazy = deserializer.deserialize(offset, numRows, pool(), pages);
+      if (deserializer.fixedRowSize().has_value()) {
+        for (const auto& child : lazy->children()) {
+          EXPECT_TRUE(isLazyNotLoaded(*child));
+        }
+      }
+      assertEqualVectors(expected, copyResultVector(lazy));
+    }
+
+    deserializer.clear();
+    EXPECT_EQ(deserializer.numRows(), 0);
+  }
+}
+
+// Compares CompactRowBatchDeserializer::deserializeColumns() on a subset of
+// columns and rows with CompactRow::deserialize().
+TEST_F(MaterializedExchangeTest, batchDeserializerColumns) {
+  VectorFuzzer::Options options;
+  options.vectorSize = 1000;
+  options.nullRatio = 0.1;
+  VectorFuzzer fuzzer(options, pool());
+
+  const auto fixedWidthType = ROW({BIGINT(), INTEGER(), DOUBLE(), BOOLEAN()});
+  const auto mixedType =
+      ROW({BIGINT(), INTEGER(), VARCHAR(), DOUBLE(), ARRAY(BIGINT())});
+  for (const auto& rowType : {fixedWidthType, mixedType}) {
+    SCOPED_TRACE(rowType->toString());
+    auto data = fuzzer.fuzzInputFlatRow(rowType);
+    const auto page = serializeRowGroups(data, 300);
+
+    CompactRowBatchDeserializer framed(rowType);
+    framed.addPage(page);
+    std::vector<std::string_view> rows;
+    splitRows(page, rows);
+    CompactRowBatchDeserializer unframed(rowType);
+    for (const auto& row : rows) {
+      unframed.addRow(row);
+    }
+    EXPECT_TRUE(framed.hasFixedOffset(1));
+    EXPECT_EQ(framed.hasFixedOffset(3), rowType == fixedWidthType);
+
+    const vector_size_t offset = 250;
+    const vector_size_t numRows = 500;
+    std::vector<vector_size_t> selected;
+    for (vector_size_t i = 0; i < numRows; i += 3) {
+      selected.push_back(i);
+    }
+    std::vector<std::string_view> selectedRows;
+    for (auto i : selected) {
+      selectedRows.push_back(rows[offset + i]);
+    }
+    auto expected = row::CompactRow::deserialize(selectedRows, rowType, pool());
+
+    const std::vector<column_index_t> channels{3, 1};
+    for (const auto* deserializer : {&framed, &unframed}) {
+      auto columns = deserializer->deserializeColumns(
+          offset, numRows, channels, &selected, pool());
+      ASSERT_EQ(columns.size(), channels.size());
+      for (size_t i = 0; i < channels.size(); ++i) {
+        assertEqualVectors(expected->childAt(channels[i]), columns[i]);
+      }
+    }
+  }
+}
+
+// Reads a subset of the columns with a filter pushed into the
+// MaterializedExchangeNode.
+TEST_F(MaterializedExchangeTest, pushdownEndToEnd) {
+  const int numRows = 10000;
+  auto fixedWidthData = makeRowVector({
+      makeFlatVector<int64_t>(numRows, [](auto row) { return row; }),
+      makeFlatVector<int32_t>(
+          numRows, [](auto row) { return row % 100; }, nullEvery(7)),
+      makeFlatVector<double>(numRows, [](auto row) { return row * 1.5; }),
+  });
+  auto mixedData = makeRowVector({
+      makeFlatVector<int64_t>(numRows, [](auto row) { return row; }),
+      makeFlatVector<std::string>(
+          numRows,
+          [](auto row) { return std::string(row % 10, 'x'); },
+          nullEvery(11)),
+      makeFlatVector<int32_t>(
+          numRows, [](auto row) { return row % 100; }, nullEvery(7)),
+  });
+  auto arrayData = makeRowVector({
+      makeFlatVector<int64_t>(numRows, [](auto row) { return row; }),
+      makeArrayVector<int64_t>(
+          numRows,
+          [](auto row) { return row % 5; },
+          [](auto index) { return index % 7 - 3; },
+          nullEvery(13)),
+  });
+
+  struct TestCase {
+    RowVectorPtr data;
+    std::string filter;
+    std::vector<std::string> outputColumns;
+  };
+  const std::vector<TestCase> testCases{
+      {fixedWidthData, "c1 % 3 = 0", {"c2", "c0"}},
+      {fixedWidthData, "c1 > 1000", {"c0"}},
+      {mixedData, "c0 % 5 = 1", {"c1", "c2"}},
+      {mixedData, "length(c1) > 6", {"c2"}},
+      {mixedData, "length(c1) > 6 and c2 > 50", {"c0", "c1"}},
+      // The lambda argument is not a column of the serialized rows.
+      {arrayData, "any_match(c1, x -> x > 0)", {"c0", "c1"}},
+  };
+
+  const int numPartitions = 4;
+  const int numDrivers = 2;
+  for (const auto& testCase : testCases) {
+    SCOPED_TRACE(testCase.filter);
+    const auto dataType = asRowType(testCase.data->type());
+    auto written = runExchangeWrite({testCase.data}, numPartitions, numDrivers);
+    auto expected = exec::test::AssertQueryBuilder(
+                        exec::test::PlanBuilder()
+                            .values(written)
+                            .filter(testCase.filter)
+                            .project(testCase.outputColumns)
+                            .planNode())
+                        .copyResults(pool());
+
+    std::vector<TypePtr> outputTypes;
+    for (const auto& name : testCase.outputColumns) {
+      outputTypes.push_back(dataType->findChild(name));
+    }
+    auto actual = runExchangeRead(
+        numPartitions,
+        ROW(testCase.outputColumns, std::move(outputTypes)),
+        dataType,
+        parseExpr(testCase.filter, dataType));
+    exec::test::assertEqualResults({expected}, actual);
+    cleanupDirectory(tempDir_->getPath());
+  }
+}
+
 // Row-count-only output: the MaterializedOutputNode projects to a ZERO-column
 // output type (e.g. a count-only shuffle after a dedupe). CompactRow::
 // fixedRowSize(ROW({})) == 0, so each serialized row is zero bytes and the
@@ -718,6 +1011,100 @@ TEST_F(MaterializedExchangeTest, replicateNullsAndAny) {
   cleanupDirectory(tempDir_->getPath());
 }
 
+TEST_F(MaterializedExchangeTest, skewSplit) {
+  const int numPartitions = 4;
+  const int32_t skewedKey = 7;
+  const auto hashPartition = [&](int32_t key) {
+    auto row = makeRowVector({makeFlatVector<int32_t>({key})});
+    std::vector<uint32_t> partitions(1);
+    exec::HashPartitionFunctionSpec(asRowType(row->type()), {0})
+        .create(numPartitions, /*localExchange=*/false)
+        ->partition(*row, partitions);
+    return partitions[0];
+  };
+
+  SkewSplitSpec spec;
+  spec.mode = SkewSplitMode::kSalt;
+  spec.maxSubPartitions = 3;
+  spec.skewFactor = 1.5;
+  spec.minPartitionBytes = 1;
+  spec.skewedPartitions = {hashPartition(skewedKey)};
+
+  // All rows have 'skewedKey'. Each batch is larger than the flush threshold,
+  // so the first batch goes to a single partition, which is split over 3
+  // destinations for the following batches.
+  std::vector<RowVectorPtr> data;
+  for (auto i = 0; i < 3; ++i) {
+    data.push_back(makeRowVector({
+        makeFlatVector<int32_t>(20'000, [&](auto) { return skewedKey; }),
+        makeFlatVector<std::string>(
+            20'000,
+            [i](auto row) {
+              return fmt::format("{:0>100}", i * 20'000 + row);
+            }),
+    }));
+  }
+  auto expected = runExchangeWrite(
+      data, numPartitions, 1, /*replicateNullsAndAny=*/false, spec);
+  std::vector<int> partitions;
+  auto actual = runExchangeRead(
+      numPartitions, asRowType(data[0]->type()), nullptr, nullptr, &partitions);
+  // Every row is read exactly once.
+  exec::test::assertEqualResults(expected, actual);
+  std::set<int> nonEmptyPartitions;
+  for (auto i = 0; i < actual.size(); ++i) {
+    if (actual[i]->size() > 0) {
+      nonEmptyPartitions.insert(partitions[i]);
+    }
+  }
+  EXPECT_EQ(nonEmptyPartitions.size(), 3);
+  cleanupDirectory(tempDir_->getPath());
+
+  // Each row of the skewed partition is written to the 3 destinations the
+  // salted side may spread it over. The other rows are written once.
+  auto buildData = makeRowVector({
+      makeFlatVector<int32_t>(100, [](auto row) { return row; }),
+      makeFlatVector<std::string>(
+          100, [](auto row) { return fmt::format("{}", row); }),
+  });
+  spec.mode = SkewSplitMode::kReplicate;
+  runExchangeWrite(
+      {buildData}, numPartitions, 1, /*replicateNullsAndAny=*/false, spec);
+  partitions.clear();
+  actual = runExchangeRead(
+      numPartitions,
+      asRowType(buildData->type()),
+      nullptr,
+      nullptr,
+      &partitions);
+  std::map<int32_t, std::set<int>> keyPartitions;
+  std::map<int32_t, int> keyCounts;
+  for (auto i = 0; i < actual.size(); ++i) {
+    auto* keys = actual[i]->childAt(0)->as<SimpleVector<int32_t>>();
+    for (vector_size_t row = 0; row < actual[i]->size(); ++row) {
+      keyPartitions[keys->valueAt(row)].insert(partitions[i]);
+      ++keyCounts[keys->valueAt(row)];
+    }
+  }
+  ASSERT_EQ(keyCounts.size(), 100);
+  for (int32_t key = 0; key < 100; ++key) {
+    const auto partition = hashPartition(key);
+    if (partition != spec.skewedPartitions[0]) {
+      EXPECT_EQ(keyCounts[key], 1) << key;
+      continue;
+    }
+    EXPECT_EQ(keyCounts[key], 3) << key;
+    EXPECT_EQ(
+        keyPartitions[key],
+        (std::set<int>{
+            static_cast<int>(partition),
+            static_cast<int>((partition + 1) % numPartitions),
+            static_cast<int>((partition + 2) % numPartitions)}))
+        << key;
+  }
+  cleanupDirectory(tempDir_->getPath());
+}
+
 // Negative control for the test above: same input, replicate=false. Each
 // row should appear exactly once across all partitions (no broadcast).
 TEST_F(MaterializedExchangeTest, replicateNullsAndAnyDisabled) {
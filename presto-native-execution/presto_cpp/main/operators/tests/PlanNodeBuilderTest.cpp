@@ -17,6 +17,7 @@
 #include "presto_cpp/main/operators/PartitionAndSerialize.h"
 #include "presto_cpp/main/operators/ShuffleRead.h"
 #include "presto_cpp/main/operators/ShuffleWrite.h"
+#include "velox/common/base/tests/GTestUtils.h"
 
 using namespace facebook::velox;
 
@@ -116,6 +117,44 @@ TEST(PlanNodeBuilderTest, testShuffleRead) {
   verify(node2);
 }
 
+TEST(PlanNodeBuilderTest, testShuffleReadPushdown) {
+  const core::PlanNodeId id = "shuffle_read_id";
+  const RowTypePtr serializedType = ROW({"c0", "c1"}, {INTEGER(), VARCHAR()});
+  const RowTypePtr outputType = ROW({"c1"}, {VARCHAR()});
+  const auto filter = std::make_shared<core::CallTypedExpr>(
+      BOOLEAN(),
+      std::vector<core::TypedExprPtr>{
+          std::make_shared<core::FieldAccessTypedExpr>(INTEGER(), "c0")},
+      "is_null");
+
+  const auto verify = [&](const std::shared_ptr<const ShuffleReadNode>& node) {
+    EXPECT_EQ(node->id(), id);
+    EXPECT_EQ(node->outputType(), outputType);
+    EXPECT_EQ(node->serializedType(), serializedType);
+    EXPECT_EQ(node->filter(), filter);
+  };
+
+  const auto node = ShuffleReadNode::Builder()
+                        .id(id)
+                        .outputType(outputType)
+                        .serializedType(serializedType)
+                        .filter(filter)
+                        .build();
+  verify(node);
+
+  const auto node2 = ShuffleReadNode::Builder(*node).build();
+  verify(node2);
+
+  // The output columns must be serialized columns.
+  VELOX_ASSERT_THROW(
+      ShuffleReadNode::Builder()
+          .id(id)
+          .outputType(ROW({"c2"}, {VARCHAR()}))
+          .serializedType(serializedType)
+          .build(),
+      "Shuffle read output column c2 is not in the serialized row type");
+}
+
 TEST(PlanNodeBuilderTest, testShuffleWrite) {
   const core::PlanNodeId id = "shuffle_write_id";
   const uint32_t numPartitions = 10;
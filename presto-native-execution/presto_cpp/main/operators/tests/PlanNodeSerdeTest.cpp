@@ -13,6 +13,8 @@
  */
 #include <gtest/gtest.h>
 
+#include "presto_cpp/main/operators/MaterializedExchange.h"
+#include "presto_cpp/main/operators/ShuffleRead.h"
 #include "presto_cpp/main/operators/tests/PlanBuilder.h"
 #include "presto_cpp/main/types/PrestoToVeloxQueryPlan.h"
 #include "velox/core/PlanNode.h"
@@ -80,6 +82,26 @@ TEST_F(PlanNodeSerdeTest, partitionAndSerializeNode) {
   testSerde(plan);
 }
 
+TEST_F(PlanNodeSerdeTest, partitionAndSerializeSkewSplit) {
+  SkewSplitSpec skewSplit;
+  skewSplit.mode = SkewSplitMode::kSalt;
+  skewSplit.maxSubPartitions = 8;
+  skewSplit.skewedPartitions = {1, 3};
+  auto plan = exec::test::PlanBuilder()
+                  .values(data_, true)
+                  .addNode([&](std::string id, core::PlanNodePtr source) {
+                    auto node = std::dynamic_pointer_cast<
+                        const PartitionAndSerializeNode>(
+                        addPartitionAndSerializeNode(4, false)(
+                            id, std::move(source)));
+                    return PartitionAndSerializeNode::Builder(*node)
+                        .skewSplit(skewSplit)
+                        .build();
+                  })
+                  .planNode();
+  testSerde(plan);
+}
+
 TEST_F(PlanNodeSerdeTest, shuffleReadNode) {
   auto plan = exec::test::PlanBuilder()
                   .addNode(addShuffleReadNode(type_))
@@ -88,6 +110,38 @@ TEST_F(PlanNodeSerdeTest, shuffleReadNode) {
   testSerde(plan);
 }
 
+TEST_F(PlanNodeSerdeTest, shuffleReadPushdown) {
+  const auto outputType = ROW({"c1", "c0"}, {INTEGER(), BIGINT()});
+  const auto filter = std::make_shared<core::CallTypedExpr>(
+      BOOLEAN(),
+      std::vector<core::TypedExprPtr>{
+          std::make_shared<core::FieldAccessTypedExpr>(BOOLEAN(), "c2"),
+          std::make_shared<core::CallTypedExpr>(
+              BOOLEAN(),
+              std::vector<core::TypedExprPtr>{
+                  std::make_shared<core::FieldAccessTypedExpr>(
+                      INTEGER(), "c1"),
+                  std::make_shared<core::ConstantTypedExpr>(
+                      INTEGER(), variant(15))},
+              "gt")},
+      "and");
+  auto plan = exec::test::PlanBuilder()
+                  .addNode([&](std::string id, core::PlanNodePtr) {
+                    return std::make_shared<ShuffleReadNode>(
+                        id, outputType, type_, filter);
+                  })
+                  .planNode();
+  testSerde(plan);
+
+  plan = exec::test::PlanBuilder()
+             .addNode([&](std::string id, core::PlanNodePtr) {
+               return std::make_shared<MaterializedExchangeNode>(
+                   id, outputType, type_, filter);
+             })
+             .planNode();
+  testSerde(plan);
+}
+
 TEST_F(PlanNodeSerdeTest, shuffleWriteNode) {
   const int numPartitions = 4;
   const std::string shuffleName("shuffleWriteNodeSerdeTest");
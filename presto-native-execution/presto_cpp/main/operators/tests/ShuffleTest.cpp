@@ -12,6 +12,9 @@
  * limitations under the License.
  */
 #include <folly/Uri.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/ManualExecutor.h>
+#include <folly/synchronization/Baton.h>
 #include "folly/init/Init.h"
 
 #include <boost/algorithm/cxx11/iota.hpp>
@@ -24,6 +27,7 @@
 #include "presto_cpp/main/operators/ShuffleExchangeSource.h"
 #include "presto_cpp/main/operators/ShuffleRead.h"
 #include "presto_cpp/main/operators/ShuffleWrite.h"
+#include "presto_cpp/main/operators/SkewedPartitionSplitter.h"
 #include "presto_cpp/main/operators/tests/PlanBuilder.h"
 
 #include "velox/common/base/tests/GTestUtils.h"
@@ -863,6 +867,82 @@ class ShuffleTest : public exec::test::OperatorTestBase {
         row::CompactRow::deserialize(rows, rowType, pool()));
   }
 
+  // Returns the partition of 'key' under hash partitioning on one INTEGER
+  // column.
+  uint32_t hashPartition(int32_t key, int32_t numPartitions) {
+    auto row = makeRowVector({makeFlatVector<int32_t>({key})});
+    std::vector<uint32_t> partitions(1);
+    exec::HashPartitionFunctionSpec(asRowType(row->type()), {0})
+        .create(numPartitions, /*localExchange=*/false)
+        ->partition(*row, partitions);
+    return partitions[0];
+  }
+
+  // Returns a PartitionAndSerialize plan that hash partitions 'data' on c0
+  // and splits skewed partitions according to 'skewSplit'.
+  core::PlanNodePtr makeSkewSplitPlan(
+      const std::vector<RowVectorPtr>& data,
+      const SkewSplitSpec& skewSplit,
+      int32_t numPartitions) {
+    return exec::test::PlanBuilder()
+        .values(data, false)
+        .addNode(
+            [&](core::PlanNodeId nodeId,
+                core::PlanNodePtr source) -> core::PlanNodePtr {
+              std::vector<core::TypedExprPtr> keys{
+                  std::make_shared<core::FieldAccessTypedExpr>(
+                      INTEGER(), "c0")};
+              const auto inputType = source->outputType();
+              return PartitionAndSerializeNode::Builder()
+                  .id(nodeId)
+                  .keys(keys)
+                  .numPartitions(numPartitions)
+                  .serializedRowType(inputType)
+                  .source(std::move(source))
+                  .replicateNullsAndAny(false)
+                  .partitionFunctionFactory(
+                      std::make_shared<exec::HashPartitionFunctionSpec>(
+                          inputType, exec::toChannels(inputType, keys)))
+                  .skewSplit(skewSplit)
+                  .build();
+            })
+        .planNode();
+  }
+
+  // Deserializes the output of a PartitionAndSerialize plan and groups the
+  // rows by destination.
+  std::vector<RowVectorPtr> deserializeByDestination(
+      const RowVectorPtr& serializedResult,
+      const RowTypePtr& rowType,
+      int32_t numPartitions) {
+    auto deserialized = deserializeResult(serializedResult, rowType);
+    auto* partitions =
+        serializedResult->childAt(0)->as<SimpleVector<int32_t>>();
+    std::vector<std::vector<vector_size_t>> destinationRows(numPartitions);
+    for (auto i = 0; i < serializedResult->size(); ++i) {
+      destinationRows[partitions->valueAt(i)].push_back(i);
+    }
+
+    std::vector<RowVectorPtr> destinations;
+    for (const auto& rows : destinationRows) {
+      if (rows.empty()) {
+        destinations.push_back(
+            BaseVector::create<RowVector>(rowType, 0, pool()));
+        continue;
+      }
+      auto indices = allocateIndices(rows.size(), pool());
+      std::copy(
+          rows.begin(), rows.end(), indices->asMutable<vector_size_t>());
+      std::vector<VectorPtr> children;
+      for (const auto& child : deserialized->children()) {
+        children.push_back(
+            BaseVector::wrapInDictionary(nullptr, indices, rows.size(), child));
+      }
+      destinations.push_back(makeRowVector(rowType->names(), children));
+    }
+    return destinations;
+  }
+
   RowVectorPtr copyResultVector(const RowVectorPtr& result) {
     auto vector = std::static_pointer_cast<RowVector>(
         BaseVector::create(result->type(), result->size(), pool()));
@@ -1208,6 +1288,251 @@ TEST_F(ShuffleTest, partitionAndSerializeRoundRobin) {
       << "Round-robin should distribute across multiple partitions";
 }
 
+TEST_F(ShuffleTest, skewedPartitionSplitter) {
+  SkewSplitSpec spec;
+  spec.mode = SkewSplitMode::kSalt;
+  spec.maxSubPartitions = 3;
+  spec.skewFactor = 1.0;
+  spec.minPartitionBytes = 100;
+  spec.skewedPartitions = {1, 2};
+  const auto copy = SkewSplitSpec::create(spec.serialize());
+  ASSERT_EQ(copy.toString(), spec.toString());
+  ASSERT_EQ(
+      spec.toString(),
+      "SALT maxSubPartitions: 3, skewFactor: 1, minPartitionBytes: 100, "
+      "skewedPartitions: [1, 2]");
+
+  SkewedPartitionSplitter splitter(spec, 4);
+  ASSERT_FALSE(splitter.replicates());
+  ASSERT_EQ(splitter.numReplicas(1), 1);
+  ASSERT_EQ(splitter.destination(3, 2), 1);
+
+  // Below 'minPartitionBytes', nothing is split.
+  splitter.updateSizes({90, 0, 0, 0});
+  ASSERT_EQ(splitter.numSplitPartitions(), 0);
+  // Partition 1 is larger than the average and than 100 bytes.
+  splitter.updateSizes({10, 150, 10, 10});
+  ASSERT_EQ(splitter.numSplitPartitions(), 1);
+  ASSERT_EQ(splitter.subPartitions(), (std::vector<uint32_t>{1, 2, 1, 1}));
+  // Sub-partitions grow up to 'maxSubPartitions' and never shrink.
+  splitter.updateSizes({10, 100'000, 10, 10});
+  ASSERT_EQ(splitter.subPartitions(), (std::vector<uint32_t>{1, 3, 1, 1}));
+  splitter.updateSizes({10'000, 10'000, 10'000, 10'000});
+  ASSERT_EQ(splitter.subPartitions(), (std::vector<uint32_t>{1, 3, 1, 1}));
+  // Partitions that are not listed as skewed are never split.
+  splitter.updateSizes({1'000'000, 10, 10, 10});
+  ASSERT_EQ(splitter.subPartitions(), (std::vector<uint32_t>{1, 3, 1, 1}));
+  ASSERT_EQ(splitter.numSplitPartitions(), 1);
+
+  std::vector<uint32_t> partitions{1, 0, 1, 1, 3, 1};
+  splitter.salt(partitions.data(), partitions.size());
+  ASSERT_EQ(partitions, (std::vector<uint32_t>{1, 0, 2, 3, 3, 1}));
+  ASSERT_EQ(splitter.numSaltedRows(), 2);
+
+  // Only the rows of the skewed partitions are replicated.
+  spec.mode = SkewSplitMode::kReplicate;
+  spec.maxSubPartitions = 8;
+  SkewedPartitionSplitter replicator(spec, 4);
+  ASSERT_TRUE(replicator.replicates());
+  ASSERT_EQ(replicator.numReplicas(0), 1);
+  ASSERT_EQ(replicator.numReplicas(1), 4);
+  ASSERT_EQ(replicator.numReplicas(2), 4);
+  ASSERT_EQ(replicator.numReplicas(3), 1);
+  replicator.updateSizes({10, 100'000, 10, 10});
+  ASSERT_EQ(replicator.numSplitPartitions(), 0);
+
+  spec.skewedPartitions = {};
+  VELOX_ASSERT_THROW(
+      (SkewedPartitionSplitter{spec, 4}),
+      "Skew split requires the list of skewed partitions");
+  spec.skewedPartitions = {4};
+  VELOX_ASSERT_THROW(
+      (SkewedPartitionSplitter{spec, 4}), "Invalid skewed partition");
+  VELOX_ASSERT_THROW(
+      skewSplitModeFromName("SPLIT"), "Unknown skew split mode: SPLIT");
+}
+
+TEST_F(ShuffleTest, partitionAndSerializeSkewSplit) {
+  const int32_t numPartitions = 4;
+  const int32_t skewedKey = 7;
+  SkewSplitSpec spec;
+  spec.mode = SkewSplitMode::kSalt;
+  spec.maxSubPartitions = 4;
+  spec.skewFactor = 1.5;
+  spec.minPartitionBytes = 1;
+  spec.skewedPartitions = {hashPartition(skewedKey, numPartitions)};
+
+  // All rows have the same key. The first batch goes to a single partition,
+  // which is then split over 3 destinations for the following batches.
+  std::vector<RowVectorPtr> data;
+  for (auto i = 0; i < 5; ++i) {
+    data.push_back(makeRowVector({
+        makeConstant<int32_t>(skewedKey, 1'000),
+        makeFlatVector<int64_t>(1'000, [](auto row) { return row; }),
+    }));
+  }
+  auto results =
+      exec::test::AssertQueryBuilder(
+          makeSkewSplitPlan(data, spec, numPartitions))
+          .copyResults(pool());
+  ASSERT_EQ(results->size(), 5 * 1'000);
+  auto* partitions = results->childAt(0)->as<SimpleVector<int32_t>>();
+  std::set<int32_t> uniquePartitions;
+  for (auto i = 0; i < results->size(); ++i) {
+    uniquePartitions.insert(partitions->valueAt(i));
+  }
+  ASSERT_EQ(uniquePartitions.size(), 3);
+
+  // A partition that is not listed as skewed is never split.
+  spec.skewedPartitions = {(spec.skewedPartitions[0] + 1) % numPartitions};
+  results = exec::test::AssertQueryBuilder(
+                makeSkewSplitPlan(data, spec, numPartitions))
+                .copyResults(pool());
+  partitions = results->childAt(0)->as<SimpleVector<int32_t>>();
+  for (auto i = 0; i < results->size(); ++i) {
+    ASSERT_EQ(partitions->valueAt(i), partitions->valueAt(0));
+  }
+
+  // Each row of the skewed partition is written to its partition and the
+  // next one. The other rows are written once.
+  data = {makeRowVector({
+      makeFlatVector<int32_t>(100, [](auto row) { return row; }),
+      makeFlatVector<int64_t>(100, [](auto row) { return row; }),
+  })};
+  spec.mode = SkewSplitMode::kReplicate;
+  spec.maxSubPartitions = 2;
+  const int32_t skewedPartition = spec.skewedPartitions[0];
+  results = exec::test::AssertQueryBuilder(
+                makeSkewSplitPlan(data, spec, numPartitions))
+                .copyResults(pool());
+  vector_size_t numSkewedRows = 0;
+  for (auto key = 0; key < 100; ++key) {
+    numSkewedRows +=
+        hashPartition(key, numPartitions) == spec.skewedPartitions[0];
+  }
+  ASSERT_GT(numSkewedRows, 0);
+  ASSERT_EQ(results->size(), 100 + numSkewedRows);
+  partitions = results->childAt(0)->as<SimpleVector<int32_t>>();
+  auto* serialized = results->childAt(2)->as<SimpleVector<StringView>>();
+  for (auto i = 0; i < results->size(); ++i) {
+    if (partitions->valueAt(i) != skewedPartition) {
+      continue;
+    }
+    ASSERT_EQ(
+        partitions->valueAt(i + 1), (skewedPartition + 1) % numPartitions);
+    ASSERT_EQ(serialized->valueAt(i + 1), serialized->valueAt(i));
+    ++i;
+  }
+}
+
+TEST_F(ShuffleTest, skewSplitJoinEquivalence) {
+  const int32_t numPartitions = 4;
+  const int32_t numKeys = 20;
+  const int32_t numBuildKeys = 15;
+  const int32_t skewedKey = 7;
+
+  // Most probe rows have 'skewedKey'. The probe keys past 'numBuildKeys' have
+  // no match.
+  auto probe = makeRowVector({
+      makeFlatVector<int32_t>(
+          5'000,
+          [&](auto row) {
+            return row % 10 == 0 ? row / 10 % numKeys : skewedKey;
+          }),
+      makeFlatVector<int64_t>(5'000, [](auto row) { return row; }),
+  });
+  std::vector<RowVectorPtr> probeBatches;
+  for (auto i = 0; i < 5; ++i) {
+    probeBatches.push_back(
+        std::dynamic_pointer_cast<RowVector>(probe->slice(i * 1'000, 1'000)));
+  }
+  auto build = makeRowVector({
+      makeFlatVector<int32_t>(
+          3 * numBuildKeys, [&](auto row) { return row % numBuildKeys; }),
+      makeFlatVector<int64_t>(3 * numBuildKeys, [](auto row) { return row; }),
+  });
+
+  SkewSplitSpec spec;
+  spec.maxSubPartitions = 3;
+  spec.skewFactor = 1.5;
+  spec.minPartitionBytes = 1;
+  spec.skewedPartitions = {hashPartition(skewedKey, numPartitions)};
+  spec.mode = SkewSplitMode::kSalt;
+  const auto probeDestinations = deserializeByDestination(
+      exec::test::AssertQueryBuilder(
+          makeSkewSplitPlan(probeBatches, spec, numPartitions))
+          .copyResults(pool()),
+      asRowType(probe->type()),
+      numPartitions);
+  spec.mode = SkewSplitMode::kReplicate;
+  const auto buildDestinations = deserializeByDestination(
+      exec::test::AssertQueryBuilder(
+          makeSkewSplitPlan({build}, spec, numPartitions))
+          .copyResults(pool()),
+      asRowType(build->type()),
+      numPartitions);
+
+  // The rows of 'skewedKey' are spread over 3 destinations.
+  int32_t numSkewedKeyDestinations = 0;
+  for (const auto& destination : probeDestinations) {
+    auto* keys = destination->childAt(0)->as<SimpleVector<int32_t>>();
+    for (auto i = 0; i < destination->size(); ++i) {
+      if (keys->valueAt(i) == skewedKey) {
+        ++numSkewedKeyDestinations;
+        break;
+      }
+    }
+  }
+  ASSERT_EQ(numSkewedKeyDestinations, 3);
+
+  // Only the build rows of the skewed partition are replicated.
+  vector_size_t numBuildRows = 0;
+  for (const auto& destination : buildDestinations) {
+    numBuildRows += destination->size();
+  }
+  vector_size_t numSkewedBuildRows = 0;
+  for (auto row = 0; row < build->size(); ++row) {
+    numSkewedBuildRows +=
+        hashPartition(row % numBuildKeys, numPartitions) ==
+        spec.skewedPartitions[0];
+  }
+  ASSERT_EQ(numBuildRows, build->size() + 2 * numSkewedBuildRows);
+
+  const auto join = [&](const RowVectorPtr& probeRows,
+                        const RowVectorPtr& buildRows,
+                        core::JoinType joinType) {
+    auto planNodeIdGenerator = std::make_shared<core::PlanNodeIdGenerator>();
+    auto plan = exec::test::PlanBuilder(planNodeIdGenerator)
+                    .values({probeRows})
+                    .hashJoin(
+                        {"c0"},
+                        {"u0"},
+                        exec::test::PlanBuilder(planNodeIdGenerator)
+                            .values({buildRows})
+                            .project({"c0 AS u0", "c1 AS u1"})
+                            .planNode(),
+                        "",
+                        {"c0", "c1", "u1"},
+                        joinType)
+                    .planNode();
+    return exec::test::AssertQueryBuilder(plan).copyResults(pool());
+  };
+
+  // Joining each destination separately gives the result of the join of the
+  // unsplit inputs.
+  for (const auto joinType : {core::JoinType::kInner, core::JoinType::kLeft}) {
+    SCOPED_TRACE(joinType == core::JoinType::kInner ? "inner" : "left");
+    std::vector<RowVectorPtr> actual;
+    for (auto destination = 0; destination < numPartitions; ++destination) {
+      actual.push_back(join(
+          probeDestinations[destination],
+          buildDestinations[destination],
+          joinType));
+    }
+    exec::test::assertEqualResults({join(probe, build, joinType)}, actual);
+  }
+}
+
 TEST_F(ShuffleTest, partitionAndSerializeEndToEnd) {
   auto data = makeRowVector({
       makeFlatVector<int32_t>({1, 2, 3, 4, 5, 6}),
@@ -1514,10 +1839,17 @@ TEST_F(ShuffleTest, shuffleWriterReader) {
     size_t minDataSize;
     size_t maxDataSize;
     std::optional<int> expectedOutputCalls;
+    bool consolidateFiles{false};
+    uint64_t mergeMemoryBytes{0};
+    std::optional<int64_t> expectedMergePasses;
+    bool backgroundFlush{false};
     std::string debugString() const {
       return fmt::format(
-          "sorted:{}, maxBytesPerPartition:{}, rows:{}, readMax:{}, dataSize:{}-{}, expectedCalls:{}",
+          "sorted:{}, consolidate:{}, mergeMemory:{}, backgroundFlush:{}, maxBytesPerPartition:{}, rows:{}, readMax:{}, dataSize:{}-{}, expectedCalls:{}",
           sortedShuffle,
+          consolidateFiles,
+          mergeMemoryBytes,
+          backgroundFlush,
           maxBytesPerPartition,
           numRows,
           readMaxBytes,
@@ -1603,6 +1935,99 @@ TEST_F(ShuffleTest, shuffleWriterReader) {
        .minDataSize = 64,
        .maxDataSize = 64,
        .expectedOutputCalls = 1},
+      // Consolidated data files: blocks are read as segments of one file.
+      {.sortedShuffle = true,
+       .maxBytesPerPartition = 500,
+       .numRows = 20,
+       .readMaxBytes = 1024 * 1024,
+       .minDataSize = 50,
+       .maxDataSize = 150,
+       .consolidateFiles = true},
+      {.sortedShuffle = true,
+       .maxBytesPerPartition = 1,
+       .numRows = 20,
+       .readMaxBytes = 100,
+       .minDataSize = 64,
+       .maxDataSize = 64,
+       .expectedOutputCalls = 20,
+       .consolidateFiles = true},
+      {.sortedShuffle = false,
+       .maxBytesPerPartition = 1,
+       .numRows = 20,
+       .readMaxBytes = 100,
+       .minDataSize = 64,
+       .maxDataSize = 64,
+       .expectedOutputCalls = 20,
+       .consolidateFiles = true},
+      {.sortedShuffle = false,
+       .maxBytesPerPartition = 1,
+       .numRows = 20,
+       .readMaxBytes = 1 << 25,
+       .minDataSize = 64,
+       .maxDataSize = 64,
+       .expectedOutputCalls = 1,
+       .consolidateFiles = true},
+      // Merge memory limit: 20 blocks are merged 3 at a time into 7 and then
+      // 3 intermediate runs before the final merge.
+      {.sortedShuffle = true,
+       .maxBytesPerPartition = 1,
+       .numRows = 20,
+       .readMaxBytes = 1024 * 1024,
+       .minDataSize = 50,
+       .maxDataSize = 150,
+       .mergeMemoryBytes = 4 * LocalShuffleReader::kMinMergeBufferSize,
+       .expectedMergePasses = 3},
+      {.sortedShuffle = true,
+       .maxBytesPerPartition = 1,
+       .numRows = 20,
+       .readMaxBytes = 100,
+       .minDataSize = 64,
+       .maxDataSize = 64,
+       .expectedOutputCalls = 20,
+       .consolidateFiles = true,
+       .mergeMemoryBytes = 4 * LocalShuffleReader::kMinMergeBufferSize,
+       .expectedMergePasses = 3},
+      // Enough memory for a single pass with smaller buffers.
+      {.sortedShuffle = true,
+       .maxBytesPerPartition = 1,
+       .numRows = 20,
+       .readMaxBytes = 1024 * 1024,
+       .minDataSize = 50,
+       .maxDataSize = 150,
+       .mergeMemoryBytes = 20 * LocalShuffleReader::kMinMergeBufferSize,
+       .expectedMergePasses = 1},
+      // Blocks written in the background, one pending block at a time.
+      {.sortedShuffle = false,
+       .maxBytesPerPartition = 1,
+       .numRows = 20,
+       .readMaxBytes = 1024 * 1024,
+       .minDataSize = 64,
+       .maxDataSize = 64,
+       .backgroundFlush = true},
+      {.sortedShuffle = true,
+       .maxBytesPerPartition = 200,
+       .numRows = 50,
+       .readMaxBytes = 1024 * 1024,
+       .minDataSize = 50,
+       .maxDataSize = 150,
+       .backgroundFlush = true},
+      {.sortedShuffle = true,
+       .maxBytesPerPartition = 200,
+       .numRows = 50,
+       .readMaxBytes = 1024 * 1024,
+       .minDataSize = 50,
+       .maxDataSize = 150,
+       .consolidateFiles = true,
+       .backgroundFlush = true},
+      // Sorted blocks larger than the staging buffer of the writer, with rows
+      // smaller and larger than the staging buffer.
+      {.sortedShuffle = true,
+       .maxBytesPerPartition =
+           3 * LocalShuffleWriter::kMaxSortedWriteBufferSize,
+       .numRows = 10,
+       .readMaxBytes = 16 << 20,
+       .minDataSize = LocalShuffleWriter::kMaxSortedWriteBufferSize / 4,
+       .maxDataSize = 3 * LocalShuffleWriter::kMaxSortedWriteBufferSize / 2},
   };
 
   for (const auto& config : testSettings) {
@@ -1621,7 +2046,10 @@ TEST_F(ShuffleTest, shuffleWriterReader) {
         writeInfo.numPartitions,
         config.maxBytesPerPartition,
         config.sortedShuffle,
-        pool());
+        pool(),
+        config.consolidateFiles,
+        config.backgroundFlush ? executor_.get() : nullptr,
+        /*maxPendingFlushBytes=*/1);
 
     std::vector<int32_t> keys;
     std::vector<std::string> dataValues;
@@ -1661,6 +2089,24 @@ TEST_F(ShuffleTest, shuffleWriterReader) {
       }
     }
     writer->noMoreData(true);
+    if (config.backgroundFlush) {
+      EXPECT_GT(writer->stats().at("local.write.blocks"), 1);
+    }
+    if (config.consolidateFiles) {
+      // One data and one index file, no matter how many blocks. The index
+      // is renamed from its temporary name.
+      EXPECT_EQ(writer->stats().at("local.write.files"), 2);
+      const auto files =
+          velox::filesystems::getFileSystem(testRootPath, nullptr)
+              ->list(fmt::format("{}/", testRootPath));
+      ASSERT_EQ(files.size(), 2);
+      EXPECT_EQ(
+          std::count_if(
+              files.begin(),
+              files.end(),
+              [](const auto& file) { return file.ends_with(".index"); }),
+          1);
+    }
 
     LocalShuffleReadInfo readInfo = LocalShuffleReadInfo::deserialize(
         localShuffleReadInfo(testRootPath, partition, config.sortedShuffle));
@@ -1670,8 +2116,17 @@ TEST_F(ShuffleTest, shuffleWriterReader) {
         readInfo.queryId,
         readInfo.partitionIds,
         config.sortedShuffle,
-        pool());
+        pool(),
+        config.mergeMemoryBytes);
     reader->initialize();
+    if (config.expectedMergePasses.has_value()) {
+      EXPECT_EQ(
+          reader->stats().at("local.read.mergePasses"),
+          config.expectedMergePasses.value());
+      EXPECT_EQ(
+          reader->stats().at("local.read.mergeSpilledBytes") > 0,
+          config.expectedMergePasses.value() > 1);
+    }
 
     size_t totalRows = 0;
     int numOutputCalls = 0;
@@ -1695,6 +2150,9 @@ TEST_F(ShuffleTest, shuffleWriterReader) {
     }
 
     EXPECT_EQ(config.numRows, totalRows);
+    EXPECT_EQ(
+        reader->stats().at("local.read.segments"),
+        writer->stats().at("local.write.blocks"));
 
     if (config.sortedShuffle) {
       // Verify data came back in sorted order
@@ -1728,10 +2186,170 @@ TEST_F(ShuffleTest, shuffleWriterReader) {
     }
 
     reader->noMoreData(true);
+    // Intermediate merge runs are deleted.
+    for (const auto& file :
+         velox::filesystems::getFileSystem(testRootPath, nullptr)
+             ->list(fmt::format("{}/", testRootPath))) {
+      EXPECT_EQ(file.find("_merge_"), std::string::npos) << file;
+    }
     cleanupDirectory(testRootPath);
   }
 }
 
+TEST_F(ShuffleTest, shuffleWriterFailure) {
+  const uint32_t numPartitions = 2;
+  for (const auto& [consolidateFiles, backgroundFlush] :
+       std::vector<std::pair<bool, bool>>{
+           {false, false}, {true, false}, {false, true}, {true, true}}) {
+    SCOPED_TRACE(fmt::format(
+        "consolidateFiles: {}, backgroundFlush: {}",
+        consolidateFiles,
+        backgroundFlush));
+    auto tempRootDir = velox::exec::test::TempDirectoryPath::create();
+    const auto testRootPath = tempRootDir->getPath();
+    auto fileSystem = velox::filesystems::getFileSystem(testRootPath, nullptr);
+
+    LocalShuffleWriteInfo writeInfo = LocalShuffleWriteInfo::deserialize(
+        localShuffleWriteInfo(testRootPath, numPartitions));
+    auto writer = std::make_shared<LocalShuffleWriter>(
+        writeInfo.rootPath,
+        writeInfo.queryId,
+        writeInfo.shuffleId,
+        writeInfo.numPartitions,
+        /*maxBytesPerPartition=*/100,
+        /*sortedShuffle=*/false,
+        pool(),
+        consolidateFiles,
+        backgroundFlush ? executor_.get() : nullptr,
+        /*maxPendingFlushBytes=*/1);
+    // Every other row of a partition fills a block, so each partition has
+    // written blocks and an in-progress block.
+    const std::string data(64, 'a');
+    for (int i = 0; i < 10; ++i) {
+      writer->collect(i % numPartitions, std::string_view{}, data);
+    }
+    if (!backgroundFlush) {
+      ASSERT_GT(writer->stats().at("local.write.blocks"), 0);
+      ASSERT_FALSE(
+          fileSystem->list(fmt::format("{}/", testRootPath)).empty());
+    }
+
+    // No block, data file or index is written after the cleanup.
+    const auto numBlocks = writer->stats().at("local.write.blocks");
+    writer->noMoreData(false);
+    EXPECT_EQ(writer->stats().at("local.write.blocks"), numBlocks);
+    EXPECT_TRUE(fileSystem->list(fmt::format("{}/", testRootPath)).empty());
+  }
+}
+
+TEST_F(ShuffleTest, shuffleWriterFlushError) {
+  auto tempRootDir = velox::exec::test::TempDirectoryPath::create();
+  // Blocks cannot be written to a directory that does not exist.
+  const auto testRootPath = tempRootDir->getPath() + "/missing";
+  LocalShuffleWriteInfo writeInfo = LocalShuffleWriteInfo::deserialize(
+      localShuffleWriteInfo(testRootPath, 1));
+  folly::ManualExecutor flushExecutor;
+  auto writer = std::make_shared<LocalShuffleWriter>(
+      writeInfo.rootPath,
+      writeInfo.queryId,
+      writeInfo.shuffleId,
+      writeInfo.numPartitions,
+      /*maxBytesPerPartition=*/1,
+      /*sortedShuffle=*/false,
+      pool(),
+      /*consolidateFiles=*/false,
+      &flushExecutor,
+      /*maxPendingFlushBytes=*/1 << 20);
+
+  // Full blocks are handed to the executor.
+  const std::string data(64, 'a');
+  for (int i = 0; i < 10; ++i) {
+    writer->collect(0, std::string_view{}, data);
+  }
+  flushExecutor.drain();
+  EXPECT_EQ(writer->stats().at("local.write.blocks"), 0);
+
+  // The error of the background write is thrown by the next call. It names
+  // the file that could not be created.
+  VELOX_ASSERT_THROW(
+      writer->collect(0, std::string_view{}, data), testRootPath + "/");
+}
+
+TEST_F(ShuffleTest, shuffleWriterFlushBackpressure) {
+  auto tempRootDir = velox::exec::test::TempDirectoryPath::create();
+  const auto testRootPath = tempRootDir->getPath();
+  LocalShuffleWriteInfo writeInfo = LocalShuffleWriteInfo::deserialize(
+      localShuffleWriteInfo(testRootPath, 1));
+
+  // Keeps the flush thread busy so that the first block stays pending until
+  // 'release' is posted.
+  auto flushExecutor = std::make_unique<folly::CPUThreadPoolExecutor>(1);
+  folly::Baton<> release;
+  flushExecutor->add([&]() { release.wait(); });
+  auto writer = std::make_shared<LocalShuffleWriter>(
+      writeInfo.rootPath,
+      writeInfo.queryId,
+      writeInfo.shuffleId,
+      writeInfo.numPartitions,
+      /*maxBytesPerPartition=*/1,
+      /*sortedShuffle=*/false,
+      pool(),
+      /*consolidateFiles=*/false,
+      flushExecutor.get(),
+      /*maxPendingFlushBytes=*/1);
+  std::thread releaser([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    release.post();
+  });
+
+  // Only one block may be pending, so the second block waits for the first
+  // one to be written.
+  const std::string data(64, 'a');
+  for (int i = 0; i < 20; ++i) {
+    writer->collect(0, std::string_view{}, data);
+  }
+  writer->noMoreData(true);
+  releaser.join();
+  EXPECT_GT(writer->stats().at("local.write.flushWaitNanos"), 0);
+  const auto numBlocks = writer->stats().at("local.write.blocks");
+  EXPECT_GT(numBlocks, 1);
+  EXPECT_EQ(
+      velox::filesystems::getFileSystem(testRootPath, nullptr)
+          ->list(fmt::format("{}/", testRootPath))
+          .size(),
+      numBlocks);
+}
+
+TEST_F(ShuffleTest, normalizedKeyPrefix) {
+  const std::vector<std::string> keys{
+      "",
+      std::string(1, '\0'),
+      std::string(9, '\0'),
+      "a",
+      std::string("a\0", 2),
+      "ab",
+      "abcdefgh",
+      "abcdefgh\x01",
+      "abcdefgi",
+      "b",
+      "\xff\xff\xff\xff\xff\xff\xff\xff",
+      "\xff\xff\xff\xff\xff\xff\xff\xff\xff"};
+  for (const auto& key1 : keys) {
+    for (const auto& key2 : keys) {
+      SCOPED_TRACE(fmt::format("'{}' vs '{}'", key1, key2));
+      EXPECT_EQ(
+          compareKeys(
+              normalizedKeyPrefix(key1), key1, normalizedKeyPrefix(key2), key2),
+          compareKeys(key1, key2));
+      if (normalizedKeyPrefix(key1) != normalizedKeyPrefix(key2)) {
+        EXPECT_EQ(
+            normalizedKeyPrefix(key1) < normalizedKeyPrefix(key2),
+            compareKeys(key1, key2));
+      }
+    }
+  }
+}
+
 TEST_F(ShuffleTest, shuffleFuzzTest) {
   fuzzerTest(false, 1);
   fuzzerTest(false, 3);
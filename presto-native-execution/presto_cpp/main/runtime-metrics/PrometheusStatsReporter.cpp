@@ -14,6 +14,9 @@
 
 #include "presto_cpp/main/runtime-metrics/PrometheusStatsReporter.h"
 
+#include <folly/Bits.h>
+#include <folly/lang/Align.h>
+#include <folly/synchronization/SmallLocks.h>
 #include <prometheus/collectable.h>
 #include <prometheus/counter.h>
 #include <prometheus/gauge.h>
@@ -22,6 +25,11 @@
 #include <prometheus/summary.h>
 #include <prometheus/text_serializer.h>
 
+#include <limits>
+#include <thread>
+
+#include "velox/common/base/BitUtil.h"
+
 namespace facebook::presto::prometheus {
 
 // Initialize singleton for the reporter
@@ -34,8 +42,181 @@ folly::Singleton<facebook::velox::BaseStatsReporter> reporter(
 
 static constexpr std::string_view kSummarySuffix("_summary");
 
+namespace {
+// Upper bound on the number of shards. With more recording threads than
+// shards, threads share shards and contend on the same cache lines.
+constexpr uint32_t kMaxShards = 64;
+
+// Number of buffered summary observations per shard before they are pushed
+// to the Prometheus summary on the recording thread.
+constexpr size_t kSummaryBufferCapacity = 1'024;
+
+// Marks a gauge that was not set since the last fetchMetrics().
+constexpr int64_t kNoGaugeValue = std::numeric_limits<int64_t>::min();
+
+// Returns a stable per-thread index that is used to pick a shard.
+uint32_t threadIndex() {
+  static std::atomic<uint32_t> nextThreadIndex{0};
+  thread_local const uint32_t index =
+      nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+std::string sanitizeMetricKey(std::string_view key) {
+  // '.' is replaced with '_'.
+  std::string sanitizedMetricKey{key};
+  std::replace(sanitizedMetricKey.begin(), sanitizedMetricKey.end(), '.', '_');
+  return sanitizedMetricKey;
+}
+
+/// Dense int64 cells, one copy per shard. A metric owns a contiguous range of
+/// cells in one chunk that is allocated at registration. Chunks never move, so
+/// allocating more cells does not block or invalidate concurrent writers.
+/// Ranges of up to kChunkSize cells share chunks. A larger range, e.g. a
+/// histogram with thousands of buckets, gets a chunk of its own.
+class ShardedCells {
+ public:
+  static constexpr uint32_t kChunkSize = 512;
+
+  /// Cells of all shards for a range of indices. The cells of each shard are
+  /// padded to separate cache lines.
+  class Chunk {
+   public:
+    Chunk(uint32_t numShards, uint32_t size)
+        : size_(size),
+          stride_(velox::bits::roundUp(size, kCellsPerCacheLine)),
+          cells_(new std::atomic<int64_t>[numShards * stride_]()) {}
+
+    uint32_t size() const {
+      return size_;
+    }
+
+    std::atomic<int64_t>* shardCells(uint32_t shard) const {
+      return &cells_[shard * stride_];
+    }
+
+   private:
+    static constexpr uint32_t kCellsPerCacheLine =
+        folly::hardware_destructive_interference_size / sizeof(int64_t);
+
+    const uint32_t size_;
+    const uint32_t stride_;
+    const std::unique_ptr<std::atomic<int64_t>[]> cells_;
+  };
+
+  /// Contiguous cells of a metric.
+  struct Range {
+    Chunk* chunk{nullptr};
+    uint32_t first{0};
+  };
+
+  explicit ShardedCells(uint32_t numShards)
+      : numShards_(numShards), shardMask_(numShards - 1) {
+    VELOX_CHECK(folly::isPowTwo(numShards));
+  }
+
+  /// Reserves 'count' contiguous cells in every shard. Calls must be
+  /// serialized by the caller.
+  Range allocate(uint32_t count) {
+    VELOX_CHECK_GT(count, 0);
+    if (count > kChunkSize) {
+      chunks_.push_back(std::make_unique<Chunk>(numShards_, count));
+      return {chunks_.back().get(), 0};
+    }
+    if (current_ == nullptr || currentSize_ + count > kChunkSize) {
+      chunks_.push_back(std::make_unique<Chunk>(numShards_, kChunkSize));
+      current_ = chunks_.back().get();
+      currentSize_ = 0;
+    }
+    const Range range{current_, currentSize_};
+    currentSize_ += count;
+    return range;
+  }
+
+  /// Returns the cells of the calling thread's shard for 'range'.
+  std::atomic<int64_t>* localCells(const Range& range) const {
+    return range.chunk->shardCells(threadIndex() & shardMask_) + range.first;
+  }
+
+  /// Returns the sum of cell 'index' of 'range' over all shards and resets it
+  /// to 0.
+  int64_t drain(const Range& range, uint32_t index = 0) const {
+    VELOX_DCHECK_LT(range.first + index, range.chunk->size());
+    int64_t sum = 0;
+    for (uint32_t shard = 0; shard < numShards_; ++shard) {
+      sum += range.chunk->shardCells(shard)[range.first + index].exchange(
+          0, std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  const uint32_t numShards_;
+  const uint32_t shardMask_;
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  // Chunk that small ranges are allocated from and its used cells.
+  Chunk* current_{nullptr};
+  uint32_t currentSize_{0};
+};
+
+/// Per-shard buffer of observations for a summary. Summaries need individual
+/// values to compute quantiles, so they cannot be pre-aggregated in cells.
+struct alignas(folly::hardware_destructive_interference_size) SummaryShard {
+  folly::MicroSpinLock lock{0};
+  std::vector<double> values;
+};
+} // namespace
+
+/// Lock-free recording state of a registered metric.
+struct MetricState {
+  std::string key;
+  velox::StatType statType;
+  // Prometheus object the recorded values are aggregated into.
+  void* metricPtr{nullptr};
+  // Cells of this metric in ShardedCells. COUNT and SUM use one cell.
+  // HISTOGRAM uses one cell per bucket followed by a cell for the sum of
+  // observed values.
+  ShardedCells::Range cells;
+
+  // Last value of an AVG or RATE gauge.
+  std::atomic<int64_t> gaugeValue{kNoGaugeValue};
+
+  // Histogram buckets. The upper bounds are min + bucketWidth * (i + 1) for
+  // 'numBounds' finite buckets plus one overflow bucket.
+  int64_t min{0};
+  int64_t bucketWidth{1};
+  uint32_t numBounds{0};
+
+  ::prometheus::Summary* summary{nullptr};
+  std::unique_ptr<SummaryShard[]> summaryShards;
+  uint32_t summaryShardMask{0};
+
+  // Returns the bucket index for 'value' matching the 'le' semantics of
+  // Prometheus histogram buckets.
+  uint32_t bucketIndex(size_t value) const {
+    if (value > static_cast<size_t>(std::numeric_limits<int64_t>::max())) {
+      return numBounds;
+    }
+    const auto signedValue = static_cast<int64_t>(value);
+    if (signedValue <= min + bucketWidth) {
+      return 0;
+    }
+    const auto index =
+        (signedValue - min + bucketWidth - 1) / bucketWidth - 1;
+    return index >= numBounds ? numBounds : static_cast<uint32_t>(index);
+  }
+
+  void flushSummary(SummaryShard& shard) const {
+    for (auto value : shard.values) {
+      summary->Observe(value);
+    }
+    shard.values.clear();
+  }
+};
+
 struct PrometheusStatsReporter::PrometheusImpl {
-  explicit PrometheusImpl(const ::prometheus::Labels& labels) {
+  PrometheusImpl(const ::prometheus::Labels& labels, uint32_t numShards)
+      : numShards(numShards), cells(numShards) {
     registry = std::make_shared<::prometheus::Registry>();
     for (const auto& itr : labels) {
       this->labels[itr.first] = itr.second;
@@ -44,32 +225,51 @@ struct PrometheusStatsReporter::PrometheusImpl {
 
   ::prometheus::Labels labels;
   std::shared_ptr<::prometheus::Registry> registry;
+  const uint32_t numShards;
+  ShardedCells cells;
+  // Registered metrics in registration order. The position is the dense
+  // metric index.
+  std::vector<std::unique_ptr<MetricState>> metrics;
 };
 
+namespace {
+uint32_t resolveNumShards(uint32_t numShards) {
+  if (numShards == 0) {
+    numShards = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+  }
+  return std::min(kMaxShards, folly::nextPowTwo(numShards));
+}
+} // namespace
+
 PrometheusStatsReporter::PrometheusStatsReporter(
     const std::map<std::string, std::string>& labels,
-    int numThreads)
-    : executor_(std::make_shared<folly::CPUThreadPoolExecutor>(numThreads)),
-      impl_(std::make_shared<PrometheusImpl>(labels)) {}
+    uint32_t numShards)
+    : impl_(std::make_shared<PrometheusImpl>(
+          labels,
+          resolveNumShards(numShards))) {}
+
+PrometheusStatsReporter::~PrometheusStatsReporter() = default;
 
 void PrometheusStatsReporter::registerMetricExportType(
     const char* key,
     facebook::velox::StatType statType) const {
+  std::lock_guard<std::mutex> l(mutex_);
   if (registeredMetricsMap_.find(key) != registeredMetricsMap_.end()) {
     VLOG(1) << "Trying to register already registered metric " << key;
     return;
   }
-  // '.' is replaced with '_'.
-  std::string sanitizedMetricKey = std::string(key);
-  std::replace(sanitizedMetricKey.begin(), sanitizedMetricKey.end(), '.', '_');
+  const auto sanitizedMetricKey = sanitizeMetricKey(key);
+  auto state = std::make_unique<MetricState>();
+  state->key = key;
+  state->statType = statType;
   switch (statType) {
     case facebook::velox::StatType::COUNT: {
       // A new MetricFamily object is built for every new metric key.
       auto& counterFamily = ::prometheus::BuildCounter()
                                 .Name(sanitizedMetricKey)
                                 .Register(*impl_->registry);
-      auto& counter = counterFamily.Add(impl_->labels);
-      registeredMetricsMap_.insert({key, StatsInfo{statType, &counter}});
+      state->metricPtr = &counterFamily.Add(impl_->labels);
+      state->cells = impl_->cells.allocate(1);
     } break;
     case facebook::velox::StatType::SUM:
     case facebook::velox::StatType::AVG:
@@ -77,14 +277,19 @@ void PrometheusStatsReporter::registerMetricExportType(
       auto& gaugeFamily = ::prometheus::BuildGauge()
                               .Name(sanitizedMetricKey)
                               .Register(*impl_->registry);
-      auto& gauge = gaugeFamily.Add(impl_->labels);
-      registeredMetricsMap_.insert(
-          std::string(key), StatsInfo{statType, &gauge});
+      state->metricPtr = &gaugeFamily.Add(impl_->labels);
+      if (statType == facebook::velox::StatType::SUM) {
+        state->cells = impl_->cells.allocate(1);
+      }
     } break;
     default:
       VELOX_UNSUPPORTED(
           "Unsupported metric type {}", velox::statTypeString(statType));
   }
+  std::string_view mapKey = state->key;
+  registeredMetricsMap_.insert(
+      mapKey, StatsInfo{statType, state->metricPtr, state.get()});
+  impl_->metrics.push_back(std::move(state));
 }
 
 void PrometheusStatsReporter::registerMetricExportType(
@@ -99,6 +304,7 @@ void PrometheusStatsReporter::registerHistogramMetricExportType(
     int64_t min,
     int64_t max,
     const std::vector<int32_t>& pcts) const {
+  std::lock_guard<std::mutex> l(mutex_);
   if (registeredMetricsMap_.find(key) != registeredMetricsMap_.end()) {
     // Already registered;
     VLOG(1) << "Trying to register already registered metric " << key;
@@ -106,9 +312,7 @@ void PrometheusStatsReporter::registerHistogramMetricExportType(
   }
   auto numBuckets = (max - min) / bucketWidth;
   auto bound = min + bucketWidth;
-  std::string sanitizedMetricKey = std::string(key);
-  // '.' is replaced with '_'.
-  std::replace(sanitizedMetricKey.begin(), sanitizedMetricKey.end(), '.', '_');
+  const auto sanitizedMetricKey = sanitizeMetricKey(key);
 
   auto& histogramFamily = ::prometheus::BuildHistogram()
                               .Name(sanitizedMetricKey)
@@ -123,8 +327,16 @@ void PrometheusStatsReporter::registerHistogramMetricExportType(
   VELOX_CHECK_GE(bucketBoundaries.size(), 1);
   auto& histogramMetric = histogramFamily.Add(impl_->labels, bucketBoundaries);
 
-  registeredMetricsMap_.insert(
-      key, StatsInfo{velox::StatType::HISTOGRAM, &histogramMetric});
+  auto state = std::make_unique<MetricState>();
+  state->key = key;
+  state->statType = velox::StatType::HISTOGRAM;
+  state->metricPtr = &histogramMetric;
+  state->min = min;
+  state->bucketWidth = bucketWidth;
+  state->numBounds = bucketBoundaries.size();
+  // One cell per bucket, including the overflow bucket, plus the sum.
+  state->cells = impl_->cells.allocate(state->numBounds + 2);
+
   // If percentiles are provided, create a Summary type metric and register.
   if (pcts.size() > 0) {
     auto summaryMetricKey = sanitizedMetricKey + std::string(kSummarySuffix);
@@ -137,11 +349,19 @@ void PrometheusStatsReporter::registerHistogramMetricExportType(
           ::prometheus::detail::CKMSQuantiles::Quantile(
               pct / static_cast<double>(100), 0));
     }
-    auto& summaryMetric = summaryFamily.Add({impl_->labels}, quantiles);
-    registeredMetricsMap_.insert(
-        std::string(key).append(kSummarySuffix),
-        StatsInfo{velox::StatType::HISTOGRAM, &summaryMetric});
+    state->summary = &summaryFamily.Add({impl_->labels}, quantiles);
+    state->summaryShards =
+        std::make_unique<SummaryShard[]>(impl_->numShards);
+    state->summaryShardMask = impl_->numShards - 1;
+    for (uint32_t i = 0; i < impl_->numShards; ++i) {
+      state->summaryShards[i].values.reserve(kSummaryBufferCapacity);
+    }
   }
+  std::string_view mapKey = state->key;
+  registeredMetricsMap_.insert(
+      mapKey,
+      StatsInfo{velox::StatType::HISTOGRAM, &histogramMetric, state.get()});
+  impl_->metrics.push_back(std::move(state));
 }
 
 void PrometheusStatsReporter::registerHistogramMetricExportType(
@@ -154,102 +374,166 @@ void PrometheusStatsReporter::registerHistogramMetricExportType(
       key.toString().c_str(), bucketWidth, min, max, pcts);
 }
 
+MetricState* PrometheusStatsReporter::findMetric(std::string_view key) const {
+  auto metricIterator = registeredMetricsMap_.find(key);
+  if (metricIterator == registeredMetricsMap_.end()) {
+    return nullptr;
+  }
+  // Metric states are never deregistered, so the state outlives the iterator.
+  return metricIterator->second.state;
+}
+
 void PrometheusStatsReporter::addMetricValue(
     const std::string& key,
     size_t value) const {
-  addMetricValue(key.c_str(), value);
+  recordMetricValue(key, value);
 }
 
 void PrometheusStatsReporter::addMetricValue(const char* key, size_t value)
     const {
-  executor_->add([this, key = std::string(key), value]() {
-    auto metricIterator = registeredMetricsMap_.find(key);
-    if (metricIterator == registeredMetricsMap_.end()) {
-      VLOG(1) << "addMetricValue called for unregistered metric " << key;
-      return;
-    }
-    auto statsInfo = metricIterator->second;
-    switch (statsInfo.statType) {
-      case velox::StatType::COUNT: {
-        auto* counter =
-            reinterpret_cast<::prometheus::Counter*>(statsInfo.metricPtr);
-        counter->Increment(static_cast<double>(value));
-        break;
-      }
-      case velox::StatType::SUM: {
-        auto* gauge =
-            reinterpret_cast<::prometheus::Gauge*>(statsInfo.metricPtr);
-        gauge->Increment(static_cast<double>(value));
-        break;
-      }
-      case velox::StatType::AVG:
-      case velox::StatType::RATE: {
-        // Overrides the existing state.
-        auto* gauge =
-            reinterpret_cast<::prometheus::Gauge*>(statsInfo.metricPtr);
-        gauge->Set(static_cast<double>(value));
-        break;
-      }
-      default:
-        VELOX_UNSUPPORTED(
-            "Unsupported metric type {}",
-            velox::statTypeString(statsInfo.statType));
-    };
-  });
+  recordMetricValue(key, value);
 }
 
 void PrometheusStatsReporter::addMetricValue(
     folly::StringPiece key,
     size_t value) const {
-  addMetricValue(key.toString().c_str(), value);
+  recordMetricValue(std::string_view(key.data(), key.size()), value);
+}
+
+void PrometheusStatsReporter::recordMetricValue(
+    std::string_view key,
+    size_t value) const {
+  auto* state = findMetric(key);
+  if (state == nullptr) {
+    VLOG(1) << "addMetricValue called for unregistered metric " << key;
+    return;
+  }
+  switch (state->statType) {
+    case velox::StatType::COUNT:
+    case velox::StatType::SUM:
+      impl_->cells.localCells(state->cells)
+          ->fetch_add(value, std::memory_order_relaxed);
+      break;
+    case velox::StatType::AVG:
+    case velox::StatType::RATE:
+      // Overrides the existing state.
+      state->gaugeValue.store(value, std::memory_order_relaxed);
+      break;
+    default:
+      VELOX_UNSUPPORTED(
+          "Unsupported metric type {}",
+          velox::statTypeString(state->statType));
+  };
 }
 
 void PrometheusStatsReporter::addHistogramMetricValue(
     const std::string& key,
     size_t value) const {
-  addHistogramMetricValue(key.c_str(), value);
+  recordHistogramMetricValue(key, value);
 }
 
 void PrometheusStatsReporter::addHistogramMetricValue(
     const char* key,
     size_t value) const {
-  executor_->add([this, key = std::string(key), value]() {
-    auto metricIterator = registeredMetricsMap_.find(key);
-    if (metricIterator == registeredMetricsMap_.end()) {
-      VLOG(1) << "addMetricValue for unregistered metric " << key;
-      return;
-    }
-    auto histogram = reinterpret_cast<::prometheus::Histogram*>(
-        metricIterator->second.metricPtr);
-    histogram->Observe(value);
-
-    std::string summaryKey = std::string(key).append(kSummarySuffix);
-    metricIterator = registeredMetricsMap_.find(summaryKey);
-    if (metricIterator != registeredMetricsMap_.end()) {
-      auto summary = reinterpret_cast<::prometheus::Summary*>(
-          metricIterator->second.metricPtr);
-      summary->Observe(value);
-    }
-  });
+  recordHistogramMetricValue(key, value);
 }
 
 void PrometheusStatsReporter::addHistogramMetricValue(
     folly::StringPiece key,
     size_t value) const {
-  addHistogramMetricValue(key.toString().c_str(), value);
+  recordHistogramMetricValue(std::string_view(key.data(), key.size()), value);
+}
+
+void PrometheusStatsReporter::recordHistogramMetricValue(
+    std::string_view key,
+    size_t value) const {
+  const auto* state = findMetric(key);
+  if (state == nullptr || state->statType != velox::StatType::HISTOGRAM) {
+    VLOG(1) << "addMetricValue for unregistered metric " << key;
+    return;
+  }
+  auto* cells = impl_->cells.localCells(state->cells);
+  cells[state->bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  cells[state->numBounds + 1].fetch_add(value, std::memory_order_relaxed);
+
+  if (state->summary != nullptr) {
+    auto& shard =
+        state->summaryShards[threadIndex() & state->summaryShardMask];
+    std::lock_guard<folly::MicroSpinLock> l(shard.lock);
+    if (shard.values.size() == kSummaryBufferCapacity) {
+      state->flushSummary(shard);
+    }
+    shard.values.push_back(value);
+  }
+}
+
+void PrometheusStatsReporter::drainMetrics() const {
+  for (const auto& state : impl_->metrics) {
+    switch (state->statType) {
+      case velox::StatType::COUNT: {
+        const auto delta = impl_->cells.drain(state->cells);
+        if (delta != 0) {
+          reinterpret_cast<::prometheus::Counter*>(state->metricPtr)
+              ->Increment(static_cast<double>(delta));
+        }
+        break;
+      }
+      case velox::StatType::SUM: {
+        const auto delta = impl_->cells.drain(state->cells);
+        if (delta != 0) {
+          reinterpret_cast<::prometheus::Gauge*>(state->metricPtr)
+              ->Increment(static_cast<double>(delta));
+        }
+        break;
+      }
+      case velox::StatType::AVG:
+      case velox::StatType::RATE: {
+        const auto value = state->gaugeValue.exchange(
+            kNoGaugeValue, std::memory_order_relaxed);
+        if (value != kNoGaugeValue) {
+          reinterpret_cast<::prometheus::Gauge*>(state->metricPtr)
+              ->Set(static_cast<double>(value));
+        }
+        break;
+      }
+      case velox::StatType::HISTOGRAM: {
+        std::vector<double> bucketIncrements(state->numBounds + 1);
+        int64_t count = 0;
+        for (uint32_t i = 0; i <= state->numBounds; ++i) {
+          const auto increment = impl_->cells.drain(state->cells, i);
+          bucketIncrements[i] = increment;
+          count += increment;
+        }
+        const auto sum =
+            impl_->cells.drain(state->cells, state->numBounds + 1);
+        if (count != 0) {
+          reinterpret_cast<::prometheus::Histogram*>(state->metricPtr)
+              ->ObserveMultiple(bucketIncrements, static_cast<double>(sum));
+        }
+        if (state->summary != nullptr) {
+          for (uint32_t i = 0; i <= state->summaryShardMask; ++i) {
+            auto& shard = state->summaryShards[i];
+            std::lock_guard<folly::MicroSpinLock> l(shard.lock);
+            state->flushSummary(shard);
+          }
+        }
+        break;
+      }
+      default:
+        VELOX_UNREACHABLE();
+    }
+  }
 }
 
 std::string PrometheusStatsReporter::fetchMetrics() {
-  if (registeredMetricsMap_.empty()) {
+  std::lock_guard<std::mutex> l(mutex_);
+  if (impl_->metrics.empty()) {
     return "";
   }
+  drainMetrics();
   ::prometheus::TextSerializer serializer;
   // Registry::Collect() acquires lock on a mutex.
   return serializer.Serialize(impl_->registry->Collect());
 }
 
-void PrometheusStatsReporter::waitForCompletion() const {
-  executor_->join();
-}
-
 } // namespace facebook::presto::prometheus
@@ -13,7 +13,7 @@
  */
 
 #include <folly/concurrency/ConcurrentHashMap.h>
-#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <mutex>
 #include "presto_cpp/main/common/Configs.h"
 #include "velox/common/base/Exceptions.h"
 #include "velox/common/base/GTestMacros.h"
@@ -21,9 +21,14 @@
 
 namespace facebook::presto::prometheus {
 
+struct MetricState;
+
 struct StatsInfo {
   velox::StatType statType;
   void* metricPtr;
+  // Lock-free recording state of the metric, aggregated into 'metricPtr' by
+  // fetchMetrics().
+  MetricState* state;
 };
 
 /// Prometheus CPP library exposes following classes:
@@ -36,13 +41,24 @@ struct StatsInfo {
 /// For metric http_latency_ms labels could be {method="GET"}, {method="PUT"},
 /// {method="POST"} etc. Prometheus treats {<metric_name>, [labels]} as unique
 /// metric object.
+///
+/// Metric updates are recorded without locks or allocations: each metric is
+/// resolved at registration to a dense range of cells that is replicated
+/// across a set of per-thread shards. Recording a value adds to the cells of
+/// the calling thread's shard, and fetchMetrics() lazily drains all shards
+/// into the Prometheus registry before serializing it.
 class PrometheusStatsReporter : public facebook::velox::BaseStatsReporter {
   class PrometheusImpl;
 
  public:
+  /// 'numShards' is the number of per-thread shards of metric cells. It is
+  /// rounded up to a power of two. If 0, it is derived from the number of
+  /// hardware threads.
   explicit PrometheusStatsReporter(
       const std::map<std::string, std::string>& labels,
-      int numThreads);
+      uint32_t numShards = 0);
+
+  ~PrometheusStatsReporter() override;
 
   void registerMetricExportType(const char* key, velox::StatType)
       const override;
@@ -128,12 +144,6 @@ class PrometheusStatsReporter : public facebook::velox::BaseStatsReporter {
 
   std::string fetchMetrics() override;
 
-  /**
-   * Waits for all pending metric updates to complete.
-   * This is only used in tests to ensure correct timing.
-   */
-  void waitForCompletion() const;
-
   static std::unique_ptr<velox::BaseStatsReporter> createPrometheusReporter() {
     auto nodeConfig = NodeConfig::instance();
     const std::string cluster = nodeConfig->nodeEnvironment();
@@ -141,16 +151,28 @@ class PrometheusStatsReporter : public facebook::velox::BaseStatsReporter {
     const std::string worker = !hostName ? "" : hostName;
     std::map<std::string, std::string> labels{
         {"cluster", cluster}, {"worker", worker}};
-    return std::make_unique<PrometheusStatsReporter>(
-        labels, nodeConfig->prometheusExecutorThreads());
+    return std::make_unique<PrometheusStatsReporter>(labels);
   }
 
  private:
-  std::shared_ptr<folly::CPUThreadPoolExecutor> executor_;
+  // Returns the registered metric for 'key' or nullptr. Lock-free and does
+  // not allocate.
+  MetricState* findMetric(std::string_view key) const;
+
+  void recordMetricValue(std::string_view key, size_t value) const;
+
+  void recordHistogramMetricValue(std::string_view key, size_t value) const;
+
+  // Aggregates the values recorded since the last call into the Prometheus
+  // metrics. Called with 'mutex_' held.
+  void drainMetrics() const;
+
   std::shared_ptr<PrometheusImpl> impl_;
+  // Serializes registrations against each other and against fetchMetrics().
+  mutable std::mutex mutex_;
   // A map of labels assigned to each metric which helps in filtering at client
-  // end.
-  mutable folly::ConcurrentHashMap<std::string, StatsInfo>
+  // end. Keys point into the owned metric names in 'impl_'.
+  mutable folly::ConcurrentHashMap<std::string_view, StatsInfo>
       registeredMetricsMap_;
   VELOX_FRIEND_TEST(PrometheusReporterTest, testCountAndGauge);
   VELOX_FRIEND_TEST(PrometheusReporterTest, testHistogramSummary);
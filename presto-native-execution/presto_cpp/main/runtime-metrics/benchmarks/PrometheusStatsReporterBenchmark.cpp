@@ -0,0 +1,142 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <folly/Benchmark.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/init/Init.h>
+#include <prometheus/counter.h>
+#include <prometheus/registry.h>
+#include <thread>
+
+#include "presto_cpp/main/runtime-metrics/PrometheusStatsReporter.h"
+
+namespace facebook::presto::prometheus {
+namespace {
+
+constexpr const char* kCounterKey = "presto_cpp.benchmark.counter";
+constexpr const char* kHistogramKey = "presto_cpp.benchmark.histogram";
+
+/// Reproduces the previous reporter update path: every update allocates a
+/// string key and posts a lambda that looks the metric up and increments the
+/// Prometheus counter on a shared executor.
+class ExecutorBasedRecorder {
+ public:
+  ExecutorBasedRecorder()
+      : executor_(std::make_shared<folly::CPUThreadPoolExecutor>(2)) {
+    auto& family = ::prometheus::BuildCounter()
+                       .Name("presto_cpp_benchmark_counter")
+                       .Register(registry_);
+    counters_.insert(kCounterKey, &family.Add({}));
+  }
+
+  void addMetricValue(const char* key, size_t value) {
+    executor_->add([this, key = std::string(key), value]() {
+      auto it = counters_.find(key);
+      if (it != counters_.end()) {
+        it->second->Increment(static_cast<double>(value));
+      }
+    });
+  }
+
+  void waitForCompletion() {
+    executor_->join();
+  }
+
+ private:
+  ::prometheus::Registry registry_;
+  folly::ConcurrentHashMap<std::string, ::prometheus::Counter*> counters_;
+  std::shared_ptr<folly::CPUThreadPoolExecutor> executor_;
+};
+
+/// Runs 'iters' updates split across 'numThreads' threads that all start at
+/// the same time.
+template <typename F>
+void runContended(size_t iters, int numThreads, F update) {
+  std::atomic_bool start{false};
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+  const auto itersPerThread = std::max<size_t>(1, iters / numThreads);
+  for (auto i = 0; i < numThreads; ++i) {
+    threads.emplace_back([&]() {
+      while (!start.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      for (size_t j = 0; j < itersPerThread; ++j) {
+        update(j);
+      }
+    });
+  }
+  start.store(true, std::memory_order_release);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+void executorCounter(size_t iters, int numThreads) {
+  folly::BenchmarkSuspender suspender;
+  ExecutorBasedRecorder recorder;
+  suspender.dismiss();
+  runContended(iters, numThreads, [&](size_t /*i*/) {
+    recorder.addMetricValue(kCounterKey, 1);
+  });
+  // Updates are only complete once the executor drained its queue.
+  recorder.waitForCompletion();
+}
+
+void shardedCounter(size_t iters, int numThreads) {
+  folly::BenchmarkSuspender suspender;
+  PrometheusStatsReporter reporter({{"cluster", "benchmark"}});
+  reporter.registerMetricExportType(kCounterKey, velox::StatType::COUNT);
+  suspender.dismiss();
+  runContended(iters, numThreads, [&](size_t /*i*/) {
+    reporter.addMetricValue(kCounterKey, 1);
+  });
+  folly::doNotOptimizeAway(reporter.fetchMetrics());
+}
+
+void shardedHistogram(size_t iters, int numThreads) {
+  folly::BenchmarkSuspender suspender;
+  PrometheusStatsReporter reporter({{"cluster", "benchmark"}});
+  reporter.registerHistogramMetricExportType(
+      kHistogramKey, 10, 0, 1'000, {50, 99});
+  suspender.dismiss();
+  runContended(iters, numThreads, [&](size_t i) {
+    reporter.addHistogramMetricValue(kHistogramKey, i % 1'000);
+  });
+  folly::doNotOptimizeAway(reporter.fetchMetrics());
+}
+
+BENCHMARK_DRAW_TEXT("=============Counter, 1 thread=============");
+BENCHMARK_NAMED_PARAM(executorCounter, 1Thread, 1);
+BENCHMARK_RELATIVE_NAMED_PARAM(shardedCounter, 1Thread, 1);
+
+BENCHMARK_DRAW_TEXT("=============Counter, 8 threads=============");
+BENCHMARK_NAMED_PARAM(executorCounter, 8Threads, 8);
+BENCHMARK_RELATIVE_NAMED_PARAM(shardedCounter, 8Threads, 8);
+
+BENCHMARK_DRAW_TEXT("=============Counter, 64 threads=============");
+BENCHMARK_NAMED_PARAM(executorCounter, 64Threads, 64);
+BENCHMARK_RELATIVE_NAMED_PARAM(shardedCounter, 64Threads, 64);
+
+BENCHMARK_DRAW_TEXT("=============Histogram with summary=============");
+BENCHMARK_NAMED_PARAM(shardedHistogram, 1Thread, 1);
+BENCHMARK_NAMED_PARAM(shardedHistogram, 64Threads, 64);
+
+} // namespace
+} // namespace facebook::presto::prometheus
+
+int main(int argc, char** argv) {
+  folly::Init init{&argc, &argv};
+  folly::runBenchmarks();
+  return 0;
+}
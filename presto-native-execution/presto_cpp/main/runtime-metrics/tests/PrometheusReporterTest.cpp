@@ -13,8 +13,11 @@
  */
 
 #include "presto_cpp/main/runtime-metrics/PrometheusStatsReporter.h"
+#include "presto_cpp/main/common/Counters.h"
 
+#include <fmt/format.h>
 #include <gtest/gtest.h>
+#include <thread>
 
 namespace facebook::presto::prometheus {
 class PrometheusReporterTest : public testing::Test {
@@ -69,9 +72,6 @@ TEST_F(PrometheusReporterTest, testConcurrentReporting) {
   multiThreadedReporter->addMetricValue("test.key1");
   multiThreadedReporter->addMetricValue("test.key3");
 
-  // Wait for all async updates to finish before validation
-  multiThreadedReporter->waitForCompletion();
-
   auto fullSerializedResult = multiThreadedReporter->fetchMetrics();
 
   std::vector<std::string> expected = {
@@ -83,6 +83,103 @@ TEST_F(PrometheusReporterTest, testConcurrentReporting) {
   verifySerializedResult(fullSerializedResult, expected);
 };
 
+TEST_F(PrometheusReporterTest, testMultiThreadedRecording) {
+  auto shardedReporter =
+      std::make_shared<PrometheusStatsReporter>(testLabels, 4);
+  shardedReporter->registerMetricExportType(
+      "test.key1", facebook::velox::StatType::COUNT);
+  shardedReporter->registerHistogramMetricExportType(
+      "test.histogram.key1", 10, 0, 20, {});
+
+  constexpr int kNumThreads = 16;
+  constexpr int kNumUpdates = 1'000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < kNumUpdates; ++j) {
+        shardedReporter->addMetricValue("test.key1", 2);
+        shardedReporter->addHistogramMetricValue(
+            "test.histogram.key1", j % 2 == 0 ? 5 : 25);
+      }
+    });
+  }
+  // Fetching while recording must not lose updates.
+  shardedReporter->fetchMetrics();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto fullSerializedResult = shardedReporter->fetchMetrics();
+  const auto total = kNumThreads * kNumUpdates;
+  std::vector<std::string> expected = {
+      "# TYPE test_key1 counter",
+      "test_key1{" + labelsSerialized + "} " + std::to_string(2 * total),
+      "# TYPE test_histogram_key1 histogram",
+      "test_histogram_key1_count{" + labelsSerialized + "} " +
+          std::to_string(total),
+      "test_histogram_key1_sum{" + labelsSerialized + "} " +
+          std::to_string(15 * total),
+      "test_histogram_key1_bucket{" + labelsSerialized + ",le=\"10\"} " +
+          std::to_string(total / 2),
+      "test_histogram_key1_bucket{" + labelsSerialized + ",le=\"20\"} " +
+          std::to_string(total / 2),
+      "test_histogram_key1_bucket{" + labelsSerialized + ",le=\"+Inf\"} " +
+          std::to_string(total)};
+  verifySerializedResult(fullSerializedResult, expected);
+}
+
+TEST_F(PrometheusReporterTest, testLargeHistograms) {
+  // Same buckets as registered by registerPrestoMetrics().
+  reporter->registerHistogramMetricExportType(
+      kCounterHTTPRequestSizeBytes, 1 * 1024, 0, 5 * 1024 * 1024, {50, 99});
+  reporter->registerHistogramMetricExportType(
+      kCounterExchangeRequestPageSize, 10 * 1024, 0, 20 * 1024 * 1024, {});
+  // More cells than fit in a fixed number of chunks.
+  for (int i = 0; i < 20; ++i) {
+    reporter->registerHistogramMetricExportType(
+        fmt::format("test.histogram.large{}", i), 1, 0, 2'000, {});
+  }
+  reporter->registerMetricExportType(
+      "test.key.after", facebook::velox::StatType::COUNT);
+
+  reporter->addHistogramMetricValue(kCounterHTTPRequestSizeBytes, 1'000);
+  reporter->addHistogramMetricValue(kCounterHTTPRequestSizeBytes, 10'000'000);
+  reporter->addHistogramMetricValue(
+      kCounterExchangeRequestPageSize, 20 * 1024 * 1024);
+  reporter->addHistogramMetricValue("test.histogram.large19", 1'999);
+  reporter->addMetricValue("test.key.after", 3);
+  const auto result = reporter->fetchMetrics();
+
+  const auto hasLine = [&](const std::string& line) {
+    return result.find(line + "\n") != std::string::npos;
+  };
+  const auto key = [](std::string_view name) {
+    std::string sanitized{name};
+    std::replace(sanitized.begin(), sanitized.end(), '.', '_');
+    return sanitized;
+  };
+  const auto http = key(kCounterHTTPRequestSizeBytes);
+  EXPECT_TRUE(hasLine(http + "_count{" + labelsSerialized + "} 2"));
+  EXPECT_TRUE(hasLine(http + "_sum{" + labelsSerialized + "} 10001000"));
+  EXPECT_TRUE(
+      hasLine(http + "_bucket{" + labelsSerialized + ",le=\"1024\"} 1"));
+  EXPECT_TRUE(
+      hasLine(http + "_bucket{" + labelsSerialized + ",le=\"5242880\"} 1"));
+  EXPECT_TRUE(
+      hasLine(http + "_bucket{" + labelsSerialized + ",le=\"+Inf\"} 2"));
+  const auto pageSize = key(kCounterExchangeRequestPageSize);
+  EXPECT_TRUE(hasLine(
+      pageSize + "_bucket{" + labelsSerialized + ",le=\"20961280\"} 0"));
+  EXPECT_TRUE(hasLine(
+      pageSize + "_bucket{" + labelsSerialized + ",le=\"20971520\"} 1"));
+  EXPECT_TRUE(hasLine(
+      "test_histogram_large19_bucket{" + labelsSerialized +
+      ",le=\"1999\"} 1"));
+  EXPECT_TRUE(
+      hasLine("test_histogram_large18_count{" + labelsSerialized + "} 0"));
+  EXPECT_TRUE(hasLine("test_key_after{" + labelsSerialized + "} 3"));
+}
+
 TEST_F(PrometheusReporterTest, testCountAndGauge) {
   reporter->registerMetricExportType(
       "test.key1", facebook::velox::StatType::COUNT);
@@ -116,7 +213,6 @@ TEST_F(PrometheusReporterTest, testCountAndGauge) {
   // Uses default value of 1 for second parameter.
   reporter->addMetricValue("test.key1");
   reporter->addMetricValue("test.key3");
-  reporter->waitForCompletion();
 
   auto fullSerializedResult = reporter->fetchMetrics();
 
@@ -156,7 +252,6 @@ TEST_F(PrometheusReporterTest, testHistogramSummary) {
     }
   }
   reporter->addHistogramMetricValue(histogramKey, 10);
-  reporter->waitForCompletion();
   auto fullSerializedResult = reporter->fetchMetrics();
   std::replace(histSummaryKey.begin(), histSummaryKey.end(), '.', '_');
   std::replace(histogramKey.begin(), histogramKey.end(), '.', '_');
@@ -0,0 +1,208 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/PressureMonitor.h"
+#include <folly/FileUtil.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/synchronization/Baton.h>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "presto_cpp/main/TaskManager.h"
+#include "velox/common/base/tests/GTestUtils.h"
+#include "velox/exec/tests/utils/TempDirectoryPath.h"
+
+using namespace facebook::velox;
+
+namespace facebook::presto {
+namespace {
+
+// Registers the triggers on the pressure files like PressureMonitor, but
+// polls an eventfd per resource instead, which fire() signals.
+class FakePressureMonitor : public PressureMonitor {
+ public:
+  FakePressureMonitor(const Config& config, Callback callback)
+      : PressureMonitor(config, std::move(callback)) {
+    eventFds_.fill(-1);
+  }
+
+  ~FakePressureMonitor() override {
+    stop();
+  }
+
+  void fire(PressureResource resource) {
+    const uint64_t one{1};
+    ASSERT_EQ(
+        folly::writeFull(
+            eventFds_[static_cast<size_t>(resource)], &one, sizeof(one)),
+        static_cast<ssize_t>(sizeof(one)));
+  }
+
+ protected:
+  int registerTrigger(PressureResource resource) const override {
+    const int fd = PressureMonitor::registerTrigger(resource);
+    if (fd < 0) {
+      return fd;
+    }
+    ::close(fd);
+    // The monitor owns and closes the returned fd.
+    eventFds_[static_cast<size_t>(resource)] =
+        ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    return eventFds_[static_cast<size_t>(resource)];
+  }
+
+  int16_t triggerEvents() const override {
+    return POLLIN;
+  }
+
+  void clearTrigger(int fd) const override {
+    uint64_t count;
+    folly::readFull(fd, &count, sizeof(count));
+  }
+
+ private:
+  mutable std::array<int, 3> eventFds_;
+};
+
+class PressureMonitorTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    tempDir_ = exec::test::TempDirectoryPath::create();
+    config_.cgroupPath = tempDir_->getPath();
+    config_.cpuStallThresholdMs = 500;
+    config_.memoryStallThresholdMs = 100;
+    config_.holdMs = 200;
+  }
+
+  void createPressureFile(PressureResource resource) {
+    ASSERT_TRUE(
+        folly::writeFile(std::string(), pressureFilePath(resource).c_str()));
+  }
+
+  std::string pressureFilePath(PressureResource resource) const {
+    return fmt::format(
+        "{}/{}.pressure", tempDir_->getPath(), pressureResourceName(resource));
+  }
+
+  std::shared_ptr<exec::test::TempDirectoryPath> tempDir_;
+  PressureMonitor::Config config_;
+};
+
+TEST_F(PressureMonitorTest, registerTriggers) {
+  createPressureFile(PressureResource::kCpu);
+  createPressureFile(PressureResource::kMemory);
+  createPressureFile(PressureResource::kIo);
+  FakePressureMonitor monitor(config_, nullptr);
+  ASSERT_TRUE(monitor.start());
+
+  // The trigger is written with its trailing null byte. IO is not monitored.
+  std::string trigger;
+  ASSERT_TRUE(folly::readFile(
+      pressureFilePath(PressureResource::kCpu).c_str(), trigger));
+  EXPECT_EQ(trigger, std::string("some 500000 2000000\0", 20));
+  ASSERT_TRUE(folly::readFile(
+      pressureFilePath(PressureResource::kMemory).c_str(), trigger));
+  EXPECT_EQ(trigger, std::string("some 100000 2000000\0", 20));
+  ASSERT_TRUE(folly::readFile(
+      pressureFilePath(PressureResource::kIo).c_str(), trigger));
+  EXPECT_TRUE(trigger.empty());
+  monitor.stop();
+}
+
+TEST_F(PressureMonitorTest, triggerAndRelease) {
+  createPressureFile(PressureResource::kMemory);
+  std::atomic_int32_t numEvents{0};
+  folly::Baton<> triggered;
+  FakePressureMonitor monitor(config_, [&](PressureResource resource) {
+    EXPECT_EQ(resource, PressureResource::kMemory);
+    ++numEvents;
+    triggered.post();
+  });
+  // Only the memory trigger is registered since there is no cpu.pressure.
+  ASSERT_TRUE(monitor.start());
+  EXPECT_TRUE(monitor.stalledResources().empty());
+
+  // The event wakes up poll() and the resource stays under pressure for
+  // 'holdMs'.
+  monitor.fire(PressureResource::kMemory);
+  ASSERT_TRUE(triggered.try_wait_for(std::chrono::seconds(10)));
+  EXPECT_EQ(numEvents, 1);
+  EXPECT_TRUE(monitor.underPressure(PressureResource::kMemory));
+  EXPECT_FALSE(monitor.underPressure(PressureResource::kCpu));
+  EXPECT_EQ(
+      monitor.stalledResources(),
+      std::vector<PressureResource>{PressureResource::kMemory});
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(config_.holdMs + 50));
+  EXPECT_FALSE(monitor.underPressure(PressureResource::kMemory));
+  EXPECT_TRUE(monitor.stalledResources().empty());
+  // The event was consumed and did not fire again.
+  EXPECT_EQ(numEvents, 1);
+  monitor.stop();
+}
+
+TEST_F(PressureMonitorTest, serverOverloaded) {
+  createPressureFile(PressureResource::kCpu);
+  auto executor = std::make_unique<folly::CPUThreadPoolExecutor>(1);
+  TaskManager taskManager(executor.get(), executor.get(), nullptr);
+  FakePressureMonitor* monitorPtr{nullptr};
+  folly::Baton<> triggered;
+  // Re-evaluates the overloaded state on every trigger like PrestoServer.
+  FakePressureMonitor monitor(config_, [&](PressureResource /*resource*/) {
+    taskManager.setServerOverloaded(!monitorPtr->stalledResources().empty());
+    triggered.post();
+  });
+  monitorPtr = &monitor;
+  ASSERT_TRUE(monitor.start());
+  ASSERT_FALSE(taskManager.isServerOverloaded());
+
+  monitor.fire(PressureResource::kCpu);
+  ASSERT_TRUE(triggered.try_wait_for(std::chrono::seconds(10)));
+  EXPECT_TRUE(taskManager.isServerOverloaded());
+
+  // The next periodic check after the hold time releases the server.
+  std::this_thread::sleep_for(std::chrono::milliseconds(config_.holdMs + 50));
+  taskManager.setServerOverloaded(!monitor.stalledResources().empty());
+  EXPECT_FALSE(taskManager.isServerOverloaded());
+  monitor.stop();
+}
+
+TEST_F(PressureMonitorTest, startWithoutPsi) {
+  config_.cgroupPath = fmt::format("{}/nonexistent", tempDir_->getPath());
+  PressureMonitor monitor(config_, nullptr);
+  ASSERT_FALSE(monitor.start());
+  EXPECT_FALSE(monitor.underPressure(PressureResource::kCpu));
+  monitor.stop();
+}
+
+TEST_F(PressureMonitorTest, invalidConfig) {
+  PressureMonitor::Config config;
+  config.windowMs = 100;
+  VELOX_ASSERT_THROW(
+      PressureMonitor(config, nullptr),
+      "PSI window must be between 500ms and 10s: 100ms");
+  config.windowMs = 20'000;
+  VELOX_ASSERT_THROW(
+      PressureMonitor(config, nullptr),
+      "PSI window must be between 500ms and 10s: 20000ms");
+
+  config.windowMs = 2'000;
+  config.ioStallThresholdMs = 3'000;
+  VELOX_ASSERT_THROW(
+      PressureMonitor(config, nullptr),
+      "Stall threshold of io must not exceed the PSI window");
+}
+
+} // namespace
+} // namespace facebook::presto
@@ -12,6 +12,7 @@
  * limitations under the License.
  */
 #include <gtest/gtest.h>
+#include <thread>
 #include "presto_cpp/main/QueryContextManager.h"
 
 DECLARE_bool(velox_memory_leak_check_enabled);
@@ -107,7 +108,8 @@ TEST_F(QueryContextCacheTest, hasStartedTasks) {
 }
 
 TEST_F(QueryContextCacheTest, eviction) {
-  QueryContextCache queryContextCache(8);
+  // Sweep released entries on every insert.
+  QueryContextCache queryContextCache(std::chrono::milliseconds(0));
 
   // Insert 8 query contexts.
   std::unordered_map<protocol::QueryId, std::shared_ptr<core::QueryCtx>>
@@ -132,7 +134,7 @@ TEST_F(QueryContextCacheTest, eviction) {
     queryCtxs.erase(queryId);
   }
 
-  // Insert 4 more query ctxs
+  // Insert 4 more query ctxs. The released ones are swept.
   for (int i = 8; i < 12; ++i) {
     auto queryId = fmt::format("query-{}", i);
     auto queryCtx = core::QueryCtx::create(
@@ -146,7 +148,7 @@ TEST_F(QueryContextCacheTest, eviction) {
   verifyQueryCtxCache(queryContextCache, queryCtxs, 0, 12);
   EXPECT_EQ(queryContextCache.size(), 8);
 
-  // Ensure that cache expands if all the queries in cache are alive.
+  // Live query contexts are never evicted.
   for (int i = 12; i < 20; ++i) {
     auto queryId = fmt::format("query-{}", i);
     auto queryCtx = core::QueryCtx::create(
@@ -162,8 +164,56 @@ TEST_F(QueryContextCacheTest, eviction) {
 
   queryCtxs.clear();
 
-  // Verify that cache returns no query context now.
-  verifyQueryCtxCache(queryContextCache, queryCtxs, 0, 20);
+  // Released entries that are not looked up are removed by a sweep.
+  queryContextCache.evict();
   EXPECT_EQ(queryContextCache.size(), 0);
 }
+
+TEST_F(QueryContextCacheTest, insertKeepsLiveQueryCtx) {
+  QueryContextCache queryContextCache;
+  auto first = core::QueryCtx::create(
+      (folly::Executor*)nullptr, core::QueryConfig({}));
+  auto second = core::QueryCtx::create(
+      (folly::Executor*)nullptr, core::QueryConfig({}));
+
+  EXPECT_EQ(queryContextCache.insert("query-0", first), first);
+  // A concurrent creator of the same query gets the cached query context.
+  EXPECT_EQ(queryContextCache.insert("query-0", second), first);
+  queryContextCache.setTasksStarted("query-0");
+  EXPECT_TRUE(queryContextCache.hasStartedTasks("query-0"));
+
+  // Once released, the entry is replaced.
+  first.reset();
+  EXPECT_EQ(queryContextCache.insert("query-0", second), second);
+  EXPECT_FALSE(queryContextCache.hasStartedTasks("query-0"));
+  EXPECT_EQ(queryContextCache.size(), 1);
+}
+
+TEST_F(QueryContextCacheTest, concurrentAccess) {
+  QueryContextCache queryContextCache;
+  std::vector<std::shared_ptr<core::QueryCtx>> queryCtxs;
+  for (int i = 0; i < 4; ++i) {
+    queryCtxs.push_back(core::QueryCtx::create(
+        (folly::Executor*)nullptr, core::QueryConfig({})));
+  }
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < 1'000; ++i) {
+        const auto index = (t + i) % queryCtxs.size();
+        const auto queryId = fmt::format("query-{}", index);
+        auto queryCtx = queryContextCache.get(queryId);
+        if (queryCtx == nullptr) {
+          queryCtx = queryContextCache.insert(queryId, queryCtxs[index]);
+        }
+        EXPECT_EQ(queryCtx, queryCtxs[index]);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(queryContextCache.size(), queryCtxs.size());
+}
 } // namespace facebook::presto
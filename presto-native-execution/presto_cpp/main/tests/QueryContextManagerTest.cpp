@@ -12,13 +12,46 @@
  * limitations under the License.
  */
 #include "presto_cpp/main/QueryContextManager.h"
+#include <folly/synchronization/Baton.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <thread>
 #include "presto_cpp/main/TaskManager.h"
 #include "presto_cpp/main/common/Configs.h"
 #include "velox/core/QueryConfig.h"
 
 namespace facebook::presto {
+namespace {
+// Blocks the creation of query contexts until 'release' is posted.
+class BlockingQueryContextManager : public QueryContextManager {
+ public:
+  using QueryContextManager::QueryContextManager;
+
+  folly::Baton<> creating;
+  folly::Baton<> release;
+
+ private:
+  std::shared_ptr<velox::core::QueryCtx> createAndCacheQueryCtxLocked(
+      const protocol::QueryId& queryId,
+      velox::core::QueryConfig&& queryConfig,
+      std::unordered_map<
+          std::string,
+          std::shared_ptr<velox::config::ConfigBase>>&& connectorConfigs,
+      std::shared_ptr<velox::memory::MemoryPool>&& pool) override {
+    creating.post();
+    release.wait();
+    auto queryCtx = velox::core::QueryCtx::create(
+        driverExecutor_,
+        std::move(queryConfig),
+        std::move(connectorConfigs),
+        nullptr,
+        std::move(pool),
+        spillerExecutor_,
+        queryId);
+    return queryContextCache_.insert(queryId, std::move(queryCtx));
+  }
+};
+} // namespace
 
 class QueryContextManagerTest : public testing::Test {
  protected:
@@ -327,4 +360,33 @@ TEST_F(QueryContextManagerTest, findOrCreateBatchQueryCtxWithAbortedPool) {
   ASSERT_THAT(newPoolName, testing::HasSubstr("batch_"));
   ASSERT_NE(firstPoolName, newPoolName);
 }
+
+TEST_F(QueryContextManagerTest, findOrCreateQueryCtxAsync) {
+  BlockingQueryContextManager queryCtxManager(
+      driverExecutor_.get(), spillerExecutor_.get());
+  protocol::TaskUpdateRequest updateRequest;
+
+  std::shared_ptr<velox::core::QueryCtx> createdQueryCtx;
+  std::thread creator([&]() {
+    createdQueryCtx =
+        queryCtxManager.findOrCreateQueryCtx("query.0.0.1.0", updateRequest);
+  });
+  queryCtxManager.creating.wait();
+
+  // Another task of the query gets a future instead of blocking.
+  auto waiting = queryCtxManager.findOrCreateQueryCtxAsync(
+      "query.1.0.1.0", updateRequest);
+  ASSERT_FALSE(waiting.isReady());
+
+  queryCtxManager.release.post();
+  creator.join();
+  ASSERT_NE(createdQueryCtx, nullptr);
+  ASSERT_EQ(std::move(waiting).get(), createdQueryCtx);
+
+  // Once created, the future is ready right away.
+  auto cached = queryCtxManager.findOrCreateQueryCtxAsync(
+      "query.2.0.1.0", updateRequest);
+  ASSERT_TRUE(cached.isReady());
+  ASSERT_EQ(std::move(cached).get(), createdQueryCtx);
+}
 } // namespace facebook::presto
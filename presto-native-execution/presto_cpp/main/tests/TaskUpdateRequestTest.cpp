@@ -13,6 +13,7 @@
  */
 
 #include <gtest/gtest.h>
+#include "presto_cpp/main/TaskResource.h"
 #include "presto_cpp/main/common/tests/test_json.h"
 #include "presto_cpp/main/connectors/HivePrestoToVeloxConnector.h"
 #include "presto_cpp/main/connectors/PrestoToVeloxConnector.h"
@@ -273,6 +274,82 @@ TEST_F(TaskUpdateRequestTest, fragment) {
   ASSERT_EQ(scan->id, "0");
 }
 
+TEST_F(TaskUpdateRequestTest, decodeThriftFragment) {
+  std::string str =
+      slurp(getDataPath(BASE_DATA_PATH, "Fragment.thrift.base64"));
+  const auto strEnd = str.find_last_not_of(" \t\n\r");
+  if (strEnd != std::string::npos) {
+    str.erase(strEnd + 1);
+  }
+  const auto fragment = facebook::velox::encoding::Base64::decode(str);
+
+  protocol::TaskUpdateRequest updateRequest;
+  updateRequest.fragment = std::make_shared<std::string>(fragment);
+  updateRequest.outputIds.version = 7;
+  thrift::TaskUpdateRequest thriftUpdateRequest;
+  thrift::toThrift(updateRequest, thriftUpdateRequest);
+  const auto thriftBody = thriftWrite(thriftUpdateRequest);
+
+  auto decoded = decodeTaskUpdateRequest(thriftBody, /*receiveThrift=*/true);
+  ASSERT_NE(decoded.fragment, nullptr);
+  ASSERT_EQ(*decoded.fragment, fragment);
+  ASSERT_EQ(decoded.outputIds.version, 7);
+
+  auto thriftPlan =
+      decodePlanFragment(*decoded.fragment, /*receiveThrift=*/true);
+  auto jsonPlan = decodePlanFragment(str, /*receiveThrift=*/false);
+  ASSERT_EQ(thriftPlan.root->_type, ".AggregationNode");
+  ASSERT_EQ(thriftPlan.root->id, jsonPlan.root->id);
+
+  // A request without a fragment decodes to a null fragment.
+  updateRequest.fragment.reset();
+  thrift::TaskUpdateRequest noFragmentRequest;
+  thrift::toThrift(updateRequest, noFragmentRequest);
+  decoded = decodeTaskUpdateRequest(
+      thriftWrite(noFragmentRequest), /*receiveThrift=*/true);
+  ASSERT_EQ(decoded.fragment, nullptr);
+}
+
+TEST_F(TaskUpdateRequestTest, decodeSplitUpdate) {
+  protocol::TaskUpdateRequest updateRequest;
+  updateRequest.session.user = "test_user";
+  updateRequest.extraCredentials["credential"] = "secret";
+  protocol::TaskSource source;
+  source.planNodeId = "0";
+  source.noMoreSplits = true;
+  updateRequest.sources.push_back(source);
+  updateRequest.outputIds.version = 3;
+  json requestJson = updateRequest;
+
+  auto decoded = decodeSplitUpdateRequest(requestJson.dump());
+  ASSERT_TRUE(decoded.has_value());
+  ASSERT_EQ(decoded->fragment, nullptr);
+  ASSERT_EQ(decoded->sources.size(), 1);
+  ASSERT_EQ(decoded->sources[0].planNodeId, "0");
+  ASSERT_TRUE(decoded->sources[0].noMoreSplits);
+  ASSERT_EQ(decoded->outputIds.version, 3);
+  // Fields not needed to deliver splits are skipped.
+  ASSERT_TRUE(decoded->session.user.empty());
+  ASSERT_TRUE(decoded->extraCredentials.empty());
+
+  // Requests with a plan fragment need the full decode.
+  updateRequest.fragment = std::make_shared<std::string>("e30=");
+  requestJson = updateRequest;
+  ASSERT_FALSE(decodeSplitUpdateRequest(requestJson.dump()).has_value());
+
+  // A "fragment": inside a string value is not the key.
+  updateRequest.fragment = nullptr;
+  updateRequest.session.user = "\"fragment\":\"x\"";
+  requestJson = updateRequest;
+  decoded = decodeSplitUpdateRequest(requestJson.dump());
+  ASSERT_TRUE(decoded.has_value());
+  ASSERT_EQ(decoded->sources.size(), 1);
+
+  // An explicit null fragment.
+  requestJson["fragment"] = nullptr;
+  ASSERT_TRUE(decodeSplitUpdateRequest(requestJson.dump()).has_value());
+}
+
 TEST_F(TaskUpdateRequestTest, sessionRepresentation) {
   protocol::SessionRepresentation sessionRepresentation;
   thrift::SessionRepresentation thriftSessionRepresentation;
@@ -68,7 +68,8 @@ core::PlanNodePtr PartitionAndSerializeReplayer::createPlanNode(
       partitionAndSerializeNode->isReplicateNullsAndAny(),
       partitionAndSerializeNode->partitionFunctionFactory(),
       partitionAndSerializeNode->sortingOrders(),
-      partitionAndSerializeNode->sortingKeys());
+      partitionAndSerializeNode->sortingKeys(),
+      partitionAndSerializeNode->skewSplit());
 }
 
 } // namespace facebook::velox::tool::trace
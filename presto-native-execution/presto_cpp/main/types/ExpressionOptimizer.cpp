@@ -13,11 +13,17 @@
  */
 
 #include "presto_cpp/main/types/ExpressionOptimizer.h"
+#include <folly/String.h>
+#include <folly/container/F14Set.h>
+#include <folly/futures/Future.h>
+#include <numeric>
 #include "presto_cpp/main/common/Configs.h"
 #include "presto_cpp/main/common/Exception.h"
 #include "presto_cpp/main/types/PrestoToVeloxExpr.h"
 #include "presto_cpp/main/types/TypeParser.h"
 #include "presto_cpp/main/types/VeloxToPrestoExpr.h"
+#include "velox/common/base/BitUtil.h"
+#include "velox/common/time/Timer.h"
 #include "velox/core/Expressions.h"
 #include "velox/expression/Expr.h"
 #include "velox/expression/ExprOptimizer.h"
@@ -61,20 +67,81 @@ velox::VectorPtr tryEvaluateToConstant(
   return results.at(0);
 }
 
+struct TimeDependence {
+  bool startTime{false};
+  bool timeZone{false};
+};
+
+// Finds the session time state the RowExpression 'expr' depends on. Calls to
+// functions returning the current time depend on the session start time and
+// time zone. Expressions with date and time types may depend on the time
+// zone. Errs on the side of reporting a dependence.
+void findTimeDependence(
+    const nlohmann::json& expr,
+    TimeDependence& dependence) {
+  static const folly::F14FastSet<std::string> kCurrentTimeFunctions{
+      "now",
+      "current_date",
+      "current_time",
+      "current_timestamp",
+      "current_timezone",
+      "localtime",
+      "localtimestamp"};
+  if (expr.is_array()) {
+    for (const auto& element : expr) {
+      findTimeDependence(element, dependence);
+    }
+    return;
+  }
+  if (!expr.is_object()) {
+    return;
+  }
+  for (const auto& [key, value] : expr.items()) {
+    if (!value.is_string()) {
+      findTimeDependence(value, dependence);
+      continue;
+    }
+    const auto& string = value.get_ref<const std::string&>();
+    if (key == "name" || key == "displayName") {
+      auto name = folly::toLowerAscii(string);
+      if (const auto pos = name.rfind('.'); pos != std::string::npos) {
+        name = name.substr(pos + 1);
+      }
+      if (kCurrentTimeFunctions.contains(name)) {
+        dependence.startTime = true;
+        dependence.timeZone = true;
+      }
+    } else if (key == "type" || key == "returnType") {
+      if (string.find("time") != std::string::npos) {
+        dependence.timeZone = true;
+      }
+    }
+  }
+}
+
+// Sets 'cacheable' to true if the result only depends on 'input', the
+// optimizer level and the session, so that it can be reused for other
+// requests.
 protocol::RowExpressionOptimizationResult optimizeExpression(
     const RowExpressionPtr& input,
     const OptimizerLevel& optimizerLevel,
     const VeloxExprConverter& prestoToVeloxConverter,
     const expression::VeloxToPrestoExprConverter& veloxToPrestoConverter,
     velox::core::QueryCtx* queryCtx,
-    velox::memory::MemoryPool* pool) {
+    velox::memory::MemoryPool* pool,
+    bool& cacheable) {
   protocol::RowExpressionOptimizationResult result;
+  cacheable = false;
   const auto expr = prestoToVeloxConverter.toVeloxExpr(input);
 
   try {
     auto optimized =
         velox::expression::optimize(expr, queryCtx, pool, kMakeFailExpr);
 
+    // The optimizer only folds deterministic expressions. Evaluating the rest
+    // may give a different result every time.
+    cacheable = optimizerLevel == OptimizerLevel::kOptimized ||
+        optimized->isConstantKind();
     if (optimizerLevel == OptimizerLevel::kEvaluated) {
       const auto evalResult = tryEvaluateToConstant(optimized, queryCtx, pool);
       optimized = std::make_shared<velox::core::ConstantTypedExpr>(evalResult);
@@ -86,35 +153,192 @@ protocol::RowExpressionOptimizationResult optimizeExpression(
     result.expressionFailureInfo =
         toNativeSidecarFailureInfo(translateToPrestoException(e));
     result.optimizedExpression = nullptr;
+    cacheable = false;
   } catch (const std::exception& e) {
     result.expressionFailureInfo =
         toNativeSidecarFailureInfo(translateToPrestoException(e));
     result.optimizedExpression = nullptr;
+    cacheable = false;
   }
   return result;
 }
 
-} // namespace
-
-std::vector<protocol::RowExpressionOptimizationResult> optimizeExpressions(
+// Optimizes the expressions of 'input' at 'indices' and stores the results at
+// the same positions of 'results'. Converters are not thread-safe, so each
+// batch uses its own.
+void optimizeBatch(
     const std::vector<RowExpressionPtr>& input,
+    folly::Range<const size_t*> indices,
     const OptimizerLevel& optimizerLevel,
     velox::core::QueryCtx* queryCtx,
-    velox::memory::MemoryPool* pool) {
+    velox::memory::MemoryPool* pool,
+    std::vector<protocol::RowExpressionOptimizationResult>& results,
+    std::vector<uint8_t>& cacheable) {
   TypeParser typeParser;
   const VeloxExprConverter prestoToVeloxConverter(pool, &typeParser);
   const expression::VeloxToPrestoExprConverter veloxToPrestoConverter(pool);
-  std::vector<protocol::RowExpressionOptimizationResult> result;
-  for (const auto& expression : input) {
-    result.push_back(optimizeExpression(
-        expression,
+  for (const auto index : indices) {
+    bool isCacheable;
+    results[index] = optimizeExpression(
+        input[index],
         optimizerLevel,
         prestoToVeloxConverter,
         veloxToPrestoConverter,
         queryCtx,
-        pool));
+        pool,
+        isCacheable);
+    cacheable[index] = isCacheable;
   }
-  return result;
+}
+
+} // namespace
+
+ExpressionOptimizationCache::ExpressionOptimizationCache(uint64_t maxBytes)
+    : maxBytes_(maxBytes), entries_(0) {
+  VELOX_CHECK_GT(maxBytes_, 0);
+  entries_.setPruneHook(
+      [this](const std::string& /*key*/, Entry&& entry) {
+        numBytes_ -= entry.bytes;
+      });
+}
+
+std::optional<protocol::RowExpressionOptimizationResult>
+ExpressionOptimizationCache::get(const std::string& key) {
+  std::lock_guard<std::mutex> l(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++numMisses_;
+    return std::nullopt;
+  }
+  ++numHits_;
+  return it->second.result;
+}
+
+void ExpressionOptimizationCache::put(
+    const std::string& key,
+    protocol::RowExpressionOptimizationResult result) {
+  const uint64_t bytes = key.size() + nlohmann::json(result).dump().size();
+  if (bytes > maxBytes_) {
+    return;
+  }
+  std::lock_guard<std::mutex> l(mutex_);
+  if (auto it = entries_.find(key); it != entries_.end()) {
+    numBytes_ -= it->second.bytes;
+    entries_.erase(it);
+  }
+  entries_.set(key, Entry{std::move(result), bytes});
+  numBytes_ += bytes;
+  while (numBytes_ > maxBytes_) {
+    entries_.prune(1);
+  }
+}
+
+ExpressionOptimizationCache::Stats ExpressionOptimizationCache::stats() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return {numHits_, numMisses_, entries_.size(), numBytes_};
+}
+
+std::vector<protocol::RowExpressionOptimizationResult> optimizeExpressions(
+    const std::vector<RowExpressionPtr>& input,
+    const OptimizerLevel& optimizerLevel,
+    velox::core::QueryCtx* queryCtx,
+    velox::memory::MemoryPool* pool) {
+  OptimizationStats stats;
+  return optimizeExpressions(
+      input, optimizerLevel, queryCtx, pool, OptimizationOptions{}, stats);
+}
+
+std::vector<protocol::RowExpressionOptimizationResult> optimizeExpressions(
+    const std::vector<RowExpressionPtr>& input,
+    const OptimizerLevel& optimizerLevel,
+    velox::core::QueryCtx* queryCtx,
+    velox::memory::MemoryPool* pool,
+    const OptimizationOptions& options,
+    OptimizationStats& stats) {
+  velox::NanosecondTimer timer(&stats.wallNanos);
+  stats.numExpressions += input.size();
+  std::vector<protocol::RowExpressionOptimizationResult> results(input.size());
+
+  // Canonical cache keys. The JSON of a RowExpression has its object keys in
+  // sorted order. The session time state is only part of the keys of the
+  // expressions that depend on it, so that the others hit the cache across
+  // queries.
+  std::vector<std::string> keys;
+  std::vector<size_t> misses;
+  if (options.cache != nullptr) {
+    keys.reserve(input.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+      const nlohmann::json expr = input[i];
+      TimeDependence dependence;
+      findTimeDependence(expr, dependence);
+      keys.push_back(fmt::format(
+          "{}\n{}\n{}\n{}\n{}",
+          static_cast<int>(optimizerLevel),
+          options.sessionKey,
+          dependence.timeZone ? options.timeZoneKey : "",
+          dependence.startTime ? options.startTimeKey : "",
+          expr.dump()));
+      if (auto cached = options.cache->get(keys.back())) {
+        results[i] = std::move(cached.value());
+        ++stats.numCacheHits;
+      } else {
+        misses.push_back(i);
+      }
+    }
+  } else {
+    misses.resize(input.size());
+    std::iota(misses.begin(), misses.end(), 0);
+  }
+
+  // Not std::vector<bool>, which batches cannot update concurrently.
+  std::vector<uint8_t> cacheable(input.size(), false);
+  if (!misses.empty()) {
+    const auto batchSize = std::max<size_t>(options.batchSize, 1);
+    const auto numBatches = options.executor == nullptr
+        ? 1
+        : velox::bits::divRoundUp(misses.size(), batchSize);
+    stats.numBatches += numBatches;
+    auto batch = [&](size_t i) {
+      const auto begin = i * batchSize;
+      const auto end = numBatches == 1
+          ? misses.size()
+          : std::min(begin + batchSize, misses.size());
+      optimizeBatch(
+          input,
+          folly::Range<const size_t*>(misses.data() + begin, end - begin),
+          optimizerLevel,
+          queryCtx,
+          pool,
+          results,
+          cacheable);
+    };
+
+    // Batches write to disjoint positions of 'results' and 'cacheable'.
+    std::vector<folly::SemiFuture<folly::Unit>> futures;
+    futures.reserve(numBatches - 1);
+    for (size_t i = 1; i < numBatches; ++i) {
+      futures.push_back(
+          folly::via(options.executor, [&batch, i]() { batch(i); }).semi());
+    }
+    // Waits for all batches before a failure of the first one unwinds the
+    // state they reference.
+    folly::Try<folly::Unit> first =
+        folly::makeTryWith([&batch]() { batch(0); });
+    auto others = folly::collectAll(std::move(futures)).get();
+    first.throwUnlessValue();
+    for (auto& other : others) {
+      other.throwUnlessValue();
+    }
+  }
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    if (results[i].optimizedExpression == nullptr) {
+      ++stats.numFailures;
+    } else if (options.cache != nullptr && cacheable[i]) {
+      options.cache->put(keys[i], results[i]);
+    }
+  }
+  return results;
 }
 
 } // namespace facebook::presto::expression
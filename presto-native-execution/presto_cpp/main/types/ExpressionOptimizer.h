@@ -13,6 +13,9 @@
  */
 #pragma once
 
+#include <folly/Executor.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <mutex>
 #include "presto_cpp/presto_protocol/core/presto_protocol_core.h"
 #include "velox/common/memory/MemoryPool.h"
 #include "velox/core/QueryCtx.h"
@@ -35,6 +38,73 @@ enum class OptimizerLevel {
   kEvaluated,
 };
 
+/// LRU cache of optimized expressions shared by the requests to the sidecar.
+/// Keys combine the canonical JSON of a RowExpression with the optimizer level
+/// and the session state that affects evaluation. Bounded by the size of the
+/// keys and of the serialized results. Thread-safe.
+class ExpressionOptimizationCache {
+ public:
+  struct Stats {
+    uint64_t numHits{0};
+    uint64_t numMisses{0};
+    size_t numEntries{0};
+    uint64_t numBytes{0};
+  };
+
+  explicit ExpressionOptimizationCache(uint64_t maxBytes);
+
+  std::optional<protocol::RowExpressionOptimizationResult> get(
+      const std::string& key);
+
+  void put(
+      const std::string& key,
+      protocol::RowExpressionOptimizationResult result);
+
+  Stats stats() const;
+
+ private:
+  struct Entry {
+    protocol::RowExpressionOptimizationResult result;
+    uint64_t bytes;
+  };
+
+  const uint64_t maxBytes_;
+  mutable std::mutex mutex_;
+  folly::EvictingCacheMap<std::string, Entry> entries_;
+  uint64_t numBytes_{0};
+  uint64_t numHits_{0};
+  uint64_t numMisses_{0};
+};
+
+struct OptimizationOptions {
+  /// Caches the results of deterministic expressions across calls if set.
+  ExpressionOptimizationCache* cache{nullptr};
+  /// Identifies the session state that affects evaluation, e.g. the session
+  /// properties. Part of the cache keys.
+  std::string sessionKey;
+  /// Session time zone. Part of the cache keys of expressions that use the
+  /// current time or have date and time types.
+  std::string timeZoneKey;
+  /// Session start time. Part of the cache keys of expressions that use the
+  /// current time, e.g. now() and current_date.
+  std::string startTimeKey;
+  /// Executor to optimize large inputs on in parallel. The calling thread
+  /// takes part and waits for the result.
+  folly::Executor* executor{nullptr};
+  /// Number of expressions optimized per task when running on 'executor'.
+  size_t batchSize{32};
+};
+
+/// Statistics of one optimizeExpressions() call.
+struct OptimizationStats {
+  size_t numExpressions{0};
+  size_t numCacheHits{0};
+  size_t numFailures{0};
+  /// Number of batches the expressions not found in the cache were split in.
+  size_t numBatches{0};
+  uint64_t wallNanos{0};
+};
+
 /// Optimizes the input list of RowExpressions. For each input RowExpression,
 /// the result is an optimized expression on success or failure info.
 /// @param input List of RowExpressions to be optimized.
@@ -50,4 +120,15 @@ std::vector<protocol::RowExpressionOptimizationResult> optimizeExpressions(
     const OptimizerLevel& optimizerLevel,
     velox::core::QueryCtx* queryCtx,
     velox::memory::MemoryPool* pool);
+
+/// Same as above, but looks up and adds results to 'options.cache' and splits
+/// large inputs over 'options.executor'. 'pool' must be usable from several
+/// threads in that case.
+std::vector<protocol::RowExpressionOptimizationResult> optimizeExpressions(
+    const std::vector<RowExpressionPtr>& input,
+    const OptimizerLevel& optimizerLevel,
+    velox::core::QueryCtx* queryCtx,
+    velox::memory::MemoryPool* pool,
+    const OptimizationOptions& options,
+    OptimizationStats& stats);
 } // namespace facebook::presto::expression
@@ -36,6 +36,7 @@
 #include "presto_cpp/main/operators/MaterializedOutput.h"
 #include "presto_cpp/main/operators/PartitionAndSerialize.h"
 #include "presto_cpp/main/operators/ShuffleRead.h"
+#include "presto_cpp/main/operators/ShuffleReadPushdown.h"
 #include "presto_cpp/main/operators/ShuffleWrite.h"
 #include "presto_cpp/main/properties/session/SessionProperties.h"
 #include "presto_cpp/main/types/TypeParser.h"
@@ -657,6 +658,91 @@ std::shared_ptr<const protocol::ProjectNode> isIdentityProjection(
 
   return nullptr;
 }
+
+// Returns a copy of 'node' with 'outputType' and 'filter' if 'node' is a
+// ShuffleReadNode or MaterializedExchangeNode. Returns nullptr otherwise.
+core::PlanNodePtr withShuffleReadPushdown(
+    const core::PlanNodePtr& node,
+    const RowTypePtr& outputType,
+    const core::TypedExprPtr& filter) {
+  if (auto read =
+          std::dynamic_pointer_cast<const operators::ShuffleReadNode>(node)) {
+    return std::make_shared<operators::ShuffleReadNode>(
+        read->id(), outputType, read->serializedType(), filter);
+  }
+  if (auto read =
+          std::dynamic_pointer_cast<const operators::MaterializedExchangeNode>(
+              node)) {
+    return std::make_shared<operators::MaterializedExchangeNode>(
+        read->id(), outputType, read->serializedType(), filter);
+  }
+  return nullptr;
+}
+
+// Returns the filter pushed into a shuffle read 'node' or nullptr.
+core::TypedExprPtr shuffleReadFilter(const core::PlanNodePtr& node) {
+  if (auto read =
+          std::dynamic_pointer_cast<const operators::ShuffleReadNode>(node)) {
+    return read->filter();
+  }
+  if (auto read =
+          std::dynamic_pointer_cast<const operators::MaterializedExchangeNode>(
+              node)) {
+    return read->filter();
+  }
+  return nullptr;
+}
+
+// Folds 'filter' into the shuffle read 'source'. Returns nullptr if 'source'
+// is not a shuffle read, already has a filter or if the filter reads a column
+// that is not in the output of 'source'.
+core::PlanNodePtr pushFilterIntoShuffleRead(
+    const core::PlanNodePtr& source,
+    const core::TypedExprPtr& filter) {
+  if (!SystemConfig::instance()->shuffleReadPushdownEnabled() ||
+      shuffleReadFilter(source) != nullptr) {
+    return nullptr;
+  }
+  folly::F14FastSet<std::string> names;
+  operators::collectInputColumns(filter, names);
+  for (const auto& name : names) {
+    if (!source->outputType()->containsChild(name)) {
+      return nullptr;
+    }
+  }
+  return withShuffleReadPushdown(source, source->outputType(), filter);
+}
+
+// Narrows the output of the shuffle read 'source' to the columns that
+// 'projections' read. Returns nullptr if 'source' is not a shuffle read or
+// all of its columns are read.
+core::PlanNodePtr pushProjectionIntoShuffleRead(
+    const core::PlanNodePtr& source,
+    const std::vector<core::TypedExprPtr>& projections) {
+  if (!SystemConfig::instance()->shuffleReadPushdownEnabled()) {
+    return nullptr;
+  }
+  folly::F14FastSet<std::string> names;
+  for (const auto& projection : projections) {
+    operators::collectInputColumns(projection, names);
+  }
+  const auto& sourceType = source->outputType();
+  if (names.size() >= sourceType->size()) {
+    return nullptr;
+  }
+  std::vector<std::string> outputNames;
+  std::vector<TypePtr> outputTypes;
+  for (column_index_t i = 0; i < sourceType->size(); ++i) {
+    if (names.contains(sourceType->nameOf(i))) {
+      outputNames.push_back(sourceType->nameOf(i));
+      outputTypes.push_back(sourceType->childAt(i));
+    }
+  }
+  return withShuffleReadPushdown(
+      source,
+      ROW(std::move(outputNames), std::move(outputTypes)),
+      shuffleReadFilter(source));
+}
 } // namespace
 
 core::PlanNodePtr VeloxQueryPlanConverterBase::toVeloxQueryPlan(
@@ -738,10 +824,13 @@ core::PlanNodePtr VeloxQueryPlanConverterBase::toVeloxQueryPlan(
         node->id, std::move(names), std::move(projections), hashJoinNode);
   }
 
+  auto filter = exprConverter_.toVeloxExpr(node->predicate);
+  auto source = toVeloxQueryPlan(node->source, tableWriteInfo, taskId);
+  if (auto read = pushFilterIntoShuffleRead(source, filter)) {
+    return read;
+  }
   return std::make_shared<core::FilterNode>(
-      node->id,
-      exprConverter_.toVeloxExpr(node->predicate),
-      toVeloxQueryPlan(node->source, tableWriteInfo, taskId));
+      node->id, std::move(filter), std::move(source));
 }
 
 std::shared_ptr<const core::ProjectNode>
@@ -849,11 +938,16 @@ VeloxQueryPlanConverterBase::toVeloxQueryPlan(
     return limit;
   }
 
+  auto projections = getProjections(exprConverter_, node->assignments);
+  auto source = toVeloxQueryPlan(node->source, tableWriteInfo, taskId);
+  if (auto read = pushProjectionIntoShuffleRead(source, projections)) {
+    source = std::move(read);
+  }
   return std::make_shared<core::ProjectNode>(
       node->id,
       getNames(node->assignments),
-      getProjections(exprConverter_, node->assignments),
-      toVeloxQueryPlan(node->source, tableWriteInfo, taskId));
+      std::move(projections),
+      std::move(source));
 }
 
 VectorPtr VeloxQueryPlanConverterBase::evaluateConstantExpression(
@@ -0,0 +1,276 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "presto_cpp/main/types/ExpressionOptimizer.h"
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <gtest/gtest.h>
+#include "presto_cpp/main/common/tests/MutableConfigs.h"
+#include "velox/common/encode/Base64.h"
+#include "velox/common/file/FileSystems.h"
+#include "velox/functions/prestosql/registration/RegistrationFunctions.h"
+#include "velox/serializers/PrestoSerializer.h"
+
+using namespace facebook::presto;
+using namespace facebook::velox;
+
+namespace facebook::presto::expression::test {
+namespace {
+
+class ExpressionOptimizerTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    memory::MemoryManager::testingSetInstance(memory::MemoryManager::Options{});
+  }
+
+  void SetUp() override {
+    filesystems::registerLocalFileSystem();
+    presto::test::setupMutableSystemConfig();
+    functions::prestosql::registerAllScalarFunctions("presto.default.");
+    if (!isRegisteredVectorSerde()) {
+      serializer::presto::PrestoVectorSerde::registerVectorSerde();
+    }
+    pool_ = memory::memoryManager()->addLeafPool();
+    queryCtx_ = core::QueryCtx::create();
+  }
+
+  // Returns a BIGINT constant with a value in [0, 256).
+  static RowExpressionPtr makeConstant(uint8_t value) {
+    // A LONG_ARRAY block of one non-null value.
+    std::string block{"\x0a\0\0\0LONG_ARRAY\x01\0\0\0\0", 19};
+    block.append(1, static_cast<char>(value));
+    block.append(7, '\0');
+    json j = {
+        {"@type", "constant"},
+        {"valueBlock", encoding::Base64::encode(block)},
+        {"type", "bigint"}};
+    return j;
+  }
+
+  // Returns a call to the function 'name' without arguments.
+  static RowExpressionPtr makeCall(
+      const std::string& name,
+      const std::string& returnType) {
+    json j = {
+        {"@type", "call"},
+        {"arguments", json::array()},
+        {"displayName", name},
+        {"functionHandle",
+         {{"@type", "$static"},
+          {"signature",
+           {{"argumentTypes", json::array()},
+            {"kind", "SCALAR"},
+            {"longVariableConstraints", json::array()},
+            {"name", "presto.default." + name},
+            {"returnType", returnType},
+            {"typeVariableConstraints", json::array()},
+            {"variableArity", false}}},
+          {"builtInFunctionKind", "ENGINE"}}},
+        {"returnType", returnType}};
+    return j;
+  }
+
+  static std::string valueBlock(
+      const protocol::RowExpressionOptimizationResult& result) {
+    auto constant = std::dynamic_pointer_cast<protocol::ConstantExpression>(
+        result.optimizedExpression);
+    EXPECT_NE(constant, nullptr);
+    return constant == nullptr ? "" : constant->valueBlock.data;
+  }
+
+  std::shared_ptr<memory::MemoryPool> pool_;
+  std::shared_ptr<core::QueryCtx> queryCtx_;
+};
+
+TEST_F(ExpressionOptimizerTest, cache) {
+  protocol::RowExpressionOptimizationResult result;
+  result.optimizedExpression = makeConstant(1);
+  // Room for two entries with single character keys.
+  const uint64_t entryBytes = 1 + json(result).dump().size();
+  ExpressionOptimizationCache cache(2 * entryBytes);
+  cache.put("a", result);
+  cache.put("b", result);
+  EXPECT_TRUE(cache.get("a").has_value());
+  // Evicts the least recently used entry 'b'.
+  cache.put("c", result);
+  EXPECT_FALSE(cache.get("b").has_value());
+  EXPECT_TRUE(cache.get("c").has_value());
+
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.numHits, 2);
+  EXPECT_EQ(stats.numMisses, 1);
+  EXPECT_EQ(stats.numEntries, 2);
+  EXPECT_EQ(stats.numBytes, 2 * entryBytes);
+
+  // Replacing an entry does not change the size.
+  cache.put("c", result);
+  EXPECT_EQ(cache.stats().numBytes, 2 * entryBytes);
+
+  // A longer key evicts both entries.
+  cache.put("dd", result);
+  stats = cache.stats();
+  EXPECT_EQ(stats.numEntries, 1);
+  EXPECT_EQ(stats.numBytes, entryBytes + 1);
+
+  // Entries larger than the cache are not added.
+  cache.put(std::string(2 * entryBytes, 'e'), result);
+  EXPECT_EQ(cache.stats().numEntries, 1);
+  EXPECT_TRUE(cache.get("dd").has_value());
+}
+
+TEST_F(ExpressionOptimizerTest, cachedResults) {
+  ExpressionOptimizationCache cache(1 << 20);
+  OptimizationOptions options;
+  options.cache = &cache;
+  options.sessionKey = "session";
+
+  std::vector<RowExpressionPtr> input{makeConstant(1), makeConstant(2)};
+  OptimizationStats stats;
+  auto results = optimizeExpressions(
+      input,
+      OptimizerLevel::kOptimized,
+      queryCtx_.get(),
+      pool_.get(),
+      options,
+      stats);
+  ASSERT_EQ(results.size(), 2);
+  EXPECT_EQ(stats.numExpressions, 2);
+  EXPECT_EQ(stats.numCacheHits, 0);
+  EXPECT_EQ(stats.numFailures, 0);
+  EXPECT_EQ(cache.stats().numEntries, 2);
+
+  input.push_back(makeConstant(3));
+  stats = {};
+  auto cachedResults = optimizeExpressions(
+      input,
+      OptimizerLevel::kOptimized,
+      queryCtx_.get(),
+      pool_.get(),
+      options,
+      stats);
+  ASSERT_EQ(cachedResults.size(), 3);
+  EXPECT_EQ(stats.numCacheHits, 2);
+  EXPECT_EQ(valueBlock(cachedResults[0]), valueBlock(results[0]));
+  EXPECT_EQ(valueBlock(cachedResults[1]), valueBlock(results[1]));
+  EXPECT_EQ(cache.stats().numEntries, 3);
+
+  // Another session or optimizer level does not hit the cache.
+  stats = {};
+  options.sessionKey = "other session";
+  optimizeExpressions(
+      input,
+      OptimizerLevel::kOptimized,
+      queryCtx_.get(),
+      pool_.get(),
+      options,
+      stats);
+  EXPECT_EQ(stats.numCacheHits, 0);
+  stats = {};
+  optimizeExpressions(
+      input,
+      OptimizerLevel::kEvaluated,
+      queryCtx_.get(),
+      pool_.get(),
+      options,
+      stats);
+  EXPECT_EQ(stats.numCacheHits, 0);
+}
+
+TEST_F(ExpressionOptimizerTest, nonDeterministicResults) {
+  ExpressionOptimizationCache cache(1 << 20);
+  OptimizationOptions options;
+  options.cache = &cache;
+  options.sessionKey = "session";
+
+  // rand() is evaluated to a different constant every time, so the results
+  // must not be reused.
+  std::vector<RowExpressionPtr> input{makeCall("rand", "double")};
+  for (auto i = 0; i < 2; ++i) {
+    OptimizationStats stats;
+    auto results = optimizeExpressions(
+        input,
+        OptimizerLevel::kEvaluated,
+        queryCtx_.get(),
+        pool_.get(),
+        options,
+        stats);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_NE(results[0].optimizedExpression, nullptr);
+    EXPECT_EQ(stats.numCacheHits, 0);
+    EXPECT_EQ(cache.stats().numEntries, 0);
+  }
+}
+
+TEST_F(ExpressionOptimizerTest, timeDependentKeys) {
+  ExpressionOptimizationCache cache(1 << 20);
+  OptimizationOptions options;
+  options.cache = &cache;
+  options.sessionKey = "session";
+  options.timeZoneKey = "America/Los_Angeles";
+
+  std::vector<RowExpressionPtr> input{
+      makeConstant(1), makeCall("current_date", "date")};
+  auto optimize = [&](const std::string& startTime) {
+    options.startTimeKey = startTime;
+    OptimizationStats stats;
+    optimizeExpressions(
+        input,
+        OptimizerLevel::kOptimized,
+        queryCtx_.get(),
+        pool_.get(),
+        options,
+        stats);
+    EXPECT_EQ(stats.numFailures, 0);
+    return stats.numCacheHits;
+  };
+  EXPECT_EQ(optimize("1000"), 0);
+  // Queries with a different start time share the result of the constant
+  // but not the one of current_date.
+  EXPECT_EQ(optimize("2000"), 1);
+  EXPECT_EQ(optimize("1000"), 2);
+
+  // current_date also depends on the time zone.
+  options.timeZoneKey = "Asia/Kolkata";
+  EXPECT_EQ(optimize("1000"), 1);
+}
+
+TEST_F(ExpressionOptimizerTest, parallelBatches) {
+  auto executor = std::make_unique<folly::CPUThreadPoolExecutor>(4);
+  OptimizationOptions options;
+  options.executor = executor.get();
+  options.batchSize = 3;
+
+  std::vector<RowExpressionPtr> input;
+  for (auto i = 0; i < 10; ++i) {
+    input.push_back(makeConstant(i));
+  }
+  OptimizationStats stats;
+  auto results = optimizeExpressions(
+      input,
+      OptimizerLevel::kOptimized,
+      queryCtx_.get(),
+      pool_.get(),
+      options,
+      stats);
+  EXPECT_EQ(stats.numBatches, 4);
+
+  // Same results in the same order as without an executor.
+  auto expected = optimizeExpressions(
+      input, OptimizerLevel::kOptimized, queryCtx_.get(), pool_.get());
+  ASSERT_EQ(results.size(), expected.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    EXPECT_EQ(valueBlock(results[i]), valueBlock(expected[i]));
+  }
+}
+
+} // namespace
+} // namespace facebook::presto::expression::test
@@ -57,14 +57,11 @@ std::shared_ptr<const core::PlanNode> assertToVeloxQueryPlan(
   return assertToVeloxFragment(fileName, pool).planNode;
 }
 
-std::shared_ptr<const core::PlanNode> assertToBatchVeloxQueryPlan(
-    const std::string& fileName,
+std::shared_ptr<const core::PlanNode> toBatchVeloxQueryPlan(
+    const protocol::PlanFragment& prestoPlan,
     const std::string& shuffleName,
     std::shared_ptr<std::string>&& serializedShuffleWriteInfo,
     std::shared_ptr<std::string>&& broadcastBasePath) {
-  const std::string fragment = slurp(test::utils::getDataPath(fileName));
-
-  protocol::PlanFragment prestoPlan = json::parse(fragment);
   auto pool = memory::deprecatedAddDefaultLeafMemoryPool();
   auto queryCtx = core::QueryCtx::create();
   VeloxBatchQueryPlanConverter converter(
@@ -78,6 +75,21 @@ std::shared_ptr<const core::PlanNode> assertToBatchVeloxQueryPlan(
           prestoPlan, nullptr, "20201107_130540_00011_wrpkw.1.2.3")
       .planNode;
 }
+
+std::shared_ptr<const core::PlanNode> assertToBatchVeloxQueryPlan(
+    const std::string& fileName,
+    const std::string& shuffleName,
+    std::shared_ptr<std::string>&& serializedShuffleWriteInfo,
+    std::shared_ptr<std::string>&& broadcastBasePath) {
+  const std::string fragment = slurp(test::utils::getDataPath(fileName));
+
+  protocol::PlanFragment prestoPlan = json::parse(fragment);
+  return toBatchVeloxQueryPlan(
+      prestoPlan,
+      shuffleName,
+      std::move(serializedShuffleWriteInfo),
+      std::move(broadcastBasePath));
+}
 } // namespace
 
 class PlanConverterTest : public ::testing::Test {
@@ -264,6 +276,83 @@ TEST_F(PlanConverterTest, batchPlanConversion) {
   ASSERT_NE(shuffleReadNode, nullptr);
 }
 
+// FinalAgg.json with a filter on regionkey and a projection that only reads
+// regionkey and sum_9 over the remote source: the filter and the column
+// subset are pushed into the shuffle read.
+TEST_F(PlanConverterTest, batchPlanConversionShuffleReadPushdown) {
+  filesystems::registerLocalFileSystem();
+  facebook::presto::test::setupMutableSystemConfig();
+  SystemConfig::instance()->setValue(
+      std::string(SystemConfig::kShuffleReadPushdownEnabled), "true");
+
+  json fragment =
+      json::parse(slurp(test::utils::getDataPath("FinalAgg.json")));
+  auto& exchangeSources = fragment["root"]["source"]["sources"];
+  const json regionKey = {
+      {"@type", "variable"}, {"name", "regionkey"}, {"type", "bigint"}};
+  const json sum = {
+      {"@type", "variable"}, {"name", "sum_9"}, {"type", "bigint"}};
+  // BIGINT constant 7.
+  const json seven = {
+      {"@type", "constant"},
+      {"valueBlock", "CgAAAExPTkdfQVJSQVkBAAAAAAcAAAAAAAAA"},
+      {"type", "bigint"}};
+  const json equal = {
+      {"@type", "call"},
+      {"displayName", "EQUAL"},
+      {"functionHandle",
+       {{"@type", "$static"},
+        {"signature",
+         {{"name", "presto.default.$operator$equal"},
+          {"kind", "SCALAR"},
+          {"typeVariableConstraints", json::array()},
+          {"longVariableConstraints", json::array()},
+          {"returnType", "boolean"},
+          {"argumentTypes", {"bigint", "bigint"}},
+          {"variableArity", false}}},
+        {"builtInFunctionKind", "ENGINE"}}},
+      {"returnType", "boolean"},
+      {"arguments", {regionKey, seven}}};
+  const json filter = {
+      {"@type", ".FilterNode"},
+      {"id", "1000"},
+      {"source", exchangeSources[0]},
+      {"predicate", equal}};
+  exchangeSources[0] = {
+      {"@type", ".ProjectNode"},
+      {"id", "1001"},
+      {"source", filter},
+      {"assignments",
+       {{"assignments",
+         {{"regionkey<bigint>", regionKey},
+          {"sum_9<bigint>", sum},
+          {"$hashvalue_10<bigint>", seven}}}}},
+      {"locality", "LOCAL"}};
+
+  const protocol::PlanFragment prestoPlan = fragment;
+  auto curNode = toBatchVeloxQueryPlan(
+      prestoPlan,
+      std::string(operators::LocalPersistentShuffleFactory::kShuffleName),
+      nullptr,
+      std::make_shared<std::string>("/tmp"));
+  SystemConfig::instance()->setValue(
+      std::string(SystemConfig::kShuffleReadPushdownEnabled), "false");
+
+  while (!curNode->sources().empty()) {
+    ASSERT_EQ(
+        std::dynamic_pointer_cast<const core::FilterNode>(curNode), nullptr);
+    curNode = curNode->sources().back();
+  }
+  auto shuffleReadNode =
+      std::dynamic_pointer_cast<const operators::ShuffleReadNode>(curNode);
+  ASSERT_NE(shuffleReadNode, nullptr);
+  ASSERT_NE(shuffleReadNode->filter(), nullptr);
+  ASSERT_EQ(shuffleReadNode->serializedType()->size(), 3);
+  ASSERT_EQ(
+      shuffleReadNode->outputType()->names(),
+      (std::vector<std::string>{"regionkey", "sum_9"}));
+}
+
 TEST_F(PlanConverterTest, batchPlanConversionExchangeWrite) {
   filesystems::registerLocalFileSystem();
   facebook::presto::test::setupMutableSystemConfig();